@@ -0,0 +1,182 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <vw/BundleAdjustment/CompactControlNetwork.h>
+#include <vw/Core/Exception.h>
+#include <vw/Core/Settings.h>
+#include <vw/Core/ThreadPool.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace vw {
+namespace ba {
+
+  CompactControlNetwork::CompactControlNetwork(ControlNetwork const& cnet, int num_threads):
+    m_type(cnet.type()), m_image_names(cnet.get_image_list()) {
+
+    if (num_threads <= 0)
+      num_threads = vw_settings().default_num_threads();
+
+    // Where the measures of each point start. The image IDs are kept
+    // as 32-bit integers.
+    size_t num_points = cnet.size();
+    m_point_offsets.resize(num_points + 1);
+    m_point_offsets[0] = 0;
+    for (size_t i = 0; i < num_points; i++) {
+      m_point_offsets[i+1] = m_point_offsets[i] + cnet[i].size();
+      for (ControlPoint::const_iterator it = cnet[i].begin(); it != cnet[i].end(); ++it)
+        if (it->image_id() >= std::numeric_limits<uint32>::max())
+          vw_throw(ArgumentErr() << "CompactControlNetwork: The network has too many "
+                   << "points, measures, or images.\n");
+    }
+    size_t num_measures = m_point_offsets[num_points];
+
+    m_point_positions.resize(num_points);
+    m_point_sigmas   .resize(num_points);
+    m_point_types    .resize(num_points);
+    m_point_ignore   .resize(num_points);
+    m_point_ids      .resize(num_points);
+    m_measure_points   .resize(num_measures);
+    m_measure_image_ids.resize(num_measures);
+    m_measure_positions.resize(2*num_measures);
+    m_measure_sigmas   .resize(2*num_measures);
+    m_measure_types    .resize(num_measures);
+    m_measure_ignore   .resize(num_measures);
+
+    // Each point writes to its own range, so they can be copied in
+    // parallel
+    process_in_parallel(num_points, num_threads, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        ControlPoint const& cp = cnet[i];
+        m_point_positions[i] = cp.position();
+        m_point_sigmas   [i] = cp.sigma();
+        m_point_types    [i] = cp.type();
+        m_point_ignore   [i] = cp.ignore();
+        m_point_ids      [i] = cp.id();
+        size_t m = m_point_offsets[i];
+        for (ControlPoint::const_iterator it = cp.begin(); it != cp.end(); ++it, ++m) {
+          Vector2 position = it->position(), sigma = it->sigma();
+          m_measure_points   [m] = uint32(i);
+          m_measure_image_ids[m] = uint32(it->image_id());
+          m_measure_positions[2*m] = position[0]; m_measure_positions[2*m+1] = position[1];
+          m_measure_sigmas   [2*m] = sigma[0];    m_measure_sigmas   [2*m+1] = sigma[1];
+          m_measure_types    [m] = it->type();
+          m_measure_ignore   [m] = it->ignore();
+        }
+      }
+    });
+
+    index_images();
+  }
+
+  CompactControlNetwork::CompactControlNetwork(std::vector<std::string> const& image_names,
+                                               std::vector<size_t>  point_offsets,
+                                               std::vector<uint32>  measure_image_ids,
+                                               std::vector<float32> measure_positions,
+                                               std::vector<float32> measure_sigmas):
+    m_type(ControlNetwork::ImageToImage), m_image_names(image_names) {
+
+    if (point_offsets.empty())
+      point_offsets.push_back(0);
+    size_t num_points = point_offsets.size() - 1;
+    size_t num_measures = measure_image_ids.size();
+    if (point_offsets[0] != 0 || point_offsets[num_points] != num_measures ||
+        !std::is_sorted(point_offsets.begin(), point_offsets.end()) ||
+        measure_positions.size() != 2*num_measures ||
+        measure_sigmas.size()    != 2*num_measures)
+      vw_throw(ArgumentErr() << "CompactControlNetwork: The point offsets, image IDs, "
+               << "positions, and sigmas do not agree.\n");
+
+    m_point_offsets     = std::move(point_offsets);
+    m_measure_image_ids = std::move(measure_image_ids);
+    m_measure_positions = std::move(measure_positions);
+    m_measure_sigmas    = std::move(measure_sigmas);
+
+    ControlPoint cp;
+    m_point_positions.assign(num_points, cp.position());
+    m_point_sigmas   .assign(num_points, cp.sigma());
+    m_point_types    .assign(num_points, cp.type());
+    m_point_ignore   .assign(num_points, cp.ignore());
+    m_point_ids      .assign(num_points, cp.id());
+    m_measure_points.resize(num_measures);
+    for (size_t i = 0; i < num_points; i++)
+      std::fill(m_measure_points.begin() + m_point_offsets[i],
+                m_measure_points.begin() + m_point_offsets[i+1], uint32(i));
+    m_measure_types .assign(num_measures, ControlMeasure().type());
+    m_measure_ignore.assign(num_measures, false);
+
+    index_images();
+  }
+
+  void CompactControlNetwork::index_images() {
+
+    // There are as many images as names, or more if a measure has a
+    // larger image ID
+    size_t num_points = this->num_points(), num_measures = this->num_measures();
+    uint64 num_images = m_image_names.size();
+    for (size_t m = 0; m < num_measures; m++)
+      num_images = std::max(num_images, uint64(m_measure_image_ids[m]) + 1);
+    if (num_points   > std::numeric_limits<uint32>::max() ||
+        num_measures > std::numeric_limits<uint32>::max() ||
+        num_images   > std::numeric_limits<uint32>::max())
+      vw_throw(ArgumentErr() << "CompactControlNetwork: The network has too many "
+               << "points, measures, or images.\n");
+
+    // The measures of each image, by a counting sort on the image IDs,
+    // which keeps them in point order
+    m_image_offsets.assign(num_images + 1, 0);
+    for (size_t m = 0; m < num_measures; m++)
+      m_image_offsets[m_measure_image_ids[m] + 1]++;
+    for (size_t i = 0; i < num_images; i++)
+      m_image_offsets[i+1] += m_image_offsets[i];
+    m_image_measures.resize(num_measures);
+    std::vector<size_t> next(m_image_offsets.begin(), m_image_offsets.end() - 1);
+    for (size_t m = 0; m < num_measures; m++)
+      m_image_measures[next[m_measure_image_ids[m]]++] = uint32(m);
+  }
+
+  ControlMeasure CompactControlNetwork::measure(size_t measure) const {
+    ControlMeasure cm(m_measure_positions[2*measure], m_measure_positions[2*measure+1],
+                      m_measure_sigmas   [2*measure], m_measure_sigmas   [2*measure+1],
+                      m_measure_image_ids[measure], measure_type(measure));
+    cm.set_ignore(measure_ignore(measure));
+    return cm;
+  }
+
+  ControlPoint CompactControlNetwork::point(size_t point) const {
+    ControlPoint cp(point_type(point));
+    cp.set_id(m_point_ids[point]);
+    cp.set_ignore(point_ignore(point));
+    cp.set_position(m_point_positions[point]);
+    cp.set_sigma(m_point_sigmas[point]);
+    cp.reserve(num_measures(point));
+    for (size_t m = measures_begin(point); m < measures_end(point); m++)
+      cp.add_measure(measure(m));
+    return cp;
+  }
+
+  void CompactControlNetwork::to_control_network(ControlNetwork & cnet) const {
+    cnet.clear_points();
+    cnet.reserve(num_points());
+    for (size_t i = 0; i < num_points(); i++)
+      cnet.add_control_point(point(i));
+    cnet.get_image_list() = m_image_names;
+    cnet.set_type(m_type);
+  }
+
+}} // namespace vw::ba
@@ -0,0 +1,157 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#ifndef __VW_BUNDLEADJUSTMENT_COMPACT_CONTROL_NETWORK_H__
+#define __VW_BUNDLEADJUSTMENT_COMPACT_CONTROL_NETWORK_H__
+
+#include <string>
+#include <vector>
+
+#include <vw/Math/Vector.h>
+#include <vw/BundleAdjustment/ControlNetwork.h>
+
+namespace vw {
+namespace ba {
+
+  // A read-mostly copy of a control network that is laid out for
+  // iterating over all of its observations. The points are kept in
+  // flat arrays, and the measures of all points are kept one after
+  // another, with each point owning the range from its offset to the
+  // next one (the CSR layout of a sparse matrix). Each measure field is
+  // its own array, so a pass over the pixels only reads the pixels.
+  // The measures seen in each image are indexed the same way, in point
+  // order.
+  //
+  // Points and measures can not be added or removed once it is built,
+  // but their positions and ignore flags can be changed, which is what
+  // a bundle adjustment or an outlier filter does. The ControlPoint and
+  // ControlMeasure of any entry can be formed on demand, and the whole
+  // network converted back.
+  class CompactControlNetwork {
+  public:
+
+    // An empty network
+    CompactControlNetwork(): m_type(ControlNetwork::ImageToImage) {}
+
+    // Copy a network. The measures are copied on num_threads threads
+    // (0 for the default). There are as many images as there are names
+    // in the network, or more if a measure has a larger image ID.
+    CompactControlNetwork(ControlNetwork const& cnet, int num_threads = 0);
+
+    // Make a network of tie points directly from its measures, without
+    // forming a ControlNetwork first. The measures of point i are the
+    // ones from point_offsets[i] up to point_offsets[i+1], and the
+    // positions and sigmas are interleaved column, row pairs. The points
+    // are as a new ControlPoint would be, until they are triangulated.
+    CompactControlNetwork(std::vector<std::string> const& image_names,
+                          std::vector<size_t>  point_offsets,
+                          std::vector<uint32>  measure_image_ids,
+                          std::vector<float32> measure_positions,
+                          std::vector<float32> measure_sigmas);
+
+    size_t num_points  () const { return m_point_positions.size(); }
+    size_t num_measures() const { return m_measure_points.size(); }
+    size_t num_images  () const { return m_image_offsets.empty() ? 0 : m_image_offsets.size() - 1; }
+
+    ControlNetwork::ControlNetworkType type() const { return m_type; }
+    std::vector<std::string> const& get_image_list() const { return m_image_names; }
+
+    // Points
+
+    Vector3 const& point_position(size_t point) const { return m_point_positions[point]; }
+    Vector3 const& point_sigma   (size_t point) const { return m_point_sigmas[point]; }
+    ControlPoint::ControlPointType point_type(size_t point) const {
+      return ControlPoint::ControlPointType(m_point_types[point]);
+    }
+    bool point_ignore(size_t point) const { return m_point_ignore[point] != 0; }
+    std::string const& point_id(size_t point) const { return m_point_ids[point]; }
+
+    void set_point_position(size_t point, Vector3 const& position) { m_point_positions[point] = position; }
+    void set_point_ignore  (size_t point, bool ignore) { m_point_ignore[point] = ignore; }
+
+    // The measures of a point are the ones from measures_begin() up to,
+    // but not including, measures_end().
+    size_t measures_begin(size_t point) const { return m_point_offsets[point]; }
+    size_t measures_end  (size_t point) const { return m_point_offsets[point+1]; }
+    size_t num_measures  (size_t point) const { return measures_end(point) - measures_begin(point); }
+
+    // Measures
+
+    size_t  measure_point   (size_t measure) const { return m_measure_points[measure]; }
+    uint32  measure_image_id(size_t measure) const { return m_measure_image_ids[measure]; }
+    Vector2 measure_position(size_t measure) const { return Vector2(m_measure_positions[2*measure],
+                                                                    m_measure_positions[2*measure+1]); }
+    Vector2 measure_sigma   (size_t measure) const { return Vector2(m_measure_sigmas[2*measure],
+                                                                    m_measure_sigmas[2*measure+1]); }
+    ControlMeasure::ControlMeasureType measure_type(size_t measure) const {
+      return ControlMeasure::ControlMeasureType(m_measure_types[measure]);
+    }
+    bool measure_ignore(size_t measure) const { return m_measure_ignore[measure] != 0; }
+
+    void set_measure_position(size_t measure, Vector2 const& position) {
+      m_measure_positions[2*measure  ] = position[0];
+      m_measure_positions[2*measure+1] = position[1];
+    }
+    void set_measure_ignore(size_t measure, bool ignore) { m_measure_ignore[measure] = ignore; }
+
+    // Raw arrays, for loops over all the measures. The positions and
+    // sigmas are interleaved column, row pairs.
+    uint32  const* measure_image_ids() const { return m_measure_image_ids.data(); }
+    float32 const* measure_positions() const { return m_measure_positions.data(); }
+    float32 const* measure_sigmas   () const { return m_measure_sigmas.data(); }
+
+    // The measures seen in an image are image_measure(k) for k from
+    // image_measures_begin() up to, but not including,
+    // image_measures_end(). These are in the order of their points.
+    size_t image_measures_begin(size_t image) const { return m_image_offsets[image]; }
+    size_t image_measures_end  (size_t image) const { return m_image_offsets[image+1]; }
+    size_t image_measure       (size_t k    ) const { return m_image_measures[k]; }
+
+    // The same entries as they would be in a ControlNetwork
+    ControlMeasure measure(size_t measure) const;
+    ControlPoint   point  (size_t point  ) const;
+
+    // Copy everything back into a network, replacing its points and
+    // images.
+    void to_control_network(ControlNetwork & cnet) const;
+
+  private:
+    // Check the sizes and make the index of the measures of each image
+    void index_images();
+
+    ControlNetwork::ControlNetworkType m_type;
+    std::vector<std::string> m_image_names;
+
+    // Per point
+    std::vector<Vector3>     m_point_positions, m_point_sigmas;
+    std::vector<uint8>       m_point_types, m_point_ignore;
+    std::vector<std::string> m_point_ids;
+    std::vector<size_t>      m_point_offsets; // One more than the points
+
+    // Per measure
+    std::vector<uint32>  m_measure_points, m_measure_image_ids;
+    std::vector<float32> m_measure_positions, m_measure_sigmas;
+    std::vector<uint8>   m_measure_types, m_measure_ignore;
+
+    // Per image
+    std::vector<size_t> m_image_offsets; // One more than the images
+    std::vector<uint32> m_image_measures;
+  };
+
+}} // namespace vw::ba
+
+#endif // __VW_BUNDLEADJUSTMENT_COMPACT_CONTROL_NETWORK_H__
@@ -21,8 +21,12 @@
 #include <vw/InterestPoint/MatcherIO.h>
 #include <vw/InterestPoint/InterestPointUtils.h>
 #include <vw/Math/RandomSet.h>
+#include <vw/Core/Settings.h>
 #include <vw/Core/Stopwatch.h>
+#include <vw/Core/ThreadPool.h>
 
+#include <algorithm>
+#include <exception>
 #include <mutex>
 #include <boost/filesystem/fstream.hpp>
 
@@ -41,9 +45,9 @@ namespace {
   // Map from (cid1, cid2) -> vector of matches
   typedef std::map<std::pair<int, int>, std::vector<IndMatch>> PairWiseMatches;
 
-  // Map from TrackID -> (ImageID -> FeatureID)
-  // This replaces VwOpenMVG::tracks::STLMAPTracks
-  typedef std::map<int, std::map<int, int>> TrackMap;
+  // Map from TrackID -> [(ImageID, FeatureID)], with at most one feature per
+  // image. This replaces VwOpenMVG::tracks::STLMAPTracks.
+  typedef std::vector<std::vector<std::pair<int, int>>> TrackList;
 }
 
 const int MAX_TRI_FAILURE_WARNINGS = 100;
@@ -186,13 +190,12 @@ double vw::ba::triangulate_control_point(ControlPoint& cp,
   return error_sum;
 }
 
-// Triangulate the points in a control network. Do not triangulate
-// GCP or points constrained to a DEM. 
-void vw::ba::triangulate_control_network(vw::ba::ControlNetwork& cnet,
-                                         std::vector<vw::CamPtr> const& camera_models,
-                                         double min_angle_radians,
-                                         double forced_triangulation_distance,
-                                         vw::BathyData const& bathy_data) {
+// Triangulate the points of a control network of either kind, with the
+// given function for each point. Do not triangulate GCP or points
+// constrained to a DEM.
+template <class TypeFunc, class TriangulateFunc>
+void triangulatePoints(size_t num_points, TypeFunc point_type,
+                       TriangulateFunc triangulate_point) {
 
   Stopwatch watch;
   watch.start();
@@ -200,16 +203,15 @@ void vw::ba::triangulate_control_network(vw::ba::ControlNetwork& cnet,
   std::int64_t num_total_points = 0, num_failed_points = 0;
   TerminalProgressCallback progress("ba", "Triangulating: ");
   progress.report_progress(0);
-  double inc_prog = 1.0/double(cnet.size());
-  for (auto& cpoint : cnet) {
+  double inc_prog = 1.0/double(num_points);
+  for (size_t i = 0; i < num_points; i++) {
     progress.report_incremental_progress(inc_prog);
 
-    if (cpoint.type() == ControlPoint::GroundControlPoint ||
-        cpoint.type() == ControlPoint::PointFromDem)
+    if (point_type(i) == ControlPoint::GroundControlPoint ||
+        point_type(i) == ControlPoint::PointFromDem)
       continue; // Skip GCPs and points from a DEM
 
-    int ans = ba::triangulate_control_point(cpoint, camera_models, min_angle_radians,
-                                            forced_triangulation_distance, bathy_data);
+    int ans = triangulate_point(i);
     num_total_points++;
     if (ans < 0)
       num_failed_points++;
@@ -234,75 +236,194 @@ void vw::ba::triangulate_control_network(vw::ba::ControlNetwork& cnet,
   watch.stop();
   vw_out() << "Triangulating the control network took " << watch.elapsed_seconds()
     << " seconds.\n";
+}
 
-  return;
+// Triangulate the points in a control network. Do not triangulate
+// GCP or points constrained to a DEM. 
+void vw::ba::triangulate_control_network(vw::ba::ControlNetwork& cnet,
+                                         std::vector<vw::CamPtr> const& camera_models,
+                                         double min_angle_radians,
+                                         double forced_triangulation_distance,
+                                         vw::BathyData const& bathy_data) {
+  triangulatePoints(cnet.size(),
+                    [&](size_t i) { return cnet[i].type(); },
+                    [&](size_t i) {
+                      return ba::triangulate_control_point(cnet[i], camera_models,
+                                                           min_angle_radians,
+                                                           forced_triangulation_distance,
+                                                           bathy_data);
+                    });
+}
+
+// The same for a compact network. Each point is formed to be
+// triangulated, and its position and ignore flag are copied back.
+void vw::ba::triangulate_control_network(vw::ba::CompactControlNetwork& cnet,
+                                         std::vector<vw::CamPtr> const& camera_models,
+                                         double min_angle_radians,
+                                         double forced_triangulation_distance,
+                                         vw::BathyData const& bathy_data) {
+  triangulatePoints(cnet.num_points(),
+                    [&](size_t i) { return cnet.point_type(i); },
+                    [&](size_t i) {
+                      ControlPoint cpoint = cnet.point(i);
+                      int ans = ba::triangulate_control_point(cpoint, camera_models,
+                                                              min_angle_radians,
+                                                              forced_triangulation_distance,
+                                                              bathy_data);
+                      cnet.set_point_position(i, cpoint.position());
+                      cnet.set_point_ignore(i, cpoint.ignore());
+                      return ans;
+                    });
 }
 
 // Notation
-typedef std::pair<std::vector<ip::InterestPoint>, std::vector<ip::InterestPoint>> MATCH_PAIR;
-typedef std::map<std::pair<int, int>, MATCH_PAIR> MATCH_MAP;
 typedef std::tuple<double, double, double> ipTriplet; // (ip.x, ip.y, ip.scale)
 
-// Convert the matches to the MVG format, so their track-building code can be used.
-void matchesToMvg(MATCH_MAP const& match_map,
-                  std::vector<std::map<ipTriplet, int>> const& keypoint_map,
-                  std::vector<std::vector<ipTriplet>> const& keypoint_vec,
-                  std::map<std::pair<int, int>, std::string> const& match_files,
-                  PairWiseMatches& mvg_match_map) {
+// The interest points of a match file, reduced to what goes into the control
+// network, and the matches between them as feature indices.
+struct MatchFileData {
+  std::pair<int, int> cid_pair;
+  std::string match_file;
+  size_t num_read, num_reduced;  // Before and after --max-pairwise-matches
+  bool rejected;                 // If it had fewer than --min-matches
+  std::vector<ipTriplet> left_ips, right_ips;
+  std::vector<IndMatch> matches;
+  std::exception_ptr error;
+  MatchFileData(): num_read(0), num_reduced(0), rejected(false) {}
+};
+
+// Read a match file and keep the location and scale of its interest points.
+void readMatchFile(MatchFileData & data, size_t min_matches,
+                   int max_pairwise_matches, bool matches_as_txt) {
+
+  std::vector<ip::InterestPoint> ip1, ip2;
+  ip::read_match_file(data.match_file, ip1, ip2, matches_as_txt);
+  data.num_read = ip1.size();
+  if (ip1.size() < min_matches) {
+    data.rejected = true;
+    return;
+  }
+
+  // Correct the scale
+  std::for_each(ip1.begin(), ip1.end(), safe_measurement);
+  std::for_each(ip2.begin(), ip2.end(), safe_measurement);
+  if (max_pairwise_matches >= 0 && (int)ip1.size() > max_pairwise_matches)
+    pick_pair_subset(ip1, ip2, max_pairwise_matches);
+  data.num_reduced = ip1.size();
+
+  data.left_ips.resize(ip1.size());
+  data.right_ips.resize(ip2.size());
+  for (size_t ip_it = 0; ip_it < ip1.size(); ip_it++) {
+    data.left_ips[ip_it]  = ipTriplet(ip1[ip_it].x, ip1[ip_it].y, ip1[ip_it].scale);
+    data.right_ips[ip_it] = ipTriplet(ip2[ip_it].x, ip2[ip_it].y, ip2[ip_it].scale);
+  }
+}
+
+// Give the distinct interest points of each image a feature index, in
+// the order of their location and scale. If an interest point is found
+// more than once, the first one found in the match files is kept. This
+// is done for the images in parallel, with sorted arrays.
+void assignFeatureIndices(std::vector<MatchFileData> const& match_data,
+                          int num_images, int num_threads,
+                          std::vector<std::vector<ipTriplet>> & keypoint_vec) {
+
+  // The match files with interest points in each image, and on which side
+  std::vector<std::vector<std::pair<size_t, bool>>> image_files(num_images);
+  for (size_t file_it = 0; file_it < match_data.size(); file_it++) {
+    if (match_data[file_it].rejected)
+      continue;
+    image_files[match_data[file_it].cid_pair.first ].push_back(std::make_pair(file_it, true));
+    image_files[match_data[file_it].cid_pair.second].push_back(std::make_pair(file_it, false));
+  }
+
+  keypoint_vec.clear();
+  keypoint_vec.resize(num_images);
+  process_in_parallel(num_images, num_threads, [&](size_t begin, size_t end) {
+    for (size_t cid = begin; cid < end; cid++) {
+      std::vector<ipTriplet> & keypoints = keypoint_vec[cid]; // alias
+      for (size_t it = 0; it < image_files[cid].size(); it++) {
+        MatchFileData const& data = match_data[image_files[cid][it].first];
+        std::vector<ipTriplet> const& ips
+          = image_files[cid][it].second ? data.left_ips : data.right_ips;
+        keypoints.insert(keypoints.end(), ips.begin(), ips.end());
+      }
+      // Stable, so that the first of the equivalent points is kept
+      std::stable_sort(keypoints.begin(), keypoints.end());
+      keypoints.erase(std::unique(keypoints.begin(), keypoints.end(),
+                                  [](ipTriplet const& a, ipTriplet const& b) {
+                                    return !(a < b);
+                                  }),
+                      keypoints.end());
+      keypoints.shrink_to_fit();
+    }
+  });
+}
+
+// The index of an interest point among the features of an image
+int featureIndex(std::vector<ipTriplet> const& keypoints, ipTriplet const& ip) {
+  auto it = std::lower_bound(keypoints.begin(), keypoints.end(), ip);
+  if (it == keypoints.end() || ip < *it)
+    vw::vw_throw(ArgumentErr() << "Bookkeeping error in featureIndex().\n");
+  return int(it - keypoints.begin());
+}
+
+// Convert the matches of each match file to feature indices, in parallel,
+// and collect them for each pair of images, in the order of the match files.
+void matchesToFeatures(std::vector<MatchFileData> & match_data,
+                       std::vector<std::vector<ipTriplet>> const& keypoint_vec,
+                       int num_threads,
+                       PairWiseMatches & mvg_match_map) {
 
   // Wipe the output
   mvg_match_map.clear();
 
-  for (auto it = match_map.begin(); it != match_map.end(); it++) {
-    std::pair<int, int> const& cid_pair = it->first;     // alias
-
-    int left_cid = cid_pair.first;
-    int right_cid = cid_pair.second;
+  process_in_parallel(match_data.size(), num_threads, [&](size_t begin, size_t end) {
+    for (size_t file_it = begin; file_it < end; file_it++) {
+      MatchFileData & data = match_data[file_it]; // alias
+      if (data.rejected)
+        continue;
+      try {
+        int left_cid  = data.cid_pair.first;
+        int right_cid = data.cid_pair.second;
+        data.matches.resize(data.left_ips.size());
+        for (size_t ip_it = 0; ip_it < data.left_ips.size(); ip_it++)
+          data.matches[ip_it] = IndMatch(featureIndex(keypoint_vec[left_cid],
+                                                      data.left_ips[ip_it]),
+                                         featureIndex(keypoint_vec[right_cid],
+                                                      data.right_ips[ip_it]));
+      } catch (...) {
+        data.error = std::current_exception();
+      }
+      // Deallocate data that is not needed anymore
+      data.left_ips  = std::vector<ipTriplet>();
+      data.right_ips = std::vector<ipTriplet>();
+    }
+  });
 
-    // Must not have left_cid == right_cid
-    if (left_cid == right_cid)
-      vw::vw_throw(ArgumentErr()
-                   << "Bookkeeping error: Cannot have matches from an image to itself.\n");
+  for (size_t file_it = 0; file_it < match_data.size(); file_it++) {
+    MatchFileData & data = match_data[file_it]; // alias
+    if (data.error)
+      std::rethrow_exception(data.error);
+    if (data.rejected)
+      continue;
 
     // This potential swap ensures that the pair is always ordered
     // in the same way. It results in almost the same results regardless
     // of the order of images vs order of matches.
-    bool swap = (left_cid > right_cid);
-    std::pair<int, int> out_pair = cid_pair;
-    if (swap)
-      out_pair = std::make_pair(right_cid, left_cid);
-
-    MATCH_PAIR const& match_pair = it->second;  // alias
-    std::vector<ip::InterestPoint> const& left_ip_vec = match_pair.first;
-    std::vector<ip::InterestPoint> const& right_ip_vec = match_pair.second;
-    std::vector<IndMatch> mvg_matches;
-    for (size_t ip_it = 0; ip_it < left_ip_vec.size(); ip_it++) {
-      auto dist_left_ip  = ipTriplet(left_ip_vec[ip_it].x, left_ip_vec[ip_it].y,
-                                      left_ip_vec[ip_it].scale);
-      auto dist_right_ip = ipTriplet(right_ip_vec[ip_it].x, right_ip_vec[ip_it].y,
-                                      right_ip_vec[ip_it].scale);
-
-      auto left_it = keypoint_map[left_cid].find(dist_left_ip);
-      if (left_it == keypoint_map[left_cid].end())
-        vw::vw_throw(ArgumentErr() << "Bookkeeping error in matchesToMvg().\n");
-      auto right_it = keypoint_map[right_cid].find(dist_right_ip);
-      if (right_it == keypoint_map[right_cid].end())
-        vw::vw_throw(ArgumentErr() << "Bookkeeping error in matchesToMvg().\n");
-      int left_fid = left_it->second;
-      int right_fid = right_it->second;
-
-      if (!swap)
-        mvg_matches.push_back(IndMatch(left_fid, right_fid));
-      else
-        mvg_matches.push_back(IndMatch(right_fid, left_fid));
+    bool swap = (data.cid_pair.first > data.cid_pair.second);
+    std::pair<int, int> out_pair = data.cid_pair;
+    if (swap) {
+      out_pair = std::make_pair(data.cid_pair.second, data.cid_pair.first);
+      for (size_t ip_it = 0; ip_it < data.matches.size(); ip_it++)
+        std::swap(data.matches[ip_it].m_left, data.matches[ip_it].m_right);
     }
 
-    // Append to vector mvg_match_map[out_pair] the vector mvg_matches.
-    // As such, can have both left-to-right and right-to-left matches.
-    mvg_match_map[out_pair].insert(mvg_match_map[out_pair].end(),
-                                   mvg_matches.begin(), mvg_matches.end());
+    // Append to vector mvg_match_map[out_pair] the matches. As such, can have
+    // both left-to-right and right-to-left matches.
+    std::vector<IndMatch> & out_matches = mvg_match_map[out_pair]; // alias
+    out_matches.insert(out_matches.end(), data.matches.begin(), data.matches.end());
+    data.matches = std::vector<IndMatch>();
   }
-
 }
 
 // Build tracks from pairwise matches. This logic was shown to be superior to the 
@@ -311,14 +432,34 @@ void matchesToMvg(MATCH_MAP const& match_map,
 // The terminology is as follows. Each track has the form: 
 //  {TrackIndex => {(imageIndex, featureIndex), ..., (imageIndex, featureIndex)}
 // Below, pid is the track id, cid is camera index, fid is feature index.
+// A match joins the tracks of its features only if at most one is in a track,
+// so the tracks depend on the order of the matches, and are built serially.
+// The track of each feature is looked up in a flat array.
 void buildTracks(PairWiseMatches const& mvg_match_map,
-                   TrackMap & pid_cid_fid) {
+                 std::vector<std::vector<ipTriplet>> const& keypoint_vec,
+                 TrackList & pid_cid_fid) {
 
   // Wipe the output
   pid_cid_fid.clear();
 
-  // This alternative bookkeeping helps lookup a track based on cid.
-  std::map<int, std::map<int, int>> cid_fid_pid;
+  // This alternative bookkeeping helps lookup a track based on cid and fid.
+  std::vector<std::vector<int>> cid_fid_pid(keypoint_vec.size());
+  for (size_t cid = 0; cid < keypoint_vec.size(); cid++)
+    cid_fid_pid[cid].assign(keypoint_vec[cid].size(), -1);
+
+  // Add a feature to a track. A track has at most one feature per image,
+  // the last one added.
+  auto add_to_track = [&](int pid, int cid, int fid) {
+    cid_fid_pid[cid][fid] = pid;
+    std::vector<std::pair<int, int>> & track = pid_cid_fid[pid]; // alias
+    for (size_t it = 0; it < track.size(); it++) {
+      if (track[it].first == cid) {
+        track[it].second = fid;
+        return;
+      }
+    }
+    track.push_back(std::make_pair(cid, fid));
+  };
 
   // In mvg_match_map we have cid pairs as keys. For each such pair, we have fid pairs.
   for (auto it = mvg_match_map.begin(); it != mvg_match_map.end(); it++) {
@@ -331,23 +472,9 @@ void buildTracks(PairWiseMatches const& mvg_match_map,
       int left_fid = mvg_matches[ip_it].m_left;
       int right_fid = mvg_matches[ip_it].m_right;
 
-      // See if the left feature is already in a track
-      auto left_cid_it = cid_fid_pid.find(left_cid);
-      int left_pid = -1;
-      if (left_cid_it != cid_fid_pid.end()) {
-        auto left_fid_it = left_cid_it->second.find(left_fid);
-        if (left_fid_it != left_cid_it->second.end())
-          left_pid = left_fid_it->second;
-      }
-
-      // See if the right feature is already in a track
-      auto right_cid_it = cid_fid_pid.find(right_cid);
-      int right_pid = -1;
-      if (right_cid_it != cid_fid_pid.end()) {
-        auto right_fid_it = right_cid_it->second.find(right_fid);
-        if (right_fid_it != right_cid_it->second.end())
-          right_pid = right_fid_it->second;
-      }
+      // See if the left and right features are already in a track
+      int left_pid  = cid_fid_pid[left_cid][left_fid];
+      int right_pid = cid_fid_pid[right_cid][right_fid];
 
       // If both left and right features are in some track, two options exist.
       // Either they are in the same track, then nothing to do. Or they are in
@@ -360,38 +487,112 @@ void buildTracks(PairWiseMatches const& mvg_match_map,
       // If the left feature is in a track, but the right one is not, add it to
       // the left feature track.
       if (left_pid >= 0 && right_pid < 0) {
-        cid_fid_pid[right_cid][right_fid] = left_pid;
-        pid_cid_fid[left_pid][right_cid] = right_fid;
+        add_to_track(left_pid, right_cid, right_fid);
         continue;
       }
 
       // If the right feature is in a track, but the left one is not, add it to
       // the right feature track.
       if (left_pid < 0 && right_pid >= 0) {
-        cid_fid_pid[left_cid][left_fid] = right_pid;
-        pid_cid_fid[right_pid][left_cid] = left_fid;
+        add_to_track(right_pid, left_cid, left_fid);
         continue;
       }
 
       // If neither feature is in a track, create a new track.
-      if (left_pid < 0 && right_pid < 0) {
-        int pid = pid_cid_fid.size(); // one past the last existing pid
-        cid_fid_pid[left_cid][left_fid] = pid;
-        cid_fid_pid[right_cid][right_fid] = pid;
-        pid_cid_fid[pid][left_cid] = left_fid;
-        pid_cid_fid[pid][right_cid] = right_fid;
-      }
+      int pid = pid_cid_fid.size(); // one past the last existing pid
+      pid_cid_fid.push_back(std::vector<std::pair<int, int>>());
+      add_to_track(pid, left_cid, left_fid);
+      add_to_track(pid, right_cid, right_fid);
     }
   }
 
   return;
 }
 
-// Create tracks and a cnet from matches. Return false if the cnet is empty.
-bool matchMapToCnet(std::vector<std::string> const& image_files,
-                    std::vector<std::vector<ipTriplet>> const& keypoint_vec,
-                    PairWiseMatches const& mvg_match_map,
-                    vw::ba::ControlNetwork& cnet) {
+// Read the match files in parallel, keeping only the location and scale of
+// the interest points, and report how many matches were kept.
+void loadMatchFiles(std::map<std::pair<int, int>, std::string> const& match_files,
+                    size_t min_matches, int max_pairwise_matches,
+                    bool matches_as_txt, int num_threads,
+                    std::vector<MatchFileData> & match_data) {
+
+  match_data.assign(match_files.size(), MatchFileData());
+  size_t file_it = 0;
+  for (auto it = match_files.begin(); it != match_files.end(); it++, file_it++) {
+    match_data[file_it].cid_pair = it->first;
+    match_data[file_it].match_file = it->second;
+  }
+
+  process_in_parallel(match_data.size(), num_threads, [&](size_t begin, size_t end) {
+    for (size_t it = begin; it < end; it++) {
+      try {
+        readMatchFile(match_data[it], min_matches, max_pairwise_matches, matches_as_txt);
+      } catch (...) {
+        match_data[it].error = std::current_exception();
+      }
+    }
+  });
+
+  size_t num_load_rejected = 0, num_loaded = 0;
+  for (size_t it = 0; it < match_data.size(); it++) {
+    MatchFileData const& data = match_data[it]; // alias
+    if (data.error)
+      std::rethrow_exception(data.error);
+    if (data.rejected) {
+      vw_out(DebugMessage,"ba") << "\tRejecting " << data.match_file << " with "
+                                << data.num_read << " matches.\n";
+      num_load_rejected += data.num_read;
+      continue;
+    }
+    // Must not have left_cid == right_cid
+    if (data.cid_pair.first == data.cid_pair.second)
+      vw::vw_throw(ArgumentErr()
+                   << "Bookkeeping error: Cannot have matches from an image to itself.\n");
+    vw_out() << "Match file " << data.match_file << " has " << data.num_read << " matches.\n";
+    if (data.num_reduced < data.num_read)
+      vw_out() << "Reducing the number of matches to: " << max_pairwise_matches << ".\n";
+    num_loaded += data.num_reduced;
+  }
+
+  if (num_load_rejected != 0)
+    vw_out(WarningMessage,"ba")
+      << "Did not load a total of " << num_load_rejected << " matches due to "
+      << "pairwise application of the --min-matches parameter. Decrease this "
+      << "to load smaller sets of matches.\n";
+  vw_out() << "Loaded " << num_loaded << " matches from all files.\n";
+}
+
+// Make the tracks of the loaded matches, with the features of each track in
+// the order of the images. The match data is freed along the way.
+void matchesToTracks(std::vector<MatchFileData> & match_data, int num_images,
+                     int num_threads,
+                     std::vector<std::vector<ipTriplet>> & keypoint_vec,
+                     TrackList & pid_cid_fid) {
+
+  // Give all interest points in a given image a unique id, and put
+  // them in a vector with the id corresponding to the interest point
+  assignFeatureIndices(match_data, num_images, num_threads, keypoint_vec);
+
+  // Convert the matches to the MVG format, so their track-building code can be used.
+  PairWiseMatches mvg_match_map;
+  matchesToFeatures(match_data, keypoint_vec, num_threads, mvg_match_map);
+
+  // Deallocate data that is not needed anymore
+  match_data = std::vector<MatchFileData>();
+
+  // If feature A in image I matches feather B in image J, which matches feature
+  // C in image K, then (A, B, C) belong together in a track, and will have a
+  // single triangulated xyz. Build such tracks.
+  buildTracks(mvg_match_map, keypoint_vec, pid_cid_fid);
+  for (size_t pid = 0; pid < pid_cid_fid.size(); pid++)
+    std::sort(pid_cid_fid[pid].begin(), pid_cid_fid[pid].end());
+}
+
+// Create a cnet from tracks. Return false if the cnet is empty.
+bool tracksToCnet(std::vector<std::string> const& image_files,
+                  std::vector<std::vector<ipTriplet>> const& keypoint_vec,
+                  TrackList & pid_cid_fid,
+                  vw::ba::ControlNetwork& cnet) {
 
   // Wipe fully the network. This does not allow passing a name to it, but that
   // looks unnecessary.
@@ -402,21 +603,17 @@ bool matchMapToCnet(std::vector<std::string> const& image_files,
   for (int i = 0; i < num_images; i++)
     cnet.add_image_name(image_files[i]);
 
-  // If feature A in image I matches feather B in image J, which matches feature
-  // C in image K, then (A, B, C) belong together in a track, and will have a
-  // single triangulated xyz. Build such tracks.
-  TrackMap pid_cid_fid;
-  buildTracks(mvg_match_map, pid_cid_fid);
-
   if (pid_cid_fid.empty())
     return false;
 
-  // Convert to the control network format. Will triangulate later.
-  for (auto pid = pid_cid_fid.begin(); pid != pid_cid_fid.end(); pid++) {
+  // Convert to the control network format, with the measures in the order of
+  // the images. Will triangulate later.
+  for (size_t pid = 0; pid < pid_cid_fid.size(); pid++) {
+    std::vector<std::pair<int, int>> & track = pid_cid_fid[pid]; // alias
     ControlPoint cpoint(ControlPoint::TiePoint);
-    for (auto cid_fid = (pid->second).begin(); cid_fid != (pid->second).end(); cid_fid++) {
-      int cid = cid_fid->first;
-      int fid = cid_fid->second;
+    for (size_t it = 0; it < track.size(); it++) {
+      int cid = track[it].first;
+      int fid = track[it].second;
       auto const& dist_ip = keypoint_vec.at(cid).at(fid);
       cpoint.add_measure(ControlMeasure(std::get<0>(dist_ip), // x position
                                         std::get<1>(dist_ip), // y position
@@ -427,116 +624,84 @@ bool matchMapToCnet(std::vector<std::string> const& image_files,
 
     if (cpoint.size() > 0)
       cnet.add_control_point(cpoint);
+    track = std::vector<std::pair<int, int>>();
   }
 
   return true;
 }
 
-bool vw::ba::build_control_network(bool triangulate_control_points,
-                                   ba::ControlNetwork& cnet,
-                                   std::vector<vw::CamPtr> const& camera_models,
-                                   std::vector<std::string> const& image_files,
-                                   std::map<std::pair<int, int>, std::string> const& match_files,
-                                   size_t min_matches,
-                                   double min_angle_radians,
-                                   double forced_triangulation_distance,
-                                   int max_pairwise_matches,
-                                   bool matches_as_txt,
-                                   vw::BathyData const& bathy_data) {
-
-  // TODO(oalexan1): Must be able to handle the case when the matches
-  // are from an image later in the list to an image earlier in the list.
-
-  MATCH_MAP match_map;
-
-  // Give all interest points in a given image a unique id, and put
-  // them in a vector with the id corresponding to the interest point
-  int num_images = image_files.size();
-  std::vector<std::map<ipTriplet, int>> keypoint_map(num_images);
-  size_t num_load_rejected = 0, num_loaded = 0;
-  for (auto it = match_files.begin(); it != match_files.end(); it++) {
-    std::pair<int, int> pair_ind = it->first;
-    std::string const& match_file = it->second; // alias
-    int index1 = pair_ind.first;
-    int index2 = pair_ind.second;
-    // Actually read in the file as it seems we've found something correct
-    std::vector<ip::InterestPoint> ip1, ip2;
-    // vw_out() << "Loading: " << match_file << "\n";
-    ip::read_match_file(match_file, ip1, ip2, matches_as_txt);
-    if (ip1.size() < min_matches) {
-      vw_out(DebugMessage,"ba") << "\tRejecting " << match_file << " with "
-                                << ip1.size() << " matches.\n";
-      num_load_rejected += ip1.size();
+// The same, filling the arrays of a compact cnet without forming the points
+bool tracksToCnet(std::vector<std::string> const& image_files,
+                  std::vector<std::vector<ipTriplet>> const& keypoint_vec,
+                  TrackList & pid_cid_fid,
+                  vw::ba::CompactControlNetwork& cnet) {
+
+  size_t num_measures = 0;
+  for (size_t pid = 0; pid < pid_cid_fid.size(); pid++)
+    num_measures += pid_cid_fid[pid].size();
+
+  std::vector<size_t> point_offsets(1, 0);
+  std::vector<uint32> image_ids;
+  std::vector<float32> positions, sigmas;
+  point_offsets.reserve(pid_cid_fid.size() + 1);
+  image_ids.reserve(num_measures);
+  positions.reserve(2*num_measures);
+  sigmas.reserve(2*num_measures);
+  for (size_t pid = 0; pid < pid_cid_fid.size(); pid++) {
+    std::vector<std::pair<int, int>> & track = pid_cid_fid[pid]; // alias
+    if (track.empty())
       continue;
+    for (size_t it = 0; it < track.size(); it++) {
+      int cid = track[it].first;
+      int fid = track[it].second;
+      auto const& dist_ip = keypoint_vec.at(cid).at(fid);
+      image_ids.push_back(cid);
+      positions.push_back(std::get<0>(dist_ip));
+      positions.push_back(std::get<1>(dist_ip));
+      sigmas.push_back(std::get<2>(dist_ip));
+      sigmas.push_back(std::get<2>(dist_ip));
     }
-    
-    vw_out() << "Match file " << match_file << " has " << ip1.size() << " matches.\n";
-
-    // Remove descriptors from interest points and correct scale
-    std::for_each(ip1.begin(), ip1.end(), ip::remove_descriptor);
-    std::for_each(ip2.begin(), ip2.end(), ip::remove_descriptor);
-    std::for_each(ip1.begin(), ip1.end(), safe_measurement);
-    std::for_each(ip2.begin(), ip2.end(), safe_measurement);
-
-    if (max_pairwise_matches >= 0 && (int)ip1.size() > max_pairwise_matches) {
-      vw_out() << "Reducing the number of matches to: " << max_pairwise_matches << ".\n";
-      pick_pair_subset(ip1, ip2, max_pairwise_matches);
-    }
-
-    num_loaded += ip1.size();
-
-    // Initialize the keypoint map to zero. Will populate the entities later.
-    for (size_t ip_it = 0; ip_it < ip1.size(); ip_it++) {
-      auto dist_left_ip  = ipTriplet(ip1[ip_it].x, ip1[ip_it].y, ip1[ip_it].scale);
-      auto dist_right_ip = ipTriplet(ip2[ip_it].x, ip2[ip_it].y, ip2[ip_it].scale);
-      keypoint_map[index1][dist_left_ip] = 0;
-      keypoint_map[index2][dist_right_ip] = 0;
-    }
+    point_offsets.push_back(image_ids.size());
+    track = std::vector<std::pair<int, int>>();
+  }
 
-    // Save the matches after getting a subset
-    match_map[pair_ind] = std::make_pair(ip1, ip2);
-  } // End loop through match files
+  cnet = ba::CompactControlNetwork(image_files, std::move(point_offsets),
+                                   std::move(image_ids), std::move(positions),
+                                   std::move(sigmas));
+  return cnet.num_points() > 0;
+}
 
-  if (num_load_rejected != 0)
-    vw_out(WarningMessage,"ba")
-      << "Did not load a total of " << num_load_rejected << " matches due to "
-      << "pairwise application of the --min-matches parameter. Decrease this "
-      << "to load smaller sets of matches.\n";
-  vw_out() << "Loaded " << num_loaded << " matches from all files.\n";
+// Load the matches, build the tracks, and make a cnet of either kind from them
+template <class CNetT>
+bool buildControlNetwork(bool triangulate_control_points,
+                         CNetT& cnet,
+                         std::vector<vw::CamPtr> const& camera_models,
+                         std::vector<std::string> const& image_files,
+                         std::map<std::pair<int, int>, std::string> const& match_files,
+                         size_t min_matches,
+                         double min_angle_radians,
+                         double forced_triangulation_distance,
+                         int max_pairwise_matches,
+                         bool matches_as_txt,
+                         vw::BathyData const& bathy_data) {
+
+  int num_threads = vw_settings().default_num_threads();
+  std::vector<MatchFileData> match_data;
+  loadMatchFiles(match_files, min_matches, max_pairwise_matches, matches_as_txt,
+                 num_threads, match_data);
 
   Stopwatch watch;
   watch.start();
 
   std::vector<std::vector<ipTriplet>> keypoint_vec; // for direct access later
-  keypoint_vec.resize(num_images);
-  for (size_t cid = 0; cid < num_images; cid++) {
-    keypoint_vec[cid].resize(keypoint_map[cid].size());
-    int fid = 0;
-    for (auto ip_it = keypoint_map[cid].begin(); ip_it != keypoint_map[cid].end();
-         ip_it++) {
-      auto& dist_ip = ip_it->first;  // alias
-      keypoint_map[cid][dist_ip] = fid;
-      keypoint_vec[cid][fid] = dist_ip;
-      fid++;
-    }
-  }
+  TrackList pid_cid_fid;
+  matchesToTracks(match_data, image_files.size(), num_threads, keypoint_vec, pid_cid_fid);
 
-  // Convert the matches to the MVG format, so their track-building code can be used.
-  PairWiseMatches mvg_match_map;
-  matchesToMvg(match_map, keypoint_map, keypoint_vec, match_files, mvg_match_map);
-
-  // Deallocate data that is not needed anymore
-  match_map = MATCH_MAP();
-  keypoint_map = std::vector<std::map<ipTriplet, int>>();
-
-  // Build the tracks and the control network using MVG
-  bool ans = matchMapToCnet(image_files, keypoint_vec, mvg_match_map, cnet);
+  // Build the control network from the tracks
+  bool ans = tracksToCnet(image_files, keypoint_vec, pid_cid_fid, cnet);
   if (!ans)
    return false;
 
-  // Wipe this, no longer needed
-  mvg_match_map.clear();
-
   watch.stop();
   vw_out() << "Building the control network took " << watch.elapsed_seconds()
     << " seconds.\n";
@@ -549,6 +714,40 @@ bool vw::ba::build_control_network(bool triangulate_control_points,
   return true;
 }
 
+bool vw::ba::build_control_network(bool triangulate_control_points,
+                                   ba::ControlNetwork& cnet,
+                                   std::vector<vw::CamPtr> const& camera_models,
+                                   std::vector<std::string> const& image_files,
+                                   std::map<std::pair<int, int>, std::string> const& match_files,
+                                   size_t min_matches,
+                                   double min_angle_radians,
+                                   double forced_triangulation_distance,
+                                   int max_pairwise_matches,
+                                   bool matches_as_txt,
+                                   vw::BathyData const& bathy_data) {
+  return buildControlNetwork(triangulate_control_points, cnet, camera_models,
+                             image_files, match_files, min_matches, min_angle_radians,
+                             forced_triangulation_distance, max_pairwise_matches,
+                             matches_as_txt, bathy_data);
+}
+
+bool vw::ba::build_control_network(bool triangulate_control_points,
+                                   ba::CompactControlNetwork& cnet,
+                                   std::vector<vw::CamPtr> const& camera_models,
+                                   std::vector<std::string> const& image_files,
+                                   std::map<std::pair<int, int>, std::string> const& match_files,
+                                   size_t min_matches,
+                                   double min_angle_radians,
+                                   double forced_triangulation_distance,
+                                   int max_pairwise_matches,
+                                   bool matches_as_txt,
+                                   vw::BathyData const& bathy_data) {
+  return buildControlNetwork(triangulate_control_points, cnet, camera_models,
+                             image_files, match_files, min_matches, min_angle_radians,
+                             forced_triangulation_distance, max_pairwise_matches,
+                             matches_as_txt, bathy_data);
+}
+
 // A little function to parse the WKT
 bool parseDatum(std::string const& wkt, vw::cartography::Datum & datum) {
 
@@ -20,6 +20,7 @@
 #define __VW_BUNDLEADJUSTMENT_CONTROL_NETWORK_LOADER_H__
 
 #include <vw/BundleAdjustment/ControlNetwork.h>
+#include <vw/BundleAdjustment/CompactControlNetwork.h>
 #include <vw/Camera/CameraModel.h>
 #include <vw/Cartography/SimplePointImageManipulation.h>
 #include <vw/Cartography/Datum.h>
@@ -45,6 +46,21 @@ namespace ba {
                              int max_pairwise_matches,
                              bool matches_as_txt,
                              vw::BathyData const& bathy_data = vw::BathyData());
+
+  /// The same, making the compact form of the network directly from the
+  /// tracks, without forming a ControlPoint for each of them.
+  bool build_control_network(bool triangulate_points,
+                             CompactControlNetwork& cnet,
+                             std::vector<boost::shared_ptr<camera::CameraModel>>
+                             const& camera_models,
+                             std::vector<std::string> const& image_files,
+                             std::map< std::pair<int, int>, std::string> const& match_files,
+                             size_t min_matches,
+                             double min_angle_radians,
+                             double forced_triangulation_distance,
+                             int max_pairwise_matches,
+                             bool matches_as_txt,
+                             vw::BathyData const& bathy_data = vw::BathyData());
   
   // Triangulate the points in a control network. Do not triangulate
   // GCP or points constrained to a DEM.
@@ -54,6 +70,12 @@ namespace ba {
                                    double min_angle_radians,
                                    double forced_triangulation_distance,
                                    vw::BathyData const& bathy_data = vw::BathyData());
+  void triangulate_control_network(vw::ba::CompactControlNetwork& cnet,
+                                   std::vector<boost::shared_ptr<camera::CameraModel>>
+                                   const& camera_models,
+                                   double min_angle_radians,
+                                   double forced_triangulation_distance,
+                                   vw::BathyData const& bathy_data = vw::BathyData());
 
   /// Recomputes the world location of a point based on camera observations.
   /// - Returns the mean triangulation error.
@@ -0,0 +1,154 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <gtest/gtest_VW.h>
+
+#include <vw/BundleAdjustment/CompactControlNetwork.h>
+
+#include <test/Helpers.h>
+
+using namespace vw;
+using namespace vw::ba;
+
+TEST( CompactControlNetwork, Layout ) {
+
+  // Point i is seen in images i, i+1, ..., 2i
+  ControlNetwork cnet( "TestCNET" );
+  cnet.add_image_name( "a.tif" );
+  cnet.add_image_name( "b.tif" );
+  for ( uint32 i = 0; i < 4; i++ ) {
+    ControlPoint cpoint( i == 2 ? ControlPoint::GroundControlPoint : ControlPoint::TiePoint );
+    cpoint.set_position( Vector3( i, 2*i, 3*i ) );
+    cpoint.set_sigma( Vector3( 1, 2, i+1 ) );
+    cpoint.set_ignore( i == 1 );
+    for ( uint32 j = i; j <= 2*i; j++ ) {
+      ControlMeasure cm( 10*i, 10*j, 1, 0.5, j );
+      cm.set_ignore( i == 3 && j == 4 );
+      cpoint.add_measure( cm );
+    }
+    cnet.add_control_point( cpoint );
+  }
+
+  CompactControlNetwork compact( cnet, 2 );
+  ASSERT_EQ( compact.num_points(), 4u );
+  ASSERT_EQ( compact.num_measures(), 10u );
+  ASSERT_EQ( compact.num_images(), 7u ); // From the largest image ID
+  EXPECT_EQ( compact.type(), ControlNetwork::ImageToGround );
+  EXPECT_EQ( compact.get_image_list().size(), 2u );
+
+  for ( size_t i = 0; i < 4; i++ ) {
+    EXPECT_VECTOR_DOUBLE_EQ( compact.point_position(i), cnet[i].position() );
+    EXPECT_VECTOR_DOUBLE_EQ( compact.point_sigma(i), cnet[i].sigma() );
+    EXPECT_EQ( compact.point_type(i), cnet[i].type() );
+    EXPECT_EQ( compact.point_ignore(i), cnet[i].ignore() );
+    ASSERT_EQ( compact.num_measures(i), cnet[i].size() );
+    for ( size_t k = 0; k < cnet[i].size(); k++ ) {
+      size_t m = compact.measures_begin(i) + k;
+      EXPECT_EQ( compact.measure_point(m), i );
+      EXPECT_EQ( compact.measure_image_id(m), cnet[i][k].image_id() );
+      EXPECT_VECTOR_DOUBLE_EQ( compact.measure_position(m), cnet[i][k].position() );
+      EXPECT_VECTOR_DOUBLE_EQ( compact.measure_sigma(m), cnet[i][k].sigma() );
+      EXPECT_EQ( compact.measure_ignore(m), cnet[i][k].ignore() );
+    }
+  }
+
+  // Image 3 is seen by points 2 and 3, in that order, and image 0 only
+  // by point 0
+  ASSERT_EQ( compact.image_measures_end(3) - compact.image_measures_begin(3), 2u );
+  EXPECT_EQ( compact.measure_point( compact.image_measure( compact.image_measures_begin(3)   ) ), 2u );
+  EXPECT_EQ( compact.measure_point( compact.image_measure( compact.image_measures_begin(3)+1 ) ), 3u );
+  ASSERT_EQ( compact.image_measures_end(0) - compact.image_measures_begin(0), 1u );
+  EXPECT_EQ( compact.image_measure( compact.image_measures_begin(0) ), 0u );
+  for ( size_t image = 0; image < compact.num_images(); image++ )
+    for ( size_t k = compact.image_measures_begin(image); k < compact.image_measures_end(image); k++ )
+      EXPECT_EQ( compact.measure_image_id( compact.image_measure(k) ), image );
+}
+
+TEST( CompactControlNetwork, RoundTrip ) {
+
+  ControlNetwork cnet( "TestCNET" );
+  cnet.add_image_name( "a.tif" );
+  cnet.add_image_name( "b.tif" );
+  for ( uint32 i = 0; i < 3; i++ ) {
+    ControlPoint cpoint;
+    cpoint.set_id( "point" );
+    cpoint.set_position( Vector3( i, i, i ) );
+    cpoint.add_measure( ControlMeasure( i, 1, 1, 1, 0 ) );
+    cpoint.add_measure( ControlMeasure( i, 2, 1, 1, 1 ) );
+    cnet.add_control_point( cpoint );
+  }
+
+  CompactControlNetwork compact( cnet );
+  compact.set_point_position( 1, Vector3( 5, 6, 7 ) );
+  compact.set_measure_ignore( compact.measures_begin(2) + 1, true );
+
+  ControlNetwork result( "Result" );
+  compact.to_control_network( result );
+  ASSERT_EQ( result.size(), 3u );
+  EXPECT_EQ( result.get_image_list(), cnet.get_image_list() );
+  EXPECT_EQ( result.type(), cnet.type() );
+  for ( size_t i = 0; i < 3; i++ ) {
+    EXPECT_EQ( result[i].id(), "point" );
+    ASSERT_EQ( result[i].size(), 2u );
+    for ( size_t k = 0; k < 2; k++ )
+      EXPECT_TRUE( result[i][k] == cnet[i][k] );
+  }
+  EXPECT_VECTOR_DOUBLE_EQ( result[0].position(), Vector3( 0, 0, 0 ) );
+  EXPECT_VECTOR_DOUBLE_EQ( result[1].position(), Vector3( 5, 6, 7 ) );
+  EXPECT_FALSE( result[2][0].ignore() );
+  EXPECT_TRUE ( result[2][1].ignore() );
+}
+
+TEST( CompactControlNetwork, FromMeasures ) {
+
+  // Two points, seen in images 0, 2 and in image 1
+  std::vector<std::string> names;
+  names.push_back( "a.tif" );
+  names.push_back( "b.tif" );
+  names.push_back( "c.tif" );
+  std::vector<size_t>  offsets   = { 0, 2, 3 };
+  std::vector<uint32>  image_ids = { 0, 2, 1 };
+  std::vector<float32> positions = { 1, 2, 3, 4, 5, 6 };
+  std::vector<float32> sigmas    = { 1, 1, 2, 2, 3, 3 };
+
+  CompactControlNetwork compact( names, offsets, image_ids, positions, sigmas );
+  ASSERT_EQ( compact.num_points(), 2u );
+  ASSERT_EQ( compact.num_measures(), 3u );
+  ASSERT_EQ( compact.num_images(), 3u );
+  EXPECT_EQ( compact.get_image_list(), names );
+  EXPECT_EQ( compact.type(), ControlNetwork::ImageToImage );
+
+  ControlPoint expected;
+  for ( size_t i = 0; i < 2; i++ ) {
+    ControlPoint cpoint = compact.point(i);
+    EXPECT_EQ( cpoint.type(), expected.type() );
+    EXPECT_EQ( cpoint.id(), expected.id() );
+    EXPECT_VECTOR_DOUBLE_EQ( cpoint.position(), expected.position() );
+    EXPECT_VECTOR_DOUBLE_EQ( cpoint.sigma(), expected.sigma() );
+    EXPECT_FALSE( cpoint.ignore() );
+  }
+  EXPECT_TRUE( compact.point(0)[1] == ControlMeasure( 3, 4, 2, 2, 2 ) );
+  EXPECT_TRUE( compact.point(1)[0] == ControlMeasure( 5, 6, 3, 3, 1 ) );
+  EXPECT_EQ( compact.measure_point(2), 1u );
+  EXPECT_EQ( compact.image_measure( compact.image_measures_begin(2) ), 1u );
+
+  // The sizes must agree
+  positions.pop_back();
+  EXPECT_THROW( CompactControlNetwork( names, offsets, image_ids, positions, sigmas ),
+                ArgumentErr );
+}
@@ -18,8 +18,11 @@
 
 #include <gtest/gtest_VW.h>
 
+#include <list>
 #include <sstream>
 #include <vw/BundleAdjustment/ControlNetworkLoader.h>
+#include <vw/InterestPoint/MatcherIO.h>
+#include <vw/Math/RandomSet.h>
 
 #include <test/Helpers.h>
 
@@ -94,3 +97,100 @@ TEST( GCPLoad, LoadingGCP ) {
   EXPECT_EQ(27, cnet.size());
 }
 
+
+TEST( ControlNetworkLoad, BuildFromMatches ) {
+
+  std::vector<std::string> image_files;
+  image_files.push_back("a.tif");
+  image_files.push_back("b.tif");
+  image_files.push_back("c.tif");
+  image_files.push_back("d.tif");
+
+  // Write a match file and list it. The names are in a list, so they are
+  // not copied, which would remove the files.
+  std::list<UnlinkName> names;
+  std::map<std::pair<int, int>, std::string> match_files;
+  auto add_file = [&](int left, int right, std::vector<ip::InterestPoint> const& ip1,
+                      std::vector<ip::InterestPoint> const& ip2) {
+    std::ostringstream os;
+    os << "cnet_load_" << left << "_" << right << ".match";
+    names.emplace_back(os.str());
+    ip::write_binary_match_file(names.back(), ip1, ip2);
+    match_files[std::make_pair(left, right)] = names.back();
+  };
+  typedef ip::InterestPoint IP;
+
+  // The second point has no scale, so gets the default of 10
+  add_file(0, 1, {IP(1, 1, 1), IP(2, 2, 0)}, {IP(11, 1, 1), IP(12, 2, 1)});
+  // From a later image to an earlier one. Its first point in b.tif is
+  // the same as in the file above, so c.tif joins that track.
+  add_file(2, 1, {IP(21, 1, 2), IP(23, 3, 2)}, {IP(11, 1, 1), IP(13, 3, 1)});
+  // More matches than allowed, so a subset is kept
+  std::vector<IP> c_ips, d_ips;
+  for (int k = 0; k < 6; k++) {
+    c_ips.push_back(IP(30 + k, 5, 3));
+    d_ips.push_back(IP(40 + k, 5, 4));
+  }
+  add_file(2, 3, c_ips, d_ips);
+  // Too few matches, so not loaded. That includes one from an image to
+  // itself, which is not an error then.
+  add_file(0, 3, {IP(99, 99, 1)}, {IP(98, 98, 1)});
+  add_file(3, 3, {IP(97, 97, 1)}, {IP(96, 96, 1)});
+
+  size_t min_matches = 2;
+  int max_pairwise_matches = 4;
+  ControlNetwork cnet("test");
+  std::vector<boost::shared_ptr<camera::CameraModel>> cameras;
+  ASSERT_TRUE(build_control_network(false, cnet, cameras, image_files, match_files,
+                                    min_matches, 0, 0, max_pairwise_matches, false));
+
+  // The tracks, in the order they are made, with their measures in the
+  // order of the images
+  std::vector<std::vector<ControlMeasure>> expected;
+  expected.push_back({ControlMeasure(1, 1, 1, 1, 0), ControlMeasure(11, 1, 1, 1, 1),
+                      ControlMeasure(21, 1, 2, 2, 2)});
+  expected.push_back({ControlMeasure(2, 2, 10, 10, 0), ControlMeasure(12, 2, 1, 1, 1)});
+  expected.push_back({ControlMeasure(13, 3, 1, 1, 1), ControlMeasure(23, 3, 2, 2, 2)});
+  std::vector<int> subset;
+  math::pick_random_indices_in_range(6, max_pairwise_matches, subset);
+  std::sort(subset.begin(), subset.end());
+  for (size_t it = 0; it < subset.size(); it++)
+    expected.push_back({ControlMeasure(30 + subset[it], 5, 3, 3, 2),
+                        ControlMeasure(40 + subset[it], 5, 4, 4, 3)});
+
+  EXPECT_EQ(image_files, cnet.get_image_list());
+  ASSERT_EQ(expected.size(), cnet.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(ControlPoint::TiePoint, cnet[i].type());
+    ASSERT_EQ(expected[i].size(), cnet[i].size());
+    for (size_t k = 0; k < expected[i].size(); k++)
+      EXPECT_TRUE(expected[i][k] == cnet[i][k]) << "point " << i << " measure " << k;
+  }
+
+  // The compact network made directly is the same
+  CompactControlNetwork compact;
+  ASSERT_TRUE(build_control_network(false, compact, cameras, image_files, match_files,
+                                    min_matches, 0, 0, max_pairwise_matches, false));
+  EXPECT_EQ(image_files, compact.get_image_list());
+  EXPECT_EQ(cnet.type(), compact.type());
+  ASSERT_EQ(expected.size(), compact.num_points());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ControlPoint cpoint = compact.point(i);
+    EXPECT_EQ(ControlPoint::TiePoint, cpoint.type());
+    EXPECT_EQ(cnet[i].id(), cpoint.id());
+    EXPECT_VECTOR_DOUBLE_EQ(cnet[i].position(), cpoint.position());
+    EXPECT_VECTOR_DOUBLE_EQ(cnet[i].sigma(), cpoint.sigma());
+    EXPECT_EQ(cnet[i].ignore(), cpoint.ignore());
+    ASSERT_EQ(expected[i].size(), cpoint.size());
+    for (size_t k = 0; k < expected[i].size(); k++)
+      EXPECT_TRUE(expected[i][k] == cpoint[k]) << "point " << i << " measure " << k;
+  }
+  ASSERT_EQ(subset.size(), compact.image_measures_end(3) - compact.image_measures_begin(3));
+  EXPECT_EQ(3u, compact.measure_point(compact.image_measure(compact.image_measures_begin(3))));
+
+  // An image matched to itself is an error if the matches are loaded
+  add_file(1, 1, {IP(5, 5, 1), IP(6, 6, 1)}, {IP(7, 7, 1), IP(8, 8, 1)});
+  EXPECT_THROW(build_control_network(false, cnet, cameras, image_files, match_files,
+                                     min_matches, 0, 0, max_pairwise_matches, false),
+               ArgumentErr);
+}
@@ -19,6 +19,7 @@
 #include <vw/Core/Log.h>
 #include <vw/Camera/CAHVORModel.h>
 #include <vw/Camera/CAHVModel.h>
+#include <algorithm>
 #include <fstream>
 #include <boost/foreach.hpp>
 
@@ -295,15 +296,18 @@ Vector3 CAHVORModel::pixel_to_vector(Vector2 const& pix,
 
 // pixel_to_vector (no returned partial matrix)
 Vector3 CAHVORModel::pixel_to_vector(Vector2 const& pix) const {
+  // Check and optionally correct for vector directions.
+  return pixel_to_vector(pix, dot_prod(cross_prod(V,H), A) < 0);
+}
+
+Vector3 CAHVORModel::pixel_to_vector(Vector2 const& pix, bool flip) const {
   // Based on JPL_CMOD_CAHVOR_2D_TO_3D
 
   // Calculate the projection ray assuming normal vector directions,
   // neglecting distortion.
   Vector3 rr = normalize(cross_prod(V - pix.y() * A,
                                     H - pix.x() * A));
-
-  // Check and optionally correct for vector directions.
-  if (dot_prod(cross_prod(V,H), A) < 0)
+  if (flip)
     rr = -1.0 * rr;
 
   // Remove the radial lens distortion.  Preliminary values of
@@ -349,6 +353,18 @@ Vector3 CAHVORModel::pixel_to_vector(Vector2 const& pix) const {
 
 Vector3 CAHVORModel::camera_center( Vector2 const& pix ) const { return C; }
 
+void CAHVORModel::pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                    size_t num) const {
+  const bool flip = (dot_prod(cross_prod(V,H), A) < 0);
+  for (size_t i = 0; i < num; i++)
+    vectors[i] = pixel_to_vector(pixels[i], flip);
+}
+
+void CAHVORModel::camera_centers(Vector2 const* /*pixels*/, Vector3* centers,
+                                 size_t num) const {
+  std::fill(centers, centers + num, C);
+}
+
 // vector_to_pixel with partial_derivatives
 Vector2 CAHVORModel::point_to_pixel(Vector3 const& point,
                                     Matrix<double> &partial_derivatives) const {
@@ -447,6 +463,25 @@ Vector2 CAHVORModel::point_to_pixel(Vector3 const& point) const {
                   dot_prod(pp_c,V) / alpha );
 }
 
+// As point_to_pixel, with the model in local variables.
+void CAHVORModel::points_to_pixels(Vector3 const* points, Vector2* pixels,
+                                   size_t num) const {
+  const double c0 = C[0], c1 = C[1], c2 = C[2];
+  const double o0 = O[0], o1 = O[1], o2 = O[2];
+  const double r0 = R[0], r1 = R[1], r2 = R[2];
+  for (size_t i = 0; i < num; i++) {
+    const double v0 = points[i][0] - c0, v1 = points[i][1] - c1, v2 = points[i][2] - c2;
+    const double omega = v0*o0 + v1*o1 + v2*o2;
+    const double l0 = v0 - omega*o0, l1 = v1 - omega*o1, l2 = v2 - omega*o2;
+    const double tau = (l0*l0 + l1*l1 + l2*l2) / (omega*omega);
+    const double mu  = r0 + (r1 * tau) + (r2 * tau * tau);
+    const double p0 = v0 + mu*l0, p1 = v1 + mu*l1, p2 = v2 + mu*l2;
+    const double alpha = p0*A[0] + p1*A[1] + p2*A[2];
+    pixels[i] = Vector2((p0*H[0] + p1*H[1] + p2*H[2]) / alpha,
+                        (p0*V[0] + p1*V[1] + p2*V[2]) / alpha);
+  }
+}
+
 // linearize_camera
 //
 // Takes CAHVOR camera --> CAHV camera
@@ -65,6 +65,14 @@ namespace camera {
     virtual Vector3 pixel_to_vector(Vector2 const& pix) const;
     virtual Vector3 camera_center(Vector2 const& /*pix*/ = Vector2() ) const;
 
+    // Batch versions, which check the vector directions once per batch.
+    virtual void points_to_pixels (Vector3 const* points, Vector2* pixels,
+                                   size_t num) const;
+    virtual void pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                   size_t num) const;
+    virtual void camera_centers   (Vector2 const* pixels, Vector3* centers,
+                                   size_t num) const;
+
     // Overloaded versions also return partial derviatives in a Matrix.
     Vector2 point_to_pixel(Vector3 const& point, Matrix<double> &partial_derivatives) const;
     Vector3 pixel_to_vector(Vector2 const& pix, Matrix<double> &partial_derivatives) const;
@@ -85,6 +93,10 @@ namespace camera {
     Vector3   V;
     Vector3   O;
     Vector3   R;
+
+  private:
+    // pixel_to_vector, given whether the vector directions are flipped.
+    Vector3 pixel_to_vector(Vector2 const& pix, bool flip) const;
   };
 
   /// Function to "map" the CAHVOR parameters into CAHV parameters:
@@ -21,6 +21,7 @@
 #include <vw/Camera/CameraModel.h>
 
 #include <sstream>
+#include <vector>
 #include <iostream>
 
 
@@ -44,6 +45,39 @@ CameraModel::camera_pose(Vector2 const& pix) const {
   return Quaternion<double>();
 }
 
+void CameraModel::points_to_pixels(Vector3 const* points, Vector2* pixels,
+                                   size_t num) const {
+  for (size_t i = 0; i < num; i++) {
+    try {
+      pixels[i] = this->point_to_pixel(points[i]);
+    } catch (...) {
+      pixels[i] = invalid_pixel();
+    }
+  }
+}
+
+void CameraModel::pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                    size_t num) const {
+  for (size_t i = 0; i < num; i++) {
+    try {
+      vectors[i] = this->pixel_to_vector(pixels[i]);
+    } catch (...) {
+      vectors[i] = Vector3();
+    }
+  }
+}
+
+void CameraModel::camera_centers(Vector2 const* pixels, Vector3* centers,
+                                 size_t num) const {
+  for (size_t i = 0; i < num; i++) {
+    try {
+      centers[i] = this->camera_center(pixels[i]);
+    } catch (...) {
+      centers[i] = Vector3();
+    }
+  }
+}
+
 AdjustedCameraModel::AdjustedCameraModel(boost::shared_ptr<CameraModel> camera_model,
                                          Vector3 const& translation, Quat const& rotation,
                                          Vector2 const& pixel_offset, double scale) :
@@ -123,6 +157,45 @@ Quat AdjustedCameraModel::camera_pose(Vector2 const& pix) const {
   return m_rotation*m_camera->camera_pose(m_scale*pix + m_pixel_offset);
 }
 
+// The batch versions transform all the inputs, make one call to the
+// underlying camera, then transform all the outputs, keeping failures.
+
+void AdjustedCameraModel::points_to_pixels(Vector3 const* points, Vector2* pixels,
+                                           size_t num) const {
+  std::vector<Vector3> new_pts(num);
+  for (size_t i = 0; i < num; i++)
+    new_pts[i] = this->adjusted_point(points[i]);
+  m_camera->points_to_pixels(new_pts.data(), pixels, num);
+  for (size_t i = 0; i < num; i++) {
+    if (pixels[i] != invalid_pixel())
+      pixels[i] = (pixels[i] - m_pixel_offset)/m_scale;
+  }
+}
+
+void AdjustedCameraModel::pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                            size_t num) const {
+  std::vector<Vector2> old_pix(num);
+  for (size_t i = 0; i < num; i++)
+    old_pix[i] = m_scale*pixels[i] + m_pixel_offset;
+  m_camera->pixels_to_vectors(old_pix.data(), vectors, num);
+  Matrix3x3 R = m_rotation.rotation_matrix();
+  for (size_t i = 0; i < num; i++)
+    vectors[i] = R*vectors[i]; // a zero vector stays zero
+}
+
+void AdjustedCameraModel::camera_centers(Vector2 const* pixels, Vector3* centers,
+                                         size_t num) const {
+  std::vector<Vector2> old_pix(num);
+  for (size_t i = 0; i < num; i++)
+    old_pix[i] = m_scale*pixels[i] + m_pixel_offset;
+  m_camera->camera_centers(old_pix.data(), centers, num);
+  Matrix3x3 R = m_rotation.rotation_matrix();
+  for (size_t i = 0; i < num; i++) {
+    if (centers[i] != Vector3())
+      centers[i] = R*(centers[i] - m_rotation_center) + m_rotation_center + m_translation;
+  }
+}
+
 // Modify the adjustments by applying on top of them a scale*rotation + translation
 // transform with the origin at the center of the planet (such as output
 // by pc_align's forward or inverse computed alignment transform). 
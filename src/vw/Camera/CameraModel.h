@@ -91,6 +91,29 @@ namespace camera {
     /// Subclasses must define a method that return the camera type as a string.
     virtual std::string type() const = 0;
 
+    //------------------------------------------------------------------
+    // Batch Interface
+    //------------------------------------------------------------------
+
+    // These apply the functions above to arrays of num inputs, writing
+    // to output arrays of the same size. A point or pixel for which the
+    // single-point function would throw gives invalid_pixel() or a zero
+    // vector instead, so one bad input does not lose the batch. The
+    // default versions loop over the single-point functions. Subclasses
+    // override them to hoist the per-camera work out of the loop.
+
+    /// The pixels where the points are imaged.
+    virtual void points_to_pixels(Vector3 const* points, Vector2* pixels,
+                                  size_t num) const;
+
+    /// The pointing vectors through the pixels.
+    virtual void pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                   size_t num) const;
+
+    /// The camera centers for the pixels.
+    virtual void camera_centers(Vector2 const* pixels, Vector3* centers,
+                                size_t num) const;
+
     /// Returns the pose (as a quaternion) of the camera for a given
     /// pixel. It represents the rotation from the camera frame to world frame.
     /// - Generally the input pixel is only used for linescane cameras.
@@ -185,6 +208,13 @@ namespace camera {
     virtual Vector3 camera_center  (Vector2 const&) const;
     virtual Quat    camera_pose    (Vector2 const&) const;
 
+    virtual void points_to_pixels (Vector3 const* points, Vector2* pixels,
+                                   size_t num) const;
+    virtual void pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                   size_t num) const;
+    virtual void camera_centers   (Vector2 const* pixels, Vector3* centers,
+                                   size_t num) const;
+
     Vector3 adjusted_point(Vector3 const& point) const;
     
     boost::shared_ptr<CameraModel> unadjusted_model(){
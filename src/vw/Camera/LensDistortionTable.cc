@@ -0,0 +1,174 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <vw/Camera/LensDistortionTable.h>
+#include <vw/Camera/LensDistortion.h>
+#include <vw/Camera/PinholeModel.h>
+#include <vw/Core/Exception.h>
+#include <vw/Core/Settings.h>
+#include <vw/Core/ThreadPool.h>
+#include <vw/Image/Interpolation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vw { namespace camera {
+
+namespace {
+  // Grids larger than this per side are not built, as a distortion
+  // that spreads the image this much is not worth tabulating.
+  const int32 MAX_GRID_SIZE = 4096;
+
+  // Samples along each side of the image when finding the extent of
+  // the undistorted image
+  const int32 NUM_EDGE_SAMPLES = 100;
+
+  bool is_finite(Vector2 const& v) {
+    return std::isfinite(v[0]) && std::isfinite(v[1]);
+  }
+}
+
+bool LensDistortionTable::Grid::lookup(Vector2 const& p, Vector2 & result) const {
+  if (offsets.cols() == 0 || !box.contains(p))
+    return false;
+  double x = (p[0] - origin[0]) / spacing;
+  double y = (p[1] - origin[1]) / spacing;
+  if (x < 1.0 || y < 1.0 || x >= offsets.cols() - 2 || y >= offsets.rows() - 2)
+    return false;
+  Vector2 offset
+    = BicubicInterpolation::interpolator(offsets)(offsets, x, y, 0);
+  if (!is_finite(offset))
+    return false; // near a node where the model failed
+  result = p + offset;
+  return output_box.empty() || output_box.contains(result);
+}
+
+template <class FuncT>
+void LensDistortionTable::build(Grid & grid, BBox2 const& box, BBox2 const& output_box,
+                                double spacing, double pixel_pitch, int num_threads,
+                                FuncT const& func) {
+  // Two nodes before the box and two after, for the bicubic support
+  grid.origin     = box.min() - 2.0 * spacing * Vector2(1, 1);
+  grid.spacing    = spacing;
+  grid.box        = box;
+  grid.output_box = output_box;
+  int32 cols = int32(std::ceil(box.width()  / spacing)) + 5;
+  int32 rows = int32(std::ceil(box.height() / spacing)) + 5;
+  if (cols > MAX_GRID_SIZE || rows > MAX_GRID_SIZE)
+    return;
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  ImageView<Vector2> offsets(cols, rows);
+  process_in_parallel(size_t(rows), num_threads, [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; row++) {
+      for (int32 col = 0; col < cols; col++) {
+        Vector2 p = grid.origin + spacing * Vector2(col, row);
+        Vector2 q;
+        if (func(p, q) && is_finite(q))
+          offsets(col, row) = q - p;
+        else
+          offsets(col, row) = Vector2(nan, nan);
+      }
+    }
+  });
+  grid.offsets = offsets;
+
+  // Compare with the model in the middle of the cells, where the
+  // interpolation is worst. Cells where the model fails, or where the
+  // lookup would not be used, are skipped.
+  int32 cells_x = std::max(1, int32(std::ceil(box.width()  / spacing)));
+  int32 cells_y = std::max(1, int32(std::ceil(box.height() / spacing)));
+  std::vector<double> row_errors(cells_y, 0.0);
+  process_in_parallel(size_t(cells_y), num_threads, [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; row++) {
+      for (int32 col = 0; col < cells_x; col++) {
+        Vector2 p = box.min() + spacing * Vector2(col + 0.5, row + 0.5);
+        Vector2 q, r;
+        if (!func(p, q) || !is_finite(q) || !grid.lookup(p, r))
+          continue;
+        row_errors[row] = std::max(row_errors[row], norm_2(q - r) / pixel_pitch);
+      }
+    }
+  });
+  grid.max_error = *std::max_element(row_errors.begin(), row_errors.end());
+}
+
+LensDistortionTable::LensDistortionTable(PinholeModel const& cam, Vector2i const& image_size,
+                                         double grid_spacing, int num_threads) {
+  VW_ASSERT(grid_spacing > 0,
+            ArgumentErr() << "LensDistortionTable: The grid spacing must be positive.");
+  VW_ASSERT(image_size[0] > 0 && image_size[1] > 0,
+            ArgumentErr() << "LensDistortionTable: The image size must be positive.");
+  if (num_threads <= 0)
+    num_threads = vw_settings().default_num_threads();
+
+  LensDistortion const* distortion = cam.lens_distortion();
+  double pitch   = cam.pixel_pitch();
+  double spacing = grid_spacing * pitch;
+
+  // Lookups are allowed over the image and a pixel around it
+  BBox2 image_box(-pitch, -pitch, (image_size[0] + 1) * pitch, (image_size[1] + 1) * pitch);
+
+  if (!distortion->has_fast_undistort()) {
+    build(m_undistort, image_box, BBox2(), spacing, pitch, num_threads,
+          [&](Vector2 const& p, Vector2 & q) -> bool {
+            try {
+              q = distortion->undistorted_coordinates(cam, p);
+            } catch (...) {
+              return false;
+            }
+            return true;
+          });
+  }
+
+  if (!distortion->has_fast_distort()) {
+    // The undistorted image is bounded by where its edges go
+    BBox2 box;
+    for (int32 i = 0; i <= NUM_EDGE_SAMPLES; i++) {
+      double t = double(i) / NUM_EDGE_SAMPLES;
+      Vector2 edges[4] = {
+        Vector2(t * image_box.width(), 0), Vector2(t * image_box.width(), image_box.height()),
+        Vector2(0, t * image_box.height()), Vector2(image_box.width(), t * image_box.height())
+      };
+      for (int k = 0; k < 4; k++) {
+        Vector2 q;
+        if (m_undistort.lookup(image_box.min() + edges[k], q)) {
+          box.grow(q);
+          continue;
+        }
+        try {
+          q = distortion->undistorted_coordinates(cam, image_box.min() + edges[k]);
+          if (is_finite(q))
+            box.grow(q);
+        } catch (...) {}
+      }
+    }
+    if (!box.empty())
+      build(m_distort, box, image_box, spacing, pitch, num_threads,
+            [&](Vector2 const& p, Vector2 & q) -> bool {
+              try {
+                q = distortion->distorted_coordinates(cam, p);
+              } catch (...) {
+                return false;
+              }
+              return true;
+            });
+  }
+}
+
+}} // namespace vw::camera
@@ -0,0 +1,102 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+/// \file LensDistortionTable.h
+///
+/// Tables of a lens distortion model and its inverse over an image.
+///
+#ifndef __VW_CAMERA_LENSDISTORTIONTABLE_H__
+#define __VW_CAMERA_LENSDISTORTIONTABLE_H__
+
+#include <vw/Math/BBox.h>
+#include <vw/Math/Vector.h>
+#include <vw/Image/ImageView.h>
+
+namespace vw {
+namespace camera {
+
+  class PinholeModel;
+
+  /// The lens distortion of a pinhole camera and its inverse, sampled on
+  /// a grid over an image and looked up with bicubic interpolation. Only
+  /// the directions that the distortion model computes with a solver are
+  /// tabulated, since a closed-form model is faster than a lookup.
+  ///
+  /// Locations are in the units of the focal length, as for
+  /// LensDistortion. A table holds the offset from its input to its
+  /// output. After sampling, it is compared with the model in the middle
+  /// of every grid cell, and the largest difference is recorded. The
+  /// distortion table only answers for locations that land in the image,
+  /// so that a fold of the model outside the image does not spoil it.
+  class LensDistortionTable {
+  public:
+
+    /// Sample the distortion of the camera over an image of the given
+    /// size, with a node every grid_spacing pixels. Nodes are sampled
+    /// with num_threads threads (0 for the default).
+    LensDistortionTable(PinholeModel const& cam, Vector2i const& image_size,
+                        double grid_spacing = 8.0, int num_threads = 0);
+
+    bool has_distort_table  () const { return m_distort.offsets.cols() > 0; }
+    bool has_undistort_table() const { return m_undistort.offsets.cols() > 0; }
+
+    /// The largest difference from the model in the middle of the grid
+    /// cells, in pixels. Zero if there is no table.
+    double max_distort_error  () const { return m_distort.max_error;   }
+    double max_undistort_error() const { return m_undistort.max_error; }
+
+    /// Look up the distorted location of an undistorted one. Returns
+    /// false if there is no table or the location is outside it.
+    bool distorted_coordinates(Vector2 const& p, Vector2 & result) const {
+      return m_distort.lookup(p, result);
+    }
+
+    /// Look up the undistorted location of a distorted one. Returns
+    /// false if there is no table or the location is outside it.
+    bool undistorted_coordinates(Vector2 const& p, Vector2 & result) const {
+      return m_undistort.lookup(p, result);
+    }
+
+  private:
+
+    // Offsets from the input to the output of a function at the nodes
+    // origin + spacing*(col, row). There are two nodes past the box on
+    // each side, for the bicubic support. If output_box is not empty,
+    // lookups with outputs outside it fail.
+    struct Grid {
+      Vector2            origin;
+      double             spacing;
+      BBox2              box, output_box;
+      ImageView<Vector2> offsets;
+      double             max_error;
+
+      Grid(): spacing(1.0), max_error(0.0) {}
+      bool lookup(Vector2 const& p, Vector2 & result) const;
+    };
+
+    // Cover the box with a grid, and sample and check the function.
+    template <class FuncT>
+    void build(Grid & grid, BBox2 const& box, BBox2 const& output_box, double spacing,
+               double pixel_pitch, int num_threads, FuncT const& func);
+
+    Grid m_distort, m_undistort;
+  };
+
+}} // namespace vw::camera
+
+#endif // __VW_CAMERA_LENSDISTORTIONTABLE_H__
@@ -19,6 +19,7 @@
 #include <vw/Camera/LinescanErr.h>
 
 #include <iomanip>
+#include <limits>
 
 namespace vw {
 namespace camera {
@@ -105,4 +106,44 @@ vw::Vector2 LinescanErr::operator()(vw::Vector2 const& pix) const {
   return vw::Vector2(dot1, dot2);
 }
 
+bool linescanInverseJacobian(LinescanErr const& err_func, vw::Vector2 const& pix,
+                             double step, vw::Matrix2x2 & inv_jac) {
+  vw::Vector2 JX, JY;
+  try {
+    JX = (err_func(pix + vw::Vector2(step, 0)) - err_func(pix - vw::Vector2(step, 0))) / (2*step);
+    JY = (err_func(pix + vw::Vector2(0, step)) - err_func(pix - vw::Vector2(0, step))) / (2*step);
+  } catch (...) {
+    return false;
+  }
+
+  // Same singularity test as in NewtonRaphson
+  double det = JX[0]*JY[1] - JY[0]*JX[1];
+  if (std::abs(det) < 1e-6 || std::isnan(det))
+    return false;
+
+  inv_jac(0, 0) =  JY[1] / det;  inv_jac(0, 1) = -JY[0] / det;
+  inv_jac(1, 0) = -JX[1] / det;  inv_jac(1, 1) =  JX[0] / det;
+  return true;
+}
+
+bool linescanChordSolve(const CameraModel* model, vw::Vector3 const& point,
+                        vw::Vector2 const& guess, vw::Matrix2x2 const& inv_jac,
+                        double tol, double max_ground_err, int max_iter,
+                        vw::Vector2 & pix) {
+  try {
+    LinescanErr err_func(model, point, guess);
+    pix = guess;
+    for (int iter = 0; iter < max_iter; iter++) {
+      vw::Vector2 F = err_func(pix);
+      if (!(norm_2(F) < std::numeric_limits<double>::max()))
+        return false; // NaN or infinite
+      vw::Vector2 DX = inv_jac * F;
+      pix -= DX;
+      if (norm_2(DX) < tol)
+        return norm_2(F) <= max_ground_err;
+    }
+  } catch (...) {}
+  return false;
+}
+
 }} // namespace asp::camera
@@ -49,6 +49,22 @@ public:
   
 }; // End class LinescanErr
 
+// The inverse of the Jacobian of a LinescanErr at a pixel, by central
+// differences with the given step in pixels. Returns false if the
+// Jacobian is singular or cannot be found.
+bool linescanInverseJacobian(LinescanErr const& err_func, vw::Vector2 const& pix,
+                             double step, vw::Matrix2x2 & inv_jac);
+
+// Find the pixel observing a point with the chord method, which is Newton's
+// method with a fixed Jacobian, such as the one at the pixel of a nearby
+// point. Each iteration then needs a single function evaluation. Returns
+// false if the step does not fall below tol pixels within max_iter
+// iterations, or if the error at the ground is then above max_ground_err.
+bool linescanChordSolve(const CameraModel* model, vw::Vector3 const& point,
+                        vw::Vector2 const& guess, vw::Matrix2x2 const& inv_jac,
+                        double tol, double max_ground_err, int max_iter,
+                        vw::Vector2 & pix);
+
 }} // end vw::camera
 
 #endif // __CAMERA_LINESCAN_ERR_H__
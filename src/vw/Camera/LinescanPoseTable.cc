@@ -0,0 +1,67 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <vw/Camera/LinescanPoseTable.h>
+
+namespace vw { namespace camera {
+
+bool LinescanPoseTable::locate(double line, size_t & index, double & weight) const {
+  // This also rejects NaN
+  if (!(line >= 0.0 && line <= double(m_positions.size()) - 1.0))
+    return false;
+  index  = size_t(line);
+  weight = line - double(index);
+  if (index + 1 == m_positions.size()) { // the last line
+    index--;
+    weight = 1.0;
+  }
+  return true;
+}
+
+bool LinescanPoseTable::pose(double line, Vector3 & position, Matrix3x3 & rotation) const {
+  size_t i;
+  double w;
+  if (m_positions.size() < 2 || !locate(line, i, w))
+    return false;
+
+  Vector3   const& p0 = m_positions[i];
+  Vector3   const& p1 = m_positions[i+1];
+  Matrix3x3 const& r0 = m_rotations[i];
+  Matrix3x3 const& r1 = m_rotations[i+1];
+  for (int k = 0; k < 3; k++)
+    position[k] = p0[k] + w * (p1[k] - p0[k]);
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      rotation(r, c) = r0(r, c) + w * (r1(r, c) - r0(r, c));
+  return true;
+}
+
+bool LinescanPoseTable::pose(double line, Vector3 & position, Matrix3x3 & rotation,
+                             Vector3 & velocity) const {
+  if (!pose(line, position, rotation))
+    return false;
+  size_t i;
+  double w;
+  locate(line, i, w);
+  Vector3 const& v0 = m_velocities[i];
+  Vector3 const& v1 = m_velocities[i+1];
+  for (int k = 0; k < 3; k++)
+    velocity[k] = v0[k] + w * (v1[k] - v0[k]);
+  return true;
+}
+
+}} // namespace vw::camera
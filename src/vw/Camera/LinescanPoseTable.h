@@ -0,0 +1,86 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+/// \file LinescanPoseTable.h
+///
+/// The pose of a linescan camera tabulated at each image line.
+///
+#ifndef __VW_CAMERA_LINESCANPOSETABLE_H__
+#define __VW_CAMERA_LINESCANPOSETABLE_H__
+
+#include <vw/Math/Matrix.h>
+#include <vw/Math/Vector.h>
+#include <vw/Core/Settings.h>
+#include <vw/Core/ThreadPool.h>
+
+#include <vector>
+
+namespace vw {
+namespace camera {
+
+  /// The camera center, camera to world rotation and velocity of a
+  /// linescan camera at each integer line, so that the pose at a line
+  /// is found in constant time instead of by evaluating the time and
+  /// pose interpolators. Between two lines the values are linearly
+  /// interpolated. Over one line the rotation changes so little that
+  /// the result differs from a proper rotation by far less than the
+  /// accuracy of the pose.
+  class LinescanPoseTable {
+  public:
+
+    /// An empty table.
+    LinescanPoseTable() {}
+
+    /// Evaluate the pose at lines 0, ..., num_lines - 1 with
+    /// func(line, position, rotation, velocity), on num_threads threads
+    /// (0 for the default). The function must be thread-safe.
+    template <class FuncT>
+    LinescanPoseTable(int num_lines, FuncT const& func, int num_threads = 0):
+      m_positions(num_lines), m_rotations(num_lines), m_velocities(num_lines) {
+      if (num_threads <= 0)
+        num_threads = vw_settings().default_num_threads();
+      process_in_parallel(size_t(num_lines), num_threads, [&](size_t begin, size_t end) {
+        for (size_t line = begin; line < end; line++)
+          func(double(line), m_positions[line], m_rotations[line], m_velocities[line]);
+      });
+    }
+
+    int  num_lines() const { return int(m_positions.size()); }
+    bool empty    () const { return m_positions.empty(); }
+
+    /// The pose at a line. Returns false if the line is outside the
+    /// table, in which case the caller must use the camera model.
+    bool pose(double line, Vector3 & position, Matrix3x3 & rotation) const;
+
+    /// The pose and velocity at a line. Returns false if the line is
+    /// outside the table.
+    bool pose(double line, Vector3 & position, Matrix3x3 & rotation,
+              Vector3 & velocity) const;
+
+  private:
+    // Find the line before the given one and the weight of the one after
+    bool locate(double line, size_t & index, double & weight) const;
+
+    std::vector<Vector3>   m_positions;
+    std::vector<Matrix3x3> m_rotations;
+    std::vector<Vector3>   m_velocities;
+  };
+
+}} // namespace vw::camera
+
+#endif // __VW_CAMERA_LINESCANPOSETABLE_H__
@@ -20,9 +20,11 @@
 #include <vw/Camera/OpticalBarModel.h>
 #include <vw/Camera/OrbitalCorrections.h>
 #include <vw/Camera/LinescanErr.h>
+#include <vw/Camera/LinescanPoseTable.h>
 #include <vw/Math/NewtonRaphson.h>
 #include <vw/Math/EulerAngles.h>
 
+#include <algorithm>
 #include <iomanip>
 
 namespace vw {
@@ -117,6 +119,7 @@ void OpticalBarModel::set_velocity(vw::Vector3 const& velocity) {
     vw_throw(ArgumentErr() 
              << "OpticalBarModel: Cannot set velocity vector without velocity modeling.\n");
    m_velocity = velocity;
+   m_pose_table.reset();
 }
 
 void OpticalBarModel::set_final_pose(vw::Vector3 const& final_pose) {
@@ -124,14 +127,17 @@ void OpticalBarModel::set_final_pose(vw::Vector3 const& final_pose) {
     vw_throw(ArgumentErr() 
              << "OpticalBarModel: Cannot set final pose without velocity modeling.\n");
    m_final_pose = final_pose;
+   m_pose_table.reset();
 }
 
 void OpticalBarModel::set_camera_center(vw::Vector3 const& position) {
   m_initial_position  = position;
+  m_pose_table.reset();
 }
 
 void OpticalBarModel::set_camera_pose(vw::Vector3 const& orientation) {
   m_initial_pose = orientation;
+  m_pose_table.reset();
 }
 
 void OpticalBarModel::set_camera_pose(vw::Quaternion<double> const& pose) {
@@ -140,6 +146,7 @@ void OpticalBarModel::set_camera_pose(vw::Quaternion<double> const& pose) {
 
 void OpticalBarModel::set_image_size(vw::Vector2i image_size) { 
   m_image_size = image_size;
+  m_pose_table.reset();
   compute_scan_rate();
 }
 
@@ -155,6 +162,7 @@ void OpticalBarModel::set_focal_length(double focal_length) {
 
 void OpticalBarModel::set_speed(double speed) { 
   m_speed = speed;
+  m_pose_table.reset();
   compute_scan_rate();
 }
 
@@ -164,15 +172,18 @@ void OpticalBarModel::set_pixel_size(double pixel_size) {
 }
 void OpticalBarModel::set_scan_time(double scan_time) { 
   m_scan_time   = scan_time;
+  m_pose_table.reset();
   compute_scan_rate();
 }
 
 void OpticalBarModel::set_scan_dir(bool scan_l_to_r) { 
   m_scan_left_to_right = scan_l_to_r;
+  m_pose_table.reset();
 }
 
 void OpticalBarModel::set_forward_tilt(double tilt_angle) { 
   m_forward_tilt_radians = tilt_angle;
+  m_pose_table.reset();
 }
 
 void OpticalBarModel::set_motion_compensation(double mc_factor) { 
@@ -258,6 +269,11 @@ Vector3 OpticalBarModel::get_final_pose() const {
 
 Vector3 OpticalBarModel::camera_center(Vector2 const& pix) const {
 
+  Vector3   cam_center;
+  Matrix3x3 cam_rotation;
+  if (m_pose_table && m_pose_table->pose(pix[0], cam_center, cam_rotation))
+    return cam_center;
+
   // We model with a constant velocity
   double dt = pixel_to_time_delta(pix);
 
@@ -278,15 +294,27 @@ Quat OpticalBarModel::camera_pose(Vector2 const& pix) const {
   // Pose interpolation in time
   Quat q_initial = axis_angle_to_quaternion(m_initial_pose);
   Quat q_final   = axis_angle_to_quaternion(m_final_pose); 
+  return interp_pose(dt, q_initial, q_final);
+}
+
+Quat OpticalBarModel::interp_pose(double dt, Quat const& q_initial, Quat const& q_final) const {
   int spin = 0; // No spin
   return vw::math::slerp(dt, q_initial, q_final, spin);
 }
 
 Vector3 OpticalBarModel::pixel_to_vector(Vector2 const& pix) const {
+
+  Vector3   cam_center;
+  Matrix3x3 cam_rotation;
+  if (m_pose_table && m_pose_table->pose(pix[0], cam_center, cam_rotation))
+    return normalize(cam_rotation * camera_ray(pix, cam_center));
+
+  return camera_pose(pix).rotate(camera_ray(pix, camera_center(pix)));
+}
+
+Vector3 OpticalBarModel::camera_ray(Vector2 const& pix, Vector3 const& cam_center) const {
  
   Vector2 sensor_plane_pos = pixel_to_sensor_plane(pix);
-  Vector3 cam_center       = camera_center(pix);
-  Quat cam_pose            = camera_pose(pix);
   
   // This is the horizontal angle away from the center point (from straight out of the camera)
   double alpha = sensor_to_alpha(sensor_plane_pos);
@@ -316,20 +344,17 @@ Vector3 OpticalBarModel::pixel_to_vector(Vector2 const& pix) const {
   Vector3 r(m_focal_length * sin(alpha),
             sensor_plane_pos[1] + image_motion_compensation,
             m_focal_length * cos(alpha));
-  r = normalize(r);
-
-  // Convert the ray vector into ECEF coordinates.
-  Vector3 result = cam_pose.rotate(r);
-
-  return result;
+  return normalize(r);
 }
 
 // TODO(oalexan1): This could be sped up further, as done in the usgscsm linescan class,
 // where an initial affine transform for ground-to-image is found.
 Vector2 OpticalBarModel::point_to_pixel(Vector3 const& point) const {
-
   // Use the image center as the initial guess for the pixel
-  Vector2 guess = m_image_size / 2.0;
+  return solve_for_pixel(point, m_image_size / 2.0);
+}
+
+Vector2 OpticalBarModel::solve_for_pixel(Vector3 const& point, Vector2 const& guess) const {
 
   // The step size for numerical differentiation in pixel units. This is for
   // finding the Jacobian, so it need not be perfect. A small step size can
@@ -348,6 +373,133 @@ Vector2 OpticalBarModel::point_to_pixel(Vector3 const& point) const {
   return pix;
 }
 
+void OpticalBarModel::points_to_pixels(Vector3 const* points, Vector2* pixels,
+                                       size_t num) const {
+
+  // Nearby points image to nearby pixels, so the last solution is a
+  // better guess than the image center, and the Jacobian there is close
+  // enough for the chord method. If that does not converge, use Newton's
+  // method from the last solution, and then from the image center.
+  const Vector2 center_guess   = m_image_size / 2.0;
+  const double  max_ground_err = 1e-6; // in meters, as measured by LinescanErr
+  const double  step = 1e-2, tol = 1e-10; // as in solve_for_pixel()
+  const int     max_chord_iter = 10;
+  Vector2   guess = center_guess;
+  Matrix2x2 inv_jac;
+  bool      have_jac = false;
+  for (size_t i = 0; i < num; i++) {
+    pixels[i] = invalid_pixel();
+    if (have_jac && linescanChordSolve(this, points[i], guess, inv_jac, tol,
+                                       max_ground_err, max_chord_iter, pixels[i])) {
+      guess = pixels[i];
+      continue;
+    }
+    pixels[i] = invalid_pixel();
+    if (guess != center_guess) {
+      try {
+        Vector2 pix = solve_for_pixel(points[i], guess);
+        if (norm_2(LinescanErr(this, points[i], guess)(pix)) <= max_ground_err)
+          pixels[i] = pix;
+      } catch (...) {}
+    }
+    if (pixels[i] == invalid_pixel()) {
+      try {
+        pixels[i] = solve_for_pixel(points[i], center_guess);
+      } catch (...) {
+        guess    = center_guess;
+        have_jac = false;
+        continue;
+      }
+    }
+    guess    = pixels[i];
+    have_jac = linescanInverseJacobian(LinescanErr(this, points[i], guess), guess,
+                                       step, inv_jac);
+  }
+}
+
+void OpticalBarModel::pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                        size_t num) const {
+
+  // The velocity is constant, and so is the pose in the older approach
+  const Quat    q_initial = axis_angle_to_quaternion(m_initial_pose);
+  const Quat    q_final   = m_have_velocity_vec ? axis_angle_to_quaternion(m_final_pose)
+                                                : q_initial;
+  Vector3 velocity;
+  try {
+    velocity = get_velocity();
+  } catch (...) {
+    std::fill(vectors, vectors + num, Vector3());
+    return;
+  }
+
+  Vector3   cam_center;
+  Matrix3x3 cam_rotation;
+  for (size_t i = 0; i < num; i++) {
+    try {
+      if (m_pose_table && m_pose_table->pose(pixels[i][0], cam_center, cam_rotation)) {
+        vectors[i] = normalize(cam_rotation * camera_ray(pixels[i], cam_center));
+        continue;
+      }
+      double dt = pixel_to_time_delta(pixels[i]);
+      cam_center = m_initial_position + dt * velocity;
+      Quat cam_pose = q_initial;
+      if (m_have_velocity_vec)
+        cam_pose = interp_pose(std::min(1.0, std::max(0.0, dt)), q_initial, q_final);
+      vectors[i] = cam_pose.rotate(camera_ray(pixels[i], cam_center));
+    } catch (...) {
+      vectors[i] = Vector3();
+    }
+  }
+}
+
+void OpticalBarModel::camera_centers(Vector2 const* pixels, Vector3* centers,
+                                     size_t num) const {
+  Vector3 velocity;
+  try {
+    velocity = get_velocity();
+  } catch (...) {
+    std::fill(centers, centers + num, Vector3());
+    return;
+  }
+
+  Matrix3x3 cam_rotation;
+  for (size_t i = 0; i < num; i++) {
+    try {
+      if (m_pose_table && m_pose_table->pose(pixels[i][0], centers[i], cam_rotation))
+        continue;
+      centers[i] = m_initial_position + pixel_to_time_delta(pixels[i]) * velocity;
+    } catch (...) {
+      centers[i] = Vector3();
+    }
+  }
+}
+
+// The time and pose found for a pixel depend only on its column. The
+// velocity is found from the first column, as it is constant.
+void OpticalBarModel::enable_pose_table(int num_threads) {
+  m_pose_table.reset();
+
+  // This throws for a configuration that is not supported, which is
+  // better done here than in the threads below.
+  pixel_to_time_delta(Vector2(0, 0));
+  const Vector3 velocity = get_velocity();
+
+  boost::shared_ptr<LinescanPoseTable> table
+    (new LinescanPoseTable(m_image_size[0],
+                           [&](double col, Vector3 & position, Matrix3x3 & rotation,
+                               Vector3 & vel) {
+                             Vector2 pix(col, 0);
+                             position = camera_center(pix);
+                             rotation = camera_pose(pix).rotation_matrix();
+                             vel      = velocity;
+                           }, num_threads));
+  m_pose_table = table;
+}
+
+void OpticalBarModel::disable_pose_table() {
+  m_pose_table.reset();
+}
+
 void OpticalBarModel::apply_transform(vw::Matrix3x3 const & rotation,
                                       vw::Vector3   const & translation,
                                       double                scale) {
@@ -375,6 +527,8 @@ void OpticalBarModel::apply_transform(vw::Matrix3x3 const & rotation,
 
 void OpticalBarModel::read(std::string const& filename) {
 
+  m_pose_table.reset();
+
   // Open the input file
   std::ifstream cam_file;
   cam_file.open(filename.c_str());
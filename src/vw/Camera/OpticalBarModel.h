@@ -28,9 +28,13 @@
 #include <vw/Math/LevenbergMarquardt.h>
 #include <vw/Camera/CameraModel.h>
 
+#include <boost/shared_ptr.hpp>
+
 namespace vw {
 namespace camera {
 
+  class LinescanPoseTable;
+
   // A camera model to approximate the type of optical bar cameras
   // that were used in the Corona and Hexagon satellites.
   
@@ -112,6 +116,25 @@ namespace camera {
     /// Gives a pose vector which represents the rotation from camera to world units
     virtual vw::Quat camera_pose(vw::Vector2 const& pix) const;
 
+    /// Batch versions of the above. The poses and the velocity are found
+    /// once per batch, and each point is solved for starting from the
+    /// pixel of the point before it.
+    virtual void points_to_pixels (vw::Vector3 const* points, vw::Vector2* pixels,
+                                   size_t num) const;
+    virtual void pixels_to_vectors(vw::Vector2 const* pixels, vw::Vector3* vectors,
+                                   size_t num) const;
+    virtual void camera_centers   (vw::Vector2 const* pixels, vw::Vector3* centers,
+                                   size_t num) const;
+
+    /// Tabulate the camera center, pose and velocity at each image
+    /// column, as the scan is along the columns, so that the functions
+    /// above and the solver in point_to_pixel() look them up instead of
+    /// finding them from the time. The table is dropped when the
+    /// position, pose, velocity, image size or scan changes.
+    void enable_pose_table(int num_threads = 0);
+    void disable_pose_table();
+    bool has_pose_table() const { return bool(m_pose_table); }
+
     // -- These are new functions --
 
     // These return the initial center/pose at time=0.
@@ -170,6 +193,15 @@ namespace camera {
     /// Compute and record the scan rate into m_scan_rate.
     void compute_scan_rate();
 
+    /// The pose at a normalized time, given the initial and final poses.
+    vw::Quat interp_pose(double dt, vw::Quat const& q_initial, vw::Quat const& q_final) const;
+
+    /// The ray through a pixel in camera coordinates, given the camera center there.
+    vw::Vector3 camera_ray(vw::Vector2 const& pix, vw::Vector3 const& cam_center) const;
+
+    /// Solve for the pixel observing a point, starting from a guess.
+    vw::Vector2 solve_for_pixel(vw::Vector3 const& point, vw::Vector2 const& guess) const;
+
   protected:
 
     /// Image size in pixels: [columns, rows]
@@ -222,6 +254,9 @@ namespace camera {
     // Old logic is kept for backward compatibility.
     bool m_have_velocity_vec;
 
+    /// Optional table of the pose at each column, shared by copies of the camera.
+    boost::shared_ptr<const LinescanPoseTable> m_pose_table;
+
   protected:
 
     /// Returns the radius of the Earth under the current camera position.
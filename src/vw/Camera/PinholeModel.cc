@@ -22,6 +22,7 @@
 #include <vw/Math/Quaternion.h>
 #include <vw/Camera/PinholeModel.h>
 #include <vw/Camera/LensDistortion.h>
+#include <vw/Camera/LensDistortionTable.h>
 #include <vw/Camera/CameraUtilities.h>
 
 #if defined(VW_HAVE_PKG_LAPACK)
@@ -29,6 +30,7 @@
 #endif
 
 #include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <iomanip>
 #include <string>
@@ -73,7 +75,8 @@ PinholeModel::PinholeModel(PinholeModel const& other) :
     m_w_direction  (other.m_w_direction),
     m_pixel_pitch  (other.m_pixel_pitch),
     m_do_point_to_pixel_check(other.m_do_point_to_pixel_check),
-    m_inv_camera_transform(other.m_inv_camera_transform) {
+    m_inv_camera_transform(other.m_inv_camera_transform),
+    m_distortion_table(other.m_distortion_table) {
 }
 
 PinholeModel::PinholeModel(Vector3 camera_center, Matrix<double,3,3> rotation,
@@ -118,6 +121,8 @@ PinholeModel::PinholeModel(Vector3 camera_center, Matrix<double,3,3> rotation,
 
 void PinholeModel::read(std::string const& filename) {
 
+  m_distortion_table.reset();
+
   // Open the input file
   std::ifstream cam_file;
   cam_file.open(filename.c_str());
@@ -362,7 +367,7 @@ Vector2 PinholeModel::point_to_pixel_no_check(Vector3 const& point) const {
   // Apply the lens distortion model
   // - Divide by pixel pitch to convert from metric units to pixels if the intrinsic
   //   values were not specified in pixel units (in that case m_pixel_pitch == 1.0)
-  Vector2 final_pixel = m_distortion->distorted_coordinates(*this, pixel) / m_pixel_pitch;
+  Vector2 final_pixel = distorted_coordinates(pixel) / m_pixel_pitch;
 
   return final_pixel;
 }
@@ -421,7 +426,7 @@ bool PinholeModel::projection_valid(Vector3 const& point) const {
 
 Vector3 PinholeModel::pixel_to_vector (Vector2 const& pix) const {
   // Apply the inverse lens distortion model
-  Vector2 undistorted_pix = m_distortion->undistorted_coordinates(*this, pix*m_pixel_pitch);
+  Vector2 undistorted_pix = undistorted_coordinates(pix*m_pixel_pitch);
 
   // Compute the direction of the ray emanating from the camera center.
   Vector3 p(0,0,1);
@@ -433,6 +438,62 @@ Vector3 PinholeModel::camera_center(Vector2 const& /*pix*/ ) const {
   return m_camera_center;
 };
 
+// Without lens distortion the point to pixel check can only fail if
+// the projection is not finite, so it is replaced by that test.
+void PinholeModel::points_to_pixels(Vector3 const* points, Vector2* pixels,
+                                    size_t num) const {
+
+  if (!dynamic_cast<NullLensDistortion const*>(m_distortion.get())) {
+    CameraModel::points_to_pixels(points, pixels, num);
+    return;
+  }
+
+  const double m00 = m_camera_matrix(0,0), m01 = m_camera_matrix(0,1),
+               m02 = m_camera_matrix(0,2), m03 = m_camera_matrix(0,3),
+               m10 = m_camera_matrix(1,0), m11 = m_camera_matrix(1,1),
+               m12 = m_camera_matrix(1,2), m13 = m_camera_matrix(1,3),
+               m20 = m_camera_matrix(2,0), m21 = m_camera_matrix(2,1),
+               m22 = m_camera_matrix(2,2), m23 = m_camera_matrix(2,3);
+  for (size_t i = 0; i < num; i++) {
+    const double x = points[i][0], y = points[i][1], z = points[i][2];
+    const double den = m20*x + m21*y + m22*z + m23;
+    const double col = ((m00*x + m01*y + m02*z + m03) / den) / m_pixel_pitch;
+    const double row = ((m10*x + m11*y + m12*z + m13) / den) / m_pixel_pitch;
+    if (m_do_point_to_pixel_check && !(std::isfinite(col) && std::isfinite(row)))
+      pixels[i] = invalid_pixel();
+    else
+      pixels[i] = Vector2(col, row);
+  }
+}
+
+void PinholeModel::pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                     size_t num) const {
+
+  const bool no_distortion
+    = (dynamic_cast<NullLensDistortion const*>(m_distortion.get()) != NULL);
+  Matrix<double,3,3> const& M = m_inv_camera_transform;
+  for (size_t i = 0; i < num; i++) {
+    Vector2 pix = pixels[i]*m_pixel_pitch;
+    if (!no_distortion) {
+      try {
+        pix = undistorted_coordinates(pix);
+      } catch (...) {
+        vectors[i] = Vector3();
+        continue;
+      }
+    }
+    Vector3 dir(M(0,0)*pix[0] + M(0,1)*pix[1] + M(0,2),
+                M(1,0)*pix[0] + M(1,1)*pix[1] + M(1,2),
+                M(2,0)*pix[0] + M(2,1)*pix[1] + M(2,2));
+    vectors[i] = normalize(dir);
+  }
+}
+
+void PinholeModel::camera_centers(Vector2 const* /*pixels*/, Vector3* centers,
+                                  size_t num) const {
+  std::fill(centers, centers + num, m_camera_center);
+}
+
 void PinholeModel::set_camera_center(Vector3 const& position) {
   m_camera_center = position; 
   rebuild_camera_matrix();
@@ -474,6 +535,49 @@ const LensDistortion* PinholeModel::lens_distortion() const { return m_distortio
 
 void PinholeModel::set_lens_distortion(LensDistortion const* distortion) {
   m_distortion = distortion->copy();
+  m_distortion_table.reset();
+}
+
+Vector2 PinholeModel::distorted_coordinates(Vector2 const& p) const {
+  Vector2 result;
+  if (m_distortion_table && m_distortion_table->distorted_coordinates(p, result))
+    return result;
+  return m_distortion->distorted_coordinates(*this, p);
+}
+
+Vector2 PinholeModel::undistorted_coordinates(Vector2 const& p) const {
+  Vector2 result;
+  if (m_distortion_table && m_distortion_table->undistorted_coordinates(p, result))
+    return result;
+  return m_distortion->undistorted_coordinates(*this, p);
+}
+
+// Each retry halves the grid spacing, which cuts the bicubic error
+// by about 16 for a smooth distortion.
+bool PinholeModel::enable_distortion_table(Vector2i const& image_size,
+                                           double grid_spacing, double max_error) {
+  m_distortion_table.reset();
+  if (m_distortion->has_fast_distort() && m_distortion->has_fast_undistort())
+    return true; // nothing to tabulate
+
+  const int NUM_TRIES = 3;
+  for (int i = 0; i < NUM_TRIES; i++) {
+    boost::shared_ptr<LensDistortionTable>
+      table(new LensDistortionTable(*this, image_size, grid_spacing));
+    if (table->max_distort_error() <= max_error && table->max_undistort_error() <= max_error) {
+      m_distortion_table = table;
+      return true;
+    }
+    grid_spacing /= 2.0;
+  }
+
+  vw_out(WarningMessage, "camera") << "PinholeModel: Could not tabulate the lens distortion to within "
+                                   << max_error << " pixels. Using the distortion model.\n";
+  return false;
+}
+
+void PinholeModel::disable_distortion_table() {
+  m_distortion_table.reset();
 }
 
 void PinholeModel::intrinsic_parameters(double& f_u, double& f_v,
@@ -484,24 +588,31 @@ void PinholeModel::intrinsic_parameters(double& f_u, double& f_v,
 void PinholeModel::set_intrinsic_parameters(double f_u, double f_v,
                                             double c_u, double c_v) {
   m_fu = f_u;  m_fv = f_v;  m_cu = c_u;  m_cv = c_v;
+  m_distortion_table.reset();
   rebuild_camera_matrix();
 }
 
 Vector2 PinholeModel::focal_length() const { return Vector2(m_fu,m_fv); }
 void PinholeModel::set_focal_length(Vector2 const& f, bool rebuild ) {
   m_fu = f[0]; m_fv = f[1];
+  m_distortion_table.reset();
   if (rebuild) rebuild_camera_matrix();
 }
 Vector2 PinholeModel::point_offset() const { return Vector2(m_cu,m_cv); }
 void PinholeModel::set_point_offset(Vector2 const& c, bool rebuild ) {
   m_cu = c[0]; m_cv = c[1];
+  m_distortion_table.reset();
   if (rebuild) rebuild_camera_matrix();
 }
 double PinholeModel::pixel_pitch() const { return m_pixel_pitch; }
-void PinholeModel::set_pixel_pitch( double pitch ) { m_pixel_pitch = pitch; }
+void PinholeModel::set_pixel_pitch( double pitch ) {
+  m_pixel_pitch = pitch;
+  m_distortion_table.reset();
+}
 
 
 void PinholeModel::set_camera_matrix( Matrix<double,3,4> const& p ) {
+  m_distortion_table.reset();
 #if defined(VW_HAVE_PKG_LAPACK)
   // Solving for camera center
   Matrix<double> cam_nullsp = nullspace(p);
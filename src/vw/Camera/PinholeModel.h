@@ -33,6 +33,7 @@ namespace vw {
 namespace camera {
 
   class LensDistortion;
+  class LensDistortionTable;
 
   /// This is a simple "generic" pinhole camera model.
   ///
@@ -118,6 +119,10 @@ namespace camera {
     /// Cached values for pixel_to_vector
     Matrix<double,3,3> m_inv_camera_transform;
 
+    /// Optional lookup table of the lens distortion, shared by copies
+    /// of the camera. Cleared when the intrinsics change.
+    boost::shared_ptr<const LensDistortionTable> m_distortion_table;
+
   public:
     //------------------------------------------------------------------
     // Constructors / Destructors
@@ -230,6 +235,15 @@ namespace camera {
 
     // The pinhole camera position does not vary by pixel so the input pixel is ignored.
     virtual Vector3 camera_center(Vector2 const& /*pix*/ = Vector2() ) const;
+
+    // Batch versions of the above. These skip the distortion model and
+    // the point to pixel check when there is no lens distortion.
+    virtual void points_to_pixels (Vector3 const* points, Vector2* pixels,
+                                   size_t num) const;
+    virtual void pixels_to_vectors(Vector2 const* pixels, Vector3* vectors,
+                                   size_t num) const;
+    virtual void camera_centers   (Vector2 const* pixels, Vector3* centers,
+                                   size_t num) const;
     void set_camera_center(Vector3 const& position);
 
     // Pose is a rotation which moves a vector in camera coordinates
@@ -261,6 +275,24 @@ namespace camera {
     LensDistortion const* lens_distortion() const;
     void set_lens_distortion(LensDistortion const* distortion); // Makes a copy
 
+    /// Apply the lens distortion or its inverse to a location in the
+    /// units of the focal length, using the distortion table if there
+    /// is one and the location is in it.
+    Vector2 distorted_coordinates  (Vector2 const& p) const;
+    Vector2 undistorted_coordinates(Vector2 const& p) const;
+
+    /// Tabulate the parts of the lens distortion that need a solver
+    /// over an image of the given size, with a node every grid_spacing
+    /// pixels, to speed up point_to_pixel() and pixel_to_vector(). If
+    /// the table differs from the model by more than max_error pixels,
+    /// a finer grid is tried, and if that fails too no table is used
+    /// and false is returned. The table is dropped whenever the lens
+    /// distortion or intrinsics change.
+    bool enable_distortion_table(Vector2i const& image_size, double grid_spacing = 8.0,
+                                 double max_error = 1e-3);
+    void disable_distortion_table();
+    bool has_distortion_table() const { return bool(m_distortion_table); }
+
     //  f_u and f_v :  focal length in horiz and vert. pixel units
     //  c_u and c_v :  principal point in pixel units
     void intrinsic_parameters(double& f_u, double& f_v,
@@ -98,3 +98,36 @@ TEST( AdjustedCameraModel, AdjustedConstruct ) {
     acos(dot_prod(Vector3(0,0,1),inverse(center_pose).rotate(adjcam2.pixel_to_vector(center_pixel))));
   EXPECT_LT( angle_from_z, 0.5 );
 }
+
+TEST( AdjustedCameraModel, BatchFunctions ) {
+
+  Matrix<double,3,3> pose = math::euler_to_rotation_matrix(1.3,2.0,-.7,"xyz");
+  boost::shared_ptr<CameraModel> pinhole(
+      new PinholeModel( Vector3(3,-2,1), pose, 500,500, 500,500 ) );
+  AdjustedCameraModel adjcam( pinhole, Vector3(1,0.5,0),
+                              Quat(math::euler_to_rotation_matrix(0.01,-0.02,0.03,"xyz")),
+                              Vector2(20,-10), 2.0 );
+
+  std::vector<Vector2> pixels;
+  std::vector<Vector3> points;
+  for (int i = 0; i < 20; i++) {
+    Vector2 pix(25*i, 480 - 17*i);
+    pixels.push_back(pix);
+    points.push_back(adjcam.camera_center(pix) + (5.0 + i)*adjcam.pixel_to_vector(pix));
+  }
+  // The unadjusted camera center cannot be projected
+  points.push_back(pinhole->camera_center(Vector2()) + Vector3(1,0.5,0));
+
+  size_t num = pixels.size();
+  std::vector<Vector2> batch_pixels(num + 1);
+  std::vector<Vector3> batch_vectors(num), batch_centers(num);
+  adjcam.points_to_pixels(&points[0], &batch_pixels[0], num + 1);
+  adjcam.pixels_to_vectors(&pixels[0], &batch_vectors[0], num);
+  adjcam.camera_centers(&pixels[0], &batch_centers[0], num);
+  for (size_t i = 0; i < num; i++) {
+    EXPECT_VECTOR_NEAR( pixels[i], batch_pixels[i], 1e-8 );
+    EXPECT_VECTOR_NEAR( adjcam.pixel_to_vector(pixels[i]), batch_vectors[i], 1e-12 );
+    EXPECT_VECTOR_NEAR( adjcam.camera_center(pixels[i]), batch_centers[i], 1e-12 );
+  }
+  EXPECT_VECTOR_EQ( CameraModel::invalid_pixel(), batch_pixels[num] );
+}
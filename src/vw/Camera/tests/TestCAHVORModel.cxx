@@ -177,3 +177,33 @@ TEST( CAHVORModel, ForwardReverse) {
     }
   }
 }
+
+TEST( CAHVORModel, BatchFunctions) {
+  CAHVORModel cahvor(Vector3(0.491222,-0.0717236,-1.24143),
+                     Vector3(0.921657,-0.230518,0.312107),
+                     Vector3(757.076,1071.6,160.227),
+                     Vector3(91.7479,-27.7504,1319.48),
+                     Vector3(0.920759,-0.206185,0.331197),
+                     Vector3(0.00096,-0.002183,0.018547));
+
+  std::vector<Vector2> pixels;
+  std::vector<Vector3> points;
+  for ( uint32 i = 100; i < 901; i += 100 ) {
+    for ( uint32 j = 100; j < 901; j+= 100 ) {
+      pixels.push_back(Vector2(i,j));
+      points.push_back(cahvor.C + (10.0 + 0.01*i)*cahvor.pixel_to_vector(Vector2(i,j)));
+    }
+  }
+
+  size_t num = pixels.size();
+  std::vector<Vector2> batch_pixels(num);
+  std::vector<Vector3> batch_vectors(num), batch_centers(num);
+  cahvor.points_to_pixels(&points[0], &batch_pixels[0], num);
+  cahvor.pixels_to_vectors(&pixels[0], &batch_vectors[0], num);
+  cahvor.camera_centers(&pixels[0], &batch_centers[0], num);
+  for (size_t k = 0; k < num; k++) {
+    EXPECT_VECTOR_NEAR( cahvor.point_to_pixel(points[k]), batch_pixels[k], 1e-8 );
+    EXPECT_VECTOR_NEAR( cahvor.pixel_to_vector(pixels[k]), batch_vectors[k], 1e-12 );
+    EXPECT_VECTOR_EQ( cahvor.C, batch_centers[k] );
+  }
+}
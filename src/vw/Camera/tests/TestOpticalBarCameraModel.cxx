@@ -19,6 +19,7 @@
 #include <vw/Stereo/StereoModel.h>
 //#include <vw/Cartography/Datum.h>
 #include <vw/Camera/OpticalBarModel.h>
+#include <vw/Math/EulerAngles.h>
 
 #include <boost/scoped_ptr.hpp>
 #include <test/Helpers.h>
@@ -112,6 +113,28 @@ TEST(OpticalBarModel, CreateCamera) {
     }
   }
 
+  // The batch functions agree with the single-point ones
+  std::vector<Vector2> pixels;
+  std::vector<Vector3> points;
+  for ( size_t i = 0; i < 3000; i += 200 ) {
+    for ( size_t j = 0; j < 2400; j += 200 ) {
+      Vector2 pixel(i,j);
+      pixels.push_back(pixel);
+      points.push_back(cam1->camera_center(pixel) + 2e4*cam1->pixel_to_vector(pixel));
+    }
+  }
+  size_t num = pixels.size();
+  std::vector<Vector2> batch_pixels(num);
+  std::vector<Vector3> batch_vectors(num), batch_centers(num);
+  cam1->points_to_pixels(&points[0], &batch_pixels[0], num);
+  cam1->pixels_to_vectors(&pixels[0], &batch_vectors[0], num);
+  cam1->camera_centers(&pixels[0], &batch_centers[0], num);
+  for (size_t i = 0; i < num; i++) {
+    EXPECT_VECTOR_NEAR(cam1->point_to_pixel(points[i]), batch_pixels[i], 1e-4);
+    EXPECT_VECTOR_NEAR(cam1->pixel_to_vector(pixels[i]), batch_vectors[i], 1e-12);
+    EXPECT_VECTOR_NEAR(cam1->camera_center(pixels[i]), batch_centers[i], 1e-6);
+  }
+
   
   /*
   Vector3   gcc2(-2470746.042265798, 5537165.6573024355, 2515786.8430585163);
@@ -203,3 +226,55 @@ TEST(OpticalBarModel, CreateCamera) {
   
 }
 
+
+TEST(OpticalBarModel, PoseTable) {
+
+  // A camera with a velocity vector, whose pose changes during the scan
+  Vector3   gcc(-2470899.9105873918, 5542443.1851118281, 2502370.2339997198);
+  Matrix3x3 rot_mat(-0.057502980758053046, -0.74594045857037883,  0.66352561327483939,
+                    -0.16417103320903326,  -0.64851223071215924, -0.74328982131589649,
+                     0.98475442576259453,  -0.15167306578477252, -0.085170429471915887);
+  vw::Quat q(rot_mat);
+  Vector3 initial_pose = q.axis_angle();
+  Vector3 final_pose   = vw::Quat(vw::math::rotation_z_axis(0.02) * rot_mat).axis_angle();
+  Vector2i image_size(3910, 2290);
+  OpticalBarModel model(image_size, Vector2(1957.24, 1112.51), 0.000112, 1.96, 0.5,
+                        true, 0, gcc, initial_pose, 0, 1.0, true,
+                        Vector3(-1000, -4000, 3000), final_pose);
+
+  OpticalBarModel cam = model;
+  cam.enable_pose_table();
+  ASSERT_TRUE(cam.has_pose_table());
+  EXPECT_FALSE(model.has_pose_table());
+
+  std::vector<Vector3> points;
+  for (double col = 0; col <= image_size[0] - 1; col += 151.3) {
+    for (double row = 0; row < image_size[1]; row += 207.7) {
+      Vector2 pix(col, row);
+      EXPECT_VECTOR_NEAR(model.camera_center(pix),   cam.camera_center(pix),   1e-6);
+      EXPECT_VECTOR_NEAR(model.pixel_to_vector(pix), cam.pixel_to_vector(pix), 1e-10);
+      Vector3 point = model.camera_center(pix) + 2e5*model.pixel_to_vector(pix);
+      EXPECT_VECTOR_NEAR(pix, cam.point_to_pixel(point), 1e-4);
+      points.push_back(point);
+    }
+  }
+
+  // Off the table the model is used
+  Vector2 off_pix(-20.5, 100);
+  EXPECT_VECTOR_NEAR(model.camera_center(off_pix),   cam.camera_center(off_pix),   1e-8);
+  EXPECT_VECTOR_NEAR(model.pixel_to_vector(off_pix), cam.pixel_to_vector(off_pix), 1e-12);
+
+  // The batch functions use the table too
+  std::vector<Vector2> pixels(points.size());
+  cam.points_to_pixels(&points[0], &pixels[0], points.size());
+  for (size_t i = 0; i < points.size(); i++)
+    EXPECT_VECTOR_NEAR(model.point_to_pixel(points[i]), pixels[i], 1e-4);
+
+  // Copies share the table, and it is dropped when the pose changes
+  OpticalBarModel cpy = cam;
+  EXPECT_TRUE(cpy.has_pose_table());
+  cpy.set_final_pose(initial_pose);
+  EXPECT_FALSE(cpy.has_pose_table());
+  cam.disable_pose_table();
+  EXPECT_FALSE(cam.has_pose_table());
+}
@@ -231,6 +231,35 @@ protected:
     }
   }
 
+  /// Check that the batch functions agree with the single-point ones,
+  ///  and that a point which cannot be projected gives an invalid pixel.
+  void batch_test(double tolerance=1e-8) {
+    std::vector<Vector2> pixels;
+    std::vector<Vector3> points;
+    Vector2 image_size = 2*pinhole.point_offset();
+    for ( unsigned x = 10; x < image_size.x(); x+=80 ) {
+      for ( unsigned y = 10; y < image_size.y(); y+=80 ) {
+        pixels.push_back(Vector2(x,y));
+        points.push_back(pinhole.camera_center() + (1.0 + 0.1*x)*pinhole.pixel_to_vector(Vector2(x,y)));
+      }
+    }
+    points.push_back(pinhole.camera_center());
+
+    size_t num = pixels.size();
+    std::vector<Vector2> batch_pixels(num + 1);
+    std::vector<Vector3> batch_vectors(num), batch_centers(num);
+    pinhole.points_to_pixels(&points[0], &batch_pixels[0], num + 1);
+    pinhole.pixels_to_vectors(&pixels[0], &batch_vectors[0], num);
+    pinhole.camera_centers(&pixels[0], &batch_centers[0], num);
+    for (size_t i = 0; i < num; i++) {
+      EXPECT_VECTOR_NEAR(pinhole.point_to_pixel(points[i]), batch_pixels[i], tolerance);
+      EXPECT_VECTOR_NEAR(pinhole.pixel_to_vector(pixels[i]), batch_vectors[i], tolerance);
+      EXPECT_VECTOR_NEAR(pinhole.camera_center(pixels[i]), batch_centers[i], tolerance);
+    }
+    EXPECT_THROW(pinhole.point_to_pixel(points[num]), PointToPixelErr);
+    EXPECT_VECTOR_EQ(CameraModel::invalid_pixel(), batch_pixels[num]);
+  }
+
   /// Write a .tsai file, then read it back in and make sure nothing has changed.
   void readback_test(std::string const& file) {
     pinhole.write( file );
@@ -259,6 +288,7 @@ protected:
 
 TEST_F( PinholeTest, NullLensDistortion ) {
   projection_test();
+  batch_test();
   UnlinkName file("NullCam.tsai");
   readback_test( file );
 
@@ -280,6 +310,7 @@ TEST_F( PinholeTest, TsaiLensDistortion ) {
   pinhole.set_lens_distortion(&lens);
 #if defined(VW_HAVE_PKG_LAPACK) && VW_HAVE_PKG_LAPACK==1
   projection_test(1e-4);
+  batch_test();
 #endif
   UnlinkName file("TsaiCam.tsai");
   readback_test( file );
@@ -318,6 +349,54 @@ TEST_F( PinholeTest, AdjustableTsaiDistortion ) {
   readback_test( file );
 }
 
+TEST_F( PinholeTest, DistortionTable ) {
+  // Adjustable Tsai needs a solver to undistort, and Brown-Conrady to distort
+  Vector<double> distort_coeff(6);
+  distort_coeff[0] = 0.007646500298509824;
+  distort_coeff[1] = -0.01743067138801845;
+  distort_coeff[2] = 0.00980946292640812;
+  distort_coeff[3] = -2.98092556225311e-05;
+  distort_coeff[4] = -1.339089765674149e-05;
+  distort_coeff[5] = -1.221974557659228e-05;
+  AdjustableTsaiLensDistortion tsai(distort_coeff);
+  BrownConradyDistortion brown(Vector2(-0.6,-0.2),
+                               Vector3(.1336185e-8, -0.5226175e-12, 0),
+                               Vector2(.5495819e-9, 0), 0.201);
+  LensDistortion const* lenses[] = {&tsai, &brown};
+
+  Vector2i image_size(2*pinhole.point_offset());
+  for (int k = 0; k < 2; k++) {
+    pinhole.set_lens_distortion(lenses[k]);
+    PinholeModel model = pinhole;
+    ASSERT_TRUE(pinhole.enable_distortion_table(image_size));
+    ASSERT_TRUE(pinhole.has_distortion_table());
+    EXPECT_FALSE(model.has_distortion_table());
+
+    for (int x = 0; x <= image_size.x(); x += 37) {
+      for (int y = 0; y <= image_size.y(); y += 29) {
+        Vector2 pix(x + 0.3, y + 0.6);
+        Vector3 point = model.camera_center() + 10.0*model.pixel_to_vector(pix);
+        EXPECT_VECTOR_NEAR(model.point_to_pixel(point), pinhole.point_to_pixel(point), 1e-3);
+        EXPECT_VECTOR_NEAR(model.pixel_to_vector(pix), pinhole.pixel_to_vector(pix), 1e-6);
+      }
+    }
+
+    // Copies share the table, and changing the intrinsics drops it
+    PinholeModel copy = pinhole;
+    EXPECT_TRUE(copy.has_distortion_table());
+    copy.set_focal_length(1.1*copy.focal_length());
+    EXPECT_FALSE(copy.has_distortion_table());
+    pinhole.set_lens_distortion(lenses[k]);
+    EXPECT_FALSE(pinhole.has_distortion_table());
+  }
+
+  // There is nothing to tabulate without distortion
+  NullLensDistortion null_lens;
+  pinhole.set_lens_distortion(&null_lens);
+  EXPECT_TRUE(pinhole.enable_distortion_table(image_size));
+  EXPECT_FALSE(pinhole.has_distortion_table());
+}
+
 TEST_F( PinholeTest, OldFormatReadTest ) {
   UnlinkName filename("monkey.tsai");
   std::ofstream filestream( filename.c_str() );
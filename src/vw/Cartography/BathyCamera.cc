@@ -28,6 +28,8 @@
 #include <vw/Math/NewtonRaphson.h>
 #include <vw/Core/Exception.h>
 
+#include <boost/scoped_array.hpp>
+
 namespace vw {
 
 namespace {
@@ -154,6 +156,51 @@ Vector3 datumBathyIntersection(Vector3 const& cam_ctr,
   return refracted_xyz;
 }
 
+// The batch version. The rays that end below the water surface are bent
+// together, and the bent rays meet the datum together.
+void datumBathyIntersection(Vector3 const* cam_ctrs,
+                            Vector3 const* cam_dirs,
+                            size_t num,
+                            double major_axis, double minor_axis,
+                            BathyPlane const& bathy_plane,
+                            double refraction_index,
+                            Vector3* xyz) {
+  if (num == 0)
+    return;
+
+  // First, intersect the rays with the datum
+  vw::cartography::datum_intersection(major_axis, minor_axis, cam_ctrs, cam_dirs,
+                                      xyz, num);
+
+  // Collect the rays that meet the datum below the water surface
+  std::vector<size_t> index;
+  std::vector<Vector3> ctrs, dirs;
+  for (size_t i = 0; i < num; i++) {
+    if (xyz[i] == Vector3(0, 0, 0))
+      continue;
+    if (signedDistToPlane(bathy_plane, xyz[i]) >= 0)
+      continue;
+    index.push_back(i);
+    ctrs.push_back(cam_ctrs[i]);
+    dirs.push_back(cam_dirs[i]);
+  }
+  size_t num_under = index.size();
+  if (num_under == 0)
+    return;
+
+  // Bend them, and continue the bent rays to the datum
+  std::vector<Vector3> out_xyz(num_under), out_dir(num_under), refracted_xyz(num_under);
+  boost::scoped_array<bool> success(new bool[num_under]);
+  curvedSnellLaw(&ctrs[0], &dirs[0], num_under, bathy_plane, refraction_index,
+                 &out_xyz[0], &out_dir[0], success.get());
+  vw::cartography::datum_intersection(major_axis, minor_axis, &out_xyz[0], &out_dir[0],
+                                      &refracted_xyz[0], num_under);
+
+  // A failure gives a zero vector, as does a refracted ray that misses
+  for (size_t k = 0; k < num_under; k++)
+    xyz[index[k]] = success[k] ? refracted_xyz[k] : Vector3(0, 0, 0);
+}
+
 // Project an ECEF point to camera pixel, accounting for bathymetry if the point
 // lies below the water surface. Fits a local ECEF tangent plane. Good for
 // shallow-water bathymetry so the point is at most meters deep. Degrades for
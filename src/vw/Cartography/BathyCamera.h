@@ -45,6 +45,17 @@ vw::Vector3 datumBathyIntersection(vw::Vector3 const& cam_ctr,
                                    BathyPlane const& bathy_plane,
                                    double refraction_index);
 
+// Batch version of datumBathyIntersection() for num rays, with the
+// intersections with the datum and the bending of the rays done for all
+// rays at once. The results are the same as for one ray at a time.
+void datumBathyIntersection(vw::Vector3 const* cam_ctrs,
+                            vw::Vector3 const* cam_dirs,
+                            size_t num,
+                            double major_axis, double minor_axis,
+                            BathyPlane const& bathy_plane,
+                            double refraction_index,
+                            vw::Vector3* xyz);
+
 // Project an ECEF point to pixel, accounting for bathymetry if the point
 // is below the bathy plane (water surface).
 vw::Vector2 point_to_pixel(vw::camera::CameraModel const* cam,
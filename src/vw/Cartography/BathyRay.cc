@@ -34,6 +34,8 @@
 #include <vw/Math/VectorUtils.h>
 #include <vw/Core/Exception.h>
 
+#include <boost/scoped_array.hpp>
+
 #include <cmath>
 
 namespace vw {
@@ -261,6 +263,56 @@ bool refineLocalPlaneFromRaster(BathyPlane const& bp,
   return true;
 }
 
+// Refine an intersection of a ray (in ECEF) with a curved bathy plane,
+// starting from intersect_ecef, which must be on the ray and near the
+// plane. Returns the refined point in ECEF and in projected coordinates,
+// and the ray direction at that location in projected coordinates.
+// Returns false if the refinement fails.
+bool refineRayBathyPlaneIntersect(vw::Vector3 const& in_ecef,
+                                  vw::Vector3 const& in_dir,
+                                  std::vector<double> const& plane,
+                                  vw::cartography::GeoReference const& plane_proj,
+                                  vw::Vector3 & intersect_ecef,
+                                  vw::Vector3 & intersect_proj_pt,
+                                  vw::Vector3 & intersect_proj_dir) {
+
+  // The fact that we trace a ray below in projected coordinates, even if very
+  // close to the bathy plane and very short, can still introduce some small
+  // error. So refine intersect_ecef so it is both along the ray in ECEF and on the
+  // curved plane.
+  for (int pass = 0; pass < 5; pass++) {
+
+    // Move a little up the ray. Move less on later passes.
+    vw::Vector3 prev_ecef = intersect_ecef - 1.0 * in_dir / (1.0 + 10.0 * pass);
+
+    // Compute projected entries. These will be exported out of this function.
+    intersect_proj_pt = vw::bathyProjPoint(plane_proj, intersect_ecef);
+    vw::Vector3 prev_proj_pt = vw::bathyProjPoint(plane_proj, prev_ecef);
+    intersect_proj_dir = intersect_proj_pt - prev_proj_pt;
+    intersect_proj_dir /= norm_2(intersect_proj_dir);
+
+    // Stop when we are within 0.1 mm of the plane, while along the ray. Going
+    // beyond that seems not useful. This is usually reached on second pass.
+
+    if (std::abs(signedDistToPlaneAux(plane, intersect_proj_pt)) < 1e-4)
+      break;
+
+    // Intersect the proj ray with the proj plane
+    vw::Vector3 refined_intersect_proj_pt;
+    if (!rayPlaneIntersect(intersect_proj_pt, intersect_proj_dir, plane,
+                           refined_intersect_proj_pt))
+      return false;
+
+    // Convert back to ECEF
+    intersect_ecef = vw::bathyUnprojPoint(plane_proj, refined_intersect_proj_pt);
+
+    // Put the point back on the ray. Then it may become slightly off the plane.
+    intersect_ecef = in_ecef + dot_prod(intersect_ecef - in_ecef, in_dir) * in_dir;
+  }
+
+  return true;
+}
+
 // Find where a ray (in ECEF) intersects a curved bathy plane. The plane is
 // modeled as flat in local stereographic projection. Returns the intersection
 // point in ECEF, the intersection point in projected coordinates, and the ray
@@ -294,41 +346,30 @@ bool rayBathyPlaneIntersect(vw::Vector3 const& in_ecef,
   intersect_ecef = vw::cartography::datum_intersection(major_radius, minor_radius,
                                                        in_ecef, in_dir);
 
-  // The fact that we trace a ray below in projected coordinates, even if very
-  // close to the bathy plane and very short, can still introduce some small
-  // error. So refine intersect_ecef so it is both along the ray in ECEF and on the
-  // curved plane.
-  for (int pass = 0; pass < 5; pass++) {
-
-    // Move a little up the ray. Move less on later passes.
-    vw::Vector3 prev_ecef = intersect_ecef - 1.0 * in_dir / (1.0 + 10.0 * pass);
-
-    // Compute projected entries. These will be exported out of this function.
-    intersect_proj_pt = vw::bathyProjPoint(plane_proj, intersect_ecef);
-    vw::Vector3 prev_proj_pt = vw::bathyProjPoint(plane_proj, prev_ecef);
-    intersect_proj_dir = intersect_proj_pt - prev_proj_pt;
-    intersect_proj_dir /= norm_2(intersect_proj_dir);
-
-    // Stop when we are within 0.1 mm of the plane, while along the ray. Going
-    // beyond that seems not useful. This is usually reached on second pass.
-
-    if (std::abs(signedDistToPlaneAux(plane, intersect_proj_pt)) < 1e-4)
-      break;
+  return refineRayBathyPlaneIntersect(in_ecef, in_dir, plane, plane_proj,
+                                      intersect_ecef, intersect_proj_pt,
+                                      intersect_proj_dir);
+}
 
-    // Intersect the proj ray with the proj plane
-    vw::Vector3 refined_intersect_proj_pt;
-    if (!rayPlaneIntersect(intersect_proj_pt, intersect_proj_dir, plane,
-                           refined_intersect_proj_pt))
-      return false;
+// Convert a ray bent at the water surface in projected coordinates back
+// to ECEF, by undoing the projection of its start and of a point 1 m
+// further along it. The assumption here is that at ground level a short
+// vector in ECEF is very close to the same short vector in projected
+// coordinates.
+void unprojBentRay(vw::cartography::GeoReference const& plane_proj,
+                   vw::Vector3 const& out_proj_pt, vw::Vector3 const& out_proj_dir,
+                   vw::Vector3 & out_ecef, vw::Vector3 & out_dir) {
 
-    // Convert back to ECEF
-    intersect_ecef = vw::bathyUnprojPoint(plane_proj, refined_intersect_proj_pt);
+  // Move a little on the ray in projected coordinates.
+  vw::Vector3 next_proj_pt = out_proj_pt + 1.0 * out_proj_dir;
 
-    // Put the point back on the ray. Then it may become slightly off the plane.
-    intersect_ecef = in_ecef + dot_prod(intersect_ecef - in_ecef, in_dir) * in_dir;
-  }
+  // Convert back to ECEF
+  out_ecef = vw::bathyUnprojPoint(plane_proj, out_proj_pt);
+  vw::Vector3 next_ecef = vw::bathyUnprojPoint(plane_proj, next_proj_pt);
 
-  return true;
+  // The outgoing direction according to Snell's law in ECEF
+  out_dir = next_ecef - out_ecef;
+  out_dir /= norm_2(out_dir);
 }
 
 // Given a ray in ECEF and a water surface which is a plane only in a local
@@ -366,18 +407,7 @@ bool curvedSnellLawAgainstPlane(vw::Vector3 const& in_ecef, vw::Vector3 const& i
   if (!ans)
     return ans;
 
-  // Move a little on the ray in projected coordinates.
-  vw::Vector3 next_proj_pt = out_proj_pt + 1.0 * out_proj_dir;
-
-  // Convert back to ECEF
-  out_ecef = vw::bathyUnprojPoint(plane_proj, out_proj_pt);
-  vw::Vector3 next_ecef = vw::bathyUnprojPoint(plane_proj, next_proj_pt);
-
-  // Finally get the outgoing direction according to Snell's law in ECEF.
-  // The assumption here is that at ground level a short vector in ECEF
-  // is very close to the same short vector in projected coordinates.
-  out_dir = next_ecef - out_ecef;
-  out_dir /= norm_2(out_dir);
+  unprojBentRay(plane_proj, out_proj_pt, out_proj_dir, out_ecef, out_dir);
 
   // Sanity check
   // testSnellLaw(plane, plane_proj, refraction_index, out_ecef, in_dir, out_dir,
@@ -445,6 +475,70 @@ bool curvedSnellLaw(vw::Vector3 const& in_ecef,
                                     out_ecef, out_dir);
 }
 
+// The batch version. Without a raster all rays bend at the same plane,
+// so the seeds on the mean water surface and the bending in projected
+// coordinates are done for all rays at once. The refinement of the
+// intersection and the conversions between ECEF and projected
+// coordinates remain per ray. With a raster the plane differs from ray
+// to ray, so each ray goes through curvedSnellLaw().
+void curvedSnellLaw(vw::Vector3 const* in_ecef,
+                    vw::Vector3 const* in_dir,
+                    size_t num,
+                    BathyPlane const& bp,
+                    double refraction_index,
+                    vw::Vector3* out_ecef,
+                    vw::Vector3* out_dir,
+                    bool* success) {
+
+  if (bp.water_surface.cols() > 0) {
+    for (size_t i = 0; i < num; i++)
+      success[i] = curvedSnellLaw(in_ecef[i], in_dir[i], bp, refraction_index,
+                                  out_ecef[i], out_dir[i]);
+    return;
+  }
+  if (num == 0)
+    return;
+
+  // Seed each intersection on the mean water surface, as
+  // rayBathyPlaneIntersect() does
+  vw::cartography::GeoReference const& plane_proj = bp.stereographic_proj;
+  std::vector<vw::Vector3> seeds(num);
+  vw::cartography::datum_intersection(plane_proj.datum().semi_major_axis() + bp.mean_height,
+                                      plane_proj.datum().semi_minor_axis() + bp.mean_height,
+                                      in_ecef, in_dir, &seeds[0], num);
+
+  // Refine each intersection. Only the rays that meet the surface are bent.
+  std::vector<size_t> index;
+  std::vector<vw::Vector3> proj_pts, proj_dirs;
+  index.reserve(num); proj_pts.reserve(num); proj_dirs.reserve(num);
+  for (size_t i = 0; i < num; i++) {
+    vw::Vector3 proj_pt, proj_dir;
+    success[i] = refineRayBathyPlaneIntersect(in_ecef[i], in_dir[i], bp.bathy_plane,
+                                              plane_proj, seeds[i], proj_pt, proj_dir);
+    if (!success[i])
+      continue;
+    index.push_back(i);
+    proj_pts.push_back(proj_pt);
+    proj_dirs.push_back(proj_dir);
+  }
+  size_t num_hit = index.size();
+  if (num_hit == 0)
+    return;
+
+  // Snell's law in projected coordinates, for all rays at once
+  std::vector<vw::Vector3> bent_pts(num_hit), bent_dirs(num_hit);
+  boost::scoped_array<bool> bent(new bool[num_hit]);
+  snellLaw(&proj_pts[0], &proj_dirs[0], num_hit, bp.bathy_plane, refraction_index,
+           &bent_pts[0], &bent_dirs[0], bent.get());
+
+  for (size_t k = 0; k < num_hit; k++) {
+    size_t i = index[k];
+    success[i] = bent[k];
+    if (success[i])
+      unprojBentRay(plane_proj, bent_pts[k], bent_dirs[k], out_ecef[i], out_dir[i]);
+  }
+}
+
 // Test Snell's law in projected and unprojected coordinates
 void testSnellLaw(std::vector<double> const& plane,
                   vw::cartography::GeoReference const& plane_proj,
@@ -66,6 +66,20 @@ bool curvedSnellLaw(vw::Vector3 const& in_ecef,
                     vw::Vector3& out_ecef,
                     vw::Vector3& out_dir);
 
+// Batch version of curvedSnellLaw() for num rays. success[i] says if
+// ray i was bent, and the outputs of rays that were not are left as
+// they were. The results are the same as from curvedSnellLaw(). Without
+// a raster water surface the seeding and bending of the rays are done
+// with SIMD kernels for all rays at once.
+void curvedSnellLaw(vw::Vector3 const* in_ecef,
+                    vw::Vector3 const* in_dir,
+                    size_t num,
+                    BathyPlane const& bp,
+                    double refraction_index,
+                    vw::Vector3* out_ecef,
+                    vw::Vector3* out_dir,
+                    bool* success);
+
 } // namespace vw
 
 #endif // __VW_CARTOGRAPHY_BATHYRAY_H__
@@ -31,6 +31,8 @@
 #include <vw/Math/Vector.h>
 #include <vw/Core/Exception.h>
 
+#include <boost/scoped_array.hpp>
+
 namespace vw {
 
 // Settings used for bathymetry correction
@@ -181,64 +183,196 @@ Vector3 BathyStereoModel::operator()(std::vector<Vector2> const& pixVec,
         return uncorr_tri_pt;
     }
 
-    // Each ray has two parts: before bending and after it. Two
-    // bent rays can intersect on their unbent parts, the bent part
-    // of one ray with unbent part of another ray, unbent part of
-    // one ray with bent part of another ray, and bent parts of both
-    // rays. Handle all these with much care.
-
-    Vector3 err, tri_pt;
-    std::vector<double> signed_dists;
-
-    // See if the unbent portions intersect above their planes
-    tri_pt = vw::stereo::triangulate_pair(camDirs[0], camCtrs[0], camDirs[1], camCtrs[1], err);
-    signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
-    if (signed_dists[0] >= 0 && signed_dists[1] >= 0) {
-      did_bathy = false; // since the rays did not reach the bathy plane
-      errorVec = err;
-      return tri_pt;
-    }
+    return triangulate_bent_pair(camDirs, camCtrs, waterDirs, waterCtrs,
+                                 errorVec, did_bathy);
 
-    // See if the bent portions intersect below their planes
-    tri_pt = vw::stereo::triangulate_pair(waterDirs[0], waterCtrs[0],
-                                          waterDirs[1], waterCtrs[1], err);
-    signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
-    if (signed_dists[0] <= 0 && signed_dists[1] <= 0) {
-      did_bathy = true; // the resulting point is at least under one plane
-      errorVec = err;
-      return tri_pt;
-    }
+  } catch (const camera::PixelToRayErr& /*e*/) {}
 
-    // See if the left unbent portion intersects the right bent portion,
-    // above left's water plane and below right's water plane
-    tri_pt = vw::stereo::triangulate_pair(camDirs[0], camCtrs[0], waterDirs[1],
-                                          waterCtrs[1], err);
-    signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
-    if (signed_dists[0] >= 0 && signed_dists[1] <= 0) {
-      did_bathy = true; // the resulting point is at least under one plane
-      errorVec = err;
-      return tri_pt;
-    }
+  // We arrive here only when there's bad luck
+  did_bathy = false;
+  errorVec = vw::Vector3();
+  return vw::Vector3();
+}
 
-    // See if the left bent portion intersects the right unbent portion,
-    // below left's water plane and above right's water plane
-    tri_pt = vw::stereo::triangulate_pair(waterDirs[0], waterCtrs[0],
-                                          camDirs[1], camCtrs[1], err);
-    signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
-    if (signed_dists[0] <= 0 && signed_dists[1] >= 0) {
-      did_bathy = true; // the resulting point is at least under one plane
-      errorVec = err;
-      return tri_pt;
-    }
+// With a water plane for each image, find where two bent rays meet.
+Vector3 BathyStereoModel::triangulate_bent_pair(std::vector<Vector3> const& camDirs,
+                                                std::vector<Vector3> const& camCtrs,
+                                                std::vector<Vector3> const& waterDirs,
+                                                std::vector<Vector3> const& waterCtrs,
+                                                Vector3& errorVec,
+                                                bool & did_bathy) const {
+
+  // Each ray has two parts: before bending and after it. Two
+  // bent rays can intersect on their unbent parts, the bent part
+  // of one ray with unbent part of another ray, unbent part of
+  // one ray with bent part of another ray, and bent parts of both
+  // rays. Handle all these with much care.
+
+  Vector3 err, tri_pt;
+  std::vector<double> signed_dists;
+
+  // See if the unbent portions intersect above their planes
+  tri_pt = vw::stereo::triangulate_pair(camDirs[0], camCtrs[0], camDirs[1], camCtrs[1], err);
+  signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
+  if (signed_dists[0] >= 0 && signed_dists[1] >= 0) {
+    did_bathy = false; // since the rays did not reach the bathy plane
+    errorVec = err;
+    return tri_pt;
+  }
 
-  } catch (const camera::PixelToRayErr& /*e*/) {}
+  // See if the bent portions intersect below their planes
+  tri_pt = vw::stereo::triangulate_pair(waterDirs[0], waterCtrs[0],
+                                        waterDirs[1], waterCtrs[1], err);
+  signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
+  if (signed_dists[0] <= 0 && signed_dists[1] <= 0) {
+    did_bathy = true; // the resulting point is at least under one plane
+    errorVec = err;
+    return tri_pt;
+  }
 
-  // We arrive here only when there's bad luck
+  // See if the left unbent portion intersects the right bent portion,
+  // above left's water plane and below right's water plane
+  tri_pt = vw::stereo::triangulate_pair(camDirs[0], camCtrs[0], waterDirs[1],
+                                        waterCtrs[1], err);
+  signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
+  if (signed_dists[0] >= 0 && signed_dists[1] <= 0) {
+    did_bathy = true; // the resulting point is at least under one plane
+    errorVec = err;
+    return tri_pt;
+  }
+
+  // See if the left bent portion intersects the right unbent portion,
+  // below left's water plane and above right's water plane
+  tri_pt = vw::stereo::triangulate_pair(waterDirs[0], waterCtrs[0],
+                                        camDirs[1], camCtrs[1], err);
+  signedDistToPlanes(m_bathy_plane_vec, tri_pt, signed_dists);
+  if (signed_dists[0] <= 0 && signed_dists[1] >= 0) {
+    did_bathy = true; // the resulting point is at least under one plane
+    errorVec = err;
+    return tri_pt;
+  }
+
+  // No combination of the parts of the rays works
   did_bathy = false;
   errorVec = vw::Vector3();
   return vw::Vector3();
 }
 
+// The batch version. The rays are found with one batch call per camera,
+// and the rays that need bending are bent together for each camera.
+void BathyStereoModel::triangulate_pairs(Vector2 const* pix1, Vector2 const* pix2,
+                                         size_t num, bool do_bathy,
+                                         Vector3* points, Vector3* errorVecs,
+                                         bool* did_bathy) const {
+
+  VW_ASSERT(m_cameras.size() == 2,
+            vw::ArgumentErr() << "Batch triangulation needs two cameras.\n");
+  if (do_bathy && !m_bathy_correct)
+    vw::vw_throw(vw::ArgumentErr()
+                  << "Requested to do bathymetry correction while "
+                  << "this mode was not set up.");
+
+  // Only the pairs of valid pixels are passed to the cameras
+  std::vector<size_t>  index;
+  std::vector<Vector2> valid1, valid2;
+  index.reserve(num); valid1.reserve(num); valid2.reserve(num);
+  for (size_t i = 0; i < num; i++) {
+    points[i]    = Vector3();
+    errorVecs[i] = Vector3();
+    did_bathy[i] = false;
+    if (pix1[i] != pix1[i] || pix1[i] == camera::CameraModel::invalid_pixel() ||
+        pix2[i] != pix2[i] || pix2[i] == camera::CameraModel::invalid_pixel())
+      continue;
+    index.push_back(i);
+    valid1.push_back(pix1[i]);
+    valid2.push_back(pix2[i]);
+  }
+  size_t num_valid = index.size();
+  if (num_valid == 0)
+    return;
+
+  // A failed ray comes back as a zero vector
+  std::vector<Vector3> dirs[2], ctrs[2];
+  for (int it = 0; it < 2; it++) {
+    std::vector<Vector2> const& pix = (it == 0) ? valid1 : valid2;
+    dirs[it].resize(num_valid);
+    ctrs[it].resize(num_valid);
+    m_cameras[it]->pixels_to_vectors(&pix[0], &dirs[it][0], num_valid);
+    m_cameras[it]->camera_centers   (&pix[0], &ctrs[it][0], num_valid);
+  }
+
+  // Triangulate without bending, and find which rays must be bent
+  std::vector<size_t> bend;
+  std::vector<Vector3> camDirs(2), camCtrs(2);
+  for (size_t k = 0; k < num_valid; k++) {
+    if (dirs[0][k] == Vector3() || dirs[1][k] == Vector3())
+      continue;
+    size_t i = index[k];
+    for (int it = 0; it < 2; it++) {
+      camDirs[it] = dirs[it][k];
+      camCtrs[it] = ctrs[it][k];
+    }
+    if (are_nearly_parallel(m_angle_tol, camDirs))
+      continue;
+
+    Vector3 uncorr_tri_pt = triangulate_point(camDirs, camCtrs, errorVecs[i]);
+    if (!m_bathy_correct) {
+      bool reflect = false;
+      for (int p = 0; p < 2; p++)
+        if (dot_prod(uncorr_tri_pt - camCtrs[p], camDirs[p]) < 0)
+          reflect = true;
+      if (reflect)
+        uncorr_tri_pt = -uncorr_tri_pt + 2*camCtrs[0];
+    }
+    points[i] = uncorr_tri_pt;
+
+    if (!do_bathy)
+      continue;
+    if (m_single_bathy_plane && signedDistToPlane(m_bathy_plane_vec[0], uncorr_tri_pt) >= 0)
+      continue; // the rays intersect above the water surface
+    bend.push_back(k);
+  }
+  size_t num_bend = bend.size();
+  if (num_bend == 0)
+    return;
+
+  // Bend the rays of each camera at its water surface
+  std::vector<Vector3> bendDirs[2], bendCtrs[2], waterDirs[2], waterCtrs[2];
+  boost::scoped_array<bool> bent[2];
+  for (int it = 0; it < 2; it++) {
+    bendDirs[it].resize(num_bend);  bendCtrs[it].resize(num_bend);
+    waterDirs[it].resize(num_bend); waterCtrs[it].resize(num_bend);
+    bent[it].reset(new bool[num_bend]);
+    for (size_t b = 0; b < num_bend; b++) {
+      bendDirs[it][b] = dirs[it][bend[b]];
+      bendCtrs[it][b] = ctrs[it][bend[b]];
+    }
+    curvedSnellLaw(&bendCtrs[it][0], &bendDirs[it][0], num_bend,
+                   m_bathy_plane_vec[it], m_refraction_index,
+                   &waterCtrs[it][0], &waterDirs[it][0], bent[it].get());
+  }
+
+  // Intersect the bent rays. A pair that failed to bend keeps the
+  // point found without bending.
+  std::vector<Vector3> bentDirs(2), bentCtrs(2);
+  for (size_t b = 0; b < num_bend; b++) {
+    if (!bent[0][b] || !bent[1][b])
+      continue;
+    size_t i = index[bend[b]];
+    for (int it = 0; it < 2; it++) {
+      camDirs[it]  = bendDirs[it][b];  camCtrs[it]  = bendCtrs[it][b];
+      bentDirs[it] = waterDirs[it][b]; bentCtrs[it] = waterCtrs[it][b];
+    }
+    if (m_single_bathy_plane) {
+      points[i] = triangulate_point(bentDirs, bentCtrs, errorVecs[i]);
+      did_bathy[i] = true;
+    } else {
+      points[i] = triangulate_bent_pair(camDirs, camCtrs, bentDirs, bentCtrs,
+                                        errorVecs[i], did_bathy[i]);
+    }
+  }
+}
+
 Vector3 BathyStereoModel::operator()(std::vector<Vector2> const& pixVec,
                                       double& error) const {
   vw::vw_throw(vw::NoImplErr() << "Not implemented for BathyStereoModel.");
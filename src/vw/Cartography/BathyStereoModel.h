@@ -72,12 +72,33 @@ public:
   virtual vw::Vector3 operator()(vw::Vector2 const& pix1, vw::Vector2 const& pix2,
                                  double & error) const;
 
+  /// Triangulate num pairs of pixels with two cameras, as the first
+  /// operator() does for each pair. The rays of each camera are found,
+  /// and those that need it are bent, for all pairs at once, which is
+  /// faster when triangulating a whole image.
+  void triangulate_pairs(vw::Vector2 const* pix1, vw::Vector2 const* pix2, size_t num,
+                         bool do_bathy, vw::Vector3* points, vw::Vector3* errorVecs,
+                         bool* did_bathy) const;
+
+  /// The StereoModel version, which does no bathymetry correction.
+  using vw::stereo::StereoModel::triangulate_pairs;
+
   // Settings used for bathymetry correction. The left and right images
   // get individual bathy plane settings, but they may be identical.
   void set_bathy(double refraction_index,
                  std::vector<BathyPlane> const& bathy_plane_vec);
 
 private:
+
+  // With a water plane for each image, find where two bent rays meet,
+  // trying each combination of the parts of the rays above and below
+  // the water. Returns a zero vector if none works.
+  vw::Vector3 triangulate_bent_pair(std::vector<vw::Vector3> const& camDirs,
+                                    std::vector<vw::Vector3> const& camCtrs,
+                                    std::vector<vw::Vector3> const& waterDirs,
+                                    std::vector<vw::Vector3> const& waterCtrs,
+                                    vw::Vector3& errorVec, bool & did_bathy) const;
+
   bool m_bathy_correct;                        // If to do bathy correction
   bool m_single_bathy_plane;                   // if the left and right images use same plane 
   double m_refraction_index;                   // Water refraction index
@@ -22,6 +22,9 @@
 #include <vw/Image/Interpolation.h>
 #include <vw/Math/LevenbergMarquardt.h>
 #include <vw/Cartography/PointImageManipulation.h>
+#include <vw/Cartography/DemRayIntersector.h>
+#include <vw/Core/Settings.h>
+#include <vw/Core/ThreadPool.h>
 
 using vw::math::BresenhamLine;
 
@@ -144,6 +147,20 @@ namespace detail {
         m_coords->clear();
     }
 
+    // Convert an intersection to the target projection
+    static bool xyz_to_point(GeoReference const& target_georef,
+                             Vector3 const& xyz, Vector2 & point) {
+      try {
+        // Use the datum to convert GCC coordinate to lon/lat/height
+        // and to a projected coordinate system
+        Vector3 llh = target_georef.datum().cartesian_to_geodetic(xyz);
+        point = target_georef.lonlat_to_point(Vector2(llh.x(), llh.y()));
+        return true;
+      } catch (...) {
+        return false;
+      }
+    }
+
     // This is a function we don't want exposed outside the logic of this file,
     // as we make too many particular choices.
     static bool pix_to_pt_aux(Vector2 const& pixel,
@@ -175,17 +192,23 @@ namespace detail {
         if (!has_intersection || xyz == Vector3())
           return false;
 
-        // Use the datum to convert GCC coordinate to lon/lat/height
-        // and to a projected coordinate system
-        Vector3 llh = target_georef.datum().cartesian_to_geodetic(xyz);
-        point = target_georef.lonlat_to_point(Vector2(llh.x(), llh.y()));
-
-        return has_intersection;
+        return xyz_to_point(target_georef, xyz, point);
       } catch (...) {
         return false;
       }
     }
 
+    /// Intersect many pixels with the DEM at once, with the same choices
+    /// as pix_to_pt_aux(). Failed pixels get Vector3().
+    void intersect(std::vector<Vector2> const& pixels, std::vector<Vector3> & xyz,
+                   std::vector<Vector3> const* xyz_guesses = NULL) const {
+      bool   treat_nodata_as_zero = false;
+      double height_error_tol     = 1e-3;
+      camera_pixels_to_dem_xyz(m_camera.get(), pixels, m_dem, m_dem_georef,
+                               treat_nodata_as_zero, xyz, height_error_tol,
+                               m_height_guess, xyz_guesses);
+    }
+
     /// Intersect this pixel with the DEM and record some information about the intersection
     void operator()(Vector2 const& pixel) {
 
@@ -201,7 +224,23 @@ namespace detail {
         m_last_valid = false;
         return;
       }
+      record(pixel, point, xyz);
+    }
 
+    /// Record an intersection of this pixel found elsewhere. Vector3()
+    /// means there was none.
+    void add_intersection(Vector2 const& pixel, Vector3 const& xyz) {
+      Vector2 point;
+      if (xyz == Vector3() || !xyz_to_point(m_target_georef, xyz, point)) {
+        m_last_valid = false;
+        return;
+      }
+      record(pixel, point, xyz);
+    }
+
+  private:
+
+    void record(Vector2 const& pixel, Vector2 const& point, Vector3 const& xyz) {
       if (m_last_valid) {
         // If the call before this successfully intersected, compute
         // distance from last intersection.
@@ -219,7 +258,6 @@ namespace detail {
       
       m_last_valid = true; // Record intersection success
       cam_pixels.push_back(pixel);
-
     }
   }; // End class CameraDemHelper
 
@@ -234,6 +272,12 @@ namespace detail {
     }
   }
 
+  /// Collect the pixels visited by bresenham_apply()
+  struct PixelCollector {
+    std::vector<Vector2> pixels;
+    void operator()(Vector2 const& pixel) { pixels.push_back(pixel); }
+  };
+
   // Collect valid pixel coordinates on the perimeter of the DEM,
   // and also inside using an X pattern. Some of these points may be duplicated.
   void sample_points_on_dem(vw::ImageViewRef<vw::PixelMask<float>> const& dem,
@@ -612,6 +656,107 @@ Vector3 camera_pixel_to_dem_xyz(Vector3 const& camera_ctr, Vector3 const& camera
   return Vector3();
 }
 
+// Intersect with a DEM the rays through many pixels of a camera. See the .h
+// file for details.
+void camera_pixels_to_dem_xyz(camera::CameraModel const* camera,
+                              std::vector<Vector2> const& pixels,
+                              vw::ImageViewRef<vw::PixelMask<float>> const& dem_image,
+                              GeoReference const& georef,
+                              bool treat_nodata_as_zero,
+                              std::vector<Vector3> & xyz,
+                              double height_error_tol,
+                              double height_guess,
+                              std::vector<Vector3> const* xyz_guesses,
+                              int num_threads) {
+
+  // Loading more than this many DEM pixels is not worth the memory
+  const double MAX_LOADED_PIXELS = 8.0 * 1024 * 1024;
+
+  size_t num = pixels.size();
+  xyz.assign(num, Vector3());
+  if (num == 0)
+    return;
+  if (num_threads <= 0)
+    num_threads = vw_settings().default_num_threads();
+  if (std::isnan(height_guess))
+    height_guess = vw::cartography::demHeightGuess(dem_image);
+
+  // The rays. A ray the camera cannot produce is left as zero.
+  std::vector<Vector3> ctrs(num), vecs(num);
+  process_in_parallel(num, num_threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      try {
+        ctrs[i] = camera->camera_center(pixels[i]);
+        vecs[i] = camera->pixel_to_vector(pixels[i]);
+      } catch (...) {
+        vecs[i] = Vector3();
+      }
+    }
+  });
+
+  // Load the whole DEM if small enough, otherwise the part around where
+  // the rays meet the datum raised to the typical DEM height.
+  BBox2i dem_box = bounding_box(dem_image), region;
+  if (double(dem_box.width()) * dem_box.height() <= MAX_LOADED_PIXELS) {
+    region = dem_box;
+  } else {
+    BBox2 footprint;
+    Datum const& datum = georef.datum();
+    for (size_t i = 0; i < num; i++) {
+      if (vecs[i] == Vector3())
+        continue;
+      Vector3 p = datum_intersection(datum.semi_major_axis() + height_guess,
+                                     datum.semi_minor_axis() + height_guess,
+                                     ctrs[i], vecs[i]);
+      if (p == Vector3())
+        continue;
+      try {
+        Vector3 llh = datum.cartesian_to_geodetic(p);
+        footprint.grow(georef.lonlat_to_pixel(Vector2(llh.x(), llh.y())));
+      } catch (...) {}
+    }
+    if (!footprint.empty()) {
+      footprint.expand(std::max(64.0, 0.25 * std::max(footprint.width(),
+                                                       footprint.height())));
+      region = grow_bbox_to_int(footprint);
+      region.crop(dem_box);
+      if (double(region.width()) * region.height() > MAX_LOADED_PIXELS)
+        region = BBox2i();
+    }
+  }
+
+  boost::shared_ptr<DemRayIntersector> intersector;
+  if (!region.empty())
+    intersector.reset(new DemRayIntersector(dem_image, georef, region,
+                                            treat_nodata_as_zero, height_error_tol));
+
+  process_in_parallel(num, num_threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (vecs[i] == Vector3())
+        continue;
+      bool has_intersection = false, in_region = false;
+      try {
+        if (intersector) {
+          Vector3 p = intersector->intersect(ctrs[i], vecs[i], has_intersection, in_region);
+          if (in_region) {
+            if (has_intersection)
+              xyz[i] = p;
+            continue;
+          }
+        }
+        Vector3 guess;
+        if (xyz_guesses != NULL && i < xyz_guesses->size())
+          guess = (*xyz_guesses)[i];
+        Vector3 p = camera_pixel_to_dem_xyz(ctrs[i], vecs[i], dem_image, georef,
+                                            treat_nodata_as_zero, has_intersection,
+                                            height_error_tol, guess, height_guess);
+        if (has_intersection)
+          xyz[i] = p;
+      } catch (...) {}
+    }
+  });
+}
+
 // Camera footprint on the datum.
 BBox2 camera_bbox(cartography::GeoReference const& georef,
                   boost::shared_ptr<camera::CameraModel> camera_model,
@@ -661,32 +806,39 @@ void sampleImageBoundary(int cols, int rows, int num_samples, bool quick,
   
   // Running the edges. Note: The last valid point on a
   // BresenhamLine is the last point before the endpoint.
-
-  // Left to right across the top side
-  functor.m_last_valid = false;
-  bresenham_apply(math::BresenhamLine(0,0,cols,0), image_step, functor);
-
-  // Top to bottom down the right side
-  functor.m_last_valid = false;
-  bresenham_apply(math::BresenhamLine(cols-1,0,cols-1,rows), image_step, functor);
-
-  // Right to left across the bottom side
-  functor.m_last_valid = false;
-  bresenham_apply(math::BresenhamLine(cols-1,rows-1,0,rows-1), image_step, functor);
-
-  // Bottom to top up the left side
-  functor.m_last_valid = false;
-  bresenham_apply(math::BresenhamLine(0,rows-1,0,0), image_step, functor);
-
+  std::vector<math::BresenhamLine> lines;
+  lines.push_back(math::BresenhamLine(0,0,cols,0));              // Left to right across the top
+  lines.push_back(math::BresenhamLine(cols-1,0,cols-1,rows));    // Down the right side
+  lines.push_back(math::BresenhamLine(cols-1,rows-1,0,rows-1));  // Right to left across the bottom
+  lines.push_back(math::BresenhamLine(0,rows-1,0,0));            // Up the left side
   if (!quick) {
     // Do the x pattern
+    lines.push_back(math::BresenhamLine(0,0,cols-1,rows-1));
+    lines.push_back(math::BresenhamLine(0,rows-1,cols-1,0));
+  }
+
+  // Intersect the pixels on all lines at once
+  std::vector<std::vector<Vector2>> line_pixels(lines.size());
+  std::vector<Vector2> pixels;
+  for (size_t it = 0; it < lines.size(); it++) {
+    detail::PixelCollector collector;
+    bresenham_apply(lines[it], image_step, collector);
+    line_pixels[it] = collector.pixels;
+    pixels.insert(pixels.end(), collector.pixels.begin(), collector.pixels.end());
+  }
+  std::vector<Vector3> xyz;
+  functor.intersect(pixels, xyz);
+
+  // Record them in order, one line at a time
+  size_t count = 0;
+  for (size_t it = 0; it < lines.size(); it++) {
     functor.m_last_valid = false;
-    bresenham_apply(math::BresenhamLine(0,0,cols-1,rows-1), image_step, functor);
-    
-    functor.m_last_valid = false;
-    bresenham_apply(math::BresenhamLine(0,rows-1,cols-1,0), image_step, functor);
-    functor.m_last_valid = false;
+    for (size_t k = 0; k < line_pixels[it].size(); k++) {
+      functor.add_intersection(line_pixels[it][k], xyz[count]);
+      count++;
+    }
   }
+  functor.m_last_valid = false;
 
   return;
 }
@@ -809,14 +961,14 @@ double calcMeanGsd(int cols, int rows,
                    detail::CameraDemHelper const& functor,
                    std::vector<Vector2> const& cam_pixels,
                    std::map<std::pair<double, double>, Vector3> const& pix2xyz,
-                   vw::ImageViewRef<vw::PixelMask<float>> const& dem,
-                   GeoReference const& dem_georef,
-                   GeoReference const& target_georef,
-                   boost::shared_ptr<vw::camera::CameraModel> const& camera_model,
-                   double height_guess) {
+                   GeoReference const& target_georef) {
 
-  std::vector<double> gsd;
+  // Each sampled pixel, cast to int, is intersected together with its
+  // four neighbors. Collect all of them and intersect them at once.
   BBox2i image_box(0, 0, cols, rows);
+  std::vector<Vector2> pixels;
+  std::vector<Vector3> guesses;
+  std::vector<std::pair<size_t, size_t>> groups; // start and size in pixels
   for (size_t it = 0; it < cam_pixels.size(); it++) {
 
     // Note how we cast to int
@@ -824,25 +976,19 @@ double calcMeanGsd(int cols, int rows,
     if (!image_box.contains(ctr_pix))
       continue;
 
-    Vector2 ctr_point;
-    Vector3 xyz_guess, xyz;
-
     // If we ran into into this pixel before, we have an idea of its xyz.
     // This will help with intersections below. Use here the original
     // pixel, not the one cast to int.
+    Vector3 xyz_guess;
     auto coord_pair = std::make_pair(cam_pixels[it].x(), cam_pixels[it].y());
     auto xyz_it = pix2xyz.find(coord_pair);
     if (xyz_it != pix2xyz.end()) {
       xyz_guess = xyz_it->second;
     }
 
-    bool has_intersection
-      = functor.pix_to_pt_aux(ctr_pix, dem, dem_georef, target_georef,  camera_model, 
-                              xyz_guess, height_guess,
-                              ctr_point, xyz); // outputs
-
-    if (!has_intersection)
-      continue;
+    size_t start = pixels.size();
+    pixels.push_back(ctr_pix);
+    guesses.push_back(xyz_guess);
 
     // Four neighboring pixels. Use the same guess.
     for (int j = 0; j < 4; j++) {
@@ -853,15 +999,28 @@ double calcMeanGsd(int cols, int rows,
       if (j == 3) off_pix += Vector2i(0, -1);
       if (!image_box.contains(off_pix))
         continue;
+      pixels.push_back(off_pix);
+      guesses.push_back(xyz_guess);
+    }
+    groups.push_back(std::make_pair(start, pixels.size() - start));
+  }
+
+  std::vector<Vector3> xyz;
+  functor.intersect(pixels, xyz, &guesses);
+
+  std::vector<double> gsd;
+  for (size_t g = 0; g < groups.size(); g++) {
+    size_t start = groups[g].first, size = groups[g].second;
+    Vector2 ctr_point;
+    if (xyz[start] == Vector3() ||
+        !functor.xyz_to_point(target_georef, xyz[start], ctr_point))
+      continue;
 
+    for (size_t k = start + 1; k < start + size; k++) {
       Vector2 off_point;
-      bool has_intersection
-        = functor.pix_to_pt_aux(off_pix, dem, dem_georef, target_georef, camera_model,
-                                xyz_guess, height_guess,
-                                off_point, xyz); // outputs
-      if (!has_intersection)
+      if (xyz[k] == Vector3() ||
+          !functor.xyz_to_point(target_georef, xyz[k], off_point))
         continue;
-
       gsd.push_back(norm_2(ctr_point-off_point));
     }
   }
@@ -953,9 +1112,7 @@ BBox2 camera_bbox(vw::ImageViewRef<vw::PixelMask<float>> const& dem,
   }
 
   // Find the mean GSD
-  mean_gsd = calcMeanGsd(cols, rows, functor, cam_pixels, pix2xyz,
-                         dem, dem_georef, target_georef, camera_model,
-                         height_guess);
+  mean_gsd = calcMeanGsd(cols, rows, functor, cam_pixels, pix2xyz, target_georef);
 
   return cam_bbox;
 }
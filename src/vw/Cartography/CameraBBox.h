@@ -66,6 +66,28 @@ namespace vw { namespace cartography {
                                   double height_guess     =
                                   std::numeric_limits<double>::quiet_NaN());
 
+  /// Intersect with a DEM the rays through many pixels of a camera. The
+  /// part of the DEM the rays can reach is loaded into memory once and
+  /// searched with a DemRayIntersector. Rays the fast search cannot
+  /// decide, for example when the DEM is too big to load, go through
+  /// camera_pixel_to_dem_xyz(), using xyz_guesses if given. Pixels with
+  /// no intersection get Vector3().
+  /// The pixels may be split among num_threads threads (0 for the
+  /// default). Then the camera, the DEM and the georef are used from all
+  /// of them at once, so ask for more than one thread only if these are
+  /// thread-safe, which most camera models and georefs are not.
+  void camera_pixels_to_dem_xyz(camera::CameraModel const* camera,
+                                std::vector<Vector2> const& pixels,
+                                vw::ImageViewRef<vw::PixelMask<float>> const& dem_image,
+                                GeoReference const& georef,
+                                bool treat_nodata_as_zero,
+                                std::vector<Vector3> & xyz,
+                                double height_error_tol = 1e-1,
+                                double height_guess =
+                                std::numeric_limits<double>::quiet_NaN(),
+                                std::vector<Vector3> const* xyz_guesses = NULL,
+                                int num_threads = 1);
+
   /// Compute the bounding box in points (georeference space) that is
   /// defined by georef. Scale is MPP as georeference space is in meters.
   /// - If coords is provided the intersection coordinates will be stored there.
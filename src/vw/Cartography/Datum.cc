@@ -21,6 +21,11 @@
 #include <ogr_spatialref.h>
 #include <cpl_string.h>
 #include <iostream>
+#include <algorithm>
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  #include <emmintrin.h>
+#endif
 
 vw::cartography::Datum::Datum(std::string const& name,
                               std::string const& spheroid_name,
@@ -448,6 +453,275 @@ vw::Vector3 vw::cartography::Datum::cartesian_to_geodetic( vw::Vector3 const& xy
   return llh;
 }
 
+namespace {
+
+  // The batch conversions split the points into chunks of this many
+  // and convert each chunk as separate x, y and z arrays, two lanes at
+  // a time.
+  const size_t DATUM_CHUNK_SIZE = 128;
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+
+  inline __m128d select_pd(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+  }
+
+  // Turn bit 'bit' of the two low 32-bit lanes of q into two 64-bit masks.
+  inline __m128d bit_mask_pd(__m128i q, int bit) {
+    __m128i b = _mm_set1_epi32(bit);
+    __m128i q64 = _mm_shuffle_epi32(q, _MM_SHUFFLE(1,1,0,0));
+    return _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(q64, b), b));
+  }
+
+  // Sine and cosine of an angle in degrees. The angle is first reduced
+  // to [-45, 45] degrees around the nearest multiple of 90, which is
+  // exact in degrees, then the Cephes minimax polynomials are used.
+  // Error is a couple of ulps.
+  inline void sincos_deg_pd(__m128d deg, __m128d & s, __m128d & c) {
+    __m128i q  = _mm_cvtpd_epi32(_mm_mul_pd(deg, _mm_set1_pd(1.0/90.0)));
+    __m128d qd = _mm_cvtepi32_pd(q);
+    __m128d x  = _mm_mul_pd(_mm_sub_pd(deg, _mm_mul_pd(qd, _mm_set1_pd(90.0))),
+                            _mm_set1_pd(M_PI/180.0));
+    __m128d z  = _mm_mul_pd(x, x);
+
+    __m128d ps = _mm_set1_pd(1.58962301576546568060E-10);
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(-2.50507477628578072866E-8));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd( 2.75573136213857245213E-6));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(-1.98412698295895385996E-4));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd( 8.33333333332211858878E-3));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(-1.66666666666666307295E-1));
+    __m128d sx = _mm_add_pd(x, _mm_mul_pd(_mm_mul_pd(x, z), ps));
+
+    __m128d pc = _mm_set1_pd(-1.13585365213876817300E-11);
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd( 2.08757008419747316778E-9));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(-2.75573141792967388112E-7));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd( 2.48015872888517045348E-5));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(-1.38888888888730564116E-3));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd( 4.16666666666665929218E-2));
+    __m128d cx = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.0), _mm_mul_pd(_mm_set1_pd(0.5), z)),
+                            _mm_mul_pd(_mm_mul_pd(z, z), pc));
+
+    // Quadrant q mod 4 gives (sin, cos) = (s,c), (c,-s), (-s,-c), (-c,s).
+    __m128d swap  = bit_mask_pd(q, 1);
+    __m128d neg_s = bit_mask_pd(q, 2);
+    __m128d neg_c = bit_mask_pd(_mm_add_epi32(q, _mm_set1_epi32(1)), 2);
+    __m128d sign  = _mm_set1_pd(-0.0);
+    s = _mm_xor_pd(select_pd(swap, cx, sx), _mm_and_pd(neg_s, sign));
+    c = _mm_xor_pd(select_pd(swap, sx, cx), _mm_and_pd(neg_c, sign));
+  }
+
+  // Arctangent of x in [0, 1], using the Cephes rational approximation.
+  inline __m128d atan01_pd(__m128d x) {
+    __m128d big  = _mm_cmpgt_pd(x, _mm_set1_pd(0.66));
+    __m128d one  = _mm_set1_pd(1.0);
+    __m128d t    = select_pd(big, _mm_div_pd(_mm_sub_pd(x, one), _mm_add_pd(x, one)), x);
+    __m128d base = _mm_and_pd(big, _mm_set1_pd(M_PI/4));
+    __m128d z    = _mm_mul_pd(t, t);
+
+    __m128d p = _mm_set1_pd(-8.750608600031904122785E-1);
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-1.615753718733365076637E1));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-7.500855792314704667340E1));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-1.228866684490136173410E2));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-6.485021904942025371773E1));
+    __m128d q = _mm_add_pd(z, _mm_set1_pd(2.485846490142306297962E1));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(1.650270098316988542046E2));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(4.328810604912902668951E2));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(4.853903996359136964868E2));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(1.945506571482613964425E2));
+
+    __m128d r = _mm_add_pd(t, _mm_mul_pd(t, _mm_div_pd(_mm_mul_pd(z, p), q)));
+    return _mm_add_pd(base, r);
+  }
+
+  // Full-range atan2(y, x). Both arguments zero gives NaN, callers
+  // route such points to the scalar code.
+  inline __m128d atan2_pd(__m128d y, __m128d x) {
+    __m128d sign = _mm_set1_pd(-0.0);
+    __m128d ax = _mm_andnot_pd(sign, x);
+    __m128d ay = _mm_andnot_pd(sign, y);
+    __m128d r  = atan01_pd(_mm_div_pd(_mm_min_pd(ax, ay), _mm_max_pd(ax, ay)));
+    r = select_pd(_mm_cmpgt_pd(ay, ax), _mm_sub_pd(_mm_set1_pd(M_PI/2), r), r);
+    r = select_pd(_mm_cmplt_pd(x, _mm_setzero_pd()), _mm_sub_pd(_mm_set1_pd(M_PI), r), r);
+    return _mm_or_pd(r, _mm_and_pd(y, sign));
+  }
+
+  // v^(2/3) for v in the normal float range. The cube root starts from
+  // the usual exponent-divided-by-three bit trick in single precision
+  // and is polished with Newton steps in double.
+  inline __m128d pow_two_thirds_pd(__m128d v) {
+    __m128i i = _mm_castps_si128(_mm_cvtpd_ps(v));
+    __m128  f = _mm_mul_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(1.0f/3.0f));
+    i = _mm_add_epi32(_mm_cvtps_epi32(f), _mm_set1_epi32(709921077));
+    __m128d y = _mm_cvtps_pd(_mm_castsi128_ps(i));
+    __m128d third = _mm_set1_pd(1.0/3.0);
+    for (int k = 0; k < 4; k++)
+      y = _mm_mul_pd(third, _mm_add_pd(_mm_add_pd(y, y), _mm_div_pd(v, _mm_mul_pd(y, y))));
+    return _mm_mul_pd(y, y);
+  }
+
+#endif
+
+} // end anonymous namespace
+
+void vw::cartography::Datum::geodetic_to_cartesian(vw::Vector3 const* llh,
+                                                   vw::Vector3* xyz,
+                                                   size_t num) const {
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  const double a  = m_semi_major_axis;
+  const double b  = m_semi_minor_axis;
+  const double e2 = (a*a - b*b) / (a*a);
+
+  const __m128d lat_min = _mm_set1_pd(-90.0), lat_max = _mm_set1_pd(90.0);
+  const __m128d offset  = _mm_set1_pd(m_meridian_offset);
+  const __m128d a_v     = _mm_set1_pd(a);
+  const __m128d e2_v    = _mm_set1_pd(e2);
+  const __m128d one     = _mm_set1_pd(1.0);
+
+  // Chunks are padded to an even length by repeating the last point
+  double lon[DATUM_CHUNK_SIZE], lat[DATUM_CHUNK_SIZE], h[DATUM_CHUNK_SIZE];
+  double x[DATUM_CHUNK_SIZE], y[DATUM_CHUNK_SIZE], z[DATUM_CHUNK_SIZE];
+  for (size_t start = 0; start < num; start += DATUM_CHUNK_SIZE) {
+    size_t count = std::min(DATUM_CHUNK_SIZE, num - start);
+    size_t padded = (count + 1) & ~size_t(1);
+    for (size_t i = 0; i < padded; i++) {
+      Vector3 const& p = llh[start + std::min(i, count - 1)];
+      lon[i] = p[0]; lat[i] = p[1]; h[i] = p[2];
+    }
+
+    for (size_t i = 0; i < padded; i += 2) {
+      // Clamp with the bound first so that NaN latitudes pass through
+      __m128d phi = _mm_min_pd(lat_max, _mm_max_pd(lat_min, _mm_loadu_pd(lat + i)));
+      __m128d lam = _mm_add_pd(_mm_loadu_pd(lon + i), offset);
+      __m128d alt = _mm_loadu_pd(h + i);
+      __m128d slat, clat, slon, clon;
+      sincos_deg_pd(phi, slat, clat);
+      sincos_deg_pd(lam, slon, clon);
+
+      __m128d radius = _mm_div_pd(a_v, _mm_sqrt_pd(_mm_sub_pd(one, _mm_mul_pd(e2_v, _mm_mul_pd(slat, slat)))));
+      __m128d horiz  = _mm_mul_pd(_mm_add_pd(radius, alt), clat);
+      _mm_storeu_pd(x + i, _mm_mul_pd(horiz, clon));
+      _mm_storeu_pd(y + i, _mm_mul_pd(horiz, slon));
+      _mm_storeu_pd(z + i, _mm_mul_pd(_mm_add_pd(_mm_mul_pd(radius, _mm_sub_pd(one, e2_v)), alt), slat));
+    }
+
+    for (size_t i = 0; i < count; i++)
+      xyz[start + i] = Vector3(x[i], y[i], z[i]);
+  }
+#else
+  for (size_t i = 0; i < num; i++)
+    xyz[i] = this->geodetic_to_cartesian(llh[i]);
+#endif
+}
+
+// The batch inverse evaluates the Vermeille closed form for points
+// outside the evolute, which covers everything but a small region
+// around the center of the body. Points on or inside the evolute, on
+// the polar axis, or with non-finite coordinates go through the scalar
+// version above.
+void vw::cartography::Datum::cartesian_to_geodetic(vw::Vector3 const* xyz,
+                                                   vw::Vector3* llh,
+                                                   size_t num) const {
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  const double a2 = m_semi_major_axis * m_semi_major_axis;
+  const double b2 = m_semi_minor_axis * m_semi_minor_axis;
+  const double e2 = 1 - b2 / a2;
+
+  const __m128d inv_a2 = _mm_set1_pd(1.0 / a2);
+  const __m128d e2_v   = _mm_set1_pd(e2);
+  const __m128d e4_v   = _mm_set1_pd(e2 * e2);
+  const __m128d one_e2 = _mm_set1_pd(1 - e2);
+  const __m128d one    = _mm_set1_pd(1.0);
+  const __m128d half   = _mm_set1_pd(0.5);
+  const __m128d sixth  = _mm_set1_pd(1.0/6.0);
+  const __m128d zero   = _mm_setzero_pd();
+  const __m128d tiny   = _mm_set1_pd(1e-30);
+  const __m128d huge   = _mm_set1_pd(1e30);
+  const __m128d to_deg = _mm_set1_pd(180.0 / M_PI);
+  const __m128d to_lon = _mm_set1_pd(360.0 / M_PI); // Twice, for the half angles
+  const __m128d sqrt2_m1 = _mm_set1_pd(sqrt(2) - 1);
+  const __m128d sqrt2_p1 = _mm_set1_pd(sqrt(2) + 1);
+  const __m128d offset = _mm_set1_pd(m_meridian_offset);
+
+  double x[DATUM_CHUNK_SIZE], y[DATUM_CHUNK_SIZE], z[DATUM_CHUNK_SIZE];
+  double lon[DATUM_CHUNK_SIZE], lat[DATUM_CHUNK_SIZE], h[DATUM_CHUNK_SIZE];
+  bool fast[DATUM_CHUNK_SIZE];
+  for (size_t start = 0; start < num; start += DATUM_CHUNK_SIZE) {
+    size_t count = std::min(DATUM_CHUNK_SIZE, num - start);
+    size_t padded = (count + 1) & ~size_t(1);
+    for (size_t i = 0; i < padded; i++) {
+      Vector3 const& p = xyz[start + std::min(i, count - 1)];
+      x[i] = p[0]; y[i] = p[1]; z[i] = p[2];
+    }
+
+    for (size_t i = 0; i < padded; i += 2) {
+      __m128d px = _mm_loadu_pd(x + i), py = _mm_loadu_pd(y + i), pz = _mm_loadu_pd(z + i);
+      __m128d xy2 = _mm_add_pd(_mm_mul_pd(px, px), _mm_mul_pd(py, py));
+      __m128d xy_dist = _mm_sqrt_pd(xy2);
+      __m128d p = _mm_mul_pd(xy2, inv_a2);
+      __m128d q = _mm_mul_pd(one_e2, _mm_mul_pd(_mm_mul_pd(pz, pz), inv_a2));
+      __m128d r = _mm_mul_pd(_mm_sub_pd(_mm_add_pd(p, q), e4_v), sixth);
+      __m128d e4pq = _mm_mul_pd(e4_v, _mm_mul_pd(p, q));
+      __m128d evolute = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(8.0), _mm_mul_pd(r, _mm_mul_pd(r, r))), e4pq);
+
+      __m128d right_inside_pow = _mm_sqrt_pd(e4pq);
+      __m128d sqrt_evolute = _mm_sqrt_pd(_mm_max_pd(evolute, zero));
+      __m128d plus  = _mm_add_pd(sqrt_evolute, right_inside_pow);
+      __m128d minus = _mm_sub_pd(sqrt_evolute, right_inside_pow);
+
+      // The comparisons are false for NaN, which sends those to the scalar code
+      __m128d ok = _mm_and_pd(_mm_cmpgt_pd(evolute, zero), _mm_cmpgt_pd(minus, tiny));
+      ok = _mm_and_pd(ok, _mm_and_pd(_mm_cmplt_pd(plus, huge), _mm_cmpgt_pd(xy_dist, zero)));
+      int ok_bits = _mm_movemask_pd(ok);
+      fast[i] = (ok_bits & 1) != 0;
+      fast[i+1] = (ok_bits & 2) != 0;
+      if (ok_bits == 0)
+        continue;
+
+      // Keep the arguments in range for lanes that will be discarded
+      plus  = select_pd(ok, plus, one);
+      minus = select_pd(ok, minus, one);
+
+      __m128d u = _mm_add_pd(r, _mm_mul_pd(half, _mm_add_pd(pow_two_thirds_pd(plus),
+                                                            pow_two_thirds_pd(minus))));
+      __m128d v   = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(u, u), _mm_mul_pd(e4_v, q)));
+      __m128d u_v = _mm_add_pd(u, v);
+      __m128d w   = _mm_div_pd(_mm_mul_pd(e2_v, _mm_sub_pd(u_v, q)), _mm_add_pd(v, v));
+      __m128d k   = _mm_div_pd(u_v, _mm_add_pd(w, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(w, w), u_v))));
+      __m128d D   = _mm_div_pd(_mm_mul_pd(k, xy_dist), _mm_add_pd(k, e2_v));
+      __m128d dist = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(D, D), _mm_mul_pd(pz, pz)));
+
+      __m128d alt = _mm_div_pd(_mm_mul_pd(_mm_sub_pd(_mm_add_pd(k, e2_v), one), dist), k);
+      __m128d phi = atan2_pd(pz, _mm_add_pd(dist, D));
+
+      // The longitude from the same half-angle formulas as the scalar
+      // version, picked by the same tests, so that it wraps the same way
+      __m128d first  = _mm_cmpgt_pd(_mm_add_pd(xy_dist, px), _mm_mul_pd(sqrt2_m1, py));
+      __m128d second = _mm_cmplt_pd(_mm_add_pd(xy_dist, py), _mm_mul_pd(sqrt2_p1, px));
+      __m128d lam_y  = select_pd(first, py, px);
+      __m128d lam_x  = select_pd(first, _mm_add_pd(xy_dist, px),
+                                 select_pd(second, _mm_sub_pd(xy_dist, py), _mm_add_pd(xy_dist, py)));
+      __m128d base   = select_pd(first, zero, select_pd(second, _mm_set1_pd(-90.0), _mm_set1_pd(90.0)));
+      __m128d scale  = select_pd(_mm_or_pd(first, second), to_lon, _mm_sub_pd(zero, to_lon));
+      __m128d lam    = _mm_add_pd(base, _mm_mul_pd(scale, atan2_pd(lam_y, lam_x)));
+
+      _mm_storeu_pd(lon + i, _mm_sub_pd(lam, offset));
+      _mm_storeu_pd(lat + i, _mm_mul_pd(_mm_add_pd(phi, phi), to_deg));
+      _mm_storeu_pd(h + i, alt);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      if (fast[i])
+        llh[start + i] = Vector3(lon[i], lat[i], h[i]);
+      else
+        llh[start + i] = this->cartesian_to_geodetic(Vector3(x[i], y[i], z[i]));
+    }
+  }
+#else
+  for (size_t i = 0; i < num; i++)
+    llh[i] = this->cartesian_to_geodetic(xyz[i]);
+#endif
+}
+
 // Get the wkt string from the datum.
 std::string vw::cartography::Datum::get_wkt() const {
   char *wkt;
@@ -564,3 +838,65 @@ vw::Vector3 vw::cartography::datum_intersection(vw::cartography::Datum const& da
   return vw::cartography::datum_intersection(datum.semi_major_axis(), datum.semi_minor_axis(),
                                              camera_ctr, camera_vec);
 }
+
+// The same operations as the single-ray version, in the same order, so
+// the results agree to the last bit.
+void vw::cartography::datum_intersection(double semi_major_axis, double semi_minor_axis,
+                                         vw::Vector3 const* camera_ctrs,
+                                         vw::Vector3 const* camera_vecs,
+                                         vw::Vector3* intersections, size_t num) {
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  const double z_scale  = semi_major_axis / semi_minor_axis;
+  const __m128d zs_v    = _mm_set1_pd(z_scale);
+  const __m128d r2_v    = _mm_set1_pd(semi_major_axis * semi_major_axis);
+  const __m128d zero    = _mm_setzero_pd();
+  const __m128d sign    = _mm_set1_pd(-0.0);
+
+  double cx[DATUM_CHUNK_SIZE], cy[DATUM_CHUNK_SIZE], cz[DATUM_CHUNK_SIZE];
+  double dx[DATUM_CHUNK_SIZE], dy[DATUM_CHUNK_SIZE], dz[DATUM_CHUNK_SIZE];
+  for (size_t start = 0; start < num; start += DATUM_CHUNK_SIZE) {
+    size_t count = std::min(DATUM_CHUNK_SIZE, num - start);
+    size_t padded = (count + 1) & ~size_t(1);
+    for (size_t i = 0; i < padded; i++) {
+      size_t k = start + std::min(i, count - 1);
+      Vector3 const& c = camera_ctrs[k];
+      Vector3 const& d = camera_vecs[k];
+      cx[i] = c[0]; cy[i] = c[1]; cz[i] = c[2];
+      dx[i] = d[0]; dy[i] = d[1]; dz[i] = d[2];
+    }
+
+    for (size_t i = 0; i < padded; i += 2) {
+      // Scale z so that the spheroid becomes a sphere
+      __m128d px = _mm_loadu_pd(cx + i), py = _mm_loadu_pd(cy + i);
+      __m128d pz = _mm_mul_pd(_mm_loadu_pd(cz + i), zs_v);
+      __m128d vx = _mm_loadu_pd(dx + i), vy = _mm_loadu_pd(dy + i);
+      __m128d vz = _mm_mul_pd(_mm_loadu_pd(dz + i), zs_v);
+      __m128d len = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy)),
+                                           _mm_mul_pd(vz, vz)));
+      vx = _mm_div_pd(vx, len); vy = _mm_div_pd(vy, len); vz = _mm_div_pd(vz, len);
+
+      __m128d alpha = _mm_xor_pd(sign, _mm_add_pd(_mm_add_pd(_mm_mul_pd(px, vx), _mm_mul_pd(py, vy)),
+                                                  _mm_mul_pd(pz, vz)));
+      __m128d qx = _mm_add_pd(px, _mm_mul_pd(alpha, vx));
+      __m128d qy = _mm_add_pd(py, _mm_mul_pd(alpha, vy));
+      __m128d qz = _mm_add_pd(pz, _mm_mul_pd(alpha, vz));
+      __m128d q2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(qx, qx), _mm_mul_pd(qy, qy)), _mm_mul_pd(qz, qz));
+      __m128d miss = _mm_cmpgt_pd(q2, r2_v);
+
+      // Misses would take the root of a negative number, and give zero
+      alpha = _mm_sub_pd(alpha, _mm_sqrt_pd(select_pd(miss, zero, _mm_sub_pd(r2_v, q2))));
+      _mm_storeu_pd(cx + i, select_pd(miss, zero, _mm_add_pd(px, _mm_mul_pd(alpha, vx))));
+      _mm_storeu_pd(cy + i, select_pd(miss, zero, _mm_add_pd(py, _mm_mul_pd(alpha, vy))));
+      _mm_storeu_pd(cz + i, select_pd(miss, zero, _mm_div_pd(_mm_add_pd(pz, _mm_mul_pd(alpha, vz)),
+                                                             zs_v)));
+    }
+
+    for (size_t i = 0; i < count; i++)
+      intersections[start + i] = Vector3(cx[i], cy[i], cz[i]);
+  }
+#else
+  for (size_t i = 0; i < num; i++)
+    intersections[i] = datum_intersection(semi_major_axis, semi_minor_axis,
+                                          camera_ctrs[i], camera_vecs[i]);
+#endif
+}
@@ -138,6 +138,13 @@ namespace cartography {
     Matrix3x3 lonlat_to_ned_matrix(Vector3 const& llh) const;
 
     Vector3 cartesian_to_geodetic( Vector3 const& xyz ) const;
+
+    /// Batch versions of geodetic_to_cartesian() and
+    /// cartesian_to_geodetic(). These convert num points at a time with
+    /// SIMD kernels and agree with the single-point versions to well
+    /// under a millimeter. The input and output may be the same array.
+    void geodetic_to_cartesian( Vector3 const* llh, Vector3* xyz, size_t num ) const;
+    void cartesian_to_geodetic( Vector3 const* xyz, Vector3* llh, size_t num ) const;
   };
 
   std::ostream& operator<<(std::ostream& os, const Datum& datum);
@@ -151,6 +158,13 @@ namespace cartography {
                              vw::Vector3 camera_ctr, vw::Vector3 camera_vec);
   vw::Vector3 datum_intersection( Datum const& datum,
                               vw::Vector3 camera_ctr, vw::Vector3 camera_vec );
+
+  /// Batch version of datum_intersection(). Intersects num rays with
+  /// the same spheroid, with SIMD kernels. A ray that misses gives a
+  /// zero vector, as for the single-ray version.
+  void datum_intersection(double semi_major_axis, double semi_minor_axis,
+                          vw::Vector3 const* camera_ctrs, vw::Vector3 const* camera_vecs,
+                          vw::Vector3* intersections, size_t num);
   
 }} // namespace vw::cartography
 
@@ -0,0 +1,360 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <vw/Cartography/DemHeightIndex.h>
+#include <vw/Core/Exception.h>
+#include <vw/Core/Log.h>
+#include <vw/Core/Settings.h>
+#include <vw/Core/ThreadPool.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/Manipulation.h>
+#include <vw/Image/MaskViews.h>
+#include <vw/FileIO/DiskImageResource.h>
+#include <vw/FileIO/DiskImageView.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+namespace vw { namespace cartography {
+
+namespace {
+  // Blocks read from the DEM at once along a row of blocks
+  const int32 BLOCKS_PER_READ = 32;
+
+  const char   INDEX_MAGIC[8] = {'V', 'W', 'D', 'H', 'I', 'D', 'X', '\0'};
+  const uint32 INDEX_VERSION  = 2;
+
+  // What identifies a DEM file and its version
+  void dem_file_stamp(std::string const& dem_file, std::string & path,
+                      uint64 & size, int64 & mtime) {
+    path  = fs::absolute(dem_file).string();
+    size  = fs::file_size(dem_file);
+    mtime = fs::last_write_time(dem_file);
+  }
+
+  // A fixed 32-bit FNV-1a hash of a string as 8 hex digits. Unlike
+  // std::hash it is the same across builds, so cache file names are too.
+  std::string short_hash(std::string const& s) {
+    uint32 h = 2166136261u;
+    for (size_t i = 0; i < s.size(); i++) {
+      h ^= static_cast<unsigned char>(s[i]);
+      h *= 16777619u;
+    }
+    std::ostringstream os;
+    os << std::hex << std::setw(8) << std::setfill('0') << h;
+    return os.str();
+  }
+
+  template <class T>
+  void write_value(std::ofstream & out, T const& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <class T>
+  bool read_value(std::ifstream & in, T & value) {
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+}
+
+DemHeightStats::DemHeightStats():
+  min_height(std::numeric_limits<float>::max()),
+  max_height(-std::numeric_limits<float>::max()),
+  num_valid(0), height_sum(0.0) {}
+
+// Zero if there is no data, as for demHeightGuess().
+double DemHeightStats::mean_height() const {
+  if (num_valid == 0)
+    return 0.0;
+  return height_sum / double(num_valid);
+}
+
+void DemHeightStats::add(DemHeightStats const& other) {
+  min_height  = std::min(min_height, other.min_height);
+  max_height  = std::max(max_height, other.max_height);
+  num_valid  += other.num_valid;
+  height_sum += other.height_sum;
+}
+
+DemHeightIndex::DemHeightIndex(): m_cols(0), m_rows(0), m_block_size(1) {
+  build_levels();
+}
+
+DemHeightIndex::DemHeightIndex(ImageViewRef<PixelMask<float>> const& dem,
+                               int block_size, int num_threads):
+  m_cols(dem.cols()), m_rows(dem.rows()), m_block_size(block_size) {
+
+  VW_ASSERT(block_size > 0, ArgumentErr() << "DemHeightIndex: The block size must be positive.");
+  if (num_threads <= 0)
+    num_threads = vw_settings().default_num_threads();
+
+  int32 blocks_x = std::max(1, (m_cols + block_size - 1) / block_size);
+  int32 blocks_y = std::max(1, (m_rows + block_size - 1) / block_size);
+  m_levels.resize(1);
+  m_levels[0].assign(size_t(blocks_x) * blocks_y, DemHeightStats());
+
+  // Each task does whole rows of blocks, reading a few blocks at a time
+  process_in_parallel(size_t(blocks_y), num_threads, [&](size_t begin, size_t end) {
+    for (size_t by = begin; by < end; by++) {
+      int32 y0 = int32(by) * block_size;
+      int32 h  = std::min(block_size, m_rows - y0);
+      if (h <= 0)
+        continue;
+      for (int32 bx0 = 0; bx0 < blocks_x; bx0 += BLOCKS_PER_READ) {
+        int32 x0 = bx0 * block_size;
+        int32 w  = std::min(BLOCKS_PER_READ * block_size, m_cols - x0);
+        if (w <= 0)
+          continue;
+        ImageView<PixelMask<float>> buf = crop(dem, BBox2i(x0, y0, w, h));
+        for (int32 row = 0; row < h; row++) {
+          for (int32 col = 0; col < w; col++) {
+            PixelMask<float> const& p = buf(col, row);
+            if (!is_valid(p) || std::isnan(p.child()))
+              continue;
+            DemHeightStats & s
+              = m_levels[0][by * blocks_x + bx0 + col / block_size];
+            s.min_height = std::min(s.min_height, p.child());
+            s.max_height = std::max(s.max_height, p.child());
+            s.num_valid++;
+            s.height_sum += p.child();
+          }
+        }
+      }
+    }
+  });
+
+  build_levels();
+}
+
+// Form the coarser levels from level 0, until there is a single cell
+void DemHeightIndex::build_levels() {
+  if (m_levels.empty())
+    m_levels.resize(1, std::vector<DemHeightStats>(1));
+  m_levels.resize(1);
+  m_level_cols.assign(1, std::max(1, (m_cols + m_block_size - 1) / m_block_size));
+  m_level_rows.assign(1, std::max(1, (m_rows + m_block_size - 1) / m_block_size));
+
+  while (m_level_cols.back() > 1 || m_level_rows.back() > 1) {
+    int level = int(m_levels.size()) - 1;
+    int32 cols = (m_level_cols[level] + 1) / 2;
+    int32 rows = (m_level_rows[level] + 1) / 2;
+    std::vector<DemHeightStats> cells(size_t(cols) * rows);
+    for (int32 row = 0; row < m_level_rows[level]; row++)
+      for (int32 col = 0; col < m_level_cols[level]; col++)
+        cells[size_t(row/2) * cols + col/2].add(cell(level, col, row));
+    m_levels.push_back(cells);
+    m_level_cols.push_back(cols);
+    m_level_rows.push_back(rows);
+  }
+}
+
+void DemHeightIndex::add_cells(int level, BBox2i const& cells, BBox2i const& box,
+                               DemHeightStats & result) const {
+  int32 cell_size = m_block_size << level;
+  for (int32 row = cells.min().y(); row < cells.max().y(); row++) {
+    for (int32 col = cells.min().x(); col < cells.max().x(); col++) {
+      BBox2i cell_box(col * cell_size, row * cell_size, cell_size, cell_size);
+      cell_box.crop(BBox2i(0, 0, m_cols, m_rows));
+      if (!box.intersects(cell_box))
+        continue;
+      DemHeightStats const& s = cell(level, col, row);
+      if (!s.has_data())
+        continue;
+      if (level == 0 || box.contains(cell_box)) {
+        result.add(s);
+        continue;
+      }
+      BBox2i children(2*col, 2*row, 2, 2);
+      children.crop(BBox2i(0, 0, m_level_cols[level-1], m_level_rows[level-1]));
+      add_cells(level - 1, children, box, result);
+    }
+  }
+}
+
+DemHeightStats DemHeightIndex::stats(BBox2i const& box) const {
+  DemHeightStats result;
+  if (box.empty())
+    return result;
+  int top = int(m_levels.size()) - 1;
+  add_cells(top, BBox2i(0, 0, 1, 1), box, result);
+  return result;
+}
+
+bool DemHeightIndex::height_range(BBox2i const& box,
+                                  double & min_height, double & max_height) const {
+  DemHeightStats s = stats(box);
+  if (!s.has_data())
+    return false;
+  min_height = s.min_height;
+  max_height = s.max_height;
+  return true;
+}
+
+// A hash of the absolute DEM path keeps DEMs with the same name in
+// different directories from sharing an index file.
+std::string DemHeightIndex::cache_file(std::string const& dem_file,
+                                       std::string const& cache_dir) {
+  std::string hash = short_hash(fs::absolute(dem_file).string());
+  return (fs::path(cache_dir) /
+          (fs::path(dem_file).filename().string() + "." + hash + ".hidx")).string();
+}
+
+// The index is written to a temporary file which is then renamed, so that
+// other processes never see a partial file.
+void DemHeightIndex::write(std::string const& index_file,
+                           std::string const& dem_file) const {
+  std::string dem_path;
+  uint64 dem_size = 0;
+  int64  dem_mtime = 0;
+  if (!dem_file.empty())
+    dem_file_stamp(dem_file, dem_path, dem_size, dem_mtime);
+
+  fs::path tmp_file = fs::path(index_file).parent_path() /
+    fs::unique_path(fs::path(index_file).filename().string() + ".%%%%%%%%");
+  {
+    std::ofstream out(tmp_file.string().c_str(), std::ios::binary);
+    if (!out)
+      vw_throw(IOErr() << "DemHeightIndex: Could not open " << tmp_file.string()
+                       << " for writing.");
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    write_value(out, INDEX_VERSION);
+    write_value(out, m_cols);
+    write_value(out, m_rows);
+    write_value(out, int32(m_block_size));
+    write_value(out, dem_size);
+    write_value(out, dem_mtime);
+    write_value(out, uint32(dem_path.size()));
+    out.write(dem_path.data(), dem_path.size());
+    for (DemHeightStats const& s: m_levels[0]) {
+      write_value(out, s.min_height);
+      write_value(out, s.max_height);
+      write_value(out, s.num_valid);
+      write_value(out, s.height_sum);
+    }
+    if (!out) {
+      out.close();
+      boost::system::error_code ec;
+      fs::remove(tmp_file, ec);
+      vw_throw(IOErr() << "DemHeightIndex: Failed writing " << tmp_file.string() << ".");
+    }
+  }
+  boost::system::error_code ec;
+  fs::rename(tmp_file, index_file, ec);
+  if (ec) {
+    fs::remove(tmp_file, ec);
+    vw_throw(IOErr() << "DemHeightIndex: Could not rename " << tmp_file.string()
+                     << " to " << index_file << ".");
+  }
+}
+
+bool DemHeightIndex::read(std::string const& index_file, std::string const& dem_file,
+                          int block_size) {
+  std::ifstream in(index_file.c_str(), std::ios::binary);
+  if (!in)
+    return false;
+
+  char   magic[sizeof(INDEX_MAGIC)];
+  uint32 version;
+  int32  cols, rows, file_block_size;
+  uint64 dem_size;
+  int64  dem_mtime;
+  uint32 path_size;
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+      !read_value(in, version) || version != INDEX_VERSION ||
+      !read_value(in, cols) || !read_value(in, rows) ||
+      !read_value(in, file_block_size) || file_block_size <= 0 ||
+      cols < 0 || rows < 0 ||
+      !read_value(in, dem_size) || !read_value(in, dem_mtime) ||
+      !read_value(in, path_size))
+    return false;
+  std::string dem_path(path_size, '\0');
+  if (path_size > 0 && !in.read(&dem_path[0], path_size))
+    return false;
+  if (block_size > 0 && file_block_size != block_size)
+    return false;
+  if (!dem_file.empty()) {
+    std::string path;
+    uint64 size;
+    int64  mtime;
+    dem_file_stamp(dem_file, path, size, mtime);
+    if (path != dem_path || size != dem_size || mtime != dem_mtime)
+      return false;
+  }
+
+  int32 blocks_x = std::max(1, (cols + file_block_size - 1) / file_block_size);
+  int32 blocks_y = std::max(1, (rows + file_block_size - 1) / file_block_size);
+  std::vector<DemHeightStats> blocks(size_t(blocks_x) * blocks_y);
+  for (DemHeightStats & s: blocks) {
+    if (!read_value(in, s.min_height) || !read_value(in, s.max_height) ||
+        !read_value(in, s.num_valid)  || !read_value(in, s.height_sum))
+      return false;
+  }
+
+  m_cols = cols;
+  m_rows = rows;
+  m_block_size = file_block_size;
+  m_levels.assign(1, blocks);
+  build_levels();
+  return true;
+}
+
+boost::shared_ptr<DemHeightIndex>
+DemHeightIndex::load_or_build(std::string const& dem_file, std::string const& cache_dir,
+                              int block_size, int num_threads) {
+
+  boost::shared_ptr<DiskImageResource> rsrc(DiskImageResourcePtr(dem_file));
+  std::string index_file;
+  boost::shared_ptr<DemHeightIndex> index(new DemHeightIndex);
+  if (!cache_dir.empty()) {
+    index_file = cache_file(dem_file, cache_dir);
+    try {
+      if (index->read(index_file, dem_file, block_size) &&
+          index->cols() == rsrc->cols() && index->rows() == rsrc->rows())
+        return index;
+    } catch (...) {} // Such as if the DEM is not a file
+  }
+
+  double nodata = std::numeric_limits<double>::quiet_NaN();
+  if (rsrc->has_nodata_read())
+    nodata = rsrc->nodata_read();
+  DiskImageView<float> dem(rsrc);
+
+  vw_out(DebugMessage, "cartography") << "Indexing the heights of " << dem_file << ".\n";
+  index.reset(new DemHeightIndex(create_mask(dem, nodata), block_size, num_threads));
+  if (index_file.empty())
+    return index;
+
+  // A failure here only costs scanning the DEM again next time
+  try {
+    fs::create_directories(cache_dir);
+    index->write(index_file, dem_file);
+  } catch (const std::exception& e) {
+    vw_out(DebugMessage, "cartography") << "DemHeightIndex: Could not save "
+                                        << index_file << ": " << e.what() << "\n";
+  }
+  return index;
+}
+
+}} // namespace vw::cartography
@@ -0,0 +1,127 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#ifndef __VW_CARTOGRAPHY_DEMHEIGHTINDEX_H__
+#define __VW_CARTOGRAPHY_DEMHEIGHTINDEX_H__
+
+/// \file DemHeightIndex.h A pyramid of height statistics over blocks of a DEM.
+
+#include <vw/Image/ImageViewRef.h>
+#include <vw/Image/PixelMask.h>
+#include <vw/Math/BBox.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace vw { namespace cartography {
+
+  /// Height statistics of the valid pixels in a part of a DEM.
+  struct DemHeightStats {
+    float  min_height, max_height; // min_height > max_height if there is no data
+    uint64 num_valid;
+    double height_sum;
+
+    DemHeightStats();
+    bool has_data() const { return num_valid > 0; }
+    double mean_height() const;
+    void add(DemHeightStats const& other);
+  };
+
+  /// Records the minimum, maximum, sum and count of the valid heights in
+  /// each block of a DEM, and the same over 2x2, 4x4, ... groups of
+  /// blocks. A query over a pixel box merges the coarsest cells that
+  /// lie inside the box, so its cost grows with the log of the box size
+  /// and with its perimeter in blocks, not with its area.
+  ///
+  /// Queries are over all the blocks that touch the box, so the height
+  /// range is a conservative bound, and no data means that there is
+  /// certainly no valid pixel in the box.
+  class DemHeightIndex {
+  public:
+
+    /// An empty index. Use read() to fill it.
+    DemHeightIndex();
+
+    /// Scan a DEM. Pixels that are invalid or NaN are not counted.
+    DemHeightIndex(ImageViewRef<PixelMask<float>> const& dem,
+                   int block_size = 64, int num_threads = 0);
+
+    /// Scan a DEM file, with its nodata value taken from the file. If a
+    /// cache directory is given, the index is kept there and is read
+    /// back while it is up to date. If the directory cannot be written,
+    /// the index is only kept in memory.
+    static boost::shared_ptr<DemHeightIndex>
+    load_or_build(std::string const& dem_file, std::string const& cache_dir = "",
+                  int block_size = 64, int num_threads = 0);
+
+    /// The name of the index file for a DEM file in a cache directory.
+    /// It is the DEM file name plus a hash of its absolute path.
+    static std::string cache_file(std::string const& dem_file, std::string const& cache_dir);
+
+    /// Write the index. The DEM file it was made from, if any, is
+    /// recorded so that a stale index can be detected.
+    void write(std::string const& index_file, std::string const& dem_file = "") const;
+
+    /// Read an index written by write(). Returns false if the file is
+    /// missing or unreadable, or, if dem_file is not empty, if the index
+    /// was made from another file, from a different version of that
+    /// file, or with a different block size.
+    bool read(std::string const& index_file, std::string const& dem_file = "",
+              int block_size = 0);
+
+    /// Statistics over the blocks that touch a box of DEM pixels.
+    DemHeightStats stats(BBox2i const& box) const;
+
+    /// Statistics over the whole DEM.
+    DemHeightStats const& stats() const { return m_levels.back()[0]; }
+
+    /// Bounds on the heights in a box of DEM pixels. Returns false if
+    /// there is no valid pixel in the box.
+    bool height_range(BBox2i const& box, double & min_height, double & max_height) const;
+
+    /// False only if there is certainly no valid pixel in the box.
+    bool has_data(BBox2i const& box) const { return stats(box).has_data(); }
+
+    int32 cols() const { return m_cols; }
+    int32 rows() const { return m_rows; }
+    int   block_size() const { return m_block_size; }
+
+  private:
+    void build_levels();
+
+    // Add the cells of the given level within a box of cells at that
+    // level, descending into those that only partly overlap the box.
+    void add_cells(int level, BBox2i const& cells, BBox2i const& box,
+                   DemHeightStats & result) const;
+
+    DemHeightStats const& cell(int level, int32 col, int32 row) const {
+      return m_levels[level][size_t(row) * m_level_cols[level] + col];
+    }
+
+    int32 m_cols, m_rows;
+    int   m_block_size;
+    // Level k holds 2^k x 2^k blocks per cell, in row-major order.
+    // The last level has a single cell.
+    std::vector<std::vector<DemHeightStats>> m_levels;
+    std::vector<int32> m_level_cols, m_level_rows;
+  };
+
+}} // namespace vw::cartography
+
+#endif // __VW_CARTOGRAPHY_DEMHEIGHTINDEX_H__
@@ -0,0 +1,364 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <vw/Cartography/DemRayIntersector.h>
+#include <vw/Image/Manipulation.h>
+#include <vw/Image/AlgorithmFunctions.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vw { namespace cartography {
+
+namespace {
+
+  // Rows of the DEM rasterized at a time when loading a region
+  const int DEM_STRIP_ROWS = 256;
+
+  // Parameters t at which the ray c + t*v enters and leaves the ellipsoid
+  // with the given semi-axes. Returns false if the line misses it.
+  bool ray_ellipsoid_range(double a, double b, Vector3 const& c, Vector3 const& v,
+                           double & t0, double & t1) {
+    Vector3 cs(c[0]/a, c[1]/a, c[2]/b);
+    Vector3 vs(v[0]/a, v[1]/a, v[2]/b);
+    double qa = dot_prod(vs, vs);
+    double qb = 2.0 * dot_prod(cs, vs);
+    double qc = dot_prod(cs, cs) - 1.0;
+    double disc = qb*qb - 4.0*qa*qc;
+    if (qa <= 0 || disc < 0)
+      return false;
+    double s = std::sqrt(disc);
+    t0 = (-qb - s) / (2.0*qa);
+    t1 = (-qb + s) / (2.0*qa);
+    return true;
+  }
+
+  inline void grow_bounds(float val, float & lo, float & hi) {
+    lo = std::min(lo, val);
+    hi = std::max(hi, val);
+  }
+
+} // end anonymous namespace
+
+DemRayIntersector::DemRayIntersector(ImageViewRef<PixelMask<float>> const& dem,
+                                     GeoReference const& georef,
+                                     BBox2i const& region,
+                                     bool treat_nodata_as_zero,
+                                     double height_error_tol):
+  m_georef(georef), m_region(region),
+  m_treat_nodata_as_zero(treat_nodata_as_zero),
+  m_height_error_tol(height_error_tol) {
+
+  BBox2i dem_box = bounding_box(dem);
+  m_region.crop(dem_box);
+  m_region_is_dem = (m_region == dem_box);
+
+  const float empty_lo =  std::numeric_limits<float>::max();
+  const float empty_hi = -std::numeric_limits<float>::max();
+  const float nan      =  std::numeric_limits<float>::quiet_NaN();
+
+  // Copy the region into memory a strip at a time
+  int cols = m_region.width(), rows = m_region.height();
+  m_heights.set_size(cols, rows);
+  for (int row0 = 0; row0 < rows; row0 += DEM_STRIP_ROWS) {
+    BBox2i strip(m_region.min().x(), m_region.min().y() + row0,
+                 cols, std::min(DEM_STRIP_ROWS, rows - row0));
+    ImageView<PixelMask<float>> buf = crop(dem, strip);
+    for (int row = 0; row < buf.rows(); row++) {
+      for (int col = 0; col < buf.cols(); col++) {
+        PixelMask<float> const& val = buf(col, row);
+        m_heights(col, row0 + row) = is_valid(val) ? val.child() : nan;
+      }
+    }
+  }
+
+  // The bottom level bounds each quad. Quads on the last row and column
+  // are degenerate, just like the edge extension used for interpolation.
+  if (cols > 0 && rows > 0) {
+    ImageView<float> lo(cols, rows), hi(cols, rows);
+    for (int row = 0; row < rows; row++) {
+      int row1 = std::min(row + 1, rows - 1);
+      for (int col = 0; col < cols; col++) {
+        int col1 = std::min(col + 1, cols - 1);
+        float v[4] = {m_heights(col, row),  m_heights(col1, row),
+                      m_heights(col, row1), m_heights(col1, row1)};
+        float l = empty_lo, h = empty_hi;
+        bool has_nodata = false;
+        for (int k = 0; k < 4; k++) {
+          if (std::isnan(v[k]))
+            has_nodata = true;
+          else
+            grow_bounds(v[k], l, h);
+        }
+        // Interpolating next to a nodata pixel gives nodata for the whole quad
+        if (has_nodata) {
+          l = empty_lo;
+          h = empty_hi;
+          if (m_treat_nodata_as_zero)
+            l = h = 0;
+        }
+        lo(col, row) = l;
+        hi(col, row) = h;
+      }
+    }
+    m_min_pyramid.push_back(lo);
+    m_max_pyramid.push_back(hi);
+
+    // Each level above halves the resolution
+    while (m_min_pyramid.back().cols() > 1 || m_min_pyramid.back().rows() > 1) {
+      ImageView<float> const& plo = m_min_pyramid.back();
+      ImageView<float> const& phi = m_max_pyramid.back();
+      int pc = plo.cols(), pr = plo.rows();
+      int nc = (pc + 1) / 2, nr = (pr + 1) / 2;
+      ImageView<float> nlo(nc, nr), nhi(nc, nr);
+      for (int row = 0; row < nr; row++) {
+        for (int col = 0; col < nc; col++) {
+          float l = empty_lo, h = empty_hi;
+          for (int r = 2*row; r < std::min(2*row + 2, pr); r++) {
+            for (int c = 2*col; c < std::min(2*col + 2, pc); c++) {
+              l = std::min(l, plo(c, r));
+              h = std::max(h, phi(c, r));
+            }
+          }
+          nlo(col, row) = l;
+          nhi(col, row) = h;
+        }
+      }
+      m_min_pyramid.push_back(nlo);
+      m_max_pyramid.push_back(nhi);
+    }
+  }
+
+  float lo = empty_lo, hi = empty_hi;
+  if (!m_min_pyramid.empty()) {
+    lo = m_min_pyramid.back()(0, 0);
+    hi = m_max_pyramid.back()(0, 0);
+  }
+  // Off the DEM the terrain is at the datum in this mode
+  if (m_treat_nodata_as_zero && m_region_is_dem)
+    grow_bounds(0, lo, hi);
+  m_min_height = lo;
+  m_max_height = hi;
+
+  Datum const& datum = m_georef.datum();
+  m_min_curvature_radius = datum.semi_minor_axis() * datum.semi_minor_axis()
+    / datum.semi_major_axis() + std::min(m_min_height, 0.0);
+}
+
+DemRayIntersector::RayPoint
+DemRayIntersector::ray_point(Vector3 const& ctr, Vector3 const& vec, double t) const {
+  RayPoint p;
+  p.t = t;
+  Vector3 llh = m_georef.datum().cartesian_to_geodetic(ctr + t*vec);
+  p.pix = m_georef.lonlat_to_pixel(Vector2(llh.x(), llh.y())) - Vector2(m_region.min());
+  p.height = llh.z();
+  return p;
+}
+
+bool DemRayIntersector::dem_height(Vector2 const& pix, double & height) const {
+  int cols = m_heights.cols(), rows = m_heights.rows();
+  double x = pix.x(), y = pix.y();
+  if (!(x >= 0 && x <= cols - 1 && y >= 0 && y <= rows - 1)) {
+    // Off the DEM
+    height = 0;
+    return m_treat_nodata_as_zero;
+  }
+
+  int c0 = std::min(int(x), cols - 1), r0 = std::min(int(y), rows - 1);
+  int c1 = std::min(c0 + 1, cols - 1), r1 = std::min(r0 + 1, rows - 1);
+  double v00 = m_heights(c0, r0), v10 = m_heights(c1, r0);
+  double v01 = m_heights(c0, r1), v11 = m_heights(c1, r1);
+  if (std::isnan(v00) || std::isnan(v10) || std::isnan(v01) || std::isnan(v11)) {
+    height = 0;
+    return m_treat_nodata_as_zero;
+  }
+
+  double dx = x - c0, dy = y - r0;
+  height = (1-dy) * ((1-dx)*v00 + dx*v10) + dy * ((1-dx)*v01 + dx*v11);
+  return true;
+}
+
+bool DemRayIntersector::height_bounds(BBox2 const& path, double pad,
+                                      float & lo, float & hi) const {
+  lo =  std::numeric_limits<float>::max();
+  hi = -std::numeric_limits<float>::max();
+
+  int cols = m_heights.cols(), rows = m_heights.rows();
+  if (!m_region_is_dem &&
+      (path.min().x() < 0 || path.max().x() > cols - 1 ||
+       path.min().y() < 0 || path.max().y() > rows - 1))
+    return false;
+
+  BBox2 box = path;
+  box.expand(pad);
+  if (m_treat_nodata_as_zero && m_region_is_dem &&
+      (box.min().x() < 0 || box.max().x() > cols - 1 ||
+       box.min().y() < 0 || box.max().y() > rows - 1))
+    grow_bounds(0, lo, hi); // Off the DEM
+
+  double x0 = std::max(box.min().x(), 0.0), x1 = std::min(box.max().x(), cols - 1.0);
+  double y0 = std::max(box.min().y(), 0.0), y1 = std::min(box.max().y(), rows - 1.0);
+  if (x0 > x1 || y0 > y1 || m_min_pyramid.empty())
+    return true;
+
+  // Go up until the box spans at most two cells along each axis
+  int c0 = int(x0), c1 = int(x1), r0 = int(y0), r1 = int(y1);
+  size_t level = 0;
+  while (level + 1 < m_min_pyramid.size() && (c1 - c0 > 1 || r1 - r0 > 1)) {
+    c0 >>= 1; c1 >>= 1; r0 >>= 1; r1 >>= 1;
+    level++;
+  }
+  ImageView<float> const& plo = m_min_pyramid[level];
+  ImageView<float> const& phi = m_max_pyramid[level];
+  for (int r = r0; r <= std::min(r1, plo.rows() - 1); r++) {
+    for (int c = c0; c <= std::min(c1, plo.cols() - 1); c++) {
+      lo = std::min(lo, plo(c, r));
+      hi = std::max(hi, phi(c, r));
+    }
+  }
+  return true;
+}
+
+Vector3 DemRayIntersector::intersect(Vector3 const& camera_ctr, Vector3 const& camera_vec,
+                                     bool & has_intersection, bool & in_region) const {
+  has_intersection = false;
+  in_region = true;
+  if (m_min_height > m_max_height)
+    return Vector3(); // No terrain at all
+
+  // Bracket the search between the ellipsoids through the lowest and
+  // highest terrain. Adding a height to both axes does not give a
+  // surface of constant height, so leave some room.
+  Datum const& datum = m_georef.datum();
+  double a = datum.semi_major_axis(), b = datum.semi_minor_axis();
+  double margin = 1.0 + 0.01 * std::max(std::abs(m_min_height), std::abs(m_max_height));
+  double t_start, t_end, lo0, lo1;
+  if (!ray_ellipsoid_range(a + m_max_height + margin, b + m_max_height + margin,
+                           camera_ctr, camera_vec, t_start, t_end) || t_end < 0)
+    return Vector3();
+  t_start = std::max(t_start, 0.0);
+  if (ray_ellipsoid_range(a + m_min_height - margin, b + m_min_height - margin,
+                          camera_ctr, camera_vec, lo0, lo1) && lo0 > t_start)
+    t_end = lo0;
+
+  double vec_len = norm_2(camera_vec);
+  const int    LEAF_SAMPLES = 4;
+  const double LEAF_PIXELS  = 2.0;
+  const double MIN_LENGTH   = 1e-3; // meters along the ray
+
+  // Depth-first search over pieces of the ray, nearest piece first
+  std::vector<std::pair<RayPoint, RayPoint>> stack;
+  stack.push_back(std::make_pair(ray_point(camera_ctr, camera_vec, t_start),
+                                 ray_point(camera_ctr, camera_vec, t_end)));
+  while (!stack.empty()) {
+    RayPoint p0 = stack.back().first, p1 = stack.back().second;
+    stack.pop_back();
+
+    if (p0.pix != p0.pix || p1.pix != p1.pix) {
+      // The projection failed, let the caller deal with this ray
+      in_region = false;
+      return Vector3();
+    }
+
+    // The DEM pixels this piece can pass over, with room for the
+    // projected path not being a straight line.
+    BBox2 path;
+    path.grow(p0.pix);
+    path.grow(p1.pix);
+    double extent = std::max(path.width(), path.height());
+
+    float dem_lo, dem_hi;
+    if (!height_bounds(path, 1.0 + 0.25 * extent, dem_lo, dem_hi)) {
+      in_region = false;
+      return Vector3();
+    }
+    if (dem_lo > dem_hi)
+      continue; // Nothing to hit
+
+    // A straight piece of length L sags below its ends by at most L^2/(8R)
+    double length = (p1.t - p0.t) * vec_len;
+    double sag = length * length / (8.0 * m_min_curvature_radius);
+    if (std::min(p0.height, p1.height) - sag - 0.1 > dem_hi)
+      continue; // Entirely above the terrain
+
+    if (extent > LEAF_PIXELS && length > MIN_LENGTH) {
+      RayPoint mid = ray_point(camera_ctr, camera_vec, 0.5 * (p0.t + p1.t));
+      stack.push_back(std::make_pair(mid, p1));
+      stack.push_back(std::make_pair(p0, mid));
+      continue;
+    }
+
+    // Look for the ray going from above the terrain to below it
+    RayPoint prev = p0;
+    double prev_h;
+    bool prev_valid = dem_height(prev.pix, prev_h);
+    for (int k = 1; k <= LEAF_SAMPLES; k++) {
+      RayPoint curr = (k == LEAF_SAMPLES) ? p1 :
+        ray_point(camera_ctr, camera_vec, p0.t + (p1.t - p0.t) * k / LEAF_SAMPLES);
+      double curr_h;
+      bool curr_valid = dem_height(curr.pix, curr_h);
+      if (prev_valid && curr_valid) {
+        double f0 = prev_h - prev.height, f1 = curr_h - curr.height;
+        if (f0 < 0 && f1 >= 0) {
+          // Illinois variant of regula falsi on the height difference
+          double t0 = prev.t, t1 = curr.t, t = t1;
+          int side = 0;
+          bool found = true;
+          for (int iter = 0; iter < 100; iter++) {
+            if (std::abs(f1) < m_height_error_tol) {
+              t = t1;
+              break;
+            }
+            t = t1 - f1 * (t1 - t0) / (f1 - f0);
+            if (!(t > t0 && t < t1))
+              t = 0.5 * (t0 + t1);
+            RayPoint p = ray_point(camera_ctr, camera_vec, t);
+            double h;
+            if (!dem_height(p.pix, h)) {
+              found = false; // The crossing is in a hole
+              break;
+            }
+            double f = h - p.height;
+            if (std::abs(f) < m_height_error_tol || (t1 - t0) * vec_len < 1e-6)
+              break;
+            if (f < 0) {
+              t0 = t; f0 = f;
+              if (side == -1) f1 /= 2;
+              side = -1;
+            } else {
+              t1 = t; f1 = f;
+              if (side == 1) f0 /= 2;
+              side = 1;
+            }
+          }
+          if (found) {
+            has_intersection = true;
+            return camera_ctr + t * camera_vec;
+          }
+        }
+      }
+      prev = curr;
+      prev_h = curr_h;
+      prev_valid = curr_valid;
+    }
+  }
+
+  return Vector3();
+}
+
+}} // end namespace vw::cartography
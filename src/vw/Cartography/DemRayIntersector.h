@@ -0,0 +1,102 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#ifndef __VW_CARTOGRAPHY_DEMRAYINTERSECTOR_H__
+#define __VW_CARTOGRAPHY_DEMRAYINTERSECTOR_H__
+
+/// \file DemRayIntersector.h Intersect many rays with a DEM held in memory.
+
+#include <vw/Image/ImageView.h>
+#include <vw/Image/ImageViewRef.h>
+#include <vw/Image/PixelMask.h>
+#include <vw/Cartography/GeoReference.h>
+
+#include <vector>
+
+namespace vw { namespace cartography {
+
+  /// Intersects rays with a DEM. A region of the DEM is copied into a
+  /// contiguous buffer, together with a pyramid of the minimum and
+  /// maximum heights over blocks of 2^k x 2^k pixels. A ray is searched
+  /// by repeatedly halving its extent, dropping any piece that is
+  /// provably above the terrain under it, and the first crossing found
+  /// is refined with a safeguarded secant method.
+  ///
+  /// The DEM is sampled with bilinear interpolation, and nodata and
+  /// off-DEM locations are handled as in camera_pixel_to_dem_xyz().
+  /// Queries do not change this object, but they go through the
+  /// georef, so they may be made from several threads at once only if
+  /// the georef allows it.
+  class DemRayIntersector {
+  public:
+
+    /// Load the given region of the DEM, in DEM pixels, into memory.
+    /// The georef is kept by reference and must outlive this object.
+    DemRayIntersector(ImageViewRef<PixelMask<float>> const& dem,
+                      GeoReference const& georef,
+                      BBox2i const& region,
+                      bool treat_nodata_as_zero,
+                      double height_error_tol = 1e-3);
+
+    /// Find the first intersection of the ray with the terrain. If the
+    /// search has to leave the loaded region before it can decide,
+    /// in_region is set to false and the ray must be intersected some
+    /// other way, for example with camera_pixel_to_dem_xyz().
+    Vector3 intersect(Vector3 const& camera_ctr, Vector3 const& camera_vec,
+                      bool & has_intersection, bool & in_region) const;
+
+    BBox2i const& region() const { return m_region; }
+
+    /// Height bounds over the loaded region. min > max if there is no data.
+    double min_height() const { return m_min_height; }
+    double max_height() const { return m_max_height; }
+
+  private:
+    // A sample of the ray: its parameter, DEM pixel in the region, and height
+    struct RayPoint {
+      double  t;
+      Vector2 pix;
+      double  height;
+    };
+
+    RayPoint ray_point(Vector3 const& ctr, Vector3 const& vec, double t) const;
+
+    // Bilinear DEM height at a pixel of the region. Returns false where
+    // there is no terrain.
+    bool dem_height(Vector2 const& pix, double & height) const;
+
+    // Height bounds over the quads within pad pixels of a box of region
+    // pixels. Returns false if the box leaves the region and the region
+    // is not the whole DEM.
+    bool height_bounds(BBox2 const& path, double pad, float & lo, float & hi) const;
+
+    GeoReference const& m_georef; // alias, as a copy is expensive for dynamic CRS
+    BBox2i  m_region;
+    bool    m_region_is_dem;
+    bool    m_treat_nodata_as_zero;
+    double  m_height_error_tol;
+    double  m_min_height, m_max_height;
+    double  m_min_curvature_radius; // for how far a chord sags below its ends
+    ImageView<float> m_heights; // nodata is NaN
+    // Level k holds bounds over 2^k x 2^k quads. A quad is the square
+    // between four neighboring pixels, which bounds bilinear interpolation.
+    std::vector<ImageView<float>> m_min_pyramid, m_max_pyramid;
+  };
+
+}} // namespace vw::cartography
+
+#endif // __VW_CARTOGRAPHY_DEMRAYINTERSECTOR_H__
@@ -916,6 +916,74 @@ Vector2 GeoReference::lonlat_to_point(Vector2 lon_lat) const {
   return Vector2(x, y);
 }
 
+namespace {
+
+// Apply a coordinate transformation to num points at once. The
+// transformation hands them to PROJ in one call.
+void transform_points(OGRCoordinateTransformation * trans,
+                      Vector2 const* in, Vector2* out, size_t num) {
+  std::vector<double> x(num), y(num);
+  std::vector<int> success(num, 0);
+  for (size_t i = 0; i < num; i++) {
+    x[i] = in[i][0];
+    y[i] = in[i][1];
+  }
+  // The return value only says if all points succeeded. Check each one.
+  trans->Transform(int(num), &x[0], &y[0], NULL, &success[0]);
+  for (size_t i = 0; i < num; i++) {
+    if (!success[i])
+      vw::vw_throw(vw::ArgumentErr() << "Failed to project point.\n");
+    out[i] = Vector2(x[i], y[i]);
+  }
+}
+
+} // namespace
+
+void GeoReference::point_to_lonlat(Vector2 const* locs, Vector2* lon_lats, size_t num) const {
+
+  if (!m_is_projected) {
+    std::copy(locs, locs + num, lon_lats);
+    return;
+  }
+
+  if (!m_proj_context.is_initialized())
+    vw::vw_throw(vw::ArgumentErr() << "Attempted to project without a valid transform.\n");
+
+  if (num > 0)
+    transform_points(m_proj_context.m_proj_to_lonlat, locs, lon_lats, num);
+}
+
+void GeoReference::lonlat_to_point(Vector2 const* lon_lats, Vector2* locs, size_t num) const {
+
+  std::vector<Vector2> adjusted(lon_lats, lon_lats + num);
+  if (!m_image_ll_box.empty()) {
+    // Adjust lonlat to be as close as possible to the center of the image
+    double mid = (m_image_ll_box.min().x() + m_image_ll_box.max().x())/2.0;
+    for (size_t i = 0; i < num; i++) {
+      Vector2 & lon_lat = adjusted[i];
+      double diff1 = std::abs(lon_lat[0] - mid);
+      double diff2 = std::abs(lon_lat[0] - mid - 360);
+      if (diff2 < diff1)
+        lon_lat[0] -= 360;
+      diff1 = std::abs(lon_lat[0] - mid);
+      diff2 = std::abs(lon_lat[0] - mid + 360);
+      if (diff2 < diff1)
+        lon_lat[0] += 360;
+    }
+  }
+
+  if (!m_is_projected) {
+    std::copy(adjusted.begin(), adjusted.end(), locs);
+    return;
+  }
+
+  if (!m_proj_context.is_initialized())
+    vw::vw_throw(vw::ArgumentErr() << "Attempted to project without a valid transform.\n");
+
+  if (num > 0)
+    transform_points(m_proj_context.m_lonlat_to_proj, &adjusted[0], locs, num);
+}
+
 /// Convert lon/lat/alt to projected x/y/alt 
 Vector3 GeoReference::geodetic_to_point(Vector3 llh) const {
 
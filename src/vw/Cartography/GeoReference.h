@@ -286,6 +286,13 @@ namespace cartography {
     /// the location in the projected coordinate system.
     Vector2 lonlat_to_point(Vector2 lon_lat) const;
 
+    /// Batch versions of point_to_lonlat() and lonlat_to_point(). These
+    /// convert num points with one call to PROJ, rather than one call
+    /// per point. The input and output may be the same array. Throws if
+    /// any point fails to project, as the single-point versions do.
+    void point_to_lonlat(Vector2 const* locs, Vector2* lon_lats, size_t num) const;
+    void lonlat_to_point(Vector2 const* lon_lats, Vector2* locs, size_t num) const;
+
     /// Convert lon/lat/alt to projected x/y/alt 
     Vector3 geodetic_to_point(Vector3 llh) const;
 
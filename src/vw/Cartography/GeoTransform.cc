@@ -266,6 +266,34 @@ namespace cartography {
     Vector2 dst_lonlat = lonlat_to_lonlat(src_lonlat, forward);
     return m_dst_georef.lonlat_to_pixel(dst_lonlat);
   }
+
+  // The same steps as forward(), with the conversions between projected
+  // coordinates and lonlat done for all pixels at once
+  void GeoTransform::forward(Vector2 const* pixels, Vector2* out, size_t num) const {
+    if (m_skip_map_projection) {
+      for (size_t i = 0; i < num; i++)
+        out[i] = m_dst_georef.point_to_pixel(m_src_georef.pixel_to_point(pixels[i]));
+      return;
+    }
+    if (num == 0)
+      return;
+
+    std::vector<Vector2> lonlats(num);
+    for (size_t i = 0; i < num; i++)
+      lonlats[i] = m_src_georef.pixel_to_point(pixels[i]);
+    m_src_georef.point_to_lonlat(&lonlats[0], &lonlats[0], num);
+
+    for (size_t i = 0; i < num; i++) {
+      if (m_dst_georef.is_projected())
+        wrapLon(lonlats[i][0]);
+      if (!m_skip_datum_conversion)
+        lonlats[i] = lonlat_to_lonlat(lonlats[i], true);
+    }
+
+    m_dst_georef.lonlat_to_point(&lonlats[0], &lonlats[0], num);
+    for (size_t i = 0; i < num; i++)
+      out[i] = m_dst_georef.point_to_pixel(lonlats[i]);
+  }
   
   // Apply the forward transform to a box
   BBox2i GeoTransform::forward_bbox(BBox2i const& bbox) const {
@@ -460,25 +488,71 @@ namespace cartography {
     return os;
   }
 
+namespace {
+  // Reproject the nonzero points in place. Only the first two
+  // coordinates change. The third is the altitude and is not touched.
+  void reproject_points(GeoTransform const& trans, Vector3* points, size_t num) {
+    std::vector<size_t>  index;
+    std::vector<Vector2> xy;
+    index.reserve(num);
+    xy.reserve(num);
+    for (size_t i = 0; i < num; i++) {
+      if (points[i] == Vector3())
+        continue;
+      index.push_back(i);
+      xy.push_back(Vector2(points[i][0], points[i][1]));
+    }
+    if (xy.empty())
+      return;
+
+    trans.forward(&xy[0], &xy[0], xy.size());
+    for (size_t k = 0; k < index.size(); k++) {
+      points[index[k]].x() = xy[k][0];
+      points[index[k]].y() = xy[k][1];
+    }
+  }
+}
+
   void reproject_point_image(ImageView<Vector3> const& point_image,
                              GeoReference const& src_georef,
                              GeoReference const& dst_georef) {
 
     GeoTransform gtx(src_georef, dst_georef);
 
-    // Iterate over the image, transforming the first two coordinates
-    // in the Vector one at a time.  The third coordinate is taken to
-    // be the altitude value, and this value is not touched.
-    for (int32 j=0; j < point_image.rows(); ++j) {
-      for (int32 i=0; i < point_image.cols(); ++i) {
-        if (point_image(i,j) != Vector3()) {
-          Vector2 in(point_image(i,j)[0], point_image(i,j)[1]);
-          Vector2 out = gtx.forward(in);
-          point_image(i,j).x() = out[0];
-          point_image(i,j).y() = out[1];
-        }
-      }
+    // Reproject a row at a time
+    for (int32 j = 0; j < point_image.rows(); ++j)
+      reproject_points(gtx, &point_image(0, j), point_image.cols());
+  }
+
+  ReprojectPointImageView::ReprojectPointImageView(ImageViewRef<Vector3> const& point_image,
+                                                   GeoReference const& src_georef,
+                                                   GeoReference const& dst_georef):
+    m_point_image(point_image), m_trans(src_georef, dst_georef), m_mutex(new Mutex) {}
+
+  ReprojectPointImageView::prerasterize_type
+  ReprojectPointImageView::prerasterize(BBox2i const& bbox) const {
+
+    ImageView<Vector3> tile = crop(m_point_image, bbox);
+
+    // Each block gets its own transform, as the PROJ objects must not be
+    // shared among threads
+    GeoTransform trans;
+    {
+      Mutex::WriteLock lock(*m_mutex);
+      trans = m_trans;
     }
+    for (int32 row = 0; row < tile.rows(); row++)
+      reproject_points(trans, &tile(0, row), tile.cols());
+
+    return prerasterize_type(tile, -bbox.min().x(), -bbox.min().y(), cols(), rows());
+  }
+
+  ReprojectPointImageView
+  reproject_point_image_view(ImageViewRef<Vector3> const& point_image,
+                             GeoReference const& src_georef,
+                             GeoReference const& dst_georef) {
+    return ReprojectPointImageView(point_image, src_georef, dst_georef);
   }
+
 }} // namespace vw::cartography
 
@@ -24,6 +24,8 @@
 
 #include <vw/Core/Thread.h>
 #include <vw/Math/Vector.h>
+#include <vw/Image/ImageViewRef.h>
+#include <vw/Image/Manipulation.h>
 #include <vw/Image/Transform.h>
 #include <vw/Cartography/GeoReference.h>
 
@@ -82,6 +84,11 @@ namespace cartography {
     /// pixel in the destination (transformed) image.
     Vector2 forward(Vector2 const& v) const;
 
+    /// Batch version of forward(). The pixels are converted with one
+    /// call to PROJ per georeference, rather than one per pixel. The
+    /// input and output may be the same array.
+    void forward(Vector2 const* pixels, Vector2* out, size_t num) const;
+
     /// Given a pixel coordinate of an image in a destination
     /// georeference frame, this routine computes the corresponding
     /// pixel from an image in the source georeference frame.
@@ -245,6 +252,51 @@ namespace cartography {
                              GeoReference const& src_georef,
                              GeoReference const& dst_georef);
 
+  /// Reproject an image of 3D points as reproject_point_image() does,
+  /// but as a view, one block at a time. Then an image too large for
+  /// memory can be streamed, for example with
+  ///   block_write_gdal_image(output, reproject_point_image_view(
+  ///     DiskImageView<Vector3>(input), src_georef, dst_georef), opt);
+  /// which reads, reprojects and writes the blocks in parallel. The
+  /// points of each block are converted with one call to PROJ.
+  class ReprojectPointImageView: public ImageViewBase<ReprojectPointImageView> {
+    ImageViewRef<Vector3>    m_point_image;
+    GeoTransform             m_trans;
+    boost::shared_ptr<Mutex> m_mutex; // To copy m_trans from several threads
+
+  public:
+    typedef Vector3 pixel_type;
+    typedef Vector3 result_type;
+    typedef ProceduralPixelAccessor<ReprojectPointImageView> pixel_accessor;
+
+    ReprojectPointImageView(ImageViewRef<Vector3> const& point_image,
+                            GeoReference const& src_georef,
+                            GeoReference const& dst_georef);
+
+    inline int32 cols  () const { return m_point_image.cols(); }
+    inline int32 rows  () const { return m_point_image.rows(); }
+    inline int32 planes() const { return 1; }
+
+    inline pixel_accessor origin() const { return pixel_accessor(*this, 0, 0); }
+    inline pixel_type operator()(int32 /*i*/, int32 /*j*/, int32 /*p*/ = 0) const {
+      vw_throw(NoImplErr() << "ReprojectPointImageView::operator() is not implemented.");
+      return pixel_type();
+    }
+
+    typedef CropView<ImageView<pixel_type>> prerasterize_type;
+    prerasterize_type prerasterize(BBox2i const& bbox) const;
+
+    template <class DestT>
+    inline void rasterize(DestT const& dest, BBox2i const& bbox) const {
+      vw::rasterize(prerasterize(bbox), dest, bbox);
+    }
+  };
+
+  ReprojectPointImageView
+  reproject_point_image_view(ImageViewRef<Vector3> const& point_image,
+                             GeoReference const& src_georef,
+                             GeoReference const& dst_georef);
+
 }} // namespace vw::cartography
 
 #endif // __GEO_TRANSFORM_H__
@@ -22,6 +22,7 @@
 #include <vw/Core/FundamentalTypes.h>
 #include <vw/Math/EulerAngles.h>
 #include <vw/Image/Algorithms.h>
+#include <vw/Image/EdgeExtension.h>
 #include <vw/Image/ImageChannels.h>
 #include <vw/Image/ImageSurface.h>
 #include <vw/Image/ImageViewRef.h>
@@ -44,6 +45,53 @@
 namespace vw {
 namespace cartography {
 
+  HillshadeView::HillshadeView(ImageViewRef<PixelMask<PixelGray<float>>> const& dem,
+                               float u_scale, float v_scale, Vector3f const& light):
+    m_dem(dem), m_u_scale(u_scale), m_v_scale(v_scale), m_light(normalize(light)) {}
+
+  // The arithmetic is that of ComputeNormalsFunc, DotProdFunc, clamp()
+  // and channel_cast_rescale(), so the result is the same to the bit.
+  HillshadeView::prerasterize_type HillshadeView::prerasterize(BBox2i const& bbox) const {
+
+    // The DEM block and the row and column after it, repeating the last
+    // row and column of the DEM past its edge, as compute_normals() does
+    BBox2i dem_box = bbox;
+    dem_box.max() += Vector2i(1, 1);
+    ImageView<PixelMask<PixelGray<float>>> dem
+      = crop(edge_extend(m_dem, ConstantEdgeExtension()), dem_box);
+
+    ImageView<pixel_type> tile(bbox.width(), bbox.height());
+    for (int32 row = 0; row < bbox.height(); row++) {
+      PixelMask<PixelGray<float>> const* curr = &dem(0, row);
+      PixelMask<PixelGray<float>> const* next = &dem(0, row + 1);
+      pixel_type* out = &tile(0, row);
+      for (int32 col = 0; col < bbox.width(); col++) {
+        if (!is_valid(curr[col]) || !is_valid(curr[col+1]) || !is_valid(next[col])) {
+          out[col] = pixel_type();
+          continue;
+        }
+        float alt1 = curr[col].child().v();
+        float alt2 = curr[col+1].child().v();
+        float alt3 = next[col].child().v();
+        Vector3f n1(m_u_scale, 0, alt2 - alt1);
+        Vector3f n2(0, m_v_scale, alt3 - alt1);
+        float shade = dot_prod(normalize(cross_prod(n1, n2)), m_light);
+        if (shade > 1.0f)
+          shade = 1.0f;
+        else if (shade < 0.0f)
+          shade = 0.0f;
+        out[col] = channel_cast_rescale<uint8>(PixelGray<float>(shade));
+      }
+    }
+
+    return prerasterize_type(tile, -bbox.min().x(), -bbox.min().y(), cols(), rows());
+  }
+
+  HillshadeView hillshade(ImageViewRef<PixelMask<PixelGray<float>>> const& dem,
+                          float u_scale, float v_scale, Vector3f const& light) {
+    return HillshadeView(dem, u_scale, v_scale, light);
+  }
+
   /// Do the hillshade work.
   void do_hillshade(std::string const& input_file_name,
                     std::string const& output_file_name,
@@ -122,8 +170,8 @@ namespace cartography {
     }
 
     // The final result is the dot product of the light source with the normals
-    ImageViewRef<PixelMask<PixelGray<uint8>>> shaded_image =
-      channel_cast_rescale<uint8>(clamp(dot_prod(compute_normals(dem, u_scale, v_scale), light)));
+    ImageViewRef<PixelMask<PixelGray<uint8>>> shaded_image
+      = hillshade(dem, u_scale, v_scale, light);
 
     // Save the result
     vw_out() << "Writing shaded relief image: " << output_file_name << "\n";
@@ -19,6 +19,12 @@
 #define __VW_CARTOGRAPHY_HILLSHADE_H__
 
 #include <vw/FileIO/GdalWriteOptions.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/ImageViewRef.h>
+#include <vw/Image/Manipulation.h>
+#include <vw/Image/PixelMask.h>
+#include <vw/Image/PixelTypes.h>
+#include <vw/Math/Vector.h>
 #include <string>
 
 /// \file Hillshade.h. Hillshade images with georeference.
@@ -26,6 +32,49 @@
 namespace vw {
 namespace cartography {
 
+  /// The shaded relief of a DEM lit from a given direction. This gives
+  /// the same result as rescaling to uint8 the clamped dot product of
+  /// the light with compute_normals() of the DEM, but each block is
+  /// done in one pass over a copy of the DEM block and one more row and
+  /// column, rather than through a chain of per-pixel views. A pixel is
+  /// invalid if it, or its neighbor to the right or below, is invalid.
+  class HillshadeView: public ImageViewBase<HillshadeView> {
+    ImageViewRef<PixelMask<PixelGray<float>>> m_dem;
+    float    m_u_scale, m_v_scale;
+    Vector3f m_light; // normalized
+
+  public:
+    typedef PixelMask<PixelGray<uint8>> pixel_type;
+    typedef pixel_type result_type;
+    typedef ProceduralPixelAccessor<HillshadeView> pixel_accessor;
+
+    HillshadeView(ImageViewRef<PixelMask<PixelGray<float>>> const& dem,
+                  float u_scale, float v_scale, Vector3f const& light);
+
+    inline int32 cols  () const { return m_dem.cols(); }
+    inline int32 rows  () const { return m_dem.rows(); }
+    inline int32 planes() const { return 1; }
+
+    inline pixel_accessor origin() const { return pixel_accessor(*this, 0, 0); }
+    inline pixel_type operator()(int32 /*i*/, int32 /*j*/, int32 /*p*/ = 0) const {
+      vw_throw(NoImplErr() << "HillshadeView::operator() is not implemented.");
+      return pixel_type();
+    }
+
+    typedef CropView<ImageView<pixel_type>> prerasterize_type;
+    prerasterize_type prerasterize(BBox2i const& bbox) const;
+
+    template <class DestT>
+    inline void rasterize(DestT const& dest, BBox2i const& bbox) const {
+      vw::rasterize(prerasterize(bbox), dest, bbox);
+    }
+  };
+
+  /// Shade a DEM. The scales are the pixel size in the units of the
+  /// heights, as for compute_normals().
+  HillshadeView hillshade(ImageViewRef<PixelMask<PixelGray<float>>> const& dem,
+                          float u_scale, float v_scale, Vector3f const& light);
+
   /// Redirect to the function with the required data type.
   void do_multitype_hillshade(std::string const& input_file,
                               std::string const& output_file,
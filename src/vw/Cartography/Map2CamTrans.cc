@@ -19,10 +19,13 @@
 #include <vw/Cartography/GeoTransform.h>
 #include <vw/Cartography/Map2CamTrans.h>
 #include <vw/Cartography/CameraBBox.h>
+#include <vw/Image/Algorithms.h>
 #include <vw/Image/MaskViews.h>
 #include <vw/Image/ImageChannels.h>
 #include <vw/Camera/CameraModel.h>
 
+#include <cmath>
+
 namespace vw { namespace cartography {
 
   // This transform is not thread-safe, unless caching is turned off. Use
@@ -57,41 +60,103 @@ namespace vw { namespace cartography {
     // a ray with the DEM.
     m_height_guess = vw::cartography::demHeightGuess(m_masked_dem);
 
-    // Set up interpolation interface to the data we loaded into memory. The
-    // nearest neighbor logic is useful when mapprojecting a mask.
-    if (m_nearest_neighbor)
-      m_interp_dem = interpolate(m_masked_dem,
-                                 NearestPixelInterpolation(), ZeroEdgeExtension());
-    else
-      m_interp_dem = interpolate(m_masked_dem,
-                                 BicubicInterpolation(), ZeroEdgeExtension());
+    // Set up interpolation interface to the data we loaded into memory.
+    m_interp_dem = interpolate_dem(m_masked_dem);
   }
 
   void Map2CamTrans::set_use_cache(bool use_cache) {
     m_use_cache = use_cache;
   }
 
+  void Map2CamTrans::set_height_index(boost::shared_ptr<DemHeightIndex> height_index) {
+    m_height_index = height_index;
+    if (m_height_index && m_height_index->stats().has_data())
+      m_height_guess = m_height_index->stats().mean_height();
+  }
+
+  // The nearest neighbor logic is useful when mapprojecting a mask.
+  ImageViewRef<PixelMask<float>>
+  Map2CamTrans::interpolate_dem(ImageViewRef<PixelMask<float>> const& masked_dem) const {
+    if (m_nearest_neighbor)
+      return interpolate(masked_dem, NearestPixelInterpolation(), ZeroEdgeExtension());
+    return interpolate(masked_dem, BicubicInterpolation(), ZeroEdgeExtension());
+  }
+
+  int Map2CamTrans::pixel_buffer() const {
+    if (m_nearest_neighbor)
+      return NearestPixelInterpolation::pixel_buffer;
+    return BicubicInterpolation::pixel_buffer;
+  }
+
   // This function is not thread-safe by default. See above.
   vw::Vector2 Map2CamTrans::reverse(const vw::Vector2 &p) const {
 
     // If we have data for the location already cached. This is only useful
     // when processing tiles. For individual samples need to turn off the caching
-    // ahead of time as it only adds overhead.
-    if (m_use_cache && m_img_cache_box.contains(p)) {
-      // Interpolate the output value using the cached data
-      PixelMask<Vector2> v = m_cache_interp_mask(p.x() - m_img_cache_box.min().x(),
-                                                 p.y() - m_img_cache_box.min().y());
-      // We can just return the value if it is valid
-      if (is_valid(v)) return v.child();
-      else             return m_invalid_pix;
+    // ahead of time as it only adds overhead. Only pixels in the tile box are
+    // looked up in the tile, so it never goes back to the object that made it.
+    if (m_use_cache && m_tile && m_tile->box().contains(p))
+      return m_tile->reverse(p);
+
+    if (m_use_cache)
+      return reverse_exact(p, m_cropped_interp_dem, m_dem_cache_box);
+    return reverse_exact(p, m_interp_dem, BBox2i());
+  }
+
+  vw::Vector2 Map2CamTrans::reverse_exact(vw::Vector2 const& p,
+                                          ImageViewRef<PixelMask<float>> const& interp_dem,
+                                          BBox2i const& dem_box) const {
+    Vector2 dem_pix;
+    Vector3 llh;
+    if (!dem_point(p, interp_dem, dem_box, dem_pix, llh))
+      return m_invalid_pix;
+    return camera_pixel(m_dem_georef.datum().geodetic_to_cartesian(llh));
+  }
+
+  void Map2CamTrans::reverse(std::vector<Vector2> const& pix, std::vector<Vector2> & cam_pix,
+                             ImageViewRef<PixelMask<float>> const& interp_dem,
+                             BBox2i const& dem_box, std::vector<Vector2> * dem_pix) const {
+    size_t num = pix.size();
+    cam_pix.assign(num, m_invalid_pix);
+    if (dem_pix)
+      dem_pix->assign(num, Vector2());
+
+    // The DEM points of the pixels with a valid DEM height
+    std::vector<Vector3> points;
+    std::vector<size_t>  index;
+    points.reserve(num);
+    index.reserve(num);
+    for (size_t i = 0; i < num; i++) {
+      Vector2 dp;
+      Vector3 llh;
+      bool valid = dem_point(pix[i], interp_dem, dem_box, dp, llh);
+      if (dem_pix)
+        (*dem_pix)[i] = dp;
+      if (!valid)
+        continue;
+      points.push_back(llh);
+      index.push_back(i);
+    }
+    if (points.empty())
+      return;
+
+    m_dem_georef.datum().geodetic_to_cartesian(&points[0], &points[0], points.size());
+    std::vector<Vector2> projected(points.size());
+    m_cam->points_to_pixels(&points[0], &projected[0], points.size());
+    for (size_t k = 0; k < points.size(); k++) {
+      if (valid_camera_pixel(projected[k]))
+        cam_pix[index[k]] = projected[k];
     }
+  }
+
+  bool Map2CamTrans::dem_point(Vector2 const& p,
+                               ImageViewRef<PixelMask<float>> const& interp_dem,
+                               BBox2i const& dem_box, Vector2 & dem_pix, Vector3 & llh) const {
 
     // Check if we are within the interpolation bounds of the DEM
-    int b = BicubicInterpolation::pixel_buffer;
-    if (m_nearest_neighbor)
-      b = NearestPixelInterpolation::pixel_buffer;
-    Vector2 lonlat  = m_image_georef.pixel_to_lonlat(p);
-    Vector2 dem_pix = m_dem_georef.lonlat_to_pixel(lonlat);
+    int b = pixel_buffer();
+    Vector2 lonlat = m_image_georef.pixel_to_lonlat(p);
+    dem_pix = m_dem_georef.lonlat_to_pixel(lonlat);
     if (dem_pix[0] < b - 1 || dem_pix[0] >= m_dem.cols() - b ||
         dem_pix[1] < b - 1 || dem_pix[1] >= m_dem.rows() - b) {
 
@@ -105,47 +170,44 @@ namespace vw { namespace cartography {
         dem_pix = grid_pix;
 
       if (!snap_to_grid)
-        return m_invalid_pix; // Out of DEM bounds
+        return false; // Out of DEM bounds
     }
 
+    // Use the DEM in memory if the pixel is far enough from its edge,
+    // and otherwise the full DEM.
     PixelMask<float> h;
-    bool no_cache = true;
-    if (m_use_cache) {
-      no_cache = false;
-      Vector2 crop_pix = dem_pix - m_dem_cache_box.min(); // since we cropped the DEM
-      if (m_dem_cache_box.empty() ||
-          crop_pix[0] < b - 1 || crop_pix[0] >= m_cropped_dem.cols() - b ||
-          crop_pix[1] < b - 1 || crop_pix[1] >= m_cropped_dem.rows() - b) {
-        no_cache = true;
-      } else {
-        // Successfully use the cached DEM data
-        h = m_cropped_interp_dem(crop_pix[0], crop_pix[1]);
-      }
-    }
-
-    // If there is no cached data, use the full DEM
-    if (no_cache)
+    Vector2 crop_pix = dem_pix - dem_box.min();
+    if (!dem_box.empty() &&
+        crop_pix[0] >= b - 1 && crop_pix[0] < dem_box.width()  - b &&
+        crop_pix[1] >= b - 1 && crop_pix[1] < dem_box.height() - b)
+      h = interp_dem(crop_pix[0], crop_pix[1]);
+    else
       h = m_interp_dem(dem_pix[0], dem_pix[1]);
 
     if (!is_valid(h))
-      return m_invalid_pix;
+      return false;
 
-    vw::Vector3 llh = Vector3(lonlat[0], lonlat[1], h.child());
-    Vector3 xyz = m_dem_georef.datum().geodetic_to_cartesian(llh);
-    Vector2 pt;
+    llh = Vector3(lonlat[0], lonlat[1], h.child());
+    return true;
+  }
+
+  vw::Vector2 Map2CamTrans::camera_pixel(Vector3 const& xyz) const {
     try {
-      pt = m_cam->point_to_pixel(xyz);
-      if (m_call_from_mapproject &&
-           (pt[0] < b - 1 || pt[0] >= m_image_size[0] - b ||
-            pt[1] < b - 1 || pt[1] >= m_image_size[1] - b)) {
-        // Won't be able to interpolate into image in transform(...)
-        return m_invalid_pix;
-      }
-    } catch(...) { // If a point failed to project
-      return m_invalid_pix;
-    }
+      Vector2 pt = m_cam->point_to_pixel(xyz);
+      if (valid_camera_pixel(pt))
+        return pt;
+    } catch(...) {} // If a point failed to project
+    return m_invalid_pix;
+  }
 
-    return pt;
+  bool Map2CamTrans::valid_camera_pixel(Vector2 const& pt) const {
+    if (pt == m_invalid_pix)
+      return false;
+    // Won't be able to interpolate into image in transform(...)
+    int b = pixel_buffer();
+    return !(m_call_from_mapproject &&
+             (pt[0] < b - 1 || pt[0] >= m_image_size[0] - b ||
+              pt[1] < b - 1 || pt[1] >= m_image_size[1] - b));
   }
 
   // Given a raw pixel, intersect the ray with the DEM and return the pixel
@@ -174,9 +236,9 @@ namespace vw { namespace cartography {
     return m_image_georef.lonlat_to_pixel(vw::Vector2(llh[0], llh[1]));
   }
 
-  // This function is not thread-safe, by default. See above. This function is slow,
-  // but later speeds things up. Better not use it for sparse pixel queries.
-  void Map2CamTrans::cache_dem(vw::BBox2i const& bbox) const {
+  // The DEM pixels needed to apply the transform to a box of mapprojected
+  // pixels, including those for interpolation.
+  vw::BBox2i Map2CamTrans::dem_pixel_box(vw::BBox2i const& bbox) const {
 
     // TODO: This may fail around poles. Need to do the standard X trick, traverse
     // the edges and diagonals of the box. Use here the function sample_float_bbox().
@@ -194,12 +256,20 @@ namespace vw { namespace cartography {
     // A lot of care is needed here when going from real box to int
     // box, and if in doubt, better expand more rather than less.
     dbox.expand(1);
-    m_dem_cache_box = grow_bbox_to_int(dbox);
+    BBox2i dem_box = grow_bbox_to_int(dbox);
     if (m_nearest_neighbor)
-      m_dem_cache_box.expand(NearestPixelInterpolation::pixel_buffer); // for interp
+      dem_box.expand(NearestPixelInterpolation::pixel_buffer); // for interp
     else
-      m_dem_cache_box.expand(BicubicInterpolation::pixel_buffer); // for interp
-    m_dem_cache_box.crop(bounding_box(m_dem));
+      dem_box.expand(BicubicInterpolation::pixel_buffer); // for interp
+    dem_box.crop(bounding_box(m_dem));
+    return dem_box;
+  }
+
+  // This function is not thread-safe, by default. See above. This function is slow,
+  // but later speeds things up. Better not use it for sparse pixel queries.
+  void Map2CamTrans::cache_dem(vw::BBox2i const& bbox) const {
+
+    m_dem_cache_box = dem_pixel_box(bbox);
 
     // Read the dem in memory for speed in the region of the expanded bounding box.
     m_cropped_dem = crop(m_dem, m_dem_cache_box);
@@ -210,62 +280,28 @@ namespace vw { namespace cartography {
       m_cropped_masked_dem = pixel_cast<PixelMask<float>>(m_cropped_dem);
     }
     // Set up interpolation interface to the data we loaded into memory
-    if (m_nearest_neighbor)
-      m_cropped_interp_dem = interpolate(m_cropped_masked_dem,
-                                         NearestPixelInterpolation(), ZeroEdgeExtension());
-    else
-      m_cropped_interp_dem = interpolate(m_cropped_masked_dem,
-                                         BicubicInterpolation(), ZeroEdgeExtension());
+    m_cropped_interp_dem = interpolate_dem(m_cropped_masked_dem);
   } // End function cache_dem
 
+  ImageView<PixelMask<float>> Map2CamTrans::dem_in_memory(BBox2i const& dem_box) const {
+    ImageView<float> dem = crop(m_dem, dem_box);
+    if (m_has_nodata)
+      return create_mask(dem, m_nodata);
+    return pixel_cast<PixelMask<float>>(dem);
+  }
+
   // This function will be called whenever we start to apply the
-  // transform in a tile. It computes and caches the point cloud at
-  // each pixel in the tile, to be used later when we iterate over pixels.
-  // This function is not thread-safe, see above. See cache_dem() for
-  // a note on performance.
+  // transform in a tile. It computes and caches the camera pixels of the
+  // tile, to be used later when we iterate over pixels. This function is
+  // not thread-safe, see above. Use a Map2CamTile directly instead to share
+  // this object among threads.
   vw::BBox2i Map2CamTrans::reverse_bbox(vw::BBox2i const& bbox) const {
 
     // Custom reverse_bbox() function which can handle invalid pixels.
     if (!m_cached_rv_box.empty()) return m_cached_rv_box;
-    
-    cache_dem(bbox);
 
-    // Cache the reverse transform
-    m_img_cache_box = BBox2i();
-    BBox2i local_cache_box = bbox;
-    if (m_nearest_neighbor)
-      local_cache_box.expand(NearestPixelInterpolation::pixel_buffer); // for interpolation
-    else
-      local_cache_box.expand(BicubicInterpolation::pixel_buffer); // for interpolation
-
-    m_cache.set_size(local_cache_box.width(), local_cache_box.height());
-    vw::BBox2 out_box;
-    for (int32 y=local_cache_box.min().y(); y<local_cache_box.max().y(); y++) {
-      for (int32 x=local_cache_box.min().x(); x<local_cache_box.max().x(); x++) {
-        Vector2 p = reverse(Vector2(x,y));
-        m_cache(x - local_cache_box.min().x(), y - local_cache_box.min().y()) = p;
-        if (p == m_invalid_pix) continue;
-        if (bbox.contains(Vector2i(x, y))) out_box.grow(p);
-      }
-    }
-    out_box = grow_bbox_to_int(out_box);
-
-    // Must happen after all calls to reverse finished.
-    m_img_cache_box = local_cache_box;
-
-    if (m_nearest_neighbor)
-      m_cache_interp_mask = interpolate(create_mask(m_cache, m_invalid_pix),
-                                        NearestPixelInterpolation(), ZeroEdgeExtension());
-    else
-      m_cache_interp_mask = interpolate(create_mask(m_cache, m_invalid_pix),
-                                        BicubicInterpolation(), ZeroEdgeExtension());
-
-    // Need the check below as to not try to create images with
-    // negative dimensions.
-    if (out_box.empty())
-      out_box = vw::BBox2i(0, 0, 0, 0);
-
-    m_cached_rv_box = out_box;
+    m_tile.reset(new Map2CamTile(*this, bbox));
+    m_cached_rv_box = m_tile->reverse_bbox(bbox);
 
     return m_cached_rv_box;
   }
@@ -287,6 +323,230 @@ namespace vw { namespace cartography {
     return TransformPtr(new Map2CamTrans(*t_ptr));
   }
 
+  Map2CamTile::Map2CamTile(Map2CamTrans const& trans, BBox2i const& bbox,
+                           int grid_spacing, double tolerance):
+    m_trans(new Map2CamTrans(trans)), m_box(bbox) {
+
+    VW_ASSERT(grid_spacing > 0,
+              ArgumentErr() << "Map2CamTile: The grid spacing must be positive.");
+
+    // The copy is only used for exact lookups outside the tile, which
+    // read the full DEM. Drop the cache, and the tile of the transform,
+    // which may be the one being replaced by this.
+    m_trans->set_use_cache(false);
+    m_trans->m_dem_cache_box      = BBox2i();
+    m_trans->m_cropped_dem        = ImageView<float>();
+    m_trans->m_cropped_masked_dem = ImageViewRef<PixelMask<float>>();
+    m_trans->m_cropped_interp_dem = ImageViewRef<PixelMask<float>>();
+    m_trans->m_cached_rv_box      = BBox2i();
+    m_trans->m_tile.reset();
+
+    int b = trans.pixel_buffer();
+    m_box.expand(b); // for interpolation
+    m_camera_pixels.set_size(m_box.width(), m_box.height());
+    fill(m_camera_pixels, trans.m_invalid_pix);
+
+    // The view shares its pixels with m_camera_pixels, which are filled below
+    if (trans.m_nearest_neighbor)
+      m_interp_camera_pixels = interpolate(create_mask(m_camera_pixels, trans.m_invalid_pix),
+                                           NearestPixelInterpolation(), ZeroEdgeExtension());
+    else
+      m_interp_camera_pixels = interpolate(create_mask(m_camera_pixels, trans.m_invalid_pix),
+                                           BicubicInterpolation(), ZeroEdgeExtension());
+
+    // The grid. Its last row and column are on the tile edge.
+    std::vector<int32> xs, ys;
+    for (int32 x = m_box.min().x(); x < m_box.max().x() - 1; x += grid_spacing)
+      xs.push_back(x);
+    xs.push_back(m_box.max().x() - 1);
+    for (int32 y = m_box.min().y(); y < m_box.max().y() - 1; y += grid_spacing)
+      ys.push_back(y);
+    ys.push_back(m_box.max().y() - 1);
+
+    // If the DEM has no data under this tile, every pixel is invalid, and
+    // reading the DEM and projecting into the camera can be skipped. The
+    // box from dem_pixel_box() comes from the tile corners only, so it is
+    // not used for this.
+    if (trans.m_height_index &&
+        !trans.m_height_index->has_data(grid_dem_box(xs, ys)))
+      return;
+
+    // An empty box means that all heights come from the full DEM
+    BBox2i dem_box = trans.dem_pixel_box(m_box);
+    ImageView<PixelMask<float>> dem;
+    ImageViewRef<PixelMask<float>> interp_dem;
+    if (!dem_box.empty()) {
+      dem = trans.dem_in_memory(dem_box);
+      interp_dem = trans.interpolate_dem(dem);
+    }
+
+    // Running count of the invalid DEM pixels, to check a box in one step
+    ImageView<int32> num_invalid(dem.cols() + 1, dem.rows() + 1);
+    fill(num_invalid, 0);
+    for (int32 row = 0; row < dem.rows(); row++)
+      for (int32 col = 0; col < dem.cols(); col++)
+        num_invalid(col + 1, row + 1) = num_invalid(col, row + 1) + num_invalid(col + 1, row)
+          - num_invalid(col, row) + (is_valid(dem(col, row)) ? 0 : 1);
+
+    std::vector<Vector2> nodes, node_cam, node_dem;
+    for (size_t j = 0; j < ys.size(); j++)
+      for (size_t i = 0; i < xs.size(); i++)
+        nodes.push_back(Vector2(xs[i], ys[j]));
+    trans.reverse(nodes, node_cam, interp_dem, dem_box, &node_dem);
+
+    // A cell can be interpolated if its corners are valid and the DEM
+    // under it is valid and away from the DEM edge. Then it must also pass
+    // the check at its center.
+    size_t num_cells_x = xs.size() - 1, num_cells_y = ys.size() - 1;
+    std::vector<bool> good(num_cells_x * num_cells_y, false);
+    std::vector<size_t> checked;
+    std::vector<Vector2> centers, center_cam;
+    for (size_t j = 0; j < num_cells_y; j++) {
+      for (size_t i = 0; i < num_cells_x; i++) {
+        size_t c[4] = {j * xs.size() + i,       j * xs.size() + i + 1,
+                       (j+1) * xs.size() + i,   (j+1) * xs.size() + i + 1};
+        BBox2 cell_dem;
+        bool valid = true;
+        for (int k = 0; k < 4; k++) {
+          valid = valid && trans.valid_camera_pixel(node_cam[c[k]]);
+          cell_dem.grow(node_dem[c[k]]);
+        }
+        if (!valid || dem_box.empty() ||
+            cell_dem.min().x() < b - 1 || cell_dem.max().x() >= trans.m_dem.cols() - b ||
+            cell_dem.min().y() < b - 1 || cell_dem.max().y() >= trans.m_dem.rows() - b)
+          continue;
+        BBox2i support = grow_bbox_to_int(cell_dem);
+        support.expand(b);
+        support -= dem_box.min();
+        if (!bounding_box(dem).contains(support))
+          continue;
+        Vector2i lo = support.min(), hi = support.max();
+        if (num_invalid(hi.x(), hi.y()) - num_invalid(lo.x(), hi.y())
+            - num_invalid(hi.x(), lo.y()) + num_invalid(lo.x(), lo.y()) != 0)
+          continue;
+        checked.push_back(j * num_cells_x + i);
+        centers.push_back(Vector2((xs[i] + xs[i+1]) / 2, (ys[j] + ys[j+1]) / 2));
+      }
+    }
+    trans.reverse(centers, center_cam, interp_dem, dem_box);
+
+    // Bilinear interpolation in a cell given its corner nodes
+    auto interp_cell = [&](size_t i, size_t j, int32 x, int32 y) -> Vector2 {
+      double tx = double(x - xs[i]) / std::max(xs[i+1] - xs[i], 1);
+      double ty = double(y - ys[j]) / std::max(ys[j+1] - ys[j], 1);
+      size_t n = j * xs.size() + i;
+      return (1-ty) * ((1-tx) * node_cam[n]            + tx * node_cam[n + 1]) +
+                 ty * ((1-tx) * node_cam[n + xs.size()] + tx * node_cam[n + xs.size() + 1]);
+    };
+
+    for (size_t k = 0; k < checked.size(); k++) {
+      size_t i = checked[k] % num_cells_x, j = checked[k] / num_cells_x;
+      Vector2 approx = interp_cell(i, j, int32(centers[k].x()), int32(centers[k].y()));
+      good[checked[k]] = trans.valid_camera_pixel(center_cam[k]) &&
+        norm_2(approx - center_cam[k]) <= tolerance;
+    }
+
+    // Fill the good cells, and list the pixels of the others
+    ImageView<uint8> done(m_box.width(), m_box.height());
+    fill(done, 0);
+    for (size_t j = 0; j < num_cells_y; j++) {
+      for (size_t i = 0; i < num_cells_x; i++) {
+        if (!good[j * num_cells_x + i])
+          continue;
+        for (int32 y = ys[j]; y <= ys[j+1]; y++) {
+          for (int32 x = xs[i]; x <= xs[i+1]; x++) {
+            Vector2 v = interp_cell(i, j, x, y);
+            int32 col = x - m_box.min().x(), row = y - m_box.min().y();
+            m_camera_pixels(col, row) = trans.valid_camera_pixel(v) ? v : trans.m_invalid_pix;
+            done(col, row) = 1;
+          }
+        }
+      }
+    }
+    std::vector<Vector2> rest, rest_cam;
+    for (int32 row = 0; row < m_box.height(); row++)
+      for (int32 col = 0; col < m_box.width(); col++)
+        if (!done(col, row))
+          rest.push_back(Vector2(col, row) + m_box.min());
+    trans.reverse(rest, rest_cam, interp_dem, dem_box);
+    for (size_t k = 0; k < rest.size(); k++)
+      m_camera_pixels(int32(rest[k].x()) - m_box.min().x(),
+                      int32(rest[k].y()) - m_box.min().y()) = rest_cam[k];
+  }
+
+  // The DEM pixels of the grid nodes, grown by the largest step between
+  // neighboring nodes, which bounds those in between unless the map to
+  // the DEM is far from smooth. Near a pole or a seam of the DEM the steps
+  // are large, and so is the box.
+  vw::BBox2i Map2CamTile::grid_dem_box(std::vector<int32> const& xs,
+                                       std::vector<int32> const& ys) const {
+    Map2CamTrans const& trans = *m_trans;
+    BBox2i full = bounding_box(trans.m_dem);
+    std::vector<Vector2> dem_pix(xs.size() * ys.size());
+    try {
+      for (size_t j = 0; j < ys.size(); j++)
+        for (size_t i = 0; i < xs.size(); i++)
+          dem_pix[j * xs.size() + i] = trans.m_dem_georef.lonlat_to_pixel
+            (trans.m_image_georef.pixel_to_lonlat(Vector2(xs[i], ys[j])));
+    } catch (...) {
+      return full;
+    }
+
+    BBox2 box;
+    double step = 0;
+    for (size_t j = 0; j < ys.size(); j++) {
+      for (size_t i = 0; i < xs.size(); i++) {
+        Vector2 const& p = dem_pix[j * xs.size() + i];
+        if (std::isnan(p.x()) || std::isnan(p.y()))
+          return full;
+        box.grow(p);
+        if (i + 1 < xs.size())
+          step = std::max(step, norm_inf(dem_pix[j * xs.size() + i + 1] - p));
+        if (j + 1 < ys.size())
+          step = std::max(step, norm_inf(dem_pix[(j+1) * xs.size() + i] - p));
+      }
+    }
+    box.expand(step + trans.pixel_buffer() + 1);
+    BBox2i dem_box = grow_bbox_to_int(box);
+    dem_box.crop(full);
+    return dem_box;
+  }
+
+  vw::Vector2 Map2CamTile::reverse(vw::Vector2 const& p) const {
+    if (!m_box.contains(p))
+      return m_trans->reverse_exact(p, m_trans->m_interp_dem, BBox2i());
+
+    // Interpolate the output value using the cached data
+    PixelMask<Vector2> v = m_interp_camera_pixels(p.x() - m_box.min().x(),
+                                                  p.y() - m_box.min().y());
+    // We can just return the value if it is valid
+    if (is_valid(v)) return v.child();
+    else             return m_trans->m_invalid_pix;
+  }
+
+  vw::BBox2i Map2CamTile::reverse_bbox(vw::BBox2i const& bbox) const {
+    vw::BBox2 out_box;
+    for (int32 y = bbox.min().y(); y < bbox.max().y(); y++) {
+      for (int32 x = bbox.min().x(); x < bbox.max().x(); x++) {
+        Vector2 p;
+        if (m_box.contains(Vector2i(x, y)))
+          p = m_camera_pixels(x - m_box.min().x(), y - m_box.min().y());
+        else
+          p = reverse(Vector2(x, y));
+        if (p == m_trans->m_invalid_pix) continue;
+        out_box.grow(p);
+      }
+    }
+    out_box = grow_bbox_to_int(out_box);
+
+    // Need the check below as to not try to create images with
+    // negative dimensions.
+    if (out_box.empty())
+      out_box = vw::BBox2i(0, 0, 0, 0);
+
+    return out_box;
+  }
+
   Datum2CamTrans::Datum2CamTrans(camera::CameraModel const* cam,
                                   GeoReference const& image_georef,
                                   GeoReference const& dem_georef,
@@ -23,6 +23,9 @@
 #include <vw/Image/Transform.h>
 #include <vw/FileIO/DiskImageView.h>
 #include <vw/Cartography/GeoReference.h>
+#include <vw/Cartography/DemHeightIndex.h>
+
+#include <vector>
 
 /// \file Map2CamTrans.h
 /// Given a pixel in a map-projected image, convert it to lonlat, then
@@ -33,7 +36,8 @@
 /// invoked for a dense set of individual pixels. The best approach is to first
 /// create a new instance of this class for each tile, do one wholesale caching
 /// computation on the entire tile, then invoke it repeatedly individual pixels
-/// in the tile.
+/// in the tile. Alternatively, make a Map2CamTile for each tile, which is
+/// thread-safe and does not need a copy of this class.
 
 // If desired to invoke it for a sparse set of pixels, turn off caching first.
 // Then it becomes thread-safe. See the locations where this is called, for more
@@ -45,6 +49,8 @@ namespace vw { namespace camera{
 
 namespace vw { namespace cartography {
 
+class Map2CamTile;
+
 class Map2CamTrans: public TransformBase<Map2CamTrans> {
 public:
   camera::CameraModel const* m_cam;
@@ -59,6 +65,7 @@ public:
   double               m_nodata;
   Vector2              m_invalid_pix;
   double               m_height_guess;
+  boost::shared_ptr<DemHeightIndex> m_height_index; // optional, shared by copies
 
   // Avoid using the cache if querying individual points. Without the cache
   // this is thread-safe.
@@ -69,10 +76,10 @@ public:
   mutable ImageView<float>                 m_cropped_dem;
   mutable ImageViewRef<PixelMask<float>>   m_cropped_masked_dem;
   mutable ImageViewRef<PixelMask<float>>   m_cropped_interp_dem;
-  mutable ImageView<Vector2>               m_cache;
-  mutable ImageViewRef<PixelMask<Vector2>> m_cache_interp_mask;
-  mutable BBox2i                           m_img_cache_box;
   mutable BBox2i                           m_cached_rv_box;
+  // Made by reverse_bbox(). It does not change once made, so copies of
+  // this object may share it.
+  mutable boost::shared_ptr<Map2CamTile>   m_tile;
 
 public:
   Map2CamTrans(camera::CameraModel const* cam,
@@ -86,18 +93,106 @@ public:
   // See m_use_cache above
   void set_use_cache(bool use_cache);
 
+  // Use an index of the DEM heights, such as from
+  // DemHeightIndex::load_or_build(). Its mean height replaces the
+  // estimate made from a sample of the DEM, and tiles where the DEM has
+  // no data are made without reading the DEM.
+  void set_height_index(boost::shared_ptr<DemHeightIndex> height_index);
+
   /// Convert mapprojected Coordinate to camera coordinate
   Vector2 reverse(const Vector2 &p) const;
+
+  /// Convert many mapprojected pixels to camera pixels, with the DEM
+  /// read in memory over dem_box and interpolated by interpolate_dem().
+  /// Heights outside dem_box come from the full DEM. The DEM points are
+  /// converted to ECEF and projected into the camera in batches. This
+  /// does not use the cache, so it is thread-safe.
+  void reverse(std::vector<Vector2> const& pix, std::vector<Vector2> & cam_pix,
+               ImageViewRef<PixelMask<float>> const& interp_dem,
+               BBox2i const& dem_box, std::vector<Vector2> * dem_pix = NULL) const;
+
   /// Convert camera pixel to mapprojected pixel
   virtual Vector2 forward(const Vector2 &p) const;
 
   // Not thread safe. Must copy this object.
   void cache_dem(BBox2i const& bbox) const;
+  // The DEM pixels needed for a box of mapprojected pixels
+  BBox2i dem_pixel_box(BBox2i const& bbox) const;
+  // Read the DEM over a box in memory, with nodata masked
+  ImageView<PixelMask<float>> dem_in_memory(BBox2i const& dem_box) const;
+  // Interpolate a DEM as this transform does
+  ImageViewRef<PixelMask<float>>
+  interpolate_dem(ImageViewRef<PixelMask<float>> const& masked_dem) const;
+  // The margin needed around a pixel for interpolation
+  int pixel_buffer() const;
+  // Make a Map2CamTile for this box, to be used by reverse()
   BBox2i reverse_bbox(BBox2i const& bbox) const;
   // Convert a camera bbox to a mapprojected bbox
   BBox2i forward_bbox(BBox2i const& bbox) const;
+
+private:
+  // The camera pixel of a mapprojected pixel, without using the cache.
+  // See the batch version of reverse() for the arguments.
+  Vector2 reverse_exact(Vector2 const& p, ImageViewRef<PixelMask<float>> const& interp_dem,
+                        BBox2i const& dem_box) const;
+  // The DEM pixel and the lon, lat and height of the DEM for a
+  // mapprojected pixel. Returns false if there is no valid DEM height.
+  bool dem_point(Vector2 const& p, ImageViewRef<PixelMask<float>> const& interp_dem,
+                 BBox2i const& dem_box, Vector2 & dem_pix, Vector3 & llh) const;
+  // Project a point into the camera, or return m_invalid_pix
+  Vector2 camera_pixel(Vector3 const& xyz) const;
+  // Check if a camera pixel is valid and, if so desired, far enough
+  // from the image boundary to interpolate
+  bool valid_camera_pixel(Vector2 const& pix) const;
+
+  friend class Map2CamTile;
 }; // End class Map2CamTrans
 
+/// The reverse transform of Map2CamTrans over one tile of a mapprojected
+/// image, plus a margin for interpolation. The camera pixels are found
+/// exactly on a grid, with all the DEM points projected into the camera
+/// in one batch, and interpolated in between. A cell of the grid is
+/// instead found exactly at each of its pixels if interpolating misses
+/// the exact value at its center by more than the tolerance, or if the
+/// cell touches a DEM pixel with no data, the DEM edge, or a pixel that
+/// cannot be projected.
+///
+/// The DEM is read through the DiskImageView of the Map2CamTrans, so the
+/// decoded DEM blocks are shared with other tiles and threads through
+/// the system cache. A tile does not change once made, so each thread
+/// can make and use its own tiles of the same Map2CamTrans. A tile keeps
+/// its own copy of the transform, without the cache, so it may outlive
+/// the transform it was made from. The camera must outlive both.
+class Map2CamTile: public TransformBase<Map2CamTile> {
+public:
+  Map2CamTile(Map2CamTrans const& trans, BBox2i const& bbox,
+              int grid_spacing = 8, double tolerance = 0.01);
+
+  /// Convert a mapprojected pixel to a camera pixel. Pixels outside
+  /// box() are found exactly.
+  Vector2 reverse(Vector2 const& p) const;
+
+  /// The bounding box of the valid camera pixels of a box of
+  /// mapprojected pixels within the tile.
+  BBox2i reverse_bbox(BBox2i const& bbox) const;
+
+  /// The tile and its margin
+  BBox2i const& box() const { return m_box; }
+
+  /// The camera pixel of each pixel of box(), or the invalid pixel
+  ImageView<Vector2> const& camera_pixels() const { return m_camera_pixels; }
+
+private:
+  // The DEM pixels under a grid of the tile, or the whole DEM if
+  // these cannot be bounded
+  BBox2i grid_dem_box(std::vector<int32> const& xs, std::vector<int32> const& ys) const;
+
+  boost::shared_ptr<Map2CamTrans> m_trans; // shared by copies
+  BBox2i m_box;
+  ImageView<Vector2> m_camera_pixels;
+  ImageViewRef<PixelMask<Vector2>> m_interp_camera_pixels;
+};
+
 /// Variant of Map2CamTrans that accepts a constant elevation instead of a DEM.
 class Datum2CamTrans: public TransformBase<Map2CamTrans> {
   camera::CameraModel const* m_cam;
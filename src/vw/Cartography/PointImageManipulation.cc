@@ -33,6 +33,29 @@ Vector3 cartography::CartesianToGeodetic::operator()(Vector3 const& v) const {
   return m_datum.cartesian_to_geodetic(v);
 }
 
+void cartography::GeodeticToCartesian::operator()(Vector3 const* in, Vector3* out,
+                                                  size_t num) const {
+  // Remember the invalid points first, the conversion may be in place
+  std::vector<size_t> invalid;
+  for (size_t i = 0; i < num; i++)
+    if (boost::math::isnan(in[i][2]))
+      invalid.push_back(i);
+  m_datum.geodetic_to_cartesian(in, out, num);
+  for (size_t i = 0; i < invalid.size(); i++)
+    out[invalid[i]] = Vector3();
+}
+
+void cartography::CartesianToGeodetic::operator()(Vector3 const* in, Vector3* out,
+                                                  size_t num) const {
+  std::vector<size_t> invalid;
+  for (size_t i = 0; i < num; i++)
+    if (in[i] == Vector3())
+      invalid.push_back(i);
+  m_datum.cartesian_to_geodetic(in, out, num);
+  for (size_t i = 0; i < invalid.size(); i++)
+    out[invalid[i]] = Vector3(0, 0, std::numeric_limits<double>::quiet_NaN());
+}
+
 Vector3 cartography::GeodeticToProjection::operator()(Vector3 const& v) const {
   if (boost::math::isnan(v[2]))
     return v;
@@ -22,6 +22,8 @@
 #include <vw/Math/Vector.h>
 #include <vw/Image/PerPixelViews.h>
 #include <vw/Image/UtilityViews.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/Manipulation.h>
 #include <vw/Cartography/GeoReference.h>
 
 
@@ -67,6 +69,9 @@ namespace cartography {
     GeodeticToCartesian(Datum const& d): m_datum(d) {}
 
     Vector3 operator()(Vector3 const& v) const;
+
+    /// Convert num points at once. The input and output may alias.
+    void operator()(Vector3 const* in, Vector3* out, size_t num) const;
   };
 
   /// Functor to convert GCC x/y/z to lon/lat/alt using a datum.
@@ -76,6 +81,9 @@ namespace cartography {
     CartesianToGeodetic(Datum const& d): m_datum(d) {}
 
     Vector3 operator()(Vector3 const& v) const;
+
+    /// Convert num points at once. The input and output may alias.
+    void operator()(Vector3 const* in, Vector3* out, size_t num) const;
   };
 
   /// Functor to convert lon/lat/alt to projected pixel col/row/alt using a georef.
@@ -155,31 +163,74 @@ namespace cartography {
     return result_type(pixel_index_view(dem), dem.impl(), func);
   }
 
+  /// A per-pixel view for the datum conversion functors above. Single
+  /// pixel access calls the functor one point at a time, while
+  /// rasterizing converts whole rows with the functor's batch overload.
+  template <class ImageT, class FuncT>
+  class DatumConversionView: public ImageViewBase<DatumConversionView<ImageT, FuncT>> {
+    ImageT m_image;
+    FuncT  m_func;
+  public:
+    typedef Vector3 pixel_type;
+    typedef Vector3 result_type;
+    typedef UnaryPerPixelAccessor<typename ImageT::pixel_accessor, FuncT> pixel_accessor;
+
+    DatumConversionView(ImageT const& image, FuncT const& func):
+      m_image(image), m_func(func) {}
+
+    inline int32 cols  () const { return m_image.cols();   }
+    inline int32 rows  () const { return m_image.rows();   }
+    inline int32 planes() const { return m_image.planes(); }
+
+    inline pixel_accessor origin() const { return pixel_accessor(m_image.origin(), m_func); }
+    inline result_type operator()(int32 i, int32 j, int32 p=0) const { return m_func(m_image(i, j, p)); }
+
+    /// \cond INTERNAL
+    typedef CropView<ImageView<pixel_type>> prerasterize_type;
+    inline prerasterize_type prerasterize(BBox2i const& bbox) const {
+      ImageView<pixel_type> buf = crop(m_image, bbox);
+      if (buf.planes() == 1) {
+        for (int32 row = 0; row < buf.rows(); row++)
+          m_func(&buf(0, row), &buf(0, row), buf.cols());
+      } else {
+        for (int32 p = 0; p < buf.planes(); p++)
+          for (int32 row = 0; row < buf.rows(); row++)
+            for (int32 col = 0; col < buf.cols(); col++)
+              buf(col, row, p) = m_func(buf(col, row, p));
+      }
+      return crop(buf, -bbox.min().x(), -bbox.min().y(), cols(), rows());
+    }
+    template <class DestT> inline void rasterize(DestT const& dest, BBox2i const& bbox) const {
+      vw::rasterize(prerasterize(bbox), dest, bbox);
+    }
+    /// \endcond
+  };
+
   template <class ImageT>
-  UnaryPerPixelView<ImageT,GeodeticToCartesian>
+  DatumConversionView<ImageT, GeodeticToCartesian>
   inline geodetic_to_cartesian(ImageViewBase<ImageT> const& lla_image, Datum const& d) {
-    typedef UnaryPerPixelView<ImageT,GeodeticToCartesian> result_type;
+    typedef DatumConversionView<ImageT, GeodeticToCartesian> result_type;
     return result_type(lla_image.impl(), GeodeticToCartesian(d));
   }
 
   template <class ImageT>
-  UnaryPerPixelView<ImageT,CartesianToGeodetic>
+  DatumConversionView<ImageT, CartesianToGeodetic>
   inline cartesian_to_geodetic(ImageViewBase<ImageT> const& xyz_image, Datum const& d) {
-    typedef UnaryPerPixelView<ImageT,CartesianToGeodetic> result_type;
+    typedef DatumConversionView<ImageT, CartesianToGeodetic> result_type;
     return result_type(xyz_image.impl(), CartesianToGeodetic(d));
   }
 
   template <class ImageT>
-  UnaryPerPixelView<ImageT,GeodeticToCartesian>
+  DatumConversionView<ImageT, GeodeticToCartesian>
   inline geodetic_to_cartesian(ImageViewBase<ImageT> const& lla_image, GeoReference const& r) {
-    typedef UnaryPerPixelView<ImageT,GeodeticToCartesian> result_type;
+    typedef DatumConversionView<ImageT, GeodeticToCartesian> result_type;
     return result_type(lla_image.impl(), GeodeticToCartesian(r.datum()));
   }
 
   template <class ImageT>
-  UnaryPerPixelView<ImageT,CartesianToGeodetic>
+  DatumConversionView<ImageT, CartesianToGeodetic>
   inline cartesian_to_geodetic(ImageViewBase<ImageT> const& xyz_image, GeoReference const& r) {
-    typedef UnaryPerPixelView<ImageT,CartesianToGeodetic> result_type;
+    typedef DatumConversionView<ImageT, CartesianToGeodetic> result_type;
     return result_type(xyz_image.impl(), CartesianToGeodetic(r.datum()));
   }
 
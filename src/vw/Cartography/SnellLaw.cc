@@ -21,11 +21,24 @@
 #include <vw/Cartography/SnellLaw.h>
 
 #include <vw/Math/Vector.h>
+#include <vw/config.h>
 
+#include <algorithm>
 #include <cmath>
 
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  #include <emmintrin.h>
+#endif
+
 namespace vw {
 
+namespace {
+  // The batch version of snellLaw() splits the rays into chunks of this
+  // many and bends each chunk as separate coordinate arrays, two lanes
+  // at a time.
+  const size_t SNELL_CHUNK_SIZE = 128;
+}
+
 // Given a plane as four values a, b, c, d, with the plane being
 // a * x + b * y + c * z + d = 0, find how far off a point (x, y, z) is from the plane
 // by evaluating the above expression. Low-level helper. For bathy work,
@@ -132,4 +145,92 @@ bool snellLaw(Vector3 const& in_xyz, Vector3 const& in_dir,
   return true;
 }
 
+// The same operations as snellLaw(), in the same order
+void snellLaw(Vector3 const* in_xyz, Vector3 const* in_dir, size_t num,
+              std::vector<double> const& plane, double refraction_index,
+              Vector3 * out_xyz, Vector3 * out_dir, bool * success) {
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  const __m128d n0 = _mm_set1_pd(plane[0]), n1 = _mm_set1_pd(plane[1]);
+  const __m128d n2 = _mm_set1_pd(plane[2]), n3 = _mm_set1_pd(plane[3]);
+  const __m128d neg_n0 = _mm_set1_pd(-plane[0]), neg_n1 = _mm_set1_pd(-plane[1]);
+  const __m128d neg_n2 = _mm_set1_pd(-plane[2]);
+  const __m128d index  = _mm_set1_pd(refraction_index);
+  const __m128d zero   = _mm_setzero_pd();
+  const __m128d one    = _mm_set1_pd(1.0);
+  const __m128d two    = _mm_set1_pd(2.0);
+  const __m128d four   = _mm_set1_pd(4.0);
+  const __m128d minus_two = _mm_set1_pd(-2.0);
+  const __m128d sign   = _mm_set1_pd(-0.0);
+
+  double px[SNELL_CHUNK_SIZE], py[SNELL_CHUNK_SIZE], pz[SNELL_CHUNK_SIZE];
+  double dx[SNELL_CHUNK_SIZE], dy[SNELL_CHUNK_SIZE], dz[SNELL_CHUNK_SIZE];
+  bool ok[SNELL_CHUNK_SIZE];
+  for (size_t start = 0; start < num; start += SNELL_CHUNK_SIZE) {
+    size_t count = std::min(SNELL_CHUNK_SIZE, num - start);
+    size_t padded = (count + 1) & ~size_t(1);
+    for (size_t i = 0; i < padded; i++) {
+      size_t k = start + std::min(i, count - 1);
+      px[i] = in_xyz[k][0]; py[i] = in_xyz[k][1]; pz[i] = in_xyz[k][2];
+      dx[i] = in_dir[k][0]; dy[i] = in_dir[k][1]; dz[i] = in_dir[k][2];
+    }
+
+    for (size_t i = 0; i < padded; i += 2) {
+      __m128d x = _mm_loadu_pd(px + i), y = _mm_loadu_pd(py + i), z = _mm_loadu_pd(pz + i);
+      __m128d u = _mm_loadu_pd(dx + i), v = _mm_loadu_pd(dy + i), w = _mm_loadu_pd(dz + i);
+
+      // Where the ray meets the plane
+      __m128d cn = _mm_add_pd(_mm_add_pd(_mm_mul_pd(n0, x), _mm_mul_pd(n1, y)), _mm_mul_pd(n2, z));
+      __m128d dn = _mm_add_pd(_mm_add_pd(_mm_mul_pd(n0, u), _mm_mul_pd(n1, v)), _mm_mul_pd(n2, w));
+      __m128d valid = _mm_cmplt_pd(dn, zero);
+      __m128d alpha = _mm_div_pd(_mm_xor_pd(sign, _mm_add_pd(n3, cn)), dn);
+      _mm_storeu_pd(px + i, _mm_add_pd(x, _mm_mul_pd(alpha, u)));
+      _mm_storeu_pd(py + i, _mm_add_pd(y, _mm_mul_pd(alpha, v)));
+      _mm_storeu_pd(pz + i, _mm_add_pd(z, _mm_mul_pd(alpha, w)));
+
+      // The bent direction. See snellLaw() for the derivation.
+      __m128d dn2    = _mm_mul_pd(dn, dn);
+      __m128d cos_sq = _mm_sub_pd(one, _mm_div_pd(_mm_div_pd(_mm_sub_pd(one, dn2), index), index));
+      __m128d qa     = _mm_sub_pd(cos_sq, dn2);
+      __m128d qb     = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(minus_two, dn), cos_sq), _mm_mul_pd(two, dn));
+      __m128d qc     = _mm_sub_pd(cos_sq, one);
+      __m128d delta  = _mm_sub_pd(_mm_mul_pd(qb, qb), _mm_mul_pd(_mm_mul_pd(four, qa), qc));
+      valid = _mm_and_pd(valid, _mm_and_pd(_mm_cmpgt_pd(qa, zero), _mm_cmpge_pd(delta, zero)));
+      __m128d beta = _mm_div_pd(_mm_add_pd(_mm_xor_pd(sign, qb), _mm_sqrt_pd(delta)),
+                                _mm_mul_pd(two, qa));
+      valid = _mm_and_pd(valid, _mm_cmpge_pd(beta, zero));
+
+      __m128d ox = _mm_add_pd(neg_n0, _mm_mul_pd(beta, u));
+      __m128d oy = _mm_add_pd(neg_n1, _mm_mul_pd(beta, v));
+      __m128d oz = _mm_add_pd(neg_n2, _mm_mul_pd(beta, w));
+      __m128d len = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(ox, ox), _mm_mul_pd(oy, oy)),
+                                           _mm_mul_pd(oz, oz)));
+      _mm_storeu_pd(dx + i, _mm_div_pd(ox, len));
+      _mm_storeu_pd(dy + i, _mm_div_pd(oy, len));
+      _mm_storeu_pd(dz + i, _mm_div_pd(oz, len));
+
+      int bits = _mm_movemask_pd(valid);
+      ok[i]   = (bits & 1) != 0;
+      ok[i+1] = (bits & 2) != 0;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      success[start + i] = ok[i];
+      if (!ok[i])
+        continue;
+      out_xyz[start + i] = Vector3(px[i], py[i], pz[i]);
+      out_dir[start + i] = Vector3(dx[i], dy[i], dz[i]);
+    }
+  }
+#else
+  for (size_t i = 0; i < num; i++) {
+    Vector3 xyz, dir;
+    success[i] = snellLaw(in_xyz[i], in_dir[i], plane, refraction_index, xyz, dir);
+    if (success[i]) {
+      out_xyz[i] = xyz;
+      out_dir[i] = dir;
+    }
+  }
+#endif
+}
+
 } // namespace vw
@@ -53,6 +53,14 @@ bool snellLaw(vw::Vector3 const& in_xyz, vw::Vector3 const& in_dir,
               std::vector<double> const& plane, double refraction_index,
               vw::Vector3 & out_xyz, vw::Vector3 & out_dir);
 
+// Batch version of snellLaw() for num rays meeting the same plane, with
+// SIMD kernels. The plane is set up once for all rays. success[i] says
+// if ray i was bent. The outputs of rays that were not are left as
+// they were. The results agree with snellLaw() to the last bit.
+void snellLaw(vw::Vector3 const* in_xyz, vw::Vector3 const* in_dir, size_t num,
+              std::vector<double> const& plane, double refraction_index,
+              vw::Vector3 * out_xyz, vw::Vector3 * out_dir, bool * success);
+
 } // namespace vw
 
 #endif // __VW_CARTOGRAPHY_SNELLLAW_H__
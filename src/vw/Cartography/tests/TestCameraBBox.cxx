@@ -108,6 +108,40 @@ TEST_F( CameraBBoxTest, CameraPixelToXYZ) {
 }
 
 
+// Intersecting many pixels at once must agree with doing it one at a time.
+TEST_F( CameraBBoxTest, CameraPixelsToXYZ) {
+  GeoReference dem_georef;
+  read_georeference(dem_georef, "tinyDemAN.tif");
+  bool treat_nodata_as_zero = false;
+  double height_error_tol = 1e-3;
+
+  std::vector<Vector2> pixels;
+  for (int row = 0; row < 3744; row += 400)
+    for (int col = 0; col < 5616; col += 600)
+      pixels.push_back(Vector2(col, row));
+
+  std::vector<Vector3> xyz;
+  camera_pixels_to_dem_xyz(pinhole_camera.get(), pixels, DEM, dem_georef,
+                           treat_nodata_as_zero, xyz, height_error_tol);
+  ASSERT_EQ(pixels.size(), xyz.size());
+
+  int num_compared = 0;
+  for (size_t i = 0; i < pixels.size(); i++) {
+    bool has_intersection = false;
+    Vector3 single = camera_pixel_to_dem_xyz(pinhole_camera->camera_center(pixels[i]),
+                                             pinhole_camera->pixel_to_vector(pixels[i]),
+                                             DEM, dem_georef, treat_nodata_as_zero,
+                                             has_intersection, height_error_tol);
+    if (!has_intersection)
+      continue;
+    ASSERT_TRUE(xyz[i] != Vector3());
+    EXPECT_VECTOR_NEAR(xyz[i], single, 1e-1);
+    EXPECT_VECTOR_NEAR(pinhole_camera->point_to_pixel(xyz[i]), pixels[i], 1e-4);
+    num_compared++;
+  }
+  EXPECT_GT(num_compared, 0);
+}
+
 /* // Make sure camera_bbox works properly in a non-toy case.
 TEST( CameraBBox, CameraBBoxDEM11 ) {
   
@@ -167,3 +167,79 @@ TEST( Datum, GeodeticConversion ) {
   EXPECT_VECTOR_NEAR( datum.cartesian_to_geodetic(datum.geodetic_to_cartesian(Vector3(30,-10,173740))),
                       Vector3(30,-10,173740), 1e-6 );
 }
+
+TEST( Datum, BatchGeodeticConversion ) {
+  std::vector<std::string> names;
+  names += "WGS84", "D_MOON", "D_MARS";
+
+  for (size_t d = 0; d < names.size(); d++) {
+    Datum datum(names[d]);
+    datum.meridian_offset() = 7.5;
+
+    // Cover all longitudes, both poles, and heights from below the
+    // surface to orbit. An odd count exercises the padded last pair.
+    std::vector<Vector3> llh;
+    for (int i = 0; i < 1001; i++)
+      llh.push_back(Vector3(-540.0 + 1.079 * i, -90.0 + 0.18 * (i % 1001),
+                            -20000.0 + 997.0 * i));
+    llh.push_back(Vector3(10, 20, std::numeric_limits<double>::quiet_NaN()));
+
+    std::vector<Vector3> xyz(llh.size());
+    datum.geodetic_to_cartesian(&llh[0], &xyz[0], llh.size());
+    for (size_t i = 0; i + 1 < llh.size(); i++)
+      EXPECT_VECTOR_NEAR( xyz[i], datum.geodetic_to_cartesian(llh[i]), 1e-4 );
+    EXPECT_TRUE( std::isnan(xyz.back()[2]) );
+
+    // Add points near the center and on the axes, which take the scalar path
+    xyz.pop_back();
+    xyz.push_back(Vector3(0, 0, datum.semi_minor_axis() + 100));
+    xyz.push_back(Vector3(50, -190, -80));
+    xyz.push_back(Vector3(-datum.semi_major_axis(), 0, 0));
+
+    // On and next to the antimeridian, where the longitude must wrap
+    // the same way as in the scalar version
+    xyz.push_back(Vector3(-datum.semi_major_axis(), -0.0, 1000));
+    xyz.push_back(Vector3(-datum.semi_major_axis() - 5000, 1e-9, -2000));
+    xyz.push_back(Vector3(-datum.semi_major_axis() - 5000, -1e-9, -2000));
+
+    std::vector<Vector3> batch(xyz.size());
+    datum.cartesian_to_geodetic(&xyz[0], &batch[0], xyz.size());
+    for (size_t i = 0; i < xyz.size(); i++) {
+      Vector3 single = datum.cartesian_to_geodetic(xyz[i]);
+      EXPECT_NEAR( batch[i][0], single[0], 1e-9 );
+      EXPECT_NEAR( batch[i][1], single[1], 1e-9 );
+      EXPECT_NEAR( batch[i][2], single[2], 1e-4 );
+    }
+
+    // In place
+    datum.cartesian_to_geodetic(&xyz[0], &xyz[0], xyz.size());
+    EXPECT_VECTOR_NEAR( xyz[17], batch[17], 1e-12 );
+  }
+}
+
+TEST( Datum, BatchDatumIntersection ) {
+  Datum datum("WGS84");
+  double a = datum.semi_major_axis(), b = datum.semi_minor_axis();
+
+  // Rays from orbit, pointing roughly down, some of which miss. An odd
+  // count exercises the padded last pair.
+  std::vector<Vector3> ctrs, dirs;
+  for (int i = 0; i < 501; i++) {
+    Vector3 llh(-180.0 + 0.719 * i, -89.0 + 0.35 * i, 500000.0 + 101.0 * i);
+    Vector3 ctr = datum.geodetic_to_cartesian(llh);
+    ctrs.push_back(ctr);
+    dirs.push_back(-ctr + 0.6 * norm_2(ctr) * Vector3(sin(0.3 * i), cos(0.7 * i), sin(1.1 * i)));
+  }
+
+  std::vector<Vector3> batch(ctrs.size());
+  datum_intersection(a, b, &ctrs[0], &dirs[0], &batch[0], ctrs.size());
+  int num_miss = 0;
+  for (size_t i = 0; i < ctrs.size(); i++) {
+    Vector3 single = datum_intersection(a, b, ctrs[i], dirs[i]);
+    EXPECT_VECTOR_NEAR( batch[i], single, 1e-6 );
+    if (single == Vector3())
+      num_miss++;
+  }
+  EXPECT_GT( num_miss, 0 );
+  EXPECT_LT( num_miss, int(ctrs.size()) );
+}
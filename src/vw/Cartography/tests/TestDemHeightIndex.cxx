@@ -0,0 +1,190 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <test/Helpers.h>
+
+#include <vw/Cartography/DemHeightIndex.h>
+#include <vw/Cartography/GeoReferenceUtils.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/MaskViews.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace fs = boost::filesystem;
+
+using namespace vw;
+using namespace vw::cartography;
+using namespace vw::test;
+
+namespace {
+  const int BLOCK_SIZE = 16;
+
+  // A DEM with a hole in a corner and a NaN height
+  ImageView<PixelMask<float>> make_dem() {
+    ImageView<PixelMask<float>> dem(203, 150);
+    for (int row = 0; row < dem.rows(); row++) {
+      for (int col = 0; col < dem.cols(); col++) {
+        dem(col, row) = 100.0 * std::sin(0.05 * col) * std::cos(0.07 * row) + 0.3 * col;
+        if (col < 80 && row >= 100)
+          dem(col, row).invalidate();
+      }
+    }
+    dem(150, 20) = std::numeric_limits<float>::quiet_NaN();
+    return dem;
+  }
+
+  // The statistics over the blocks touching a box, by brute force
+  DemHeightStats block_stats(ImageView<PixelMask<float>> const& dem, BBox2i const& box) {
+    BBox2i blocks(BLOCK_SIZE * (box.min().x() / BLOCK_SIZE),
+                  BLOCK_SIZE * (box.min().y() / BLOCK_SIZE), 0, 0);
+    blocks.max() = Vector2i(BLOCK_SIZE * ((box.max().x() + BLOCK_SIZE - 1) / BLOCK_SIZE),
+                            BLOCK_SIZE * ((box.max().y() + BLOCK_SIZE - 1) / BLOCK_SIZE));
+    blocks.crop(bounding_box(dem));
+    DemHeightStats s;
+    for (int row = blocks.min().y(); row < blocks.max().y(); row++) {
+      for (int col = blocks.min().x(); col < blocks.max().x(); col++) {
+        PixelMask<float> p = dem(col, row);
+        if (!is_valid(p) || std::isnan(p.child()))
+          continue;
+        s.min_height = std::min(s.min_height, p.child());
+        s.max_height = std::max(s.max_height, p.child());
+        s.num_valid++;
+        s.height_sum += p.child();
+      }
+    }
+    return s;
+  }
+
+  void expect_same(DemHeightStats const& a, DemHeightStats const& b) {
+    EXPECT_EQ(a.num_valid, b.num_valid);
+    if (!a.has_data())
+      return;
+    EXPECT_EQ(a.min_height, b.min_height);
+    EXPECT_EQ(a.max_height, b.max_height);
+    EXPECT_NEAR(a.height_sum, b.height_sum, 1e-6 * std::abs(a.height_sum) + 1e-6);
+  }
+}
+
+TEST(DemHeightIndex, Queries) {
+  ImageView<PixelMask<float>> dem = make_dem();
+  DemHeightIndex index(dem, BLOCK_SIZE, 4);
+  ASSERT_EQ(dem.cols(), index.cols());
+  ASSERT_EQ(dem.rows(), index.rows());
+
+  expect_same(block_stats(dem, bounding_box(dem)), index.stats());
+  EXPECT_EQ(uint64(203*150 - 80*50 - 1), index.stats().num_valid);
+
+  std::srand(3);
+  for (int i = 0; i < 300; i++) {
+    int x0 = std::rand() % dem.cols(), y0 = std::rand() % dem.rows();
+    int w  = 1 + std::rand() % (dem.cols() - x0), h = 1 + std::rand() % (dem.rows() - y0);
+    BBox2i box(x0, y0, w, h);
+    DemHeightStats s = index.stats(box);
+    expect_same(block_stats(dem, box), s);
+
+    // The range bounds every valid height in the box
+    double lo = 0, hi = 0;
+    ASSERT_EQ(s.has_data(), index.height_range(box, lo, hi));
+    for (int row = box.min().y(); row < box.max().y(); row++) {
+      for (int col = box.min().x(); col < box.max().x(); col++) {
+        if (!is_valid(dem(col, row)) || std::isnan(dem(col, row).child()))
+          continue;
+        EXPECT_LE(lo, dem(col, row).child());
+        EXPECT_GE(hi, dem(col, row).child());
+      }
+    }
+  }
+
+  // The hole, and boxes off the DEM, have no data
+  EXPECT_FALSE(index.has_data(BBox2i(0, 112, 64, 32)));
+  EXPECT_TRUE (index.has_data(BBox2i(0, 100, 81, 50)));
+  EXPECT_FALSE(index.has_data(BBox2i(300, 0, 10, 10)));
+  EXPECT_FALSE(index.has_data(BBox2i()));
+}
+
+TEST(DemHeightIndex, ReadWrite) {
+  ImageView<PixelMask<float>> dem = make_dem();
+  DemHeightIndex index(dem, BLOCK_SIZE);
+
+  UnlinkName file("dem.hidx");
+  index.write(file);
+
+  DemHeightIndex index2;
+  EXPECT_FALSE(index2.read(file, "", 2*BLOCK_SIZE));
+  ASSERT_TRUE(index2.read(file));
+  EXPECT_EQ(index.cols(), index2.cols());
+  EXPECT_EQ(index.rows(), index2.rows());
+  EXPECT_EQ(index.block_size(), index2.block_size());
+  expect_same(index.stats(), index2.stats());
+  expect_same(index.stats(BBox2i(17, 33, 100, 90)), index2.stats(BBox2i(17, 33, 100, 90)));
+
+  DemHeightIndex index3;
+  EXPECT_FALSE(index3.read(file + ".missing"));
+}
+
+TEST(DemHeightIndex, LoadOrBuild) {
+  ImageView<PixelMask<float>> dem = make_dem();
+  UnlinkName dem_file("dem_index.tif"), cache_dir("dem_index_cache");
+  GdalWriteOptions opt;
+  block_write_gdal_image(dem_file, apply_mask(dem, -1000), -1000, opt);
+  std::string index_file = DemHeightIndex::cache_file(dem_file, cache_dir);
+
+  // Without a cache directory nothing is written
+  boost::shared_ptr<DemHeightIndex> index
+    = DemHeightIndex::load_or_build(dem_file, "", BLOCK_SIZE);
+  expect_same(block_stats(dem, bounding_box(dem)), index->stats());
+  EXPECT_FALSE(fs::exists(index_file));
+
+  // With one the index is kept there, and read back
+  index = DemHeightIndex::load_or_build(dem_file, cache_dir, BLOCK_SIZE);
+  ASSERT_TRUE(fs::exists(index_file));
+  DemHeightIndex index2;
+  EXPECT_TRUE(index2.read(index_file, dem_file, BLOCK_SIZE));
+  expect_same(index->stats(), index2.stats());
+  expect_same(index->stats(),
+              DemHeightIndex::load_or_build(dem_file, cache_dir, BLOCK_SIZE)->stats());
+
+  // A DEM with the same name, size and time elsewhere gets its own
+  // index file, and would find this one stale
+  UnlinkName other_dir("dem_index_other");
+  fs::create_directories(std::string(other_dir));
+  std::string other_file = (fs::path(other_dir) / "dem_index.tif").string();
+  fs::copy_file(std::string(dem_file), other_file);
+  fs::last_write_time(other_file, fs::last_write_time(std::string(dem_file)));
+  std::string other_index_file = DemHeightIndex::cache_file(other_file, cache_dir);
+  EXPECT_NE(index_file, other_index_file);
+  EXPECT_EQ(fs::path(index_file).parent_path(), fs::path(other_index_file).parent_path());
+  EXPECT_EQ(index_file, DemHeightIndex::cache_file(fs::absolute(std::string(dem_file)).string(),
+                                                   cache_dir));
+  EXPECT_FALSE(index2.read(index_file, other_file, BLOCK_SIZE));
+  EXPECT_TRUE(fs::path(other_index_file).filename().string().find("dem_index.tif.") == 0);
+
+  // Both DEMs can then be cached side by side
+  DemHeightIndex::load_or_build(other_file, cache_dir, BLOCK_SIZE);
+  EXPECT_TRUE(fs::exists(other_index_file));
+  EXPECT_TRUE(index2.read(index_file, dem_file, BLOCK_SIZE));
+  EXPECT_TRUE(index2.read(other_index_file, other_file, BLOCK_SIZE));
+
+  // A cache directory that can not be made is not an error
+  EXPECT_NO_THROW(index = DemHeightIndex::load_or_build(dem_file, dem_file + "/cache",
+                                                        BLOCK_SIZE));
+  expect_same(block_stats(dem, bounding_box(dem)), index->stats());
+}
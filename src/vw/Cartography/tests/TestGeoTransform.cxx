@@ -339,3 +339,54 @@ TEST(GeoTransform, sinusoidalTest) {
   EXPECT_NEAR(pixel2.max().x(), 924.0, eps);
   EXPECT_NEAR(pixel2.max().y(), 914.0, eps);  
 }
+
+TEST(GeoTransform, BatchForward) {
+  Matrix3x3 affine;
+  affine(0,0) =  0.001;
+  affine(1,1) = -0.001;
+  affine(2,2) = 1;
+  affine(0,2) = 172.6;
+  affine(1,2) = -43.5;
+  GeoReference ll_georef(Datum("WGS84"), affine);
+
+  affine(0,0) =  90;
+  affine(1,1) = -90;
+  affine(0,2) = 630000;
+  affine(1,2) = 5180000;
+  GeoReference utm_georef(Datum("WGS84"), affine);
+  utm_georef.set_UTM(59, false);
+
+  GeoTransform trans(ll_georef, utm_georef);
+
+  std::vector<Vector2> pixels;
+  for (int i = 0; i < 37; i++)
+    pixels.push_back(Vector2(13.5 * i, 7.25 * i + 3));
+  std::vector<Vector2> out(pixels.size());
+  trans.forward(&pixels[0], &out[0], pixels.size());
+  for (size_t i = 0; i < pixels.size(); i++)
+    EXPECT_VECTOR_NEAR(trans.forward(pixels[i]), out[i], 1e-8);
+
+  // An image of points, with a zero point that must be left alone
+  ImageView<Vector3> points(23, 17);
+  for (int row = 0; row < points.rows(); row++)
+    for (int col = 0; col < points.cols(); col++)
+      points(col, row) = Vector3(20.0 * col + 5, 30.0 * row + 5, 10.0 * col);
+  points(5, 6) = Vector3();
+
+  ImageView<Vector3> view_result
+    = reproject_point_image_view(points, ll_georef, utm_georef);
+  ImageView<Vector3> result = copy(points);
+  reproject_point_image(result, ll_georef, utm_georef);
+
+  EXPECT_VECTOR_EQ(Vector3(), result(5, 6));
+  for (int row = 0; row < points.rows(); row++) {
+    for (int col = 0; col < points.cols(); col++) {
+      EXPECT_VECTOR_NEAR(result(col, row), view_result(col, row), 1e-8);
+      if (col == 5 && row == 6)
+        continue;
+      Vector2 p = trans.forward(subvector(points(col, row), 0, 2));
+      EXPECT_VECTOR_NEAR(p, subvector(result(col, row), 0, 2), 1e-8);
+      EXPECT_EQ(points(col, row)[2], result(col, row)[2]);
+    }
+  }
+}
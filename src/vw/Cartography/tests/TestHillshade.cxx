@@ -0,0 +1,71 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <test/Helpers.h>
+
+#include <vw/Cartography/Hillshade.h>
+#include <vw/Image/Algorithms.h>
+#include <vw/Image/BlockRasterize.h>
+#include <vw/Image/ImageChannels.h>
+#include <vw/Image/ImageSurface.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/PixelMath.h>
+
+#include <cmath>
+
+using namespace vw;
+using namespace vw::cartography;
+
+TEST(Hillshade, MatchesNormals) {
+  // A DEM with a hole and an invalid pixel on the last row
+  ImageView<PixelMask<PixelGray<float>>> dem(157, 93);
+  for (int row = 0; row < dem.rows(); row++) {
+    for (int col = 0; col < dem.cols(); col++) {
+      dem(col, row) = PixelGray<float>(50.0 * std::sin(0.09 * col) * std::cos(0.13 * row)
+                                       + 0.7 * row);
+      if (col >= 40 && col < 60 && row >= 20 && row < 35)
+        dem(col, row).invalidate();
+    }
+  }
+  dem(100, dem.rows() - 1).invalidate();
+
+  float u_scale = 2.5, v_scale = -2.5;
+  Vector3f light(0.3, -0.4, 0.8);
+
+  // The shading as done before with per-pixel views
+  ImageView<PixelMask<PixelGray<uint8>>> expected
+    = channel_cast_rescale<uint8>(clamp(dot_prod(compute_normals(dem, u_scale, v_scale),
+                                                 light)));
+
+  // Small blocks, so that many block edges are crossed
+  ImageView<PixelMask<PixelGray<uint8>>> shaded
+    = block_rasterize(hillshade(dem, u_scale, v_scale, light), Vector2i(32, 16), 4);
+  ASSERT_EQ(expected.cols(), shaded.cols());
+  ASSERT_EQ(expected.rows(), shaded.rows());
+
+  for (int row = 0; row < dem.rows(); row++) {
+    for (int col = 0; col < dem.cols(); col++) {
+      ASSERT_EQ(is_valid(expected(col, row)), is_valid(shaded(col, row)))
+        << col << " " << row;
+      if (is_valid(expected(col, row)))
+        EXPECT_EQ(expected(col, row).child().v(), shaded(col, row).child().v());
+    }
+  }
+  EXPECT_FALSE(is_valid(shaded(39, 25)));
+  EXPECT_FALSE(is_valid(shaded(100, dem.rows() - 2)));
+  EXPECT_TRUE (is_valid(shaded(60, 25)));
+}
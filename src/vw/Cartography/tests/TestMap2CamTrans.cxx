@@ -0,0 +1,160 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <gtest/gtest_VW.h>
+#include <test/Helpers.h>
+
+#include <vw/Cartography/Map2CamTrans.h>
+#include <vw/Cartography/GeoReferenceUtils.h>
+#include <vw/Camera/PinholeModel.h>
+
+#include <cmath>
+
+#if defined(VW_HAVE_PKG_CAMERA) && VW_HAVE_PKG_CAMERA
+
+using namespace vw;
+using namespace vw::cartography;
+using namespace vw::camera;
+using namespace vw::test;
+
+namespace {
+  const double NODATA = -1000;
+
+  // A geographic georef on WGS84 with square pixels
+  GeoReference make_georef(double lon0, double lat0, double res) {
+    GeoReference georef;
+    georef.set_well_known_geogcs("WGS84");
+    Matrix3x3 affine;
+    affine(0,0) = res;
+    affine(1,1) = -res;
+    affine(2,2) = 1;
+    affine(0,2) = lon0;
+    affine(1,2) = lat0;
+    georef.set_transform(affine);
+    return georef;
+  }
+
+  // A small DEM with a hole of no data
+  void write_dem(std::string const& filename) {
+    ImageView<float> dem(40, 30);
+    for (int32 row = 0; row < dem.rows(); row++)
+      for (int32 col = 0; col < dem.cols(); col++)
+        dem(col, row) = 200 + 50 * std::sin(0.3 * col) * std::cos(0.2 * row);
+    for (int32 row = 5; row < 11; row++)
+      for (int32 col = 20; col < 26; col++)
+        dem(col, row) = NODATA;
+    GdalWriteOptions opt;
+    block_write_gdal_image(filename, dem, NODATA, opt);
+  }
+
+  // A camera 50 km above the DEM looking straight down, with north up
+  PinholeModel make_camera(Datum const& datum) {
+    Vector3 center = datum.geodetic_to_cartesian(Vector3(10.02, 19.985, 50000));
+    Vector3 down  = -normalize(center);
+    Vector3 east  = normalize(cross_prod(Vector3(0, 0, 1), down));
+    Vector3 south = cross_prod(down, east);
+    Matrix3x3 rotation;
+    select_col(rotation, 0) = east;
+    select_col(rotation, 1) = south;
+    select_col(rotation, 2) = down;
+    return PinholeModel(center, rotation, 6000, 6000, 500, 400);
+  }
+}
+
+// The camera pixels of a tile must match the exact ones, including at
+// the DEM edges and at the hole, and the tile must still work once the
+// transform that made it is gone.
+TEST( Map2CamTrans, TileMatchesExact ) {
+  UnlinkName dem_file("map2cam_dem.tif");
+  write_dem(dem_file);
+  GeoReference dem_georef   = make_georef(10.0,   20.0,   0.001);
+  GeoReference image_georef = make_georef(9.995,  20.005, 0.0005);
+  PinholeModel camera = make_camera(dem_georef.datum());
+
+  // The tile goes past the DEM on all sides, as the DEM starts at
+  // pixel 10 and ends at pixel 90 in columns and 70 in rows.
+  BBox2i bbox(0, 0, 96, 76);
+  boost::shared_ptr<Map2CamTile> tile;
+  boost::shared_ptr<Map2CamTrans> exact;
+  BBox2i cached_bbox;
+  {
+    Map2CamTrans trans(&camera, image_georef, dem_georef, dem_file,
+                       Vector2i(1000, 800), true);
+    tile.reset(new Map2CamTile(trans, bbox));
+    exact.reset(new Map2CamTrans(trans));
+    exact->set_use_cache(false);
+    cached_bbox = trans.reverse_bbox(bbox);
+  }
+
+  Vector2 invalid = CameraModel::invalid_pixel();
+  BBox2i const& box = tile->box();
+  EXPECT_TRUE(box.contains(bbox));
+  int num_valid = 0, num_invalid = 0;
+  BBox2 exact_bbox;
+  for (int32 y = box.min().y(); y < box.max().y(); y++) {
+    for (int32 x = box.min().x(); x < box.max().x(); x++) {
+      Vector2 p(x, y);
+      Vector2 e = exact->reverse(p);
+      Vector2 c = tile->camera_pixels()(x - box.min().x(), y - box.min().y());
+      ASSERT_EQ(e == invalid, c == invalid) << "at " << p;
+      if (e == invalid) {
+        num_invalid++;
+        continue;
+      }
+      num_valid++;
+      EXPECT_VECTOR_NEAR(c, e, 0.05);
+      if (bbox.contains(Vector2i(x, y)))
+        exact_bbox.grow(e);
+
+      // Interpolating the tile gives the same wherever it is valid
+      Vector2 r = tile->reverse(p);
+      if (r != invalid)
+        EXPECT_VECTOR_NEAR(r, e, 0.05);
+    }
+  }
+  EXPECT_LT(1000, num_valid);
+  EXPECT_LT(1000, num_invalid);
+
+  // Outside the tile the pixels are found exactly
+  for (int32 k = 0; k < 20; k++) {
+    Vector2 p(100 + 0.7 * k, 3.3 * k);
+    EXPECT_VECTOR_NEAR(tile->reverse(p), exact->reverse(p), 1e-8);
+  }
+
+  // The camera box of the tile, as found from the tile and by the
+  // transform with its cache
+  BBox2i tile_bbox = tile->reverse_bbox(bbox);
+  exact_bbox = grow_bbox_to_int(exact_bbox);
+  EXPECT_VECTOR_NEAR(tile_bbox.min(), exact_bbox.min(), 1);
+  EXPECT_VECTOR_NEAR(tile_bbox.max(), exact_bbox.max(), 1);
+  EXPECT_EQ(cached_bbox, tile_bbox);
+
+  // With a height index, tiles off the DEM are made without reading it,
+  // with the same result
+  Map2CamTrans indexed(*exact);
+  indexed.set_height_index(DemHeightIndex::load_or_build(dem_file));
+  BBox2i boxes[3] = {bbox, BBox2i(200, 0, 50, 50), BBox2i(52, 22, 8, 8)};
+  for (int k = 0; k < 3; k++) {
+    Map2CamTile plain(*exact, boxes[k]), skipped(indexed, boxes[k]);
+    ASSERT_EQ(plain.box(), skipped.box());
+    for (int32 row = 0; row < plain.box().height(); row++)
+      for (int32 col = 0; col < plain.box().width(); col++)
+        ASSERT_EQ(plain.camera_pixels()(col, row), skipped.camera_pixels()(col, row));
+  }
+}
+
+#endif
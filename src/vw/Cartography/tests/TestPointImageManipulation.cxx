@@ -82,3 +82,31 @@ TEST( PointImageManipulation, CartesianGeodetic ) {
   EXPECT_SEQ_NEAR( cartesian, result_moon,  1e-6 );
   EXPECT_SEQ_NEAR( cartesian, result_earth, 1e-6 );
 }
+
+TEST( PointImageManipulation, GeodeticCartesianRows ) {
+  // Rasterizing the views converts whole rows at a time. It must agree
+  // with per-pixel access, which goes one point at a time.
+  ImageView<Vector3> geodetic(35,5);
+  for (int32 row = 0; row < geodetic.rows(); row++)
+    for (int32 col = 0; col < geodetic.cols(); col++)
+      geodetic(col,row) = Vector3(-175 + 10*col, -80 + 40*row, 100*col - 500);
+  geodetic(3,2) = Vector3(0, 0, std::numeric_limits<double>::quiet_NaN());
+
+  Datum earth("WGS84");
+  ImageView<Vector3> xyz = geodetic_to_cartesian(geodetic, earth);
+  ImageView<Vector3> llh = cartesian_to_geodetic(xyz, earth);
+  for (int32 row = 0; row < geodetic.rows(); row++) {
+    for (int32 col = 0; col < geodetic.cols(); col++) {
+      if (col == 3 && row == 2)
+        continue;
+      EXPECT_VECTOR_NEAR( xyz(col,row), geodetic_to_cartesian(geodetic, earth)(col,row), 1e-4 );
+      EXPECT_VECTOR_NEAR( llh(col,row), cartesian_to_geodetic(xyz, earth)(col,row), 1e-4 );
+    }
+  }
+  EXPECT_EQ( Vector3(), xyz(3,2) );
+  EXPECT_TRUE( boost::math::isnan(llh(3,2).z()) );
+
+  // A crop goes through prerasterize with an offset bounding box
+  ImageView<Vector3> part = crop(geodetic_to_cartesian(geodetic, earth), 5, 1, 20, 3);
+  EXPECT_VECTOR_NEAR( part(4,2), xyz(9,3), 1e-9 );
+}
@@ -24,9 +24,12 @@
 #ifndef __VW_CORE_THREADPOOL_H__
 #define __VW_CORE_THREADPOOL_H__
 
+#include <algorithm>
 #include <vector>
 #include <list>
 
+#include <boost/noncopyable.hpp>
+
 #include <vw/Core/Condition.h>
 #include <vw/Core/Settings.h>
 #include <vw/Core/Thread.h>
@@ -185,6 +188,37 @@ namespace vw {
     virtual boost::shared_ptr<Task> get_next_task();
   };
 
+
+  /// A task that calls func(begin, end) for one piece of an index range.
+  template <class FuncT>
+  class RangeTask: public Task, private boost::noncopyable {
+    FuncT const& m_func;
+    size_t m_begin, m_end;
+  public:
+    RangeTask(FuncT const& func, size_t begin, size_t end):
+      m_func(func), m_begin(begin), m_end(end) {}
+    void operator()() { m_func(m_begin, m_end); }
+  };
+
+  /// Split [0, count) into one contiguous piece per thread, call
+  /// func(begin, end) on each piece and wait for all of them. Runs in
+  /// the calling thread if there is only one piece.
+  template <class FuncT>
+  void process_in_parallel(size_t count, int num_threads, FuncT const& func) {
+    size_t num_tasks = std::min(count, size_t(std::max(num_threads, 1)));
+    if (num_tasks <= 1) {
+      func(0, count);
+      return;
+    }
+    FifoWorkQueue queue(num_tasks);
+    for (size_t i = 0; i < num_tasks; i++) {
+      boost::shared_ptr<Task> task(new RangeTask<FuncT>(func, count * i / num_tasks,
+                                                        count * (i+1) / num_tasks));
+      queue.add_task(task);
+    }
+    queue.join_all();
+  }
+
 } // namespace vw
 
 #endif // __VW_CORE_THREADPOOL_H__
@@ -0,0 +1,106 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <vw/Image/AntiAliasing.h>
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  #include <emmintrin.h>
+#endif
+
+void vw::subsample_aa_2x2_row( double* sums, int32* counts, PixelMask<float32> const* row0,
+                               PixelMask<float32> const* row1, int32 num ) {
+  int32 x = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  // Two blocks at a time, one in each lane. The invalid pixels are set
+  // to zero, and adding that leaves the sums as skipping them does, as
+  // the sums start from positive zero and so are never negative zero.
+  const __m128  zero_ps = _mm_setzero_ps();
+  const __m128d zero_pd = _mm_setzero_pd();
+  for( ; x+2 <= num; x+=2 ) {
+    float32 const* rows[2] = { reinterpret_cast<float32 const*>( row0+2*x ),
+                               reinterpret_cast<float32 const*>( row1+2*x ) };
+    __m128d sum   = zero_pd;
+    int     valid = 0;
+    for( int r=0; r<2; ++r ) {
+      __m128 a      = _mm_loadu_ps( rows[r]   );
+      __m128 b      = _mm_loadu_ps( rows[r]+4 );
+      __m128 mask   = _mm_cmpneq_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE(3,1,3,1) ), zero_ps );
+      __m128 values = _mm_and_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE(2,0,2,0) ), mask );
+      valid |= _mm_movemask_ps( mask ) << (4*r);
+      __m128d first  = _mm_cvtps_pd( values );                        // The first block
+      __m128d second = _mm_cvtps_pd( _mm_movehl_ps( values, values ) ); // The second one
+      sum = _mm_add_pd( sum, _mm_add_pd( _mm_add_pd( zero_pd, _mm_unpacklo_pd( first, second ) ),
+                                         _mm_unpackhi_pd( first, second ) ) );
+    }
+    _mm_storeu_pd( sums+x, sum );
+    counts[x]   = ((valid>>0)&1) + ((valid>>1)&1) + ((valid>>4)&1) + ((valid>>5)&1);
+    counts[x+1] = ((valid>>2)&1) + ((valid>>3)&1) + ((valid>>6)&1) + ((valid>>7)&1);
+  }
+#endif
+  subsample_aa_2x2_row<float32, double>( sums+x, counts+x, row0+2*x, row1+2*x, num-x );
+}
+
+void vw::box_subsample_2x2_row( PixelRGBA<uint8>* dst, PixelRGBA<uint8> const* row0,
+                                PixelRGBA<uint8> const* row1, int32 num ) {
+  int32 x = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  // Four output pixels at a time. The generic version's sums are exact
+  // and truncated, so the channels are summed in 16 bits and shifted.
+  const __m128i zero = _mm_setzero_si128();
+  for( ; x+4 <= num; x+=4 ) {
+    __m128i sums[2] = { zero, zero };
+    PixelRGBA<uint8> const* rows[2] = { row0+2*x, row1+2*x };
+    for( int r=0; r<2; ++r ) {
+      __m128 a = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( rows[r]   ) ) );
+      __m128 b = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( rows[r]+4 ) ) );
+      __m128i left  = _mm_castps_si128( _mm_shuffle_ps( a, b, _MM_SHUFFLE(2,0,2,0) ) );
+      __m128i right = _mm_castps_si128( _mm_shuffle_ps( a, b, _MM_SHUFFLE(3,1,3,1) ) );
+      sums[0] = _mm_add_epi16( sums[0], _mm_add_epi16( _mm_unpacklo_epi8( left, zero ), _mm_unpacklo_epi8( right, zero ) ) );
+      sums[1] = _mm_add_epi16( sums[1], _mm_add_epi16( _mm_unpackhi_epi8( left, zero ), _mm_unpackhi_epi8( right, zero ) ) );
+    }
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( dst+x ),
+                      _mm_packus_epi16( _mm_srli_epi16( sums[0], 2 ), _mm_srli_epi16( sums[1], 2 ) ) );
+  }
+#endif
+  box_subsample_2x2_row<PixelRGBA<uint8> >( dst+x, row0+2*x, row1+2*x, num-x );
+}
+
+void vw::box_subsample_2x2_row( PixelRGBA<float32>* dst, PixelRGBA<float32> const* row0,
+                                PixelRGBA<float32> const* row1, int32 num ) {
+  int32 x = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  // One output pixel at a time, with two channels in each register.
+  // The sum is in double precision and starts from zero, in the same
+  // order as in the generic version, and is rounded to float.
+  const __m128d quarter = _mm_set1_pd( 0.25 );
+  for( ; x<num; ++x ) {
+    float32 const* pixels[4] = { reinterpret_cast<float32 const*>( row0+2*x ),
+                                 reinterpret_cast<float32 const*>( row0+2*x+1 ),
+                                 reinterpret_cast<float32 const*>( row1+2*x ),
+                                 reinterpret_cast<float32 const*>( row1+2*x+1 ) };
+    __m128d lo = _mm_setzero_pd(), hi = _mm_setzero_pd();
+    for( int k=0; k<4; ++k ) {
+      __m128 p = _mm_loadu_ps( pixels[k] );
+      lo = _mm_add_pd( lo, _mm_mul_pd( quarter, _mm_cvtps_pd( p ) ) );
+      hi = _mm_add_pd( hi, _mm_mul_pd( quarter, _mm_cvtps_pd( _mm_movehl_ps( p, p ) ) ) );
+    }
+    _mm_storeu_ps( reinterpret_cast<float32*>( dst+x ), _mm_movelh_ps( _mm_cvtpd_ps( lo ), _mm_cvtpd_ps( hi ) ) );
+  }
+#endif
+  box_subsample_2x2_row<PixelRGBA<float32> >( dst+x, row0+2*x, row1+2*x, num-x );
+}
@@ -20,6 +20,7 @@
 #define __VW_IMAGE_ANTIALIASING_H__
 
 #include <vw/Image/ImageView.h>
+#include <vw/Image/PixelMask.h>
 #include <vw/Image/Transform.h>
 #include <vw/Image/PerPixelAccessorViews.h>
 #include <boost/foreach.hpp>
@@ -300,6 +301,150 @@ namespace vw {
                         int32(.5+(input.impl().rows()*factor)) );
   }
 
+  // Sum the valid pixels of the blocks of two by two pixels along two
+  // rows for subsample_aa(), each row of a block and then the rows, and
+  // count them. All the blocks must be in the rows.
+  template <class ChildT, class SumT>
+  void subsample_aa_2x2_row( SumT* sums, int32* counts, PixelMask<ChildT> const* row0,
+                             PixelMask<ChildT> const* row1, int32 num ) {
+    PixelMask<ChildT> const* rows[2] = { row0, row1 };
+    for ( int32 x = 0; x < num; x++ ) {
+      set_all( sums[x], 0 );
+      counts[x] = 0;
+      for ( int32 r = 0; r < 2; r++ ) {
+        SumT sum;
+        set_all( sum, 0 );
+        for ( int32 c = 2 * x; c < 2 * x + 2; c++ ) {
+          if ( is_valid( rows[r][c] ) ) {
+            sum += channel_cast<double>( rows[r][c].child() );
+            counts[x]++;
+          }
+        }
+        sums[x] += sum;
+      }
+    }
+  }
+
+  // A vectorized version for float pixels, which gives the same sums
+  void subsample_aa_2x2_row( double* sums, int32* counts, PixelMask<float32> const* row0,
+                             PixelMask<float32> const* row1, int32 num );
+
+  // Subsample a masked image by an integer factor, averaging the valid
+  // pixels of each factor x factor block in double precision. This is
+  // what resample_aa() computes with a factor of 1/factor, without
+  // summing the blocks that are not kept. The blocks at the right and
+  // bottom edges of the input may be partial. The output pixels with
+  // no valid pixels in their block are invalid.
+  template <class ChildT>
+  ImageView<PixelMask<typename CompoundChannelCast<ChildT, double>::type> >
+  subsample_aa( ImageView<PixelMask<ChildT> > const& input, int32 factor, int32 cols, int32 rows ) {
+    typedef typename CompoundChannelCast<ChildT, double>::type sum_type;
+    VW_ASSERT( factor >= 1 && cols >= 0 && rows >= 0 &&
+               ( cols == 0 || (cols-1) * factor < input.cols() ) &&
+               ( rows == 0 || (rows-1) * factor < input.rows() ),
+               ArgumentErr() << "subsample_aa: The output does not fit the input." );
+
+    ImageView<PixelMask<sum_type> > output( cols, rows );
+    std::vector<sum_type> sums( cols );
+    std::vector<int32>    counts( cols );
+    for ( int32 y = 0; y < rows; y++ ) {
+      // Whole blocks of two by two pixels are summed in one go
+      int32 begin = 0;
+      if ( factor == 2 && 2 * y + 2 <= input.rows() ) {
+        begin = std::min( cols, input.cols() / 2 );
+        if ( begin > 0 )
+          subsample_aa_2x2_row( &sums[0], &counts[0], &input( 0, 2 * y ),
+                                &input( 0, 2 * y + 1 ), begin );
+      }
+      for ( int32 x = begin; x < cols; x++ ) {
+        set_all( sums[x], 0 );
+        counts[x] = 0;
+      }
+      // Sum each row of the blocks, then the rows, like resample_aa()
+      int32 row_end = std::min( (y+1) * factor, input.rows() );
+      for ( int32 r = y * factor; r < row_end && begin < cols; r++ ) {
+        for ( int32 x = begin; x < cols; x++ ) {
+          sum_type sum;
+          set_all( sum, 0 );
+          int32 col_end = std::min( (x+1) * factor, input.cols() );
+          for ( int32 c = x * factor; c < col_end; c++ ) {
+            PixelMask<ChildT> const& pixel = input( c, r );
+            if ( is_valid( pixel ) ) {
+              sum += channel_cast<double>( pixel.child() );
+              counts[x]++;
+            }
+          }
+          sums[x] += sum;
+        }
+      }
+      for ( int32 x = 0; x < cols; x++ )
+        if ( counts[x] > 0 )
+          output( x, y ) = PixelMask<sum_type>( sum_type( sums[x] / counts[x] ) );
+    }
+    return output;
+  }
+
+  // Average the blocks of two by two pixels along two rows for
+  // box_subsample(), with its arithmetic.
+  template <class PixelT>
+  void box_subsample_2x2_row( PixelT* dst, PixelT const* row0, PixelT const* row1, int32 num ) {
+    typedef typename CompoundChannelType<PixelT>::type channel_type;
+    typedef typename ProductType<PixelT, double>::type sum_type;
+    for ( int32 x = 0; x < num; x++ ) {
+      sum_type sum = sum_type();
+      validate( sum );
+      sum += 0.25 * row0[2*x];
+      sum += 0.25 * row0[2*x+1];
+      sum += 0.25 * row1[2*x];
+      sum += 0.25 * row1[2*x+1];
+      dst[x] = channel_cast_clamp_if_int<channel_type>( sum );
+    }
+  }
+
+  // Vectorized versions for the usual tile pixel types, which give the
+  // same results as the generic version.
+  void box_subsample_2x2_row( PixelRGBA<uint8  >* dst, PixelRGBA<uint8  > const* row0,
+                              PixelRGBA<uint8  > const* row1, int32 num );
+  void box_subsample_2x2_row( PixelRGBA<float32>* dst, PixelRGBA<float32> const* row0,
+                              PixelRGBA<float32> const* row1, int32 num );
+
+  // Subsample an image by averaging its blocks of scale.x() by
+  // scale.y() pixels, row by row, in double precision. The blocks at
+  // the right and bottom edges may be partial, and are filled by
+  // repeating the last column and row of the image. The results are
+  // those of subsampling a separable box filter of the image, without
+  // evaluating it through views pixel by pixel.
+  template <class PixelT>
+  ImageView<PixelT> box_subsample( ImageView<PixelT> const& image, Vector2i const& scale ) {
+    typedef typename CompoundChannelType<PixelT>::type channel_type;
+    typedef typename ProductType<PixelT, double>::type sum_type;
+    VW_ASSERT( scale.x() >= 1 && scale.y() >= 1,
+               ArgumentErr() << "box_subsample: The scale must be positive." );
+
+    ImageView<PixelT> result( (image.cols() + scale.x() - 1) / scale.x(),
+                              (image.rows() + scale.y() - 1) / scale.y() );
+    double weight = (1.0 / scale.x()) * (1.0 / scale.y());
+    for ( int32 y = 0; y < result.rows(); y++ ) {
+      // Whole blocks of two by two pixels are averaged in one go
+      int32 begin = 0;
+      if ( scale == Vector2i( 2, 2 ) && 2 * y + 2 <= image.rows() ) {
+        begin = image.cols() / 2;
+        box_subsample_2x2_row( &result( 0, y ), &image( 0, 2*y ), &image( 0, 2*y+1 ), begin );
+      }
+      for ( int32 x = begin; x < result.cols(); x++ ) {
+        sum_type sum = sum_type();
+        validate( sum );
+        for ( int32 j = 0; j < scale.y(); j++ ) {
+          PixelT const* row = &image( 0, std::min( y * scale.y() + j, image.rows() - 1 ) );
+          for ( int32 i = 0; i < scale.x(); i++ )
+            sum += weight * row[ std::min( x * scale.x() + i, image.cols() - 1 ) ];
+        }
+        result( x, y ) = channel_cast_clamp_if_int<channel_type>( sum );
+      }
+    }
+    return result;
+  }
+
 }
 
 #endif//__VW_IMAGE_ANTIALIASING_H__
@@ -20,6 +20,8 @@
 
 #include <vw/Image/Colormap.h>
 
+#include <cmath>
+
 #include <boost/tokenizer.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/numeric/conversion/cast.hpp>
@@ -1352,28 +1354,63 @@ void parseColorStyle(std::string const& colormap_style,
 }
 
 // Colormap function
+Colormap::Colormap(std::map<float, Vector3u> const& map):
+  m_bin_start(NUM_BINS, 0) {
+  for (auto const& it: map) {
+    m_values.push_back(it.first);
+    m_colors.push_back(it.second);
+  }
+
+  // The start of a bin is the last entry below it, or the first entry.
+  // As the entries are increasing, a single pass finds them all.
+  uint32 k = 0;
+  for (int b = 0; b < NUM_BINS; b++) {
+    double bin_min = double(b) / (NUM_BINS - 1);
+    while (k + 1 < m_values.size() && m_values[k + 1] < bin_min)
+      k++;
+    m_bin_start[b] = k;
+  }
+}
+
 PixelMask<PixelRGB<uint8>> Colormap::operator()(PixelMask<PixelGray<float>> const& pix) const {
-  if (is_transparent(pix))
+  if (is_transparent(pix) || m_values.empty())
     return PixelMask<PixelRGB<uint8>>(); // Skip transparent pixels
   
   float val = compound_select_channel<const float&>(pix, 0);
+
+  // A value that is not a number gets the last color, as it did with a
+  // search of the map. It must not be used to find a bin.
+  if (std::isnan(val)) {
+    Vector3u const& color = m_colors.back();
+    return PixelRGB<uint8>(color[0], color[1], color[2]);
+  }
   if (val > 1.0) val = 1.0;
   if (val < 0.0) val = 0.0;
-  
-  // Get locations on sparse colormap that bound this pixel value
-  map_type::const_iterator bot = m_colormap.upper_bound(val); bot--;
-  map_type::const_iterator top = m_colormap.upper_bound(val);
 
+  // Below the first colormap value, use the first color
+  if (val < m_values[0])
+    return PixelRGB<uint8>(m_colors[0][0], m_colors[0][1], m_colors[0][2]);
+
+  // Find the last colormap value not above this pixel value, starting
+  // from the one below its bin. Stepping back covers the rare value
+  // that float rounding put in the next bin.
+  size_t bot = m_bin_start[int(val * (NUM_BINS - 1))];
+  while (bot > 0 && m_values[bot] > val)
+    bot--;
+  while (bot + 1 < m_values.size() && m_values[bot + 1] <= val)
+    bot++;
+  
   // If this is above the top colormap value, use the max val.
-  if (top == m_colormap.end())
-    return PixelRGB<uint8>(bot->second[0], bot->second[1], bot->second[2]); 
+  if (bot + 1 == m_values.size())
+    return PixelRGB<uint8>(m_colors[bot][0], m_colors[bot][1], m_colors[bot][2]);
   
   // Otherwise determine a proportional color between the bracketing
   // colormap values. Do the operations in double precision, then
   // round.
-  double ratio = (val - bot->first)/(top->first - bot->first);
-  Vector3u output = bot->second + 
-    round(ratio * (Vector3(top->second) - Vector3(bot->second)));
+  size_t top = bot + 1;
+  double ratio = (val - m_values[bot])/(m_values[top] - m_values[bot]);
+  Vector3u output = m_colors[bot] + 
+    round(ratio * (Vector3(m_colors[top]) - Vector3(m_colors[bot])));
   
   return PixelRGB<uint8>(output[0], output[1], output[2]);
 }
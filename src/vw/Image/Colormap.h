@@ -29,6 +29,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace vw {
 // These are specialized definitions for colormap functionality
@@ -48,13 +49,21 @@ void parseColorStyle(std::string const& colormap_style,
 void populate_lut_map(lut_type const& lut,
                       std::map<float, Vector3u> & lut_map);
 
-// Functor which colorizes every pixel
+// Functor which colorizes every pixel. Values are clamped to [0, 1]
+// and the color is interpolated linearly between the two bracketing
+// entries of the colormap. To avoid searching the colormap for every
+// pixel, [0, 1] is split into NUM_BINS bins, and each bin records the
+// entry just below it, so that finding the bracketing entries takes
+// only a step or two.
 class Colormap: public ReturnFixedType<PixelMask<PixelRGB<uint8>>> {
-  typedef std::map<float, Vector3u> map_type;
-  map_type m_colormap;
+  static const int NUM_BINS = 4096;
+
+  std::vector<float>    m_values; // increasing
+  std::vector<Vector3u> m_colors;
+  std::vector<uint32>   m_bin_start;
 
 public:
-  Colormap(std::map<float, Vector3u> const& map) : m_colormap(map) {}
+  Colormap(std::map<float, Vector3u> const& map);
 
   PixelMask<PixelRGB<uint8>> operator()(PixelMask<PixelGray<float>> const& pix) const;
 };
@@ -0,0 +1,106 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <vw/Image/OccupancyMap.h>
+
+namespace vw {
+
+  void OccupancyMap::initialize( Vector2i const& size, int32 cell_size ) {
+    VW_ASSERT( cell_size > 0, ArgumentErr() << "OccupancyMap: The cell size must be positive." );
+    m_cell_size = cell_size;
+    m_size      = size;
+    m_cells_x   = (size.x() + cell_size - 1) / cell_size;
+    m_cells_y   = (size.y() + cell_size - 1) / cell_size;
+    m_data_bboxes.assign( size_t(m_cells_x) * m_cells_y, BBox2i() );
+    m_opaque.assign( size_t(m_cells_x) * m_cells_y, 0 );
+  }
+
+  void OccupancyMap::make_tables() {
+    size_t stride = m_cells_x + 1;
+    m_data_table.assign( stride * (m_cells_y + 1), 0 );
+    m_opaque_table.assign( stride * (m_cells_y + 1), 0 );
+    for( int32 y = 0; y < m_cells_y; ++y ) {
+      for( int32 x = 0; x < m_cells_x; ++x ) {
+        size_t cell = size_t(y) * m_cells_x + x;
+        size_t i    = (y + 1) * stride + (x + 1);
+        m_data_table[i]   = m_data_table[i-1] + m_data_table[i-stride] - m_data_table[i-stride-1]
+                          + ( m_data_bboxes[cell].empty() ? 0 : 1 );
+        m_opaque_table[i] = m_opaque_table[i-1] + m_opaque_table[i-stride] - m_opaque_table[i-stride-1]
+                          + m_opaque[cell];
+      }
+    }
+  }
+
+  BBox2i OccupancyMap::cell_bbox( size_t index ) const {
+    BBox2i bbox( int32(index % m_cells_x) * m_cell_size, int32(index / m_cells_x) * m_cell_size,
+                 m_cell_size, m_cell_size );
+    bbox.crop( BBox2i( Vector2i(), m_size ) );
+    return bbox;
+  }
+
+  BBox2i OccupancyMap::cell_range( BBox2i const& bbox ) const {
+    BBox2i image_bbox = bbox;
+    image_bbox.crop( BBox2i( Vector2i(), m_size ) );
+    if( m_cell_size == 0 || image_bbox.empty() )
+      return BBox2i( 0, 0, 0, 0 );
+    return BBox2i( image_bbox.min() / m_cell_size,
+                   ( image_bbox.max() + Vector2i( m_cell_size - 1, m_cell_size - 1 ) ) / m_cell_size );
+  }
+
+  int64 OccupancyMap::count( std::vector<int32> const& table, BBox2i const& cells ) const {
+    size_t stride = m_cells_x + 1;
+    return int64( table[cells.max().y() * stride + cells.max().x()] )
+         - table[cells.min().y() * stride + cells.max().x()]
+         - table[cells.max().y() * stride + cells.min().x()]
+         + table[cells.min().y() * stride + cells.min().x()];
+  }
+
+  bool OccupancyMap::is_empty( BBox2i const& bbox ) const {
+    BBox2i cells = cell_range( bbox );
+    return cells.empty() || count( m_data_table, cells ) == 0;
+  }
+
+  bool OccupancyMap::is_opaque( BBox2i const& bbox ) const {
+    if( bbox.empty() || ! BBox2i( Vector2i(), m_size ).contains( bbox ) )
+      return false;
+    BBox2i cells = cell_range( bbox );
+    return count( m_opaque_table, cells ) == int64( cells.width() ) * cells.height();
+  }
+
+  bool OccupancyMap::data_bbox( BBox2i const& bbox, BBox2i & result ) const {
+    // Every cell that the region overlaps must be inside it
+    if( m_cell_size == 0 || bbox.min().x() % m_cell_size != 0 || bbox.min().y() % m_cell_size != 0 )
+      return false;
+    if( ( bbox.max().x() % m_cell_size != 0 && bbox.max().x() < m_size.x() ) ||
+        ( bbox.max().y() % m_cell_size != 0 && bbox.max().y() < m_size.y() ) )
+      return false;
+
+    result = BBox2i();
+    BBox2i cells = cell_range( bbox );
+    if( cells.empty() || count( m_data_table, cells ) == 0 )
+      return true;
+    for( int32 y = cells.min().y(); y < cells.max().y(); ++y )
+      for( int32 x = cells.min().x(); x < cells.max().x(); ++x ) {
+        BBox2i const& cell = m_data_bboxes[ size_t(y) * m_cells_x + x ];
+        if( ! cell.empty() )
+          result.grow( cell );
+      }
+    return true;
+  }
+
+} // namespace vw
@@ -0,0 +1,114 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+/// \file OccupancyMap.h
+///
+/// Which parts of an image hold data, found once so that regions can
+/// be checked without rasterizing them.
+///
+#ifndef __VW_IMAGE_OCCUPANCYMAP_H__
+#define __VW_IMAGE_OCCUPANCYMAP_H__
+
+#include <vw/Math/BBox.h>
+#include <vw/Core/Settings.h>
+#include <vw/Core/ThreadPool.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/ImageOpacity.h>
+#include <vw/Image/Manipulation.h>
+
+#include <vector>
+
+namespace vw {
+
+  /// Which pixels of an image hold data, and which are opaque, in
+  /// square cells of a fixed size. The image is rasterized once, a cell
+  /// at a time, and then any region is checked in constant time, as
+  /// the counts of the cells with data and of the opaque ones are kept
+  /// as summed area tables. As for nonzero_data_bounding_box(), the
+  /// pixels with data are the nonzero ones. The bounding box of the
+  /// data in each cell is also kept, to find that of cell-aligned
+  /// regions without scanning them.
+  class OccupancyMap {
+  public:
+
+    /// An empty map, which has no cells.
+    OccupancyMap() : m_cell_size(0), m_cells_x(0), m_cells_y(0) {}
+
+    /// Find the cells of an image with data, on num_threads threads (0
+    /// for the default). The image must be thread-safe to rasterize.
+    template <class ImageT>
+    OccupancyMap( ImageViewBase<ImageT> const& image, int32 cell_size, int32 num_threads = 0 ) {
+      initialize( Vector2i( image.impl().cols(), image.impl().rows() ), cell_size );
+      if( num_threads <= 0 )
+        num_threads = vw_settings().default_num_threads();
+      ImageT const& source = image.impl();
+      process_in_parallel( m_data_bboxes.size(), num_threads, [&]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; ++i ) {
+          BBox2i bbox = cell_bbox( i );
+          ImageView<typename ImageT::pixel_type> cell = crop( source, bbox );
+          BBox2i data_bbox = nonzero_data_bounding_box( cell );
+          if( ! data_bbox.empty() )
+            m_data_bboxes[i] = data_bbox + bbox.min();
+          m_opaque[i] = vw::is_opaque( cell );
+        }
+      } );
+      make_tables();
+    }
+
+    /// The side of the cells, or 0 for an empty map.
+    int32 cell_size() const { return m_cell_size; }
+
+    /// Whether a region has no data. There is none outside the image.
+    /// This is found from the cells that the region overlaps, so it is
+    /// only exact for regions aligned with them. Otherwise a region is
+    /// not found empty if it shares a cell with data.
+    bool is_empty( BBox2i const& bbox ) const;
+
+    /// Whether all the pixels of a region are in the image and opaque.
+    /// As for is_empty(), this is only exact for aligned regions, and
+    /// otherwise a region is not found opaque if it shares a cell with
+    /// pixels that are not.
+    bool is_opaque( BBox2i const& bbox ) const;
+
+    /// Find the bounding box of the data in a region, which is empty if
+    /// it has none. Returns false if that can not be found from the
+    /// cells, which is when the region is not aligned with them.
+    bool data_bbox( BBox2i const& bbox, BBox2i & result ) const;
+
+  private:
+    void   initialize( Vector2i const& size, int32 cell_size );
+    void   make_tables();
+    BBox2i cell_bbox( size_t index ) const;
+
+    // The cells that a region overlaps, which is empty if it is not in
+    // the image
+    BBox2i cell_range( BBox2i const& bbox ) const;
+
+    // The number of cells counted by a summed area table in a range
+    int64  count( std::vector<int32> const& table, BBox2i const& cells ) const;
+
+    int32    m_cell_size, m_cells_x, m_cells_y;
+    Vector2i m_size;
+    std::vector<BBox2i> m_data_bboxes; ///< Empty for cells with no data
+    std::vector<uint8>  m_opaque;
+    std::vector<int32>  m_data_table, m_opaque_table; ///< Summed area tables, with a row and column of zeros before
+  };
+
+} // namespace vw
+
+#endif // __VW_IMAGE_OCCUPANCYMAP_H__
@@ -18,6 +18,10 @@
 
 #include <gtest/gtest_VW.h>
 #include <vw/Image/AntiAliasing.h>
+#include <vw/Image/ImageChannels.h>
+#include <vw/Image/Filter.h>
+#include <vw/Image/Manipulation.h>
+#include <vw/Image/PixelTypes.h>
 
 using namespace vw;
 
@@ -57,3 +61,86 @@ TEST( AntiAliasing, VerifySameOperation ) {
     }
   }
 }
+
+TEST( AntiAliasing, SubsampleMatchesResample ) {
+
+  // Blocks with valid, invalid and partly valid pixels, and partial
+  // blocks at the edges for some of the factors
+  typedef PixelMask<float> PT;
+  ImageView<PT> input( 37, 29 );
+  for ( int32 y = 0; y < input.rows(); y++ ) {
+    for ( int32 x = 0; x < input.cols(); x++ ) {
+      input(x,y) = PT( float( (x * 7 + y * 13) % 17 ) / 3 );
+      if ( (x * y) % 5 == 1 || (x > 20 && y > 20) )
+        invalidate( input(x,y) );
+    }
+  }
+
+  for ( int32 factor = 2; factor <= 5; factor++ ) {
+    ImageView<PixelMask<double> > expected = resample_aa( channel_cast<double>( input ), 1.0/factor );
+    ImageView<PixelMask<double> > result
+      = subsample_aa( input, factor, expected.cols(), expected.rows() );
+    ASSERT_EQ( expected.cols(), result.cols() );
+    ASSERT_EQ( expected.rows(), result.rows() );
+    for ( int32 y = 0; y < result.rows(); y++ ) {
+      for ( int32 x = 0; x < result.cols(); x++ ) {
+        EXPECT_EQ( is_valid( expected(x,y) ), is_valid( result(x,y) ) ) << factor << ": " << x << "," << y;
+        if ( is_valid( expected(x,y) ) )
+          EXPECT_NEAR( expected(x,y).child(), result(x,y).child(), 1e-12 );
+      }
+    }
+
+    // The vectorized version for float pixels sums as the generic one
+    ImageView<PixelMask<double> > input_double = channel_cast<double>( input );
+    ImageView<PixelMask<double> > generic
+      = subsample_aa( input_double, factor, expected.cols(), expected.rows() );
+    for ( int32 y = 0; y < result.rows(); y++ ) {
+      for ( int32 x = 0; x < result.cols(); x++ ) {
+        EXPECT_EQ( is_valid( generic(x,y) ), is_valid( result(x,y) ) ) << factor << ": " << x << "," << y;
+        EXPECT_EQ( generic(x,y).child(), result(x,y).child() ) << factor << ": " << x << "," << y;
+      }
+    }
+  }
+}
+
+namespace {
+  // What box_subsample() computed with views
+  template <class PixelT>
+  ImageView<PixelT> box_filter_subsample( ImageView<PixelT> const& image, Vector2i const& scale ) {
+    std::vector<double> xkernel( scale.x(), 1.0 / scale.x() ), ykernel( scale.y(), 1.0 / scale.y() );
+    ImageView<PixelT> result;
+    rasterize( subsample( separable_convolution_filter( image, xkernel, ykernel, scale.x()-1, scale.y()-1 ),
+                          scale.x(), scale.y() ), result );
+    return result;
+  }
+
+  template <class PixelT>
+  void check_box_subsample( int32 cols, int32 rows ) {
+    typedef typename PixelChannelType<PixelT>::type channel_type;
+    ImageView<PixelT> image( cols, rows );
+    for ( int32 y = 0; y < rows; y++ )
+      for ( int32 x = 0; x < cols; x++ )
+        for ( int32 c = 0; c < PixelNumChannels<PixelT>::value; c++ )
+          image(x,y)[c] = channel_type( ( (x * 37 + y * 101 + c * 59) % 256 ) * ChannelRange<channel_type>::max() / 255.0 );
+
+    Vector2i scales[] = { Vector2i(2,2), Vector2i(3,2), Vector2i(1,4), Vector2i(4,4) };
+    for ( int32 i = 0; i < 4; i++ ) {
+      ImageView<PixelT> expected = box_filter_subsample( image, scales[i] );
+      ImageView<PixelT> result   = box_subsample( image, scales[i] );
+      ASSERT_EQ( expected.cols(), result.cols() );
+      ASSERT_EQ( expected.rows(), result.rows() );
+      for ( int32 y = 0; y < result.rows(); y++ )
+        for ( int32 x = 0; x < result.cols(); x++ )
+          for ( int32 c = 0; c < PixelNumChannels<PixelT>::value; c++ )
+            EXPECT_EQ( expected(x,y)[c], result(x,y)[c] ) << scales[i] << ": " << x << "," << y;
+    }
+  }
+}
+
+TEST( AntiAliasing, BoxSubsampleMatchesFilter ) {
+  // Sizes with pixels left after the vectorized loops, and partial blocks
+  check_box_subsample<PixelRGBA<uint8  > >( 37, 29 );
+  check_box_subsample<PixelRGBA<float32> >( 37, 29 );
+  check_box_subsample<PixelGrayA<float32> >( 37, 29 );
+  check_box_subsample<PixelRGBA<uint8  > >( 64, 16 );
+}
@@ -0,0 +1,100 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <test/Helpers.h>
+#include <vw/Image/Colormap.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace vw;
+
+namespace {
+  typedef std::map<float, Vector3u> map_type;
+
+  // The color of a value found by searching the map, with values below
+  // the first entry getting the first color
+  PixelRGB<uint8> map_color(map_type const& map, float val) {
+    if (val > 1.0) val = 1.0;
+    if (val < 0.0) val = 0.0;
+    map_type::const_iterator top = map.upper_bound(val);
+    if (top == map.begin())
+      return PixelRGB<uint8>(top->second[0], top->second[1], top->second[2]);
+    map_type::const_iterator bot = top; bot--;
+    if (top == map.end())
+      return PixelRGB<uint8>(bot->second[0], bot->second[1], bot->second[2]);
+    double ratio = (val - bot->first)/(top->first - bot->first);
+    Vector3u output = bot->second +
+      round(ratio * (Vector3(top->second) - Vector3(bot->second)));
+    return PixelRGB<uint8>(output[0], output[1], output[2]);
+  }
+}
+
+TEST( Colormap, MatchesMapSearch ) {
+  // Entries that do not start at 0 or end at 1, some of them right at
+  // the edges of the 4096 bins, where float rounding can put a value
+  // in the next bin
+  map_type map;
+  map[0.1f] = Vector3u(0, 0, 255);
+  map[float(1000.0/4095)] = Vector3u(0, 255, 255);
+  map[float(1001.0/4095)] = Vector3u(255, 255, 0);
+  map[0.5f] = Vector3u(255, 0, 0);
+  map[0.9f] = Vector3u(255, 255, 255);
+  Colormap colormap(map);
+
+  std::vector<float> values;
+  values.push_back(-1);
+  values.push_back(0);
+  values.push_back(0.05f);
+  values.push_back(0.95f);
+  values.push_back(1);
+  values.push_back(3);
+  values.push_back(std::numeric_limits<float>::infinity());
+  values.push_back(-std::numeric_limits<float>::infinity());
+  for (int b = 990; b < 1010; b++) {
+    float edge = float(double(b) / 4095);
+    values.push_back(std::nextafter(edge, -1.0f));
+    values.push_back(edge);
+    values.push_back(std::nextafter(edge, 2.0f));
+  }
+  for (int k = 0; k <= 1000; k++)
+    values.push_back(k / 1000.0f);
+
+  for (size_t k = 0; k < values.size(); k++) {
+    PixelMask<PixelRGB<uint8>> color
+      = colormap(PixelMask<PixelGray<float>>(values[k]));
+    ASSERT_TRUE(is_valid(color)) << "value " << values[k];
+    EXPECT_EQ(map_color(map, values[k]), color.child()) << "value " << values[k];
+  }
+
+  // Below the first entry is the first color, and above the last one
+  // is the last color
+  EXPECT_EQ(PixelRGB<uint8>(0, 0, 255),
+            colormap(PixelMask<PixelGray<float>>(0.01f)).child());
+  EXPECT_EQ(PixelRGB<uint8>(255, 255, 255),
+            colormap(PixelMask<PixelGray<float>>(0.99f)).child());
+
+  // Not a number gets the last color, and invalid pixels no color
+  float nan = std::numeric_limits<float>::quiet_NaN();
+  PixelMask<PixelRGB<uint8>> color = colormap(PixelMask<PixelGray<float>>(nan));
+  EXPECT_TRUE(is_valid(color));
+  EXPECT_EQ(PixelRGB<uint8>(255, 255, 255), color.child());
+  PixelMask<PixelGray<float>> invalid(0.5f);
+  invalid.invalidate();
+  EXPECT_FALSE(is_valid(colormap(invalid)));
+}
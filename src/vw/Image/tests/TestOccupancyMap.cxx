@@ -0,0 +1,83 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <test/Helpers.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/ImageOpacity.h>
+#include <vw/Image/Manipulation.h>
+#include <vw/Image/OccupancyMap.h>
+#include <vw/Image/PixelTypes.h>
+
+using namespace vw;
+
+TEST( OccupancyMap, MatchesRasterizing ) {
+  // Transparent around a disk, with a partly transparent band
+  ImageView<PixelRGBA<uint8> > image(101, 77);
+  for ( int32 row = 0; row < image.rows(); ++row )
+    for ( int32 col = 0; col < image.cols(); ++col ) {
+      if ( (col-40)*(col-40) + (row-30)*(row-30) < 25*25 )
+        image(col,row) = PixelRGBA<uint8>(200, 100, 50, 255);
+      else if ( row == 70 && col > 80 )
+        image(col,row) = PixelRGBA<uint8>(20, 10, 5, 40);
+    }
+
+  OccupancyMap map( image, 8, 2 );
+  EXPECT_EQ( 8, map.cell_size() );
+
+  for ( int32 y0 = -8; y0 < 80; y0 += 4 )
+    for ( int32 x0 = -8; x0 < 104; x0 += 4 )
+      for ( int32 size = 4; size <= 40; size *= 2 ) {
+        BBox2i bbox( x0, y0, size, size );
+        BBox2i inside = bbox;
+        inside.crop( bounding_box(image) );
+
+        BBox2i expected;
+        bool empty = true, opaque = (inside == bbox);
+        if ( ! inside.empty() ) {
+          expected = nonzero_data_bounding_box( crop( image, inside ) );
+          empty = (expected.width() == 0 || expected.height() == 0);
+          expected += inside.min();
+          opaque = opaque && is_opaque( crop( image, inside ) );
+        }
+        // Exact for regions aligned with the cells, and otherwise only
+        // found empty or opaque when they are
+        bool aligned = (x0 % 8 == 0 && y0 % 8 == 0 && size % 8 == 0);
+        if ( aligned ) {
+          EXPECT_EQ( empty,  map.is_empty ( bbox ) ) << bbox;
+          EXPECT_EQ( opaque, map.is_opaque( bbox ) ) << bbox;
+        }
+        if ( map.is_empty( bbox ) )
+          EXPECT_TRUE( empty ) << bbox;
+        if ( map.is_opaque( bbox ) )
+          EXPECT_TRUE( opaque ) << bbox;
+
+        BBox2i result;
+        if ( map.data_bbox( bbox, result ) ) {
+          EXPECT_TRUE( aligned ) << bbox;
+          EXPECT_EQ( empty, result.empty() ) << bbox;
+          if ( ! empty )
+            EXPECT_EQ( expected, result ) << bbox;
+        }
+        else {
+          EXPECT_FALSE( aligned ) << bbox;
+        }
+      }
+
+  OccupancyMap none;
+  EXPECT_EQ( 0, none.cell_size() );
+}
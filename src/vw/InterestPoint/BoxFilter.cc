@@ -0,0 +1,106 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <vw/Core/Cache.h>
+#include <vw/Core/Settings.h>
+#include <vw/InterestPoint/BoxFilter.h>
+#include <vw/Image/BlockProcessor.h>
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  #include <emmintrin.h>
+#endif
+
+namespace vw {
+namespace ip {
+
+namespace {
+
+  /// Evaluates a box filter over a block of rows.
+  struct BoxFilterRows {
+    ImageView<float> const& m_integral;
+    BoxFilter        const& m_filter;
+    ImageView<float>      & m_output;
+    int m_begin, m_end; // Valid columns
+
+    BoxFilterRows(ImageView<float> const& integral, BoxFilter const& filter,
+                  ImageView<float>& output, int begin, int end):
+      m_integral(integral), m_filter(filter), m_output(output),
+      m_begin(begin), m_end(end) {}
+
+    void operator()(BBox2i const& bbox) const {
+      const int n = m_end - m_begin;
+      for (int y = bbox.min().y(); y < bbox.max().y(); y++) {
+        float* out = &m_output(m_begin, y);
+        for (size_t b = 0; b < m_filter.size(); b++) {
+          SumBox const& box = m_filter[b];
+          // Same corners and order of operations as apply_box_filter_at_point()
+          int x0 = m_begin + box.start[0], y0 = y + box.start[1];
+          float const* a = &m_integral(x0,                 y0);
+          float const* c = &m_integral(x0 + box.size[0],   y0);
+          float const* d = &m_integral(x0,                 y0 + box.size[1]);
+          float const* e = &m_integral(x0 + box.size[0],   y0 + box.size[1]);
+          int i = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+          __m128 weight = _mm_set1_ps(box.weight);
+          for (; i + 4 <= n; i += 4) {
+            __m128 sum = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(c + i));
+            sum = _mm_sub_ps(sum, _mm_loadu_ps(d + i));
+            sum = _mm_add_ps(sum, _mm_loadu_ps(e + i));
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i),
+                                              _mm_mul_ps(weight, sum)));
+          }
+#endif
+          for (; i < n; i++) {
+            float sum = a[i] - c[i] - d[i] + e[i];
+            out[i] += box.weight * sum;
+          }
+        }
+      }
+    }
+  };
+
+} // end anonymous namespace
+
+ImageView<float> rasterize_box_filter(ImageView<float> const& integral,
+                                      BoxFilter const& box,
+                                      int num_threads) {
+  ImageView<float> output(std::max(integral.cols() - 1, 0),
+                          std::max(integral.rows() - 1, 0));
+
+  // Same border as BoxFilterView
+  int max_filter_size = 0;
+  for (size_t b = 0; b < box.size(); b++)
+    max_filter_size = std::max(max_filter_size,
+                               std::max(box[b].size[0], box[b].size[1]));
+  int buffer = max_filter_size >> 1;
+  int begin = buffer, end     = integral.cols() - buffer - 1;
+  int top   = buffer, bottom  = integral.rows() - buffer - 1;
+  if (begin >= end || top >= bottom)
+    return output;
+
+  // Small images are not worth the threads
+  if (int64(output.cols()) * int64(output.rows()) < 512*512)
+    num_threads = 1;
+
+  BoxFilterRows func(integral, box, output, begin, end);
+  image_block::BlockProcessor<BoxFilterRows>
+    processor(func, Vector2i(output.cols(), 64), num_threads);
+  processor(BBox2i(0, top, output.cols(), bottom - top));
+  return output;
+}
+
+}} // end namespace vw::ip
@@ -131,6 +131,26 @@ namespace ip {
     return BoxFilterView<ImageT>( integral.impl(), box );
   }
 
+  // Rasterized Box Filter
+  // _____________________________________________________
+
+  /// Render box_filter() into memory. The generic version just rasterizes
+  /// the view.
+  template <class ImageT>
+  ImageView<typename ImageT::pixel_type>
+  rasterize_box_filter( ImageViewBase<ImageT> const& integral,
+                        BoxFilter const& box ) {
+    return box_filter( integral, box );
+  }
+
+  /// Float integral images are filtered a row at a time instead of through
+  /// the per-pixel accessor. Each box adds its weighted sum to the whole
+  /// output row using SSE, and blocks of rows are split across threads. The
+  /// result matches BoxFilterView, including the zero border.
+  ImageView<float> rasterize_box_filter( ImageView<float> const& integral,
+                                         BoxFilter const& box,
+                                         int num_threads = 0 );
+
 }}
 
 #endif//__VW_INTERESTPOINT_BOX_FILTER_H__
@@ -21,6 +21,14 @@
 ///
 #include <vw/InterestPoint/Descriptor.h>
 
+#include <algorithm>
+#include <cmath>
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  #include <emmintrin.h>
+  #include <smmintrin.h> // SSE4.1
+#endif
+
 namespace vw {
 namespace ip {
 
@@ -28,4 +36,284 @@ namespace ip {
   const uint32 SGradDescriptorGenerator::box_size[5] = {2,4,8,10,14};
   const uint32 SGradDescriptorGenerator::box_half[5] = {1,2,4,5,7};
 
+namespace {
+
+  /// Bilinear interpolation with zero edge extension, as done by
+  /// get_support() through an interpolated, edge extended view.
+  inline float sample_bilinear(float const* data, int cols, int rows, float x, float y) {
+    float fx = std::floor(x), fy = std::floor(y);
+    int   ix = int(fx), iy = int(fy);
+    float wx = x - fx, wy = y - fy;
+    float p00 = 0, p10 = 0, p01 = 0, p11 = 0;
+    bool  x0_in = (ix >= 0 && ix < cols),   x1_in = (ix + 1 >= 0 && ix + 1 < cols);
+    bool  y0_in = (iy >= 0 && iy < rows),   y1_in = (iy + 1 >= 0 && iy + 1 < rows);
+    if (y0_in) {
+      float const* row = data + size_t(iy) * cols;
+      if (x0_in) p00 = row[ix];
+      if (x1_in) p10 = row[ix + 1];
+    }
+    if (y1_in) {
+      float const* row = data + size_t(iy + 1) * cols;
+      if (x0_in) p01 = row[ix];
+      if (x1_in) p11 = row[ix + 1];
+    }
+    return (p00 * (1 - wx) + p10 * wx) * (1 - wy) + (p01 * (1 - wx) + p11 * wx) * wy;
+  }
+
+  /// Number of patches described together by the SGrad kernel, one per lane.
+  const int SGRAD_LANES = 4;
+
+} // end anonymous namespace
+
+void sample_supports(ImageView<float> const& image,
+                     std::vector<InterestPoint const*> const& points,
+                     int support_size, Matrix<float>& patches) {
+
+  const int num_pixels = support_size * support_size;
+  patches.set_size(points.size(), num_pixels);
+  if (points.empty())
+    return;
+
+  // The sampling grid, as offsets from the patch center. It is the same for
+  // every point, up to the rotation and scale applied below.
+  const float half_size = float(support_size - 1) / 2.0f;
+  std::vector<float> grid_u(num_pixels), grid_v(num_pixels);
+  for (int j = 0; j < support_size; j++) {
+    for (int i = 0; i < support_size; i++) {
+      grid_u[j * support_size + i] = i - half_size;
+      grid_v[j * support_size + i] = j - half_size;
+    }
+  }
+
+  float const* data = image.data();
+  const int cols = image.cols(), rows = image.rows();
+
+  for (size_t k = 0; k < points.size(); k++) {
+    InterestPoint const& pt = *points[k];
+
+    // Grid offset (u,v) samples the image at the point plus (u,v) rotated
+    // by the point orientation and scaled by its scale. This is the reverse
+    // of the transform in get_support().
+    const float c = std::cos(pt.orientation), s = std::sin(pt.orientation);
+    const float axx = pt.scale * c, axy = -pt.scale * s;
+    const float ayx = pt.scale * s, ayy =  pt.scale * c;
+    const float x0 = pt.x, y0 = pt.y;
+
+    float* out = &patches(k, 0);
+    int idx = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+    const __m128 v_axx = _mm_set1_ps(axx), v_axy = _mm_set1_ps(axy);
+    const __m128 v_ayx = _mm_set1_ps(ayx), v_ayy = _mm_set1_ps(ayy);
+    const __m128 v_x0  = _mm_set1_ps(x0),  v_y0  = _mm_set1_ps(y0);
+    const __m128 one   = _mm_set1_ps(1.0f);
+    for (; idx + 4 <= num_pixels; idx += 4) {
+      __m128 u  = _mm_loadu_ps(&grid_u[idx]), v = _mm_loadu_ps(&grid_v[idx]);
+      __m128 sx = _mm_add_ps(v_x0, _mm_add_ps(_mm_mul_ps(v_axx, u), _mm_mul_ps(v_axy, v)));
+      __m128 sy = _mm_add_ps(v_y0, _mm_add_ps(_mm_mul_ps(v_ayx, u), _mm_mul_ps(v_ayy, v)));
+      __m128 fx = _mm_floor_ps(sx), fy = _mm_floor_ps(sy);
+
+      // Fall back to the edge-aware code unless all four 2x2
+      // neighborhoods are inside the image.
+      float fxs[4], fys[4];
+      _mm_storeu_ps(fxs, fx);
+      _mm_storeu_ps(fys, fy);
+      float min_x = std::min(std::min(fxs[0], fxs[1]), std::min(fxs[2], fxs[3]));
+      float max_x = std::max(std::max(fxs[0], fxs[1]), std::max(fxs[2], fxs[3]));
+      float min_y = std::min(std::min(fys[0], fys[1]), std::min(fys[2], fys[3]));
+      float max_y = std::max(std::max(fys[0], fys[1]), std::max(fys[2], fys[3]));
+      if (min_x < 0 || min_y < 0 || max_x > cols - 2 || max_y > rows - 2) {
+        float sxs[4], sys[4];
+        _mm_storeu_ps(sxs, sx);
+        _mm_storeu_ps(sys, sy);
+        for (int l = 0; l < 4; l++)
+          out[idx + l] = sample_bilinear(data, cols, rows, sxs[l], sys[l]);
+        continue;
+      }
+
+      // Gather the four neighbors of each sample, then blend in registers
+      float p00[4], p10[4], p01[4], p11[4];
+      for (int l = 0; l < 4; l++) {
+        float const* top = data + size_t(fys[l]) * cols + int(fxs[l]);
+        p00[l] = top[0];
+        p10[l] = top[1];
+        p01[l] = top[cols];
+        p11[l] = top[cols + 1];
+      }
+      __m128 wx = _mm_sub_ps(sx, fx), wy = _mm_sub_ps(sy, fy);
+      __m128 w1x = _mm_sub_ps(one, wx), w1y = _mm_sub_ps(one, wy);
+      __m128 top = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(p00), w1x),
+                              _mm_mul_ps(_mm_loadu_ps(p10), wx));
+      __m128 bot = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(p01), w1x),
+                              _mm_mul_ps(_mm_loadu_ps(p11), wx));
+      _mm_storeu_ps(out + idx, _mm_add_ps(_mm_mul_ps(top, w1y), _mm_mul_ps(bot, wy)));
+    }
+#endif
+    for (; idx < num_pixels; idx++) {
+      float sx = x0 + axx * grid_u[idx] + axy * grid_v[idx];
+      float sy = y0 + ayx * grid_u[idx] + ayy * grid_v[idx];
+      out[idx] = sample_bilinear(data, cols, rows, sx, sy);
+    }
+  }
+}
+
+// The patches are processed four at a time, with the integral images of the
+// four interleaved so that every box sum of the descriptor is computed for
+// all of them at once.
+void sgrad_descriptors(Matrix<float> const& patches, Matrix<float>& descriptors) {
+
+  const int support_size = 42, descriptor_size = 180;
+  VW_ASSERT(patches.cols() == size_t(support_size * support_size),
+            ArgumentErr() << "sgrad_descriptors: Expected " << support_size << "x"
+            << support_size << " patches.\n");
+
+  const size_t num_patches = patches.rows();
+  descriptors.set_size(num_patches, descriptor_size);
+
+  // Integral images, (support_size+1)^2 pixels by SGRAD_LANES lanes
+  const int ii_cols = support_size + 1;
+  std::vector<float> integral(ii_cols * ii_cols * SGRAD_LANES, 0.0f);
+  std::vector<float> values(descriptor_size * SGRAD_LANES);
+  std::vector<float> zeros(support_size * support_size, 0.0f);
+
+  for (size_t first = 0; first < num_patches; first += SGRAD_LANES) {
+    size_t count = std::min(size_t(SGRAD_LANES), num_patches - first);
+    float const* patch[SGRAD_LANES];
+    for (int l = 0; l < SGRAD_LANES; l++)
+      patch[l] = (size_t(l) < count) ? &patches(first + l, 0) : &zeros[0];
+
+    // 1. Integral images. The first row and column stay zero.
+    for (int y = 1; y < ii_cols; y++) {
+      float* ii_row   = &integral[(y * ii_cols) * SGRAD_LANES];
+      float* ii_above = ii_row - ii_cols * SGRAD_LANES;
+      int    src      = (y - 1) * support_size;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+      __m128 row_sum = _mm_setzero_ps();
+      for (int x = 1; x < ii_cols; x++, src++) {
+        row_sum = _mm_add_ps(row_sum, _mm_set_ps(patch[3][src], patch[2][src],
+                                                 patch[1][src], patch[0][src]));
+        _mm_storeu_ps(ii_row + x * SGRAD_LANES,
+                      _mm_add_ps(_mm_loadu_ps(ii_above + x * SGRAD_LANES), row_sum));
+      }
+#else
+      float row_sum[SGRAD_LANES] = {0};
+      for (int x = 1; x < ii_cols; x++, src++) {
+        for (int l = 0; l < SGRAD_LANES; l++) {
+          row_sum[l] += patch[l][src];
+          ii_row[x * SGRAD_LANES + l] = ii_above[x * SGRAD_LANES + l] + row_sum[l];
+        }
+      }
+#endif
+    }
+
+    // 2. Box sums over the quadrants of each cell, at each scale, in the
+    //    same order as SGradDescriptorGenerator::compute_descriptor().
+    float* fill = &values[0];
+    for (int s = 0; s < 5; s++) {
+      const int   strt = SGradDescriptorGenerator::box_strt[s];
+      const int   size = SGradDescriptorGenerator::box_size[s];
+      const int   h    = SGradDescriptorGenerator::box_half[s];
+      const float inv_bh2 = 1 / float(h * h);
+      for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+          const int x = strt + i * size, y = strt + j * size;
+          // The integral image at the 3x3 corners of the four quadrants
+          float const* corner[3][3];
+          for (int cy = 0; cy < 3; cy++)
+            for (int cx = 0; cx < 3; cx++)
+              corner[cy][cx] = &integral[((y + cy * h) * ii_cols + x + cx * h) * SGRAD_LANES];
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+          __m128 c[3][3];
+          for (int cy = 0; cy < 3; cy++)
+            for (int cx = 0; cx < 3; cx++)
+              c[cy][cx] = _mm_loadu_ps(corner[cy][cx]);
+          // Top left, top right, bottom left and bottom right quadrants
+          __m128 q0 = _mm_sub_ps(_mm_add_ps(c[0][0], c[1][1]), _mm_add_ps(c[1][0], c[0][1]));
+          __m128 q1 = _mm_sub_ps(_mm_add_ps(c[0][1], c[1][2]), _mm_add_ps(c[1][1], c[0][2]));
+          __m128 q2 = _mm_sub_ps(_mm_add_ps(c[1][0], c[2][1]), _mm_add_ps(c[2][0], c[1][1]));
+          __m128 q3 = _mm_sub_ps(_mm_add_ps(c[1][1], c[2][2]), _mm_add_ps(c[2][1], c[1][2]));
+          __m128 w  = _mm_set1_ps(inv_bh2);
+          _mm_storeu_ps(fill,     _mm_mul_ps(_mm_sub_ps(q0, q2), w));
+          _mm_storeu_ps(fill + 4, _mm_mul_ps(_mm_sub_ps(q1, q3), w));
+          _mm_storeu_ps(fill + 8, _mm_mul_ps(_mm_sub_ps(q0, q1), w));
+          _mm_storeu_ps(fill + 12, _mm_mul_ps(_mm_sub_ps(q2, q3), w));
+#else
+          for (int l = 0; l < SGRAD_LANES; l++) {
+            float q0 = corner[0][0][l] + corner[1][1][l] - corner[1][0][l] - corner[0][1][l];
+            float q1 = corner[0][1][l] + corner[1][2][l] - corner[1][1][l] - corner[0][2][l];
+            float q2 = corner[1][0][l] + corner[2][1][l] - corner[2][0][l] - corner[1][1][l];
+            float q3 = corner[1][1][l] + corner[2][2][l] - corner[2][1][l] - corner[1][2][l];
+            fill[l]      = (q0 - q2) * inv_bh2;
+            fill[l + 4]  = (q1 - q3) * inv_bh2;
+            fill[l + 8]  = (q0 - q1) * inv_bh2;
+            fill[l + 12] = (q2 - q3) * inv_bh2;
+          }
+#endif
+          fill += 4 * SGRAD_LANES;
+        } // end j
+      } // end i
+    } // end s
+
+    // 3. Normalize and write out each patch's descriptor
+    for (size_t l = 0; l < count; l++) {
+      float sqr_length = 0;
+      for (int d = 0; d < descriptor_size; d++)
+        sqr_length += values[d * SGRAD_LANES + l] * values[d * SGRAD_LANES + l];
+      float sqr_length_inv = 1.0f / std::sqrt(sqr_length);
+      if (!std::isnormal(sqr_length_inv))
+        sqr_length_inv = 0.0f;
+      float* out = &descriptors(first + l, 0);
+      for (int d = 0; d < descriptor_size; d++)
+        out[d] = values[d * SGRAD_LANES + l] * sqr_length_inv;
+    }
+  }
+}
+
+void pca_sift_descriptors(Matrix<float> const& patches, Matrix<float> const& pca_basis,
+                          Vector<float> const& pca_avg, Matrix<float>& descriptors) {
+
+  const size_t num_patches = patches.rows(), dim = patches.cols(), k = pca_basis.cols();
+  VW_ASSERT(pca_basis.rows() == dim && pca_avg.size() == dim,
+            ArgumentErr() << "pca_sift_descriptors: The PCA basis does not match the "
+            << "support size.\n");
+
+  // Normalize each patch to unit length and subtract the average
+  Matrix<float> centered(num_patches, dim);
+  for (size_t r = 0; r < num_patches; r++) {
+    float const* patch = &patches(r, 0);
+    double norm_const = 0;
+    for (size_t d = 0; d < dim; d++)
+      norm_const += patch[d] * patch[d];
+    norm_const = sqrt(norm_const);
+    float* out = &centered(r, 0);
+    for (size_t d = 0; d < dim; d++)
+      out[d] = patch[d] / norm_const - pca_avg[d];
+  }
+
+  // descriptors = centered * pca_basis. Four patches are done at a time so
+  // that each row of the basis is loaded once for all four.
+  descriptors = Matrix<float>(num_patches, k);
+  if (k == 0)
+    return;
+  const size_t ROWS = 4;
+  for (size_t r0 = 0; r0 < num_patches; r0 += ROWS) {
+    size_t nr = std::min(ROWS, num_patches - r0);
+    for (size_t d = 0; d < dim; d++) {
+      float const* basis_row = &pca_basis(d, 0);
+      for (size_t r = r0; r < r0 + nr; r++) {
+        const float a = centered(r, d);
+        float* out = &descriptors(r, 0);
+        size_t c = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+        const __m128 va = _mm_set1_ps(a);
+        for (; c + 4 <= k; c += 4)
+          _mm_storeu_ps(out + c, _mm_add_ps(_mm_loadu_ps(out + c),
+                                            _mm_mul_ps(va, _mm_loadu_ps(basis_row + c))));
+#endif
+        for (; c < k; c++)
+          out[c] += a * basis_row[c];
+      }
+    }
+  }
+}
+
 }} // namespace vw::ip
@@ -92,6 +92,36 @@ struct PatchDescriptorGenerator: public DescriptorGeneratorBase<PatchDescriptorG
   int descriptor_size() { return 41*41; }
 };
 
+// Batched description. Rather than resampling each support region through a
+// transformed view and describing it alone, the support regions of a batch
+// of points are resampled into the rows of one matrix and described together.
+
+/// Resample the support regions of the given points into the rows of
+/// patches. Each row holds the support_size x support_size region of
+/// get_support(), scaled and rotated about the point, with bilinear
+/// interpolation and zero edge extension. A sampling grid is computed once
+/// and reused for every point, and four pixels are interpolated at a time.
+void sample_supports(ImageView<float> const& image,
+                     std::vector<InterestPoint const*> const& points,
+                     int support_size, Matrix<float>& patches);
+
+/// The SGrad descriptors of 42x42 support regions, one per row, as
+/// computed by SGradDescriptorGenerator::compute_descriptor(). Four
+/// regions are described at once, one per SIMD lane.
+void sgrad_descriptors(Matrix<float> const& patches, Matrix<float>& descriptors);
+
+/// The PCA-SIFT descriptors of support regions, one per row, as computed
+/// by PCASIFTDescriptorGenerator::compute_descriptor(). The projection
+/// onto the basis is one matrix product for the whole batch.
+void pca_sift_descriptors(Matrix<float> const& patches, Matrix<float> const& pca_basis,
+                          Vector<float> const& pca_avg, Matrix<float>& descriptors);
+
+/// Describe the points in [start, end) a batch at a time, with the
+/// generator's describe_batch() method.
+template <class DescriptorT, class ViewT, class IterT>
+void describe_in_batches(DescriptorT& generator, ImageViewBase<ViewT> const& image,
+                         IterT start, IterT end);
+
 // An implementation of PCA-SIFT
 struct PCASIFTDescriptorGenerator: public DescriptorGeneratorBase<PCASIFTDescriptorGenerator> {
 
@@ -108,10 +138,23 @@ struct PCASIFTDescriptorGenerator: public DescriptorGeneratorBase<PCASIFTDescrip
     read_vector(pca_avg, avg_filename);
   }
 
+  /// Describe the points in batches, see describe_in_batches().
+  template <class ViewT>
+  void operator()(ImageViewBase<ViewT> const& image, InterestPointList& points) {
+    describe_in_batches(*this, image, points.begin(), points.end());
+  }
+  template <class ViewT, class IterT>
+  void operator()(ImageViewBase<ViewT> const& image, IterT start, IterT end) {
+    describe_in_batches(*this, image, start, end);
+  }
+
   template <class ViewT, class IterT>
   void compute_descriptor(ImageViewBase<ViewT> const& support,
                           IterT first, IterT last) const;
 
+  /// Compute the descriptors of a batch of support regions, one per row.
+  void describe_batch(Matrix<float> const& patches, Matrix<float>& descriptors) const;
+
   int descriptor_size() { return pca_basis.cols(); }
 };
 
@@ -123,10 +166,23 @@ struct SGradDescriptorGenerator: public DescriptorGeneratorBase<SGradDescriptorG
   static const uint32 box_size[5];
   static const uint32 box_half[5];
 
+  /// Describe the points in batches, see describe_in_batches().
+  template <class ViewT>
+  void operator()(ImageViewBase<ViewT> const& image, InterestPointList& points) {
+    describe_in_batches(*this, image, points.begin(), points.end());
+  }
+  template <class ViewT, class IterT>
+  void operator()(ImageViewBase<ViewT> const& image, IterT start, IterT end) {
+    describe_in_batches(*this, image, start, end);
+  }
+
   template <class ViewT, class IterT>
   void compute_descriptor(ImageViewBase<ViewT> const& support,
               IterT first, IterT last) const;
 
+  /// Compute the descriptors of a batch of support regions, one per row.
+  void describe_batch(Matrix<float> const& patches, Matrix<float>& descriptors) const;
+
   int support_size   () { return  42; }
   int descriptor_size() { return 180; }
 };
@@ -353,6 +409,46 @@ void describe_interest_points(ImageViewBase<ViewT> const& view, DescriptorT& des
   return;
 }
 
+// Batched description
+
+template <class DescriptorT, class ViewT, class IterT>
+void describe_in_batches(DescriptorT& generator, ImageViewBase<ViewT> const& image,
+                         IterT start, IterT end) {
+  Timer total("\tTotal elapsed time", DebugMessage, "interest_point");
+
+  const size_t BATCH_SIZE = 256; // Bounds the memory used for the patches
+  ImageView<float> source = pixel_cast<PixelGray<float>>(channel_cast_rescale<float>(image.impl()));
+  std::vector<InterestPoint const*> batch;
+  std::vector<IterT> batch_iters;
+  Matrix<float> patches, descriptors;
+  for (IterT it = start; it != end; ) {
+    batch.clear();
+    batch_iters.clear();
+    for (; it != end && batch.size() < BATCH_SIZE; ++it) {
+      batch.push_back(&(*it));
+      batch_iters.push_back(it);
+    }
+    sample_supports(source, batch, generator.support_size(), patches);
+    generator.describe_batch(patches, descriptors);
+    for (size_t k = 0; k < batch_iters.size(); k++) {
+      typename InterestPoint::descriptor_type& descriptor = batch_iters[k]->descriptor;
+      descriptor.set_size(descriptors.cols());
+      std::copy(&descriptors(k, 0), &descriptors(k, 0) + descriptors.cols(),
+                descriptor.begin());
+    }
+  }
+}
+
+inline void PCASIFTDescriptorGenerator::describe_batch(Matrix<float> const& patches,
+                                                       Matrix<float>& descriptors) const {
+  pca_sift_descriptors(patches, pca_basis, pca_avg, descriptors);
+}
+
+inline void SGradDescriptorGenerator::describe_batch(Matrix<float> const& patches,
+                                                     Matrix<float>& descriptors) const {
+  sgrad_descriptors(patches, descriptors);
+}
+
 // PatchDescriptorGenerator
 
 template <class ViewT, class IterT>
@@ -15,12 +15,225 @@
 //  limitations under the License.
 // __END_LICENSE__
 
+#include <vw/Core/Cache.h>
+#include <vw/Core/Settings.h>
 #include <vw/InterestPoint/IntegralImage.h>
+#include <vw/Image/BlockProcessor.h>
+
 #include <cmath>
+#include <cstring>
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  #include <emmintrin.h>
+  #include <smmintrin.h> // SSE4.1
+#endif
 
 namespace vw {
 namespace ip {
 
+namespace {
+
+  // Work is handed to threads in blocks of this many rows or columns
+  const int BLOCK_LINES = 64;
+
+  // Images smaller than this are processed on a single thread
+  const int64 MIN_THREADED_PIXELS = 512*512;
+
+  int integral_num_threads(int num_threads, int cols, int rows) {
+    if (int64(cols)*int64(rows) < MIN_THREADED_PIXELS)
+      return 1;
+    if (num_threads <= 0)
+      num_threads = vw_settings().default_num_threads();
+    return num_threads;
+  }
+
+  /// Running sum along one row.
+  template <class SrcT, class DstT>
+  inline void prefix_sum_row(SrcT const* src, DstT* dst, int cols) {
+    DstT sum = 0;
+    for (int i = 0; i < cols; i++) {
+      sum += DstT(src[i]);
+      dst[i] = sum;
+    }
+  }
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  /// Running sum along one row, four floats at a time. Each group of four is
+  /// scanned in-register with two shift-and-add steps, then the carry from
+  /// the previous group is added.
+  inline void prefix_sum_row(float const* src, float* dst, int cols) {
+    __m128 carry = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= cols; i += 4) {
+      __m128 x = _mm_loadu_ps(src + i);
+      x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+      x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+      x = _mm_add_ps(x, carry);
+      _mm_storeu_ps(dst + i, x);
+      carry = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    float sum = _mm_cvtss_f32(carry);
+    for (; i < cols; i++) {
+      sum += src[i];
+      dst[i] = sum;
+    }
+  }
+
+  /// Same as above for 8 bit input, widened to 32 bit lanes.
+  inline void prefix_sum_row(uint8 const* src, uint32* dst, int cols) {
+    __m128i carry = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= cols; i += 4) {
+      int32 packed;
+      memcpy(&packed, src + i, sizeof(packed));
+      __m128i x = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+      x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+      x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+      x = _mm_add_epi32(x, carry);
+      _mm_storeu_si128((__m128i*)(dst + i), x);
+      carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    uint32 sum = uint32(_mm_cvtsi128_si32(carry));
+    for (; i < cols; i++) {
+      sum += src[i];
+      dst[i] = sum;
+    }
+  }
+#endif
+
+  /// First pass: write the running sum of each source row in a block into
+  /// the matching integral row, skipping the zero row and column.
+  template <class SrcT, class DstT>
+  struct RowPrefixSum {
+    ImageView<SrcT> const& m_src;
+    ImageView<DstT>      & m_dst;
+    RowPrefixSum(ImageView<SrcT> const& src, ImageView<DstT>& dst): m_src(src), m_dst(dst) {}
+    void operator()(BBox2i const& bbox) const {
+      for (int row = bbox.min().y(); row < bbox.max().y(); row++)
+        prefix_sum_row(&m_src(0, row), &m_dst(1, row + 1), m_src.cols());
+    }
+  };
+
+  /// Second pass: accumulate the row sums down the columns of a block. The
+  /// inner loop is contiguous so the compiler vectorizes it.
+  template <class DstT>
+  struct ColumnSum {
+    ImageView<DstT> & m_dst;
+    ColumnSum(ImageView<DstT>& dst): m_dst(dst) {}
+    void operator()(BBox2i const& bbox) const {
+      for (int row = 1; row < m_dst.rows(); row++) {
+        DstT const* prev = &m_dst(0, row - 1);
+        DstT      * curr = &m_dst(0, row);
+        for (int col = bbox.min().x(); col < bbox.max().x(); col++)
+          curr[col] += prev[col];
+      }
+    }
+  };
+
+  template <class SrcT, class DstT>
+  ImageView<DstT> integral_image_impl(ImageView<SrcT> const& source, int num_threads) {
+    // The new image comes zeroed, which takes care of the first row and column
+    ImageView<DstT> integral(source.cols() + 1, source.rows() + 1);
+    if (source.cols() == 0 || source.rows() == 0)
+      return integral;
+
+    num_threads = integral_num_threads(num_threads, source.cols(), source.rows());
+    typedef RowPrefixSum<SrcT, DstT> RowFunc;
+    image_block::BlockProcessor<RowFunc>
+      row_processor(RowFunc(source, integral),
+                    Vector2i(source.cols(), BLOCK_LINES), num_threads);
+    row_processor(BBox2i(0, 0, source.cols(), source.rows()));
+
+    // Column blocks are a multiple of 64 bytes wide so threads don't share
+    // cache lines
+    typedef ColumnSum<DstT> ColFunc;
+    image_block::BlockProcessor<ColFunc>
+      col_processor(ColFunc(integral),
+                    Vector2i(BLOCK_LINES * 16, integral.rows()), num_threads);
+    col_processor(BBox2i(0, 0, integral.cols(), integral.rows()));
+    return integral;
+  }
+
+  /// Add weight * IntegralBlock() for the columns [begin, end) of one row.
+  /// The block corners are given as offsets from the evaluation pixel.
+  inline void add_block_row(ImageView<float> const& integral, int y,
+                            int begin, int end,
+                            int x0, int y0, int x1, int y1,
+                            float weight, float* out) {
+    float const* top_left     = &integral(begin + x0, y + y0);
+    float const* bottom_right = &integral(begin + x1, y + y1);
+    float const* bottom_left  = &integral(begin + x0, y + y1);
+    float const* top_right    = &integral(begin + x1, y + y0);
+    out += begin;
+    int n = end - begin, i = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+    __m128 w = _mm_set1_ps(weight);
+    for (; i + 4 <= n; i += 4) {
+      __m128 sum = _mm_add_ps(_mm_loadu_ps(top_left + i), _mm_loadu_ps(bottom_right + i));
+      sum = _mm_sub_ps(sum, _mm_loadu_ps(bottom_left + i));
+      sum = _mm_sub_ps(sum, _mm_loadu_ps(top_right + i));
+      _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(w, sum)));
+    }
+#endif
+    for (; i < n; i++) {
+      float sum = top_left[i] + bottom_right[i] - bottom_left[i] - top_right[i];
+      out[i] += weight * sum;
+    }
+  }
+
+  /// Evaluates the three box filter derivatives for a range of rows. The
+  /// blocks are the same as in XSecondDerivative() and friends.
+  struct HessianRows {
+    ImageView<float> const& m_integral;
+    ImageView<float> &m_dxx, &m_dyy, &m_dxy;
+    int m_lobe, m_half_lobe;
+    int m_begin, m_end, m_row_begin, m_row_end;
+    float m_norm;
+
+    HessianRows(ImageView<float> const& integral, unsigned filter_size,
+                ImageView<float>& dxx, ImageView<float>& dyy, ImageView<float>& dxy):
+      m_integral(integral), m_dxx(dxx), m_dyy(dyy), m_dxy(dxy) {
+      m_lobe      = filter_size / 3;
+      m_half_lobe = m_lobe / 2;
+      m_norm      = float(filter_size * filter_size);
+      // The same margin on every side keeps all three filters in bounds
+      m_begin     = m_lobe + m_half_lobe;
+      m_end       = integral.cols() - 1 - m_lobe - m_half_lobe;
+      m_row_begin = m_lobe + m_half_lobe;
+      m_row_end   = integral.rows() - 1 - m_lobe - m_half_lobe;
+    }
+
+    void operator()(BBox2i const& bbox) const {
+      const int l = m_lobe, h = m_half_lobe;
+      for (int y = bbox.min().y(); y < bbox.max().y(); y++) {
+        float* dxx = &m_dxx(0, y);
+        float* dyy = &m_dyy(0, y);
+        float* dxy = &m_dxy(0, y);
+
+        add_block_row(m_integral, y, m_begin, m_end, -l-h,  -l+1, -h,      l,  1.0f, dxx);
+        add_block_row(m_integral, y, m_begin, m_end, -h,    -l+1, h+1,     l, -2.0f, dxx);
+        add_block_row(m_integral, y, m_begin, m_end, h+1,   -l+1, h+l+1,   l,  1.0f, dxx);
+
+        add_block_row(m_integral, y, m_begin, m_end, -l+1, -l-h,  l, -h,       1.0f, dyy);
+        add_block_row(m_integral, y, m_begin, m_end, -l+1, -h,    l, h+1,     -2.0f, dyy);
+        add_block_row(m_integral, y, m_begin, m_end, -l+1, h+1,   l, h+l+1,    1.0f, dyy);
+
+        add_block_row(m_integral, y, m_begin, m_end, -l, -l,  0,     0,        1.0f, dxy);
+        add_block_row(m_integral, y, m_begin, m_end, 1,  -l,  l+1,   0,       -1.0f, dxy);
+        add_block_row(m_integral, y, m_begin, m_end, -l, 1,   0,     l+1,     -1.0f, dxy);
+        add_block_row(m_integral, y, m_begin, m_end, 1,  1,   l+1,   l+1,      1.0f, dxy);
+
+        for (int x = m_begin; x < m_end; x++) {
+          dxx[x] /= m_norm;
+          dyy[x] /= m_norm;
+          dxy[x] /= m_norm;
+        }
+      }
+    }
+  };
+
+} // end anonymous namespace
+
 /// Using an integral image, compute the summed value of a region
 /// in the original image.
 float
@@ -178,4 +391,39 @@ XYDerivative(ImageView<float> const& integral,
   return derivative;
 }
 
+ImageView<float> integral_image(ImageView<float> const& source, int num_threads) {
+  return integral_image_impl<float, float>(source, num_threads);
+}
+
+ImageView<uint32> integral_image(ImageView<uint8> const& source, int num_threads) {
+  return integral_image_impl<uint8, uint32>(source, num_threads);
+}
+
+ImageView<uint64> integral_image(ImageView<uint16> const& source, int num_threads) {
+  return integral_image_impl<uint16, uint64>(source, num_threads);
+}
+
+void HessianResponse(ImageView<float> const& integral,
+                     unsigned filter_size,
+                     ImageView<float> & dxx,
+                     ImageView<float> & dyy,
+                     ImageView<float> & dxy,
+                     int num_threads) {
+  int cols = std::max(integral.cols() - 1, 0);
+  int rows = std::max(integral.rows() - 1, 0);
+  // Fresh buffers come zeroed, which covers the border
+  dxx = ImageView<float>(cols, rows);
+  dyy = ImageView<float>(cols, rows);
+  dxy = ImageView<float>(cols, rows);
+
+  HessianRows func(integral, filter_size, dxx, dyy, dxy);
+  if (func.m_begin >= func.m_end || func.m_row_begin >= func.m_row_end)
+    return; // The filter does not fit anywhere, leave all zeros
+
+  num_threads = integral_num_threads(num_threads, cols, rows);
+  image_block::BlockProcessor<HessianRows>
+    processor(func, Vector2i(cols, BLOCK_LINES), num_threads);
+  processor(BBox2i(0, func.m_row_begin, cols, func.m_row_end - func.m_row_begin));
+}
+
 }} // end namespace vw::ip
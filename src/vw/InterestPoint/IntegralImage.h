@@ -27,69 +27,51 @@
 #include <boost/utility/enable_if.hpp>
 #include <vw/Core/FundamentalTypes.h>
 #include <vw/Image/ImageView.h>
+#include <vw/Image/ImageChannels.h>
 
 // TODO: Change the function names to meet the standard convention!
 
 namespace vw {
 namespace ip {
 
+  /// Build the integral image of a float image. The output has one more row
+  /// and column than the input, with the first row and column set to zero.
+  /// - Each row is prefix-summed (four lanes at a time with SSE), then the
+  ///   row sums are accumulated down the columns. Both passes are split
+  ///   across threads. Set num_threads to 0 to use the VW default.
+  ImageView<float> integral_image(ImageView<float> const& source,
+                                  int num_threads = 0);
+
+  /// Integer variants of integral_image() for 8 and 16 bit imagery. Sums are
+  /// exact, unlike with float, which loses precision after 2^24.
+  /// - The sums wrap around on overflow. Box sums computed from the four
+  ///   corners with the same unsigned type are still exact, as long as the
+  ///   sum over the box itself fits in the type. For uint8 input that is
+  ///   any box with fewer than 2^24 pixels.
+  ImageView<uint32> integral_image(ImageView<uint8>  const& source,
+                                   int num_threads = 0);
+  ImageView<uint64> integral_image(ImageView<uint16> const& source,
+                                   int num_threads = 0);
+
   /// Function to create an integral image of an input image.
   /// - Despite the caps, this is a function and IntegralImage is not a type!
   /// - An integral image can be used to quickly find regional sums using
   ///   the function below.
   /// - Returns ImageView<float>. All callers use float.
+  /// - The source is rasterized to float and handed to integral_image().
   template <class ViewT>
   inline ImageView<float>
   IntegralImage(ImageViewBase<ViewT> const& source) {
-
-    // Allocating space
-    ImageView<float> integral(source.impl().cols() + 1,
-                              source.impl().rows() + 1);
-
-    typedef typename ImageView<float>::pixel_accessor dst_accessor;
-    typedef typename ViewT::pixel_accessor src_accessor;
-
-    // Zero-ing the first row and col
-    dst_accessor dest_row = integral.origin();
-    *dest_row = 0;
-    for (int i = 1; i < integral.cols(); i++) {
-      dest_row.next_col();
-      *dest_row = 0;
-    }
-    dest_row = integral.origin();
-    for (int i = 1; i < integral.rows(); i++) {
-      dest_row.next_row();
-      *dest_row = 0;
-    }
-
-    // Pointer and pointer offset
-    int offset = integral.cols();
-    float* p = nullptr;
-
-    // Now filling in integral image
-    dest_row = integral.origin();
-    dest_row.advance(1, 1);
-    src_accessor src_row = source.impl().origin();
-    for (int iy = 0; iy < source.impl().rows(); iy++) {
-      dst_accessor dest_col = dest_row;
-      src_accessor src_col = src_row;
-      for (int ix = 0; ix < source.impl().cols(); ix++) {
-        p = &(*dest_col);
-
-        // Summing
-        *dest_col = pixel_cast<PixelGray<float>>(*src_col).v()
-                    + *(p - 1) + *(p - offset) - *(p - offset - 1);
-
-        dest_col.next_col();
-        src_col.next_col();
-      }
-      dest_row.next_row();
-      src_row.next_row();
-    }
-
-    return integral;
+    ImageView<float> image = pixel_cast<PixelGray<float>>(source.impl());
+    return integral_image(image);
   } // End IntegralImage function
 
+  /// Float images need no conversion before integration.
+  inline ImageView<float>
+  IntegralImage(ImageView<float> const& source) {
+    return integral_image(source);
+  }
+
   /// Using an integral image, compute the summed value of a region
   /// in the original image.
   float IntegralBlock(ImageView<float> const& integral,
@@ -121,6 +103,20 @@ namespace ip {
                      int const& x, int const& y,
                      unsigned const& filter_size);
 
+  /// Evaluate XSecondDerivative(), YSecondDerivative() and XYDerivative()
+  /// at every pixel of the source image of an integral image.
+  /// - The outputs have the size of the source image, so one less row and
+  ///   column than the integral. Pixels where the filter would reach outside
+  ///   the integral image are set to zero.
+  /// - Rows are split across threads and each row is evaluated with SSE.
+  ///   The result is identical to calling the per-pixel functions.
+  void HessianResponse(ImageView<float> const& integral,
+                       unsigned filter_size,
+                       ImageView<float> & dxx,
+                       ImageView<float> & dyy,
+                       ImageView<float> & dxy,
+                       int num_threads = 0);
+
   // Horizontal Wavelet
   // - integral  = Integral used for calculations
   // - x         = x location to evaluate at
@@ -0,0 +1,186 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+/// \file InterestPointGrid.cc
+///
+/// A uniform grid over interest point locations.
+///
+#include <vw/InterestPoint/InterestPointGrid.h>
+
+#include <cmath>
+
+namespace vw {
+namespace ip {
+
+InterestPointGrid::InterestPointGrid(double cell_size):
+  m_cell_size(cell_size), m_size(0) {
+  VW_ASSERT(cell_size > 0, ArgumentErr() << "InterestPointGrid: The cell size must be positive.\n");
+}
+
+InterestPointGrid::InterestPointGrid(std::vector<InterestPoint> const& ip, double cell_size):
+  m_cell_size(cell_size), m_size(0) {
+  VW_ASSERT(cell_size > 0, ArgumentErr() << "InterestPointGrid: The cell size must be positive.\n");
+  for (size_t i = 0; i < ip.size(); i++)
+    insert(ip[i].x, ip[i].y, i);
+}
+
+int64 InterestPointGrid::cell_coord(double v) const {
+  return static_cast<int64>(std::floor(v / m_cell_size));
+}
+
+uint64 InterestPointGrid::cell_key(int64 cx, int64 cy) const {
+  return (uint64(uint32(cx)) << 32) | uint64(uint32(cy));
+}
+
+void InterestPointGrid::insert(double x, double y, size_t index) {
+  Entry entry = {x, y, index};
+  m_cells[cell_key(cell_coord(x), cell_coord(y))].push_back(entry);
+  m_size++;
+}
+
+void InterestPointGrid::clear() {
+  m_cells.clear();
+  m_size = 0;
+}
+
+template <class FuncT>
+bool InterestPointGrid::visit_box(double min_x, double min_y, double max_x, double max_y,
+                                  FuncT const& func) const {
+  if (min_x > max_x || min_y > max_y)
+    return false;
+  int64 cx0 = cell_coord(min_x), cx1 = cell_coord(max_x);
+  int64 cy0 = cell_coord(min_y), cy1 = cell_coord(max_y);
+
+  // For a box larger than the occupied area, look at the occupied cells
+  // instead of every cell in the box.
+  double num_box_cells = double(cx1 - cx0 + 1) * double(cy1 - cy0 + 1);
+  if (num_box_cells > double(m_cells.size())) {
+    for (CellMap::const_iterator it = m_cells.begin(); it != m_cells.end(); ++it)
+      for (size_t i = 0; i < it->second.size(); i++)
+        if (func(it->second[i]))
+          return true;
+    return false;
+  }
+
+  for (int64 cy = cy0; cy <= cy1; cy++) {
+    for (int64 cx = cx0; cx <= cx1; cx++) {
+      CellMap::const_iterator it = m_cells.find(cell_key(cx, cy));
+      if (it == m_cells.end())
+        continue;
+      for (size_t i = 0; i < it->second.size(); i++)
+        if (func(it->second[i]))
+          return true;
+    }
+  }
+  return false;
+}
+
+void InterestPointGrid::box_search(double min_x, double min_y, double max_x, double max_y,
+                                   std::vector<size_t> & result) const {
+  visit_box(min_x, min_y, max_x, max_y, [&](Entry const& e) {
+    if (e.x >= min_x && e.x <= max_x && e.y >= min_y && e.y <= max_y)
+      result.push_back(e.index);
+    return false;
+  });
+}
+
+void InterestPointGrid::radius_search(double x, double y, double radius,
+                                      std::vector<size_t> & result) const {
+  double r2 = radius * radius;
+  visit_box(x - radius, y - radius, x + radius, y + radius, [&](Entry const& e) {
+    double dx = e.x - x, dy = e.y - y;
+    if (dx*dx + dy*dy <= r2)
+      result.push_back(e.index);
+    return false;
+  });
+}
+
+bool InterestPointGrid::any_within_radius(double x, double y, double radius) const {
+  double r2 = radius * radius;
+  return visit_box(x - radius, y - radius, x + radius, y + radius, [&](Entry const& e) {
+    double dx = e.x - x, dy = e.y - y;
+    return dx*dx + dy*dy <= r2;
+  });
+}
+
+namespace {
+
+  // Flag the entries to keep: at most max_per_cell per cell, the ones that
+  // rank first by score.
+  void flag_top_per_cell(std::vector<InterestPoint> const& ip,
+                         std::vector<float> const& score,
+                         double cell_size, size_t max_per_cell,
+                         std::vector<bool> & keep) {
+    VW_ASSERT(cell_size > 0, ArgumentErr() << "The cell size must be positive.\n");
+
+    std::unordered_map<uint64, std::vector<size_t>> cells;
+    for (size_t i = 0; i < ip.size(); i++) {
+      int64 cx = static_cast<int64>(std::floor(ip[i].x / cell_size));
+      int64 cy = static_cast<int64>(std::floor(ip[i].y / cell_size));
+      cells[(uint64(uint32(cx)) << 32) | uint64(uint32(cy))].push_back(i);
+    }
+
+    keep.assign(ip.size(), false);
+    for (auto& cell: cells) {
+      std::vector<size_t>& members = cell.second;
+      size_t count = std::min(max_per_cell, members.size());
+      // Ties go to the earlier point, so the result does not depend on the
+      // hash order.
+      std::partial_sort(members.begin(), members.begin() + count, members.end(),
+                        [&score](size_t a, size_t b) {
+                          return score[a] > score[b] || (score[a] == score[b] && a < b);
+                        });
+      for (size_t k = 0; k < count; k++)
+        keep[members[k]] = true;
+    }
+  }
+
+  void keep_flagged(std::vector<InterestPoint> & ip, std::vector<bool> const& keep) {
+    size_t out = 0;
+    for (size_t i = 0; i < ip.size(); i++)
+      if (keep[i])
+        ip[out++] = ip[i];
+    ip.resize(out);
+  }
+
+} // end anonymous namespace
+
+void cull_per_cell(std::vector<InterestPoint> & ip, double cell_size,
+                   size_t max_per_cell) {
+  std::vector<float> score(ip.size());
+  for (size_t i = 0; i < ip.size(); i++)
+    score[i] = ip[i].interest;
+  std::vector<bool> keep;
+  flag_top_per_cell(ip, score, cell_size, max_per_cell, keep);
+  keep_flagged(ip, keep);
+}
+
+void cull_matches_per_cell(std::vector<InterestPoint> & ip1,
+                           std::vector<InterestPoint> & ip2,
+                           double cell_size, size_t max_per_cell) {
+  VW_ASSERT(ip1.size() == ip2.size(),
+            ArgumentErr() << "Input vectors are not the same size.");
+  std::vector<float> score(ip1.size());
+  for (size_t i = 0; i < ip1.size(); i++)
+    score[i] = std::min(ip1[i].interest, ip2[i].interest);
+  std::vector<bool> keep;
+  flag_top_per_cell(ip1, score, cell_size, max_per_cell, keep);
+  keep_flagged(ip1, keep);
+  keep_flagged(ip2, keep);
+}
+
+}} // namespace vw::ip
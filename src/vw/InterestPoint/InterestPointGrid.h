@@ -0,0 +1,103 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2026, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+/// \file InterestPointGrid.h
+///
+/// A uniform grid over interest point locations, for finding the points
+/// near a location without searching all of them.
+///
+#ifndef __VW_INTERESTPOINT_INTEREST_POINT_GRID_H__
+#define __VW_INTERESTPOINT_INTEREST_POINT_GRID_H__
+
+#include <vw/InterestPoint/InterestPoint.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace vw {
+namespace ip {
+
+  /// Buckets point locations into square cells, hashed by cell, so that
+  /// finding the points in a neighborhood only looks at the few cells it
+  /// overlaps. Points are identified by an index given on insertion,
+  /// usually their position in a list.
+  /// - Lookups cost O(1) per cell plus the number of points in those
+  ///   cells, so the cell size should be on the order of the search size.
+  class InterestPointGrid {
+  public:
+
+    /// An empty grid with the given cell size in pixels.
+    explicit InterestPointGrid(double cell_size);
+
+    /// A grid over the given points, indexed by their position in the list.
+    InterestPointGrid(std::vector<InterestPoint> const& ip, double cell_size);
+
+    double cell_size() const { return m_cell_size; }
+    size_t size     () const { return m_size; }
+
+    void insert(double x, double y, size_t index);
+    void clear();
+
+    /// Append to result the indices of the points with min_x <= x <= max_x
+    /// and min_y <= y <= max_y.
+    void box_search(double min_x, double min_y, double max_x, double max_y,
+                    std::vector<size_t> & result) const;
+
+    /// Append to result the indices of the points within the given distance.
+    void radius_search(double x, double y, double radius,
+                       std::vector<size_t> & result) const;
+
+    /// True if there is a point within the given distance.
+    bool any_within_radius(double x, double y, double radius) const;
+
+  private:
+    struct Entry {
+      double x, y;
+      size_t index;
+    };
+    typedef std::unordered_map<uint64, std::vector<Entry>> CellMap;
+
+    int64  cell_coord(double v) const;
+    uint64 cell_key  (int64 cx, int64 cy) const;
+
+    /// Call func(entry) for each point in the cells overlapping the box.
+    /// Stops early if func returns true, and returns whether it did.
+    template <class FuncT>
+    bool visit_box(double min_x, double min_y, double max_x, double max_y,
+                   FuncT const& func) const;
+
+    double  m_cell_size;
+    size_t  m_size;
+    CellMap m_cells;
+  };
+
+  /// Keep at most max_per_cell points in each cell of a grid with the
+  /// given cell size, the ones with the largest interest, so that the
+  /// points cover the image evenly. The kept points stay in order.
+  void cull_per_cell(std::vector<InterestPoint> & ip, double cell_size,
+                     size_t max_per_cell);
+
+  /// As cull_per_cell(), for matches. The matches are binned by their
+  /// location in the first image and ranked by the smaller interest of
+  /// their two points.
+  void cull_matches_per_cell(std::vector<InterestPoint> & ip1,
+                             std::vector<InterestPoint> & ip2,
+                             double cell_size, size_t max_per_cell);
+
+}} // namespace vw::ip
+
+#endif // __VW_INTERESTPOINT_INTEREST_POINT_GRID_H__
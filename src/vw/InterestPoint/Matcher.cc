@@ -146,6 +146,51 @@ bool PositionConstraint::operator()( InterestPoint const& baseline_ip,
   return false;
 }
 
+//==================================================================================
+// InterestPointIndex
+
+InterestPointIndex::InterestPointIndex(std::vector<InterestPoint> const& ip,
+                                       math::FLANN_DistType dist_type,
+                                       std::string const& flann_method,
+                                       std::string const& cache_file):
+  m_ip(ip), m_dist_type(dist_type), m_tree_float(flann_method),
+  m_tree_uchar(flann_method), m_loaded_from_cache(false) {
+
+  if (m_ip.empty())
+    vw_throw(ArgumentErr() << "InterestPointIndex: No interest points to index.\n");
+
+  if (dist_type == math::FLANN_DistType_Hamming) {
+    Matrix<unsigned char> descriptors;
+    ip_list_to_matrix(m_ip, descriptors);
+    if (cache_file.empty())
+      m_tree_uchar.load_match_data(descriptors, dist_type);
+    else
+      m_loaded_from_cache = m_tree_uchar.load_match_data(descriptors, dist_type, cache_file);
+  } else {
+    Matrix<float> descriptors;
+    ip_list_to_matrix(m_ip, descriptors);
+    if (cache_file.empty())
+      m_tree_float.load_match_data(descriptors, dist_type);
+    else
+      m_loaded_from_cache = m_tree_float.load_match_data(descriptors, dist_type, cache_file);
+  }
+
+  if (m_loaded_from_cache)
+    VW_OUT(DebugMessage, "interest_point") << "Read FLANN index: " << cache_file << "\n";
+}
+
+size_t InterestPointIndex::knn_search(InterestPoint const& ip, Vector<int>& indices,
+                                      Vector<double>& dists, size_t knn) {
+  if (m_dist_type == math::FLANN_DistType_Hamming) {
+    // Convert the descriptor to unsigned chars, then call FLANN
+    Vector<unsigned char> uchar_descriptor(ip.descriptor.size());
+    for (size_t i = 0; i < ip.descriptor.size(); i++)
+      uchar_descriptor[i] = static_cast<unsigned char>(ip.descriptor[i]);
+    return m_tree_uchar.knn_search(uchar_descriptor, indices, dists, knn);
+  }
+  return m_tree_float.knn_search(ip.descriptor, indices, dists, knn);
+}
+
 // Remove duplicates in interest point matches. Use a set for speed. When
 // duplicates are encountered, keep the last repeated value. The code is this
 // way to get the same results as a prior version of the code.
@@ -194,4 +239,41 @@ void remove_duplicates(std::vector<InterestPoint>& ip1,
   }
 }
 
+// Same as above, but with a grid to find the matches within a radius. When
+// duplicates are encountered, keep the last one.
+void remove_duplicates(std::vector<InterestPoint>& ip1,
+                       std::vector<InterestPoint>& ip2,
+                       double radius) {
+
+  VW_ASSERT(ip1.size() == ip2.size(),
+            ArgumentErr() << "Input vectors are not the same size.");
+  if (radius <= 0) {
+    remove_duplicates(ip1, ip2);
+    return;
+  }
+
+  InterestPointGrid grid1(radius), grid2(radius);
+  std::vector<bool> keep(ip1.size(), false);
+  for (size_t i = 0; i < ip1.size(); i++) {
+    size_t j = ip1.size() - i - 1; // reverse order to keep the last repeated one
+    if (grid1.any_within_radius(ip1[j].x, ip1[j].y, radius) ||
+        grid2.any_within_radius(ip2[j].x, ip2[j].y, radius))
+      continue;
+    grid1.insert(ip1[j].x, ip1[j].y, j);
+    grid2.insert(ip2[j].x, ip2[j].y, j);
+    keep[j] = true;
+  }
+
+  size_t out = 0;
+  for (size_t i = 0; i < ip1.size(); i++) {
+    if (!keep[i])
+      continue;
+    ip1[out] = ip1[i];
+    ip2[out] = ip2[i];
+    out++;
+  }
+  ip1.resize(out);
+  ip2.resize(out);
+}
+
 }} // namespace vw::ip
@@ -28,8 +28,10 @@
 #include <vw/Core/Log.h>
 #include <vw/InterestPoint/Descriptor.h>
 #include <vw/InterestPoint/InterestPoint.h>
+#include <vw/InterestPoint/InterestPointGrid.h>
 #include <vector>
 #include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
 
 #ifdef VW_HAVE_PKG_FLANN
 #include <vw/Math/FLANNTree.h>
@@ -152,6 +154,37 @@ namespace ip {
   //                         Interest Point Matcher
   // ---------------------------------------------------------------------------
 
+  /// A set of interest points with a FLANN index over their descriptors,
+  /// to be matched against. If cache_file is not empty, the index is read
+  /// from it when it exists and is written to it otherwise, so an image
+  /// matched against many others has its index built only once. Use
+  /// flann_index_filename() to name this file.
+  class InterestPointIndex: boost::noncopyable {
+  public:
+    InterestPointIndex(std::vector<InterestPoint> const& ip,
+                       math::FLANN_DistType dist_type,
+                       std::string const& flann_method,
+                       std::string const& cache_file = "");
+
+    std::vector<InterestPoint> const& interest_points() const { return m_ip; }
+    math::FLANN_DistType dist_type() const { return m_dist_type; }
+
+    /// True if the index was read from the cache file instead of built.
+    bool loaded_from_cache() const { return m_loaded_from_cache; }
+
+    /// Find the knn points with the closest descriptors to the given one.
+    /// Returns how many were found.
+    size_t knn_search(InterestPoint const& ip, Vector<int>& indices,
+                      Vector<double>& dists, size_t knn);
+
+  private:
+    std::vector<InterestPoint>     m_ip;
+    math::FLANN_DistType           m_dist_type;
+    math::FLANNTree<float>         m_tree_float;
+    math::FLANNTree<unsigned char> m_tree_uchar;
+    bool                           m_loaded_from_cache;
+  };
+
   /// Interest point matcher class
   template < class MetricT, class ConstraintT >
   class InterestPointMatcher {
@@ -173,6 +206,20 @@ namespace ip {
       return true;
     }
 
+    // Given the two nearest neighbors of ip, return the index of the
+    // first if it passes the constraint and is significantly closer than
+    // the second, and the max value of size_t otherwise.
+    size_t accept_match( InterestPoint const& ip, InterestPoint const& nearest0,
+                         InterestPoint const& nearest1, size_t index0 ) const {
+      if (!check_constraint<ConstraintT>( nearest0, ip ))
+        return (size_t)(-1);
+      double dist0 = m_distance_metric(nearest0, ip);
+      double dist1 = m_distance_metric(nearest1, ip);
+      if (dist0 < m_threshold * dist1)
+        return index0;
+      return (size_t)(-1);
+    }
+
   public:
 
     InterestPointMatcher(std::string const& flann_method, 
@@ -199,6 +246,18 @@ namespace ip {
                      MatchListT& matched_ip1, MatchListT& matched_ip2,
                      const ProgressCallback &progress_callback = ProgressCallback::dummy_instance(), 
                      bool quiet = false) const;
+
+    /// Match ip1 against several indexed sets of interest points with one
+    /// pass over ip1. On output index_lists[k][i] is the index in
+    /// indices[k]->interest_points() of the match for the i-th point of
+    /// ip1, or the max value of size_t if there is none. The indices must
+    /// have been made with the distance type of MetricT.
+    template <class ListT>
+    void match_indexed( ListT const& ip1,
+                        std::vector<boost::shared_ptr<InterestPointIndex>> const& indices,
+                        std::vector<std::vector<size_t>>& index_lists,
+                        const ProgressCallback &progress_callback = ProgressCallback::dummy_instance(),
+                        bool quiet = false) const;
   };
 
 
@@ -234,6 +293,28 @@ namespace ip {
   void remove_duplicates(std::vector<InterestPoint>& ip1,
                          std::vector<InterestPoint>& ip2);
 
+  /// As above, but a match is also a duplicate if its point in either image
+  /// is within the given radius, in pixels, of that of a kept match. As
+  /// above, the last of a group of duplicates is kept.
+  void remove_duplicates(std::vector<InterestPoint>& ip1,
+                         std::vector<InterestPoint>& ip2,
+                         double radius);
+
+  /// Match each point of ip1 to the point of ip2 with the closest
+  /// descriptor among those satisfying the position constraint. The
+  /// candidates are found with a grid over ip2 instead of checking the
+  /// constraint on every point. As in InterestPointMatcher, a match is
+  /// kept only if it is closer than threshold times the distance to the
+  /// next best candidate, when there is one. index_list[i] is the index in
+  /// ip2 of the match for ip1[i], or the max value of size_t if none.
+  template <class MetricT>
+  void match_with_position_constraint(std::vector<InterestPoint> const& ip1,
+                                      std::vector<InterestPoint> const& ip2,
+                                      PositionConstraint const& constraint,
+                                      double threshold,
+                                      std::vector<size_t> & index_list,
+                                      MetricT const& metric = MetricT());
+
 //==========================================================================
 // Fuction definitions
 
@@ -365,18 +446,10 @@ void InterestPointMatcher<MetricT, ConstraintT>::operator()
       std::advance( iterator, indices[1] );
       nearest_records[1] = *iterator;
 
-      // Check the user constraint on the record
-      if ( check_constraint<ConstraintT>( nearest_records[0], ip ) ) {
-        double dist0 = m_distance_metric(nearest_records[0], ip);
-        double dist1 = m_distance_metric(nearest_records[1], ip);
-
-        // As a final check, make sure the nearest record is significantly closer than the next one.
-        if (dist0 < m_threshold * dist1) {
-          index_list.push_back( indices[0] );
-        } else {
-          index_list.push_back( (size_t)(-1) ); // Last value of size_t
-        }
-      } // End check constraint
+      // Check the user constraint and make sure the nearest record is
+      // significantly closer than the next one.
+      index_list.push_back( accept_match( ip, nearest_records[0], nearest_records[1],
+                                          indices[0] ) );
     } // End both valid case
   }
 
@@ -385,6 +458,62 @@ void InterestPointMatcher<MetricT, ConstraintT>::operator()
 
 } // End InterestPointMatcher::operator()
 
+template <class MetricT, class ConstraintT>
+template <class ListT>
+void InterestPointMatcher<MetricT, ConstraintT>::match_indexed
+    (ListT const& ip1,
+     std::vector<boost::shared_ptr<InterestPointIndex>> const& indices,
+     std::vector<std::vector<size_t>>& index_lists,
+     const ProgressCallback &progress_callback,
+     bool quiet) const {
+
+  Timer total_time("Total elapsed time", DebugMessage, "interest_point");
+
+  index_lists.clear();
+  index_lists.resize(indices.size());
+  for (size_t k = 0; k < indices.size(); k++) {
+    if (indices[k]->dist_type() != MetricT::flann_type)
+      vw_throw( ArgumentErr() << "InterestPointMatcher: The index distance type "
+                << "does not match the metric.\n" );
+    index_lists[k].reserve(ip1.size());
+  }
+
+  if (ip1.size() == 0 || indices.empty()) {
+    if (!quiet)
+      progress_callback.report_finished();
+    return;
+  }
+
+  float inc_amt = 1.0f/float(ip1.size());
+  if (!quiet)
+    progress_callback.report_progress(0);
+
+  const size_t KNN = 2; // Find this many matches
+  Vector<int>    knn_indices(KNN);
+  Vector<double> distances(KNN);
+
+  BOOST_FOREACH( InterestPoint const& ip, ip1 ) {
+    if (progress_callback.abort_requested())
+      vw_throw( Aborted() << "Aborted by ProgressCallback");
+
+    if (!quiet)
+      progress_callback.report_incremental_progress(inc_amt);
+
+    for (size_t k = 0; k < indices.size(); k++) {
+      if (indices[k]->knn_search(ip, knn_indices, distances, KNN) < KNN) {
+        index_lists[k].push_back( (size_t)(-1) );
+        continue;
+      }
+      std::vector<InterestPoint> const& ip2 = indices[k]->interest_points();
+      index_lists[k].push_back( accept_match( ip, ip2[knn_indices[0]], ip2[knn_indices[1]],
+                                              knn_indices[0] ) );
+    }
+  }
+
+  if (!quiet)
+    progress_callback.report_finished();
+}
+
 // Given two lists of interest points, this routine returns the two lists
 // of matching interest points based on the Metric and Constraints
 // provided by the user.
@@ -426,6 +555,58 @@ void InterestPointMatcher<MetricT, ConstraintT>::operator()
 
 }
 
+//-----------------------------------------------------------
+// match_with_position_constraint
+
+template <class MetricT>
+void match_with_position_constraint(std::vector<InterestPoint> const& ip1,
+                                    std::vector<InterestPoint> const& ip2,
+                                    PositionConstraint const& constraint,
+                                    double threshold,
+                                    std::vector<size_t> & index_list,
+                                    MetricT const& metric) {
+  Timer total_time("Total elapsed time", DebugMessage, "interest_point");
+
+  index_list.assign(ip1.size(), (size_t)(-1));
+  if (ip1.empty() || ip2.empty())
+    return;
+
+  // Cells about the size of the search window keep the number of cells
+  // visited per point small.
+  double cell_size = std::max(1.0, std::max(constraint.max_x - constraint.min_x,
+                                            constraint.max_y - constraint.min_y));
+  InterestPointGrid grid(ip2, cell_size);
+
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < ip1.size(); i++) {
+    // The constraint is on ip1 minus the ip2 position
+    candidates.clear();
+    grid.box_search(ip1[i].x - constraint.max_x, ip1[i].y - constraint.max_y,
+                    ip1[i].x - constraint.min_x, ip1[i].y - constraint.min_y,
+                    candidates);
+
+    float  first_pick  = std::numeric_limits<float>::max();
+    float  second_pick = first_pick;
+    size_t best = (size_t)(-1);
+    for (size_t k = 0; k < candidates.size(); k++) {
+      InterestPoint const& candidate = ip2[candidates[k]];
+      if (!constraint(candidate, ip1[i]))
+        continue;
+      float dist = metric(ip1[i], candidate, second_pick);
+      if (dist < first_pick) {
+        second_pick = first_pick;
+        first_pick  = dist;
+        best        = candidates[k];
+      } else if (dist < second_pick) {
+        second_pick = dist;
+      }
+    }
+
+    if (best != (size_t)(-1) && first_pick < threshold * second_pick)
+      index_list[i] = best;
+  }
+}
+
 //-----------------------------------------------------------
 // InterestPointMatcherSimple
 
@@ -38,20 +38,31 @@ namespace vw { namespace ip {
 // on most file systems. Budget the generated names against this, with a margin.
 const size_t g_name_budget = 240;
 
-// A fixed, portable 64-bit FNV-1a hash, as 16 hex digits. This keeps shortened
-// file names distinct across platforms and runs, unlike std::hash, which
-// differs between standard library implementations.
-static std::string fnv1a64Hex(std::string const& s) {
-  uint64_t h = 14695981039346656037ULL;
-  for (unsigned char c: s) {
-    h ^= static_cast<uint64_t>(c);
+// A fixed, portable 64-bit FNV-1a hash. This keeps shortened file names
+// distinct across platforms and runs, unlike std::hash, which differs between
+// standard library implementations. Pass in the previous value to continue
+// hashing more data.
+static uint64_t fnv1a64(void const* data, size_t len,
+                        uint64_t h = 14695981039346656037ULL) {
+  unsigned char const* bytes = static_cast<unsigned char const*>(data);
+  for (size_t i = 0; i < len; i++) {
+    h ^= static_cast<uint64_t>(bytes[i]);
     h *= 1099511628211ULL;
   }
+  return h;
+}
+
+// A hash as 16 hex digits
+static std::string hashToHex(uint64_t h) {
   std::ostringstream os;
   os << std::hex << std::setw(16) << std::setfill('0') << h;
   return os.str();
 }
 
+static std::string fnv1a64Hex(std::string const& s) {
+  return hashToHex(fnv1a64(s.data(), s.size()));
+}
+
 // Shorten a name to at most max_len characters. If it already fits, it is
 // returned unchanged. Otherwise it is reduced to a leading portion plus a
 // 64-bit hash of the full name, so distinct names stay distinct. See the
@@ -210,6 +221,28 @@ std::string ip_filename(std::string const& out_prefix,
   return prefix + "-" + name + ".vwip";
 }
 
+std::string flann_index_filename(std::string const& ip_file,
+                                 std::vector<InterestPoint> const& ip,
+                                 std::string const& flann_method,
+                                 math::FLANN_DistType dist_type) {
+  // Hash everything the index depends on, in order
+  int32 type = dist_type;
+  uint64_t h = fnv1a64(&type, sizeof(type));
+  h = fnv1a64(flann_method.data(), flann_method.size(), h);
+  for (size_t i = 0; i < ip.size(); i++) {
+    InterestPoint::descriptor_type const& d = ip[i].descriptor;
+    if (d.size() > 0)
+      h = fnv1a64(&d[0], d.size() * sizeof(float), h);
+  }
+  std::string hash = hashToHex(h);
+
+  // Replace the .vwip extension, and shorten the name to fit the file system
+  // limit along with the dash, hash and ".flann".
+  fs::path p(ip_file);
+  std::string name = shortenName(p.stem().string(), g_name_budget - 1 - hash.size() - 6);
+  return (p.parent_path() / (name + "-" + hash + ".flann")).string();
+}
+
 void ip_filenames(std::string const& out_prefix,
                   std::string const& input_file1,
                   std::string const& input_file2,
@@ -23,6 +23,7 @@
 #define _INTERESTPOINT_MATCHER_IO_H_
 
 #include <vw/InterestPoint/InterestPoint.h>
+#include <vw/Math/FLANNTree.h>
 
 #include <string>
 #include <vector>
@@ -54,6 +55,15 @@ namespace ip {
   std::string ip_filename(std::string const& out_prefix,
                           std::string const& input_file);
 
+  /// The name of the file caching a FLANN index over the descriptors of
+  /// the given interest points, next to their IP file. It includes a hash
+  /// of the descriptors, the FLANN method and the distance type, so an
+  /// index is never reused after the IP file changes.
+  std::string flann_index_filename(std::string const& ip_file,
+                                   std::vector<InterestPoint> const& ip,
+                                   std::string const& flann_method,
+                                   math::FLANN_DistType dist_type);
+
   /// The .vwip file name for a standalone image, with no output prefix. The
   /// input is a path with the extension already removed. Shortens the name if
   /// needed to fit the file system limit. Used by ipfind and ipmatch.
@@ -89,3 +89,28 @@ TEST( BoxFilter, FilterView ) {
   EXPECT_NEAR( 0, applied(0,0), 1e-5 );
   EXPECT_NEAR( 0, applied(3,3), 1e-5 );
 }
+
+TEST( BoxFilter, RasterizeBoxFilter ) {
+  ImageView<float> image(41, 29);
+  for ( int j = 0; j < image.rows(); j++ )
+    for ( int i = 0; i < image.cols(); i++ )
+      image(i,j) = float((i*5 + j*3) % 7);
+  ImageView<float> integral = IntegralImage( image );
+
+  BoxFilter filter;
+  filter.resize(2);
+  filter[0].start = Vector2i(-1,-1);
+  filter[0].size = Vector2i(3,3);
+  filter[0].weight = -1;
+  filter[1].start = Vector2i(-4,-2);
+  filter[1].size = Vector2i(9,5);
+  filter[1].weight = 0.25;
+
+  ImageView<float> expected = box_filter( integral, filter );
+  ImageView<float> applied  = rasterize_box_filter( integral, filter );
+  ASSERT_EQ( expected.cols(), applied.cols() );
+  ASSERT_EQ( expected.rows(), applied.rows() );
+  for ( int j = 0; j < applied.rows(); j++ )
+    for ( int i = 0; i < applied.cols(); i++ )
+      EXPECT_NEAR( expected(i,j), applied(i,j), 1e-5 );
+}
@@ -0,0 +1,113 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2013, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <gtest/gtest_VW.h>
+#include <test/Helpers.h>
+#include <vw/InterestPoint/Descriptor.h>
+
+using namespace vw;
+using namespace vw::ip;
+using namespace vw::test;
+
+namespace {
+  // A smooth pattern, with points in the middle and at the edges
+  void make_test_data(ImageView<PixelGray<float>>& image, InterestPointList& points) {
+    image.set_size(120, 100);
+    for (int j = 0; j < image.rows(); j++)
+      for (int i = 0; i < image.cols(); i++)
+        image(i,j) = 0.5 + 0.25*sin(0.3*i + 0.1*j) + 0.2*cos(0.17*j*j/(1.0+i));
+    for (int k = 0; k < 12; k++)
+      points.push_back(InterestPoint(10*k + 0.3, 8*k + 2.6, 0.7 + 0.15*k, 0.55*k - 3.0));
+  }
+}
+
+TEST( Descriptor, SampleSupports ) {
+  ImageView<PixelGray<float>> image;
+  InterestPointList points;
+  make_test_data(image, points);
+  ImageView<float> source = pixel_cast<PixelGray<float>>(image);
+
+  std::vector<InterestPoint const*> batch;
+  for (InterestPointList::iterator it = points.begin(); it != points.end(); ++it)
+    batch.push_back(&(*it));
+  Matrix<float> patches;
+  sample_supports(source, batch, 41, patches);
+  ASSERT_EQ( points.size(), patches.rows() );
+  ASSERT_EQ( 41u*41u, patches.cols() );
+
+  PatchDescriptorGenerator generator;
+  size_t k = 0;
+  for (InterestPointList::iterator it = points.begin(); it != points.end(); ++it, ++k) {
+    ImageView<PixelGray<float>> support = generator.get_support(*it, image);
+    for (int j = 0; j < 41; j++)
+      for (int i = 0; i < 41; i++)
+        EXPECT_NEAR( support(i,j).v(), patches(k, j*41 + i), 1e-4 );
+  }
+}
+
+TEST( Descriptor, BatchedSGrad ) {
+  ImageView<PixelGray<float>> image;
+  InterestPointList batched;
+  make_test_data(image, batched);
+  InterestPointList single = batched;
+
+  // The batched path, and the one point at a time path of the base class
+  SGradDescriptorGenerator generator;
+  generator(image, batched);
+  DescriptorGeneratorBase<SGradDescriptorGenerator>& base = generator;
+  base(image, single.begin(), single.end());
+
+  InterestPointList::iterator it1 = batched.begin(), it2 = single.begin();
+  for (; it1 != batched.end(); ++it1, ++it2) {
+    ASSERT_EQ( 180u, it1->descriptor.size() );
+    ASSERT_EQ( 180u, it2->descriptor.size() );
+    for (size_t d = 0; d < 180; d++)
+      EXPECT_NEAR( it2->descriptor[d], it1->descriptor[d], 1e-3 );
+  }
+}
+
+TEST( Descriptor, BatchedPCAProjection ) {
+  const int num_patches = 7, dim = 41*41, k = 9;
+  Matrix<float> patches(num_patches, dim), basis(dim, k);
+  Vector<float> avg(dim);
+  for (int d = 0; d < dim; d++) {
+    avg[d] = 0.01*cos(d);
+    for (int c = 0; c < k; c++)
+      basis(d, c) = sin(0.1*d + c);
+    for (int r = 0; r < num_patches; r++)
+      patches(r, d) = 1.0 + sin(0.01*d*(r+1));
+  }
+
+  Matrix<float> descriptors;
+  pca_sift_descriptors(patches, basis, avg, descriptors);
+  ASSERT_EQ( size_t(num_patches), descriptors.rows() );
+  ASSERT_EQ( size_t(k),           descriptors.cols() );
+
+  for (int r = 0; r < num_patches; r++) {
+    double norm = 0;
+    for (int d = 0; d < dim; d++)
+      norm += patches(r, d) * patches(r, d);
+    norm = sqrt(norm);
+    for (int c = 0; c < k; c++) {
+      double expected = 0;
+      for (int d = 0; d < dim; d++)
+        expected += (patches(r, d) / norm - avg[d]) * basis(d, c);
+      EXPECT_NEAR( expected, descriptors(r, c), 1e-3 );
+    }
+  }
+}
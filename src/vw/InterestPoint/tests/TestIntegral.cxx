@@ -251,3 +251,101 @@ TEST( Integral, InterpolationProof ) {
 }
 
 #endif
+
+// Deterministic test pattern, so no test images are needed
+static float test_pattern(int i, int j) {
+  return float((i*7 + j*13 + (i*j) % 11) % 17) / 17.0f;
+}
+
+TEST( Integral, FastIntegralSumming ) {
+  ImageView<float> image(37, 23);
+  for (int j = 0; j < image.rows(); j++)
+    for (int i = 0; i < image.cols(); i++)
+      image(i,j) = test_pattern(i,j);
+
+  ImageView<float> integral = IntegralImage( image );
+  ASSERT_EQ( 38, integral.cols() );
+  ASSERT_EQ( 24, integral.rows() );
+
+  for (int j = 0; j < integral.rows(); j++) {
+    for (int i = 0; i < integral.cols(); i++) {
+      double actual_sum = 0;
+      for (int y = 0; y < j; y++)
+        for (int x = 0; x < i; x++)
+          actual_sum += image(x,y);
+      EXPECT_NEAR( actual_sum, integral(i,j), 1e-3 );
+    }
+  }
+}
+
+TEST( Integral, FastIntegralThreads ) {
+  // Big enough that the work is split across threads
+  ImageView<float> image(601, 530);
+  for (int j = 0; j < image.rows(); j++)
+    for (int i = 0; i < image.cols(); i++)
+      image(i,j) = test_pattern(i,j);
+
+  ImageView<float> single = integral_image( image, 1 );
+  ImageView<float> multi  = integral_image( image, 4 );
+  for (int j = 0; j < single.rows(); j++)
+    for (int i = 0; i < single.cols(); i++)
+      ASSERT_EQ( single(i,j), multi(i,j) );
+}
+
+TEST( Integral, IntegerIntegral ) {
+  ImageView<uint8>  image8 (45, 31);
+  ImageView<uint16> image16(45, 31);
+  for (int j = 0; j < image8.rows(); j++) {
+    for (int i = 0; i < image8.cols(); i++) {
+      image8 (i,j) = uint8 (255 * test_pattern(i,j));
+      image16(i,j) = uint16(65535 * test_pattern(i,j));
+    }
+  }
+
+  ImageView<uint32> integral8  = integral_image( image8 );
+  ImageView<uint64> integral16 = integral_image( image16 );
+  for (int j = 0; j < integral8.rows(); j++) {
+    for (int i = 0; i < integral8.cols(); i++) {
+      uint32 sum8 = 0;
+      uint64 sum16 = 0;
+      for (int y = 0; y < j; y++) {
+        for (int x = 0; x < i; x++) {
+          sum8  += image8 (x,y);
+          sum16 += image16(x,y);
+        }
+      }
+      EXPECT_EQ( sum8,  integral8 (i,j) );
+      EXPECT_EQ( sum16, integral16(i,j) );
+    }
+  }
+}
+
+TEST( Integral, HessianResponse ) {
+  ImageView<float> image(80, 70);
+  for (int j = 0; j < image.rows(); j++)
+    for (int i = 0; i < image.cols(); i++)
+      image(i,j) = test_pattern(i,j);
+  ImageView<float> integral = IntegralImage( image );
+
+  for (unsigned filter_size = 9; filter_size <= 27; filter_size += 6) {
+    ImageView<float> dxx, dyy, dxy;
+    HessianResponse( integral, filter_size, dxx, dyy, dxy );
+    ASSERT_EQ( image.cols(), dxx.cols() );
+    ASSERT_EQ( image.rows(), dxx.rows() );
+
+    int lobe = filter_size / 3;
+    int margin = lobe + lobe / 2;
+    for (int y = 0; y < image.rows(); y++) {
+      for (int x = 0; x < image.cols(); x++) {
+        if (x < margin || y < margin ||
+            x >= integral.cols() - 1 - margin || y >= integral.rows() - 1 - margin) {
+          EXPECT_EQ( 0, dxx(x,y) );
+          continue;
+        }
+        EXPECT_NEAR( XSecondDerivative( integral, x, y, filter_size ), dxx(x,y), 1e-5 );
+        EXPECT_NEAR( YSecondDerivative( integral, x, y, filter_size ), dyy(x,y), 1e-5 );
+        EXPECT_NEAR( XYDerivative     ( integral, x, y, filter_size ), dxy(x,y), 1e-5 );
+      }
+    }
+  }
+}
@@ -0,0 +1,88 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2013, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <gtest/gtest_VW.h>
+#include <test/Helpers.h>
+#include <vw/InterestPoint/InterestPointGrid.h>
+
+#include <algorithm>
+
+using namespace vw;
+using namespace vw::ip;
+
+TEST( InterestPointGrid, Search ) {
+  std::vector<InterestPoint> ip;
+  for (int j = -10; j < 10; j++)
+    for (int i = -10; i < 10; i++)
+      ip.push_back(InterestPoint(i * 3.0 + 0.5, j * 2.0 + 0.25));
+
+  InterestPointGrid grid(ip, 4.0);
+  EXPECT_EQ( ip.size(), grid.size() );
+
+  // Compare against a brute force search, over small and large areas
+  const double boxes[3][4] = {{-5, -3, 7, 4}, {-100, -100, 100, 100}, {1, 1, 1.4, 1.1}};
+  for (int b = 0; b < 3; b++) {
+    std::vector<size_t> found, expected;
+    grid.box_search(boxes[b][0], boxes[b][1], boxes[b][2], boxes[b][3], found);
+    for (size_t i = 0; i < ip.size(); i++)
+      if (ip[i].x >= boxes[b][0] && ip[i].x <= boxes[b][2] &&
+          ip[i].y >= boxes[b][1] && ip[i].y <= boxes[b][3])
+        expected.push_back(i);
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ( expected, found );
+  }
+
+  std::vector<size_t> found, expected;
+  grid.radius_search(2.0, -1.0, 5.5, found);
+  for (size_t i = 0; i < ip.size(); i++)
+    if ((ip[i].x - 2.0)*(ip[i].x - 2.0) + (ip[i].y + 1.0)*(ip[i].y + 1.0) <= 5.5*5.5)
+      expected.push_back(i);
+  std::sort(found.begin(), found.end());
+  EXPECT_EQ( expected, found );
+
+  EXPECT_TRUE ( grid.any_within_radius(0.6, 0.3, 0.2) );
+  EXPECT_FALSE( grid.any_within_radius(2.0, 1.25, 0.5) );
+  EXPECT_FALSE( grid.any_within_radius(500, 500, 10) );
+}
+
+TEST( InterestPointGrid, CullPerCell ) {
+  std::vector<InterestPoint> ip1, ip2;
+  for (int i = 0; i < 20; i++) {
+    // Two cells of ten points each, 10 pixels wide
+    ip1.push_back(InterestPoint(i, 1, 1.0, float(i % 7)));
+    ip2.push_back(InterestPoint(0, i, 1.0, 3.0));
+  }
+  std::vector<InterestPoint> ip = ip1;
+  cull_per_cell(ip, 10.0, 3);
+  ASSERT_EQ( 6u, ip.size() );
+  // The three most interesting in each cell, still in order. Ties go to the
+  // earlier point.
+  const float expected_x[6] = {4, 5, 6, 12, 13, 19};
+  for (size_t i = 0; i < ip.size(); i++)
+    EXPECT_EQ( expected_x[i], ip[i].x );
+
+  // For matches the smaller interest of the pair counts
+  cull_matches_per_cell(ip1, ip2, 10.0, 2);
+  ASSERT_EQ( 4u, ip1.size() );
+  ASSERT_EQ( 4u, ip2.size() );
+  EXPECT_EQ( 3, ip1[0].x );
+  EXPECT_EQ( 4, ip1[1].x );
+  EXPECT_EQ( 10, ip1[2].x );
+  EXPECT_EQ( 11, ip1[3].x );
+  EXPECT_EQ( ip1[3].x, ip2[3].y );
+}
@@ -20,6 +20,7 @@
 #include <gtest/gtest_VW.h>
 
 #include <vw/InterestPoint/Matcher.h>
+#include <vw/InterestPoint/MatcherIO.h>
 #include <vw/InterestPoint/InterestPoint.h>
 #include <test/Helpers.h>
 
@@ -27,6 +28,7 @@
 
 using namespace vw;
 using namespace vw::ip;
+using namespace vw::test;
 
 TEST( Matcher, IPComparison ) {
   std::list<InterestPoint> ip_list;
@@ -137,4 +139,115 @@ TEST( Matcher, Matcher ) {
   EXPECT_EQ( matched_indexes[0], 3 );
 }
 
+TEST( Matcher, MatchIndexed ) {
+  std::vector<InterestPoint> ip1_list, ip2_list;
+  for (int i = 0; i < 5; i++) {
+    InterestPoint ip1(i, 0, 1.0, 1.0, 0.0), ip2(0, i, 1.0, 1.0, 0.0);
+    ip1.descriptor = Vector3(10*i + 0.1, 0, 0);
+    ip2.descriptor = Vector3(10*(4-i), 0, 0);
+    ip1_list.push_back(ip1);
+    ip2_list.push_back(ip2);
+  }
+
+  std::string flann_method = "kmeans";
+  UnlinkName cache("matcher_index.flann");
+  std::vector<boost::shared_ptr<InterestPointIndex>> indices;
+  indices.push_back(boost::shared_ptr<InterestPointIndex>
+                    (new InterestPointIndex(ip2_list, math::FLANN_DistType_L2, flann_method)));
+  indices.push_back(boost::shared_ptr<InterestPointIndex>
+                    (new InterestPointIndex(ip2_list, math::FLANN_DistType_L2, flann_method,
+                                            cache)));
+  EXPECT_FALSE( indices[1]->loaded_from_cache() );
+
+  // The second time the index is read from disk
+  indices.push_back(boost::shared_ptr<InterestPointIndex>
+                    (new InterestPointIndex(ip2_list, math::FLANN_DistType_L2, flann_method,
+                                            cache)));
+  EXPECT_TRUE( indices[2]->loaded_from_cache() );
+
+  InterestPointMatcher<L2NormMetric,NullConstraint> matcher(flann_method);
+  std::vector<std::vector<size_t>> index_lists;
+  matcher.match_indexed(ip1_list, indices, index_lists);
+  ASSERT_EQ( 3u, index_lists.size() );
+
+  // Each index gives the same result as matching the lists directly
+  std::vector<size_t> expected;
+  matcher(ip1_list, ip2_list, expected);
+  for (size_t k = 0; k < index_lists.size(); k++) {
+    ASSERT_EQ( ip1_list.size(), index_lists[k].size() );
+    for (size_t i = 0; i < ip1_list.size(); i++) {
+      EXPECT_EQ( 4 - i, index_lists[k][i] );
+      EXPECT_EQ( expected[i], index_lists[k][i] );
+    }
+  }
+}
 
+TEST( Matcher, FlannIndexFilename ) {
+  std::vector<InterestPoint> ip(2);
+  ip[0].descriptor = Vector2(1, 2);
+  ip[1].descriptor = Vector2(3, 4);
+  std::string name = flann_index_filename("run/img.vwip", ip, "kmeans",
+                                          math::FLANN_DistType_L2);
+  EXPECT_EQ( 0u, name.find("run/img-") );
+  EXPECT_EQ( name.size() - 6, name.rfind(".flann") );
+
+  // Any change to what the index depends on changes the name
+  EXPECT_NE( name, flann_index_filename("run/img.vwip", ip, "kdtree",
+                                        math::FLANN_DistType_L2) );
+  ip[1].descriptor[0] = 5;
+  EXPECT_NE( name, flann_index_filename("run/img.vwip", ip, "kmeans",
+                                        math::FLANN_DistType_L2) );
+}
+
+TEST( Matcher, RemoveDuplicatesRadius ) {
+  std::vector<InterestPoint> ip1, ip2;
+  ip1.push_back(InterestPoint(10, 10));   ip2.push_back(InterestPoint(50, 50));
+  ip1.push_back(InterestPoint(10.5, 10)); ip2.push_back(InterestPoint(80, 80)); // near in ip1
+  ip1.push_back(InterestPoint(30, 30));   ip2.push_back(InterestPoint(50.4, 50.4)); // near in ip2
+  ip1.push_back(InterestPoint(60, 60));   ip2.push_back(InterestPoint(90, 90));
+
+  // No radius is the same as exact duplicate removal
+  std::vector<InterestPoint> exact1 = ip1, exact2 = ip2;
+  remove_duplicates(exact1, exact2, 0.0);
+  EXPECT_EQ( 4u, exact1.size() );
+
+  // The last of each group of duplicates is kept. The first match is near
+  // the second in ip1 and the third in ip2, so only it is dropped.
+  remove_duplicates(ip1, ip2, 1.0);
+  ASSERT_EQ( 3u, ip1.size() );
+  ASSERT_EQ( 3u, ip2.size() );
+  EXPECT_EQ( 10.5, ip1[0].x );
+  EXPECT_EQ( 30,   ip1[1].x );
+  EXPECT_EQ( 60,   ip1[2].x );
+  EXPECT_EQ( 80,   ip2[0].x );
+}
+
+TEST( Matcher, PositionConstrainedMatch ) {
+  // Points on a grid, with descriptors that repeat every 20 pixels, and a
+  // second image shifted by (5, -3).
+  std::vector<InterestPoint> ip1, ip2;
+  for (int j = 0; j < 10; j++) {
+    for (int i = 0; i < 10; i++) {
+      InterestPoint p1(i * 10, j * 10), p2(i * 10 - 5, j * 10 + 3);
+      p1.descriptor = Vector3(i % 2, j % 2, 0.1 * ((i + j) % 3));
+      p2.descriptor = p1.descriptor;
+      ip1.push_back(p1);
+      ip2.push_back(p2);
+    }
+  }
+
+  // Without the constraint the descriptors are ambiguous. With a window
+  // around the true shift each point matches its counterpart.
+  PositionConstraint constraint(3, 7, -5, -1);
+  std::vector<size_t> index_list;
+  match_with_position_constraint(ip1, ip2, constraint, 0.8, index_list, L2NormMetric());
+  ASSERT_EQ( ip1.size(), index_list.size() );
+  for (size_t i = 0; i < ip1.size(); i++)
+    EXPECT_EQ( i, index_list[i] );
+
+  // A window with nothing in it gives no matches
+  match_with_position_constraint(ip1, ip2, PositionConstraint(-2, -1, -2, -1), 0.8,
+                                 index_list, L2NormMetric());
+  for (size_t i = 0; i < ip1.size(); i++)
+    EXPECT_EQ( (size_t)(-1), index_list[i] );
+}
@@ -22,6 +22,10 @@
 #include <flann/flann.hpp>
 #pragma GCC diagnostic pop
 
+#include <boost/filesystem/operations.hpp>
+
+namespace fs = boost::filesystem;
+
 namespace vw {
 namespace math {
 
@@ -182,11 +186,78 @@ void construct_index_aux(void* data_ptr, size_t num_features, size_t cols,
   }; // end switch
 }
 
+// Read an index saved by save_index_aux(). FLANN throws if the file is not
+// a saved index of this type, in which case the index is built instead.
+template <class DistanceT>
+bool load_index_aux(void* data_ptr, size_t num_features, size_t cols,
+                    std::string const& index_file, void* & index_ptr) {
+  typedef typename DistanceT::ElementType ElemT;
+
+  if (index_ptr != NULL)
+    vw_throw(IOErr() << "FLANNTree: Void ptr is not null, this is unexpected.");
+  if (index_file.empty() || !fs::exists(index_file))
+    return false;
+
+  flann::Index<DistanceT>* index = NULL;
+  try {
+    index = new flann::Index<DistanceT>(
+        flann::Matrix<ElemT>((ElemT*)data_ptr, num_features, cols),
+        flann::SavedIndexParams(index_file), DistanceT());
+  } catch (const std::exception& e) {
+    vw_out(WarningMessage) << "FLANNTree: Ignoring unreadable index " << index_file
+                           << ": " << e.what() << "\n";
+    return false;
+  }
+  if (index->size() != num_features || index->veclen() != cols) {
+    vw_out(WarningMessage) << "FLANNTree: Ignoring index " << index_file
+                           << " made for different data.\n";
+    delete index;
+    return false;
+  }
+
+  index_ptr = index;
+  return true;
+}
+
+// Save an index. A failure here only costs rebuilding the index next time,
+// so it is not an error. The index is written to a temporary file which is
+// then renamed, so that other processes never see a partial file.
+template <class DistanceT>
+void save_index_aux(void* index_ptr, std::string const& index_file) {
+  if (index_ptr == NULL || index_file.empty())
+    return;
+  fs::path tmp_file = fs::path(index_file).parent_path() /
+    fs::unique_path(fs::path(index_file).filename().string() + ".%%%%%%%%");
+  try {
+    reinterpret_cast<flann::Index<DistanceT>*>(index_ptr)->save(tmp_file.string());
+    fs::rename(tmp_file, index_file);
+  } catch (const std::exception& e) {
+    boost::system::error_code ec;
+    fs::remove(tmp_file, ec);
+    vw_out(WarningMessage) << "FLANNTree: Could not save the index to " << index_file
+                           << ": " << e.what() << "\n";
+  }
+}
+
 template <>
 void FLANNTree<float>::construct_index(void* data_ptr, size_t num_features, size_t cols) {
   construct_index_aux<float>(data_ptr, num_features, cols, m_flann_method, m_dist_type, m_index_ptr);
 }
 
+template <>
+bool FLANNTree<float>::load_index(void* data_ptr, size_t num_features, size_t cols,
+                                  std::string const& index_file) {
+  if (m_dist_type != FLANN_DistType_L2)
+    vw_throw(IOErr() << "FLANNTree: Illegal distance type passed in.");
+  return load_index_aux<flann::L2<float>>(data_ptr, num_features, cols, index_file, m_index_ptr);
+}
+
+template <>
+void FLANNTree<float>::save_index(std::string const& index_file) {
+  if (m_dist_type == FLANN_DistType_L2)
+    save_index_aux<flann::L2<float>>(m_index_ptr, index_file);
+}
+
 template <>
 FLANNTree<float>::~FLANNTree() {
   switch (m_dist_type) {
@@ -254,6 +325,20 @@ void FLANNTree<double>::construct_index(void* data_ptr, size_t rows, size_t cols
   construct_index_aux<double>(data_ptr, rows, cols, m_flann_method, m_dist_type, m_index_ptr);
 }
 
+template <>
+bool FLANNTree<double>::load_index(void* data_ptr, size_t rows, size_t cols,
+                                   std::string const& index_file) {
+  if (m_dist_type != FLANN_DistType_L2)
+    vw_throw(IOErr() << "FLANNTree: Illegal distance type passed in.");
+  return load_index_aux<flann::L2<double>>(data_ptr, rows, cols, index_file, m_index_ptr);
+}
+
+template <>
+void FLANNTree<double>::save_index(std::string const& index_file) {
+  if (m_dist_type == FLANN_DistType_L2)
+    save_index_aux<flann::L2<double>>(m_index_ptr, index_file);
+}
+
 template <>
 FLANNTree<double>::~FLANNTree() {
   switch(m_dist_type) {
@@ -329,6 +414,21 @@ void FLANNTree<unsigned char>::construct_index(void* data_ptr, size_t rows, size
   construct_index_aux<unsigned char>(data_ptr, rows, cols, m_flann_method, m_dist_type, m_index_ptr);
 }
 
+template <>
+bool FLANNTree<unsigned char>::load_index(void* data_ptr, size_t rows, size_t cols,
+                                          std::string const& index_file) {
+  if (m_dist_type != FLANN_DistType_Hamming)
+    vw_throw(IOErr() << "FLANNTree: Illegal distance type passed in.");
+  return load_index_aux<flann::Hamming<unsigned char>>(data_ptr, rows, cols, index_file,
+                                                       m_index_ptr);
+}
+
+template <>
+void FLANNTree<unsigned char>::save_index(std::string const& index_file) {
+  if (m_dist_type == FLANN_DistType_Hamming)
+    save_index_aux<flann::Hamming<unsigned char>>(m_index_ptr, index_file);
+}
+
 template <>
 FLANNTree<unsigned char>::~FLANNTree() {
   switch(m_dist_type) {
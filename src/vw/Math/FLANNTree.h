@@ -23,6 +23,7 @@
 #include <vw/Core/Log.h>
 
 #include <stddef.h>
+#include <string>
 
 #include <boost/noncopyable.hpp>
 
@@ -59,6 +60,11 @@ private:
   /// Make a FLANN index wrapping a matrix of feature data
   void construct_index(void* data_ptr, size_t rows, size_t cols);
 
+  /// Read a FLANN index over a matrix of feature data from disk. Returns
+  /// false, leaving no index, if the file is missing or cannot be used.
+  bool load_index(void* data_ptr, size_t rows, size_t cols,
+                  std::string const& index_file);
+
 public: // Functions
 
   /// Simple constructor. Call load_match_data() before calling knn_search()!
@@ -86,6 +92,31 @@ public: // Functions
     //         << m_features_cast.cols() << "\n";
   }
 
+  /// As load_match_data() above, but read the index from index_file if it
+  /// exists, and otherwise build it and write it there. The file must have
+  /// been made from the same features, FLANN method and distance type, so
+  /// its name should encode these. Returns true if the index was read.
+  template <class MatrixT>
+  bool load_match_data(MatrixBase<MatrixT> const& features, FLANN_DistType dist_type,
+                       std::string const& index_file) {
+    if (features.impl().rows() == 0)
+      vw_throw(ArgumentErr() << "Cannot create a FLANN tree with no input data!");
+    m_dist_type           = dist_type;
+    m_features_cast       = features;
+    m_num_features_loaded = m_features_cast.rows();
+    if (load_index((void*)&m_features_cast(0,0), m_features_cast.rows(),
+                   m_features_cast.cols(), index_file))
+      return true;
+    construct_index((void*)&m_features_cast(0,0), m_features_cast.rows(), 
+                    m_features_cast.cols());
+    save_index(index_file);
+    return false;
+  }
+
+  /// Write the index made by load_match_data() to disk. The features are
+  /// not saved, they must be passed in again when loading the index.
+  void save_index(std::string const& index_file);
+
   /// Multiple query access via VW's Matrix
   template <class MatrixT>
   size_t knn_search(MatrixBase<MatrixT> const& query, // Values we are looking for
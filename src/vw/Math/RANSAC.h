@@ -50,6 +50,10 @@
 ///    set of points, this routine could compute the 2-norm of the
 ///    error: || p2 - H * p1 ||
 ///
+/// PreemptiveSampleConsensus takes the same functors. It scores batches
+/// of hypotheses on growing subsets of the data, can use per-match
+/// quality values to guide sampling, and spreads the work across threads.
+///
 
 #ifndef __VW_MATH_RANSAC_H__
 #define __VW_MATH_RANSAC_H__
@@ -58,6 +62,12 @@
 #include <vw/Core/Log.h>
 #include <vw/Core/Settings.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
 namespace vw {
 namespace math {
 
@@ -105,9 +115,49 @@ namespace math {
   /// points using RANSAC.
   typedef HomogeneousL2NormErrorMetric<2> InterestPointErrorMetric;
 
+  /// \cond INTERNAL
+  // Utility function: Pick n unique, random integers in the range
+  // [0, size).
+
+  // TODO(oalexan1): If we have to pick 999 random integers out of
+  // 1000, this algorithm will do quite badly, as it will take very
+  // many attempts to get this subset, apart from the quadratic
+  // complexity of each attempt. But if we have to pick as small
+  // subset out of a big set, this is fine.
+
+  // Note: We do not modify the initial random seed. As such, if a
+  // program uses RANSAC, repeatedly running this program will
+  // always return the same results. However, if that program calls
+  // RANSAC twice while within the same instance of the program, the
+  // second time the result of RANSAC will be different, since we
+  // keep on pulling new random numbers.
+
+  // This function is not thread-safe, as rand() is not thread-safe,
+  // which can be a potential problem.
+
+  inline void get_n_unique_integers(int size, std::vector<int> & samples) {
+
+    int n = samples.size();
+    VW_ASSERT(size >= n, ArgumentErr() << "Not enough samples (" << n << " / " << size << ")\n");
+
+    const double divisor = static_cast<double>(RAND_MAX) + 1.0;
+    for (int i = 0; i < n; ++i) {
+      bool done = false;
+      while (!done) {
+        samples[i] = static_cast<int>( (static_cast<double>(std::rand()) / divisor) * size );
+        done = true;
+        for (int j = 0; j < i; j++)
+          if (samples[i] == samples[j])
+            done = false;
+      }
+    }
+  }
+  /// \endcond
+
   /// RANSAC Driver class
   template <class FittingFuncT, class ErrorFuncT>
   class RandomSampleConsensus {
+  protected:
     const FittingFuncT& m_fitting_func;
     const ErrorFuncT  & m_error_func;
           int           m_num_iterations;
@@ -115,45 +165,6 @@ namespace math {
           int           m_min_num_output_inliers;
           bool          m_reduce_min_num_output_inliers_if_no_fit;
           int           m_num_threads;
-    
-    /// \cond INTERNAL
-    // Utility function: Pick n unique, random integers in the range
-    // [0, size). 
-          
-    // TODO(oalexan1): If we have to pick 999 random integers out of
-    // 1000, this algorithm will do quite badly, as it will take very
-    // many attempts to get this subset, apart from the quadratic
-    // complexity of each attempt. But if we have to pick as small
-    // subset out of a big set, this is fine.
-
-    // Note: We do not modify the initial random seed. As such, if a
-    // program uses RANSAC, repeatedly running this program will
-    // always return the same results. However, if that program calls
-    // RANSAC twice while within the same instance of the program, the
-    // second time the result of RANSAC will be different, since we
-    // keep on pulling new random numbers.
-
-    // This function is not thread-safe, as rand() is not thread-safe,
-    // which can be a potential problem.
-
-    inline void get_n_unique_integers(int size, std::vector<int> & samples) const {
-
-      int n = samples.size();
-      VW_ASSERT(size >= n, ArgumentErr() << "Not enough samples (" << n << " / " << size << ")\n");
-
-      const double divisor = static_cast<double>(RAND_MAX) + 1.0;
-      for (int i = 0; i < n; ++i) {
-        bool done = false;
-        while (!done) {
-          samples[i] = static_cast<int>( (static_cast<double>(std::rand()) / divisor) * size );
-          done = true;
-          for (int j = 0; j < i; j++)
-            if (samples[i] == samples[j])
-              done = false;
-        }
-      }
-    }
-    /// \endcond
 
   public:
 
@@ -352,6 +363,311 @@ namespace math {
     return ransac_instance(p1,p2);
   }
 
+  /// Preemptive RANSAC driver class.
+  ///
+  /// RandomSampleConsensus scores every hypothesis against all of the
+  /// data. Here hypotheses are instead generated in batches and scored on
+  /// successive blocks of the data, in a random order. After each block
+  /// only the best scoring half of the hypotheses is kept, so most of them
+  /// are discarded after seeing a small fraction of the data (Nister,
+  /// "Preemptive RANSAC for live structure and motion estimation", 2003).
+  /// The batch winner is scored on all the data, and batches continue
+  /// until enough hypotheses were tried for the best inlier ratio found so
+  /// far, as in ARRSAC (Raguram et al., 2008).
+  ///
+  /// If a quality value is given for each match, for example the interest
+  /// of the matched interest points, samples are drawn as in PROSAC (Chum
+  /// and Matas, 2005): first from the best matches, then from a growing
+  /// pool, until sampling is uniform by the end of the hypothesis budget.
+  ///
+  /// Fitting and scoring are spread across threads. All random choices are
+  /// made up front, so the result does not depend on the number of threads.
+  template <class FittingFuncT, class ErrorFuncT>
+  class PreemptiveSampleConsensus:
+    public RandomSampleConsensus<FittingFuncT, ErrorFuncT> {
+
+    typedef RandomSampleConsensus<FittingFuncT, ErrorFuncT> Base;
+    typedef typename FittingFuncT::result_type result_type;
+
+    int    m_batch_size;  ///< Hypotheses generated at a time
+    int    m_block_size;  ///< Matches scored before each round of preemption
+    double m_confidence;  ///< Probability of drawing an all-inlier sample
+
+    /// \cond INTERNAL
+    struct Hypothesis {
+      result_type H;
+      bool   valid;
+      int    num_inliers;
+      double error_sum; // Sum of the inlier errors, used to break ties
+      Hypothesis(): valid(false), num_inliers(0), error_sum(0.0) {}
+      bool operator<(Hypothesis const& other) const { // true if better
+        if (valid != other.valid)
+          return valid;
+        if (num_inliers != other.num_inliers)
+          return num_inliers > other.num_inliers;
+        return error_sum < other.error_sum;
+      }
+    };
+
+    /// PROSAC sampling state. The pool is the first 'n' entries of the
+    /// matches sorted by decreasing quality.
+    struct ProsacState {
+      int    m, N, n, t;
+      double t_n, t_n_prime;
+      ProsacState(int m_, int N_, int budget): m(m_), N(N_), n(m_), t(0), t_n_prime(1.0) {
+        // Expected number of samples from the top m matches among 'budget'
+        // uniform samples.
+        t_n = budget;
+        for (int i = 0; i < m; i++)
+          t_n *= double(m - i) / double(N - i);
+      }
+      /// Draw the next sample as positions in the sorted order
+      void draw(std::vector<int> & sample) {
+        t++;
+        if (t > t_n_prime && n < N) {
+          double t_n_next = t_n * double(n + 1) / double(n + 1 - m);
+          t_n_prime += std::ceil(t_n_next - t_n);
+          t_n = t_n_next;
+          n++;
+        }
+        if (t_n_prime < t) { // Sample the whole pool
+          sample.resize(m);
+          get_n_unique_integers(n, sample);
+        } else { // Always include the newest match in the pool
+          sample.resize(m - 1);
+          get_n_unique_integers(n - 1, sample);
+          sample.push_back(n - 1);
+        }
+      }
+    };
+
+    /// Add the errors of the matches at positions [begin, end) of 'order'
+    /// to a hypothesis score.
+    template <class ContainerT1, class ContainerT2>
+    void score(Hypothesis & hyp, std::vector<int> const& order,
+               size_t begin, size_t end,
+               std::vector<ContainerT1> const& p1,
+               std::vector<ContainerT2> const& p2) const {
+      for (size_t i = begin; i < end; i++) {
+        double err = this->m_error_func(hyp.H, p1[order[i]], p2[order[i]]);
+        if (err < this->m_inlier_threshold) {
+          hyp.num_inliers++;
+          hyp.error_sum += err;
+        }
+      }
+    }
+    /// \endcond
+
+  public:
+
+    /// Constructor. The arguments are as for RandomSampleConsensus, with
+    /// num_iterations the most hypotheses that will be generated.
+    PreemptiveSampleConsensus(FittingFuncT const& fitting_func,
+                              ErrorFuncT   const& error_func,
+                              int    num_iterations,
+                              double inlier_threshold,
+                              int    min_num_output_inliers,
+                              bool   reduce_min_num_output_inliers_if_no_fit = false,
+                              int    num_threads = vw::vw_settings().default_num_threads(),
+                              int    batch_size  = 256,
+                              int    block_size  = 100,
+                              double confidence  = 0.999):
+      Base(fitting_func, error_func, num_iterations, inlier_threshold,
+           min_num_output_inliers, reduce_min_num_output_inliers_if_no_fit, num_threads),
+      m_batch_size(std::max(batch_size, 1)), m_block_size(std::max(block_size, 1)),
+      m_confidence(confidence) {}
+
+    /// As attempt_ransac but keep trying with smaller numbers of required
+    /// inliers. See attempt_ransac() for the meaning of 'quality'.
+    template <class ContainerT1, class ContainerT2>
+    result_type operator()(std::vector<ContainerT1> const& p1,
+                           std::vector<ContainerT2> const& p2,
+                           std::vector<double> const& quality = std::vector<double>()) {
+      result_type H;
+      bool success = false;
+
+      for (int attempt = 0; attempt < 10; attempt++){
+        try{
+          H = attempt_ransac(p1, p2, quality);
+          success = true;
+          break;
+        } catch ( const std::exception& e ) {
+          vw_out() << e.what() << "\n";
+          if (!this->m_reduce_min_num_output_inliers_if_no_fit)
+            break;
+          this->reduce_min_num_output_inliers();
+          if (this->m_min_num_output_inliers < 2) // Can't compute a transform with 1 or 0 samples
+            break;
+          vw_out() << "Attempting RANSAC with " << this->m_min_num_output_inliers << " inliers.\n";
+        }
+      }
+
+      if (!success)
+        vw_throw( RANSACErr() << "RANSAC was unable to find a fit that matched the supplied data.");
+
+      return H;
+    }
+
+    /// Run preemptive RANSAC on two input data lists using the current
+    /// parameters. If 'quality' is not empty it must have one entry per
+    /// match, larger meaning more likely to be an inlier, and it is used
+    /// to guide the sampling.
+    template <class ContainerT1, class ContainerT2>
+    result_type attempt_ransac(std::vector<ContainerT1> const& p1,
+                               std::vector<ContainerT2> const& p2,
+                               std::vector<double> const& quality = std::vector<double>()) const {
+
+      VW_ASSERT( !p1.empty(),
+                 RANSACErr() << "RANSAC Error.  Insufficient data.\n");
+      VW_ASSERT( p1.size() == p2.size(),
+                 RANSACErr() << "RANSAC Error.  Data vectors are not the same size." );
+      VW_ASSERT( quality.empty() || quality.size() == p1.size(),
+                 RANSACErr() << "RANSAC Error.  Need one quality value per match." );
+
+      int num_matches       = p1.size();
+      int min_elems_for_fit = this->m_fitting_func.min_elements_needed_for_fit(p1[0]);
+
+      VW_ASSERT( num_matches >= min_elems_for_fit,
+                 RANSACErr() << "RANSAC Error.  Not enough potential matches for this fitting functor. (" << p1.size() << "/" << min_elems_for_fit << ")\n");
+
+      VW_ASSERT( this->m_min_num_output_inliers >= min_elems_for_fit,
+                 RANSACErr() << "RANSAC Error.  Number of requested inliers is less than min number of elements needed for fit. (" << this->m_min_num_output_inliers << "/" << min_elems_for_fit << ")\n");
+
+      // Matches sorted by decreasing quality, for sampling
+      std::vector<int> sorted(num_matches);
+      for (int i = 0; i < num_matches; i++)
+        sorted[i] = i;
+      if (!quality.empty())
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [&quality](int a, int b) { return quality[a] > quality[b]; });
+
+      // Random order in which the matches are scored
+      std::vector<int> order(sorted);
+      const double divisor = static_cast<double>(RAND_MAX) + 1.0;
+      for (int i = num_matches - 1; i > 0; i--) {
+        int j = static_cast<int>((static_cast<double>(std::rand()) / divisor) * (i + 1));
+        std::swap(order[i], order[j]);
+      }
+
+      ProsacState prosac(min_elems_for_fit, num_matches, this->m_num_iterations);
+      Hypothesis best;
+      int num_generated = 0;
+      while (num_generated < this->m_num_iterations) {
+
+        // 1. Draw a batch of samples. This uses rand() so is not threaded.
+        int batch = std::min(m_batch_size, this->m_num_iterations - num_generated);
+        std::vector<std::vector<int>> samples(batch);
+        for (int k = 0; k < batch; k++) {
+          if (quality.empty()) {
+            samples[k].resize(min_elems_for_fit);
+            get_n_unique_integers(num_matches, samples[k]);
+          } else {
+            prosac.draw(samples[k]);
+            for (size_t i = 0; i < samples[k].size(); i++)
+              samples[k][i] = sorted[samples[k][i]];
+          }
+        }
+        num_generated += batch;
+
+        // 2. Fit a hypothesis to each sample
+        std::vector<Hypothesis> hyps(batch);
+        #pragma omp parallel for num_threads(this->m_num_threads) schedule(dynamic)
+        for (int k = 0; k < batch; k++) {
+          std::vector<ContainerT1> try1(min_elems_for_fit);
+          std::vector<ContainerT2> try2(min_elems_for_fit);
+          for (int i = 0; i < min_elems_for_fit; i++) {
+            try1[i] = p1[samples[k][i]];
+            try2[i] = p2[samples[k][i]];
+          }
+          try {
+            hyps[k].H     = this->m_fitting_func(try1, try2);
+            hyps[k].valid = true;
+          } catch (const std::exception&) {
+            // Degenerate sample, leave the hypothesis invalid
+          }
+        }
+
+        // 3. Score the surviving hypotheses block by block, halving their
+        //    number after each block.
+        std::vector<Hypothesis*> alive;
+        for (int k = 0; k < batch; k++)
+          if (hyps[k].valid)
+            alive.push_back(&hyps[k]);
+        size_t num_scored = 0;
+        while (num_scored < size_t(num_matches) && alive.size() > 1) {
+          size_t block_end = std::min(num_scored + m_block_size, size_t(num_matches));
+          int num_alive = alive.size();
+          #pragma omp parallel for num_threads(this->m_num_threads) schedule(static)
+          for (int k = 0; k < num_alive; k++)
+            score(*alive[k], order, num_scored, block_end, p1, p2);
+          num_scored = block_end;
+          std::stable_sort(alive.begin(), alive.end(),
+                           [](Hypothesis const* a, Hypothesis const* b) { return *a < *b; });
+          size_t keep = std::max(size_t(1), alive.size() / 2);
+          alive.resize(keep);
+        }
+        if (alive.empty())
+          continue; // Every sample in the batch was degenerate
+
+        // 4. Finish scoring the batch winner on all the data
+        score(*alive[0], order, num_scored, num_matches, p1, p2);
+        if (*alive[0] < best)
+          best = *alive[0];
+
+        // 5. Stop once enough samples were drawn to have picked an
+        //    all-inlier one with the desired confidence.
+        double inlier_ratio = double(best.num_inliers) / double(num_matches);
+        double p_good = std::pow(inlier_ratio, min_elems_for_fit);
+        if (p_good >= 1.0)
+          break;
+        if (p_good > 0.0) {
+          double needed = std::log(1.0 - m_confidence) / std::log(1.0 - p_good);
+          if (num_generated >= needed)
+            break;
+        }
+      }
+
+      if (!best.valid || best.num_inliers < this->m_min_num_output_inliers) {
+        vw_throw(RANSACErr()
+                 << "RANSAC was unable to find a fit that matched the supplied data.");
+      }
+
+      // Re-estimate the model using all of its inliers
+      std::vector<ContainerT1> inliers1;
+      std::vector<ContainerT2> inliers2;
+      this->inliers(best.H, p1, p2, inliers1, inliers2);
+      result_type best_H = this->m_fitting_func(inliers1, inliers2, best.H);
+
+      // For debugging
+      VW_OUT(InfoMessage, "interest_point") << "\nPreemptive RANSAC summary:" << "\n";
+      VW_OUT(InfoMessage, "interest_point") << "\tFit = "              << best_H << "\n";
+      VW_OUT(InfoMessage, "interest_point") << "\tHypotheses = "       << num_generated << "\n";
+      VW_OUT(InfoMessage, "interest_point") << "\tInliers / total  = " << inliers1.size()
+                                            << " / " << p1.size() << "\n\n";
+
+      return best_H;
+    }
+
+  }; // End of PreemptiveSampleConsensus class definition
+
+  // Helper function to instantiate a preemptive RANSAC object and immediately call it
+  template <class ContainerT1, class ContainerT2, class FittingFuncT, class ErrorFuncT>
+  typename FittingFuncT::result_type
+  preemptive_ransac(std::vector<ContainerT1> const& p1,
+                    std::vector<ContainerT2> const& p2,
+                    FittingFuncT             const& fitting_func,
+                    ErrorFuncT               const& error_func,
+                    int     num_iterations,
+                    double  inlier_threshold,
+                    int     min_num_output_inliers,
+                    bool    reduce_min_num_output_inliers_if_no_fit = false,
+                    std::vector<double> const& quality = std::vector<double>()) {
+    PreemptiveSampleConsensus<FittingFuncT, ErrorFuncT>
+      ransac_instance(fitting_func, error_func, num_iterations, inlier_threshold,
+                      min_num_output_inliers, reduce_min_num_output_inliers_if_no_fit);
+    return ransac_instance(p1, p2, quality);
+  }
+
 }} // namespace vw::math
 
 #endif // __MATH_RANSAC_H__
@@ -21,6 +21,7 @@
 #include <vw/Math/Matrix.h>
 #include <vw/Math/Geometry.h>
 #include <vw/Math/EulerAngles.h>
+#include <vw/Math/RANSAC.h>
 
 using namespace vw;
 using namespace vw::math;
@@ -421,3 +422,49 @@ TEST(Geometry, TranslationFittingFunctorN) {
   // similarity.
   EXPECT_MATRIX_NEAR( S, TranslationFittingFunctorN<3>()(p1,p2), 1.8e-15 );
 }
+
+TEST(Geometry, PreemptiveRansac) {
+  // A similarity with a third of the matches replaced by outliers
+  Matrix3x3 S;
+  S.set_identity();
+  S(0,0) =  1.2*cos(0.3); S(0,1) = -1.2*sin(0.3); S(0,2) =  4.5;
+  S(1,0) =  1.2*sin(0.3); S(1,1) =  1.2*cos(0.3); S(1,2) = -2.0;
+
+  std::srand(7);
+  std::vector<Vector3> p1, p2;
+  std::vector<double> quality;
+  for (int i = 0; i < 300; i++) {
+    Vector3 p(std::rand() % 1000, std::rand() % 1000, 1);
+    Vector3 q = S * p;
+    bool outlier = (i % 3 == 0);
+    if (outlier)
+      q = Vector3(std::rand() % 1000, std::rand() % 1000, 1);
+    p1.push_back(p);
+    p2.push_back(q);
+    quality.push_back(outlier ? 0.2 : 0.8);
+  }
+
+  // Uniform sampling
+  SimilarityFittingFunctorN<2> fit;
+  InterestPointErrorMetric     err;
+  PreemptiveSampleConsensus<SimilarityFittingFunctorN<2>, InterestPointErrorMetric>
+    ransac(fit, err, 2000, 1.0, p1.size()/2, false, 4, 64, 20);
+  EXPECT_MATRIX_NEAR( S, ransac(p1, p2), 1e-6 );
+  EXPECT_EQ( 200u, ransac.inlier_indices(ransac(p1, p2), p1, p2).size() );
+
+  // Guided sampling with the default number of threads
+  Matrix3x3 H = preemptive_ransac(p1, p2, fit, err, 2000, 1.0, p1.size()/2, false, quality);
+  EXPECT_MATRIX_NEAR( S, H, 1e-6 );
+
+  // All random draws happen before the threaded work, so with the same
+  // seed one thread and several threads give the same fit
+  PreemptiveSampleConsensus<SimilarityFittingFunctorN<2>, InterestPointErrorMetric>
+    single(fit, err, 2000, 1.0, p1.size()/2, false, 1, 64, 20),
+    multi (fit, err, 2000, 1.0, p1.size()/2, false, 4, 64, 20);
+  std::srand(11);
+  Matrix3x3 H1 = single(p1, p2, quality);
+  std::srand(11);
+  Matrix3x3 H4 = multi(p1, p2, quality);
+  EXPECT_MATRIX_NEAR( S, H1, 1e-6 );
+  EXPECT_MATRIX_EQ( H1, H4 );
+}
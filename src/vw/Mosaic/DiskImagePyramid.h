@@ -29,6 +29,8 @@
 #include <vector>
 
 #include <vw/Core/ProgressCallback.h>
+#include <vw/Core/Settings.h>
+#include <vw/Core/ThreadPool.h>
 #include <vw/Image/ImageView.h>
 #include <vw/Image/ImageViewRef.h>
 #include <vw/Cartography/GeoReferenceUtils.h>
@@ -179,24 +181,19 @@ namespace vw { namespace mosaic {
     return overwrite;
   }
 
-  // Find approximate min/max for valid pixels, ignoring outliers.
-  // Uses the lowest pyramid level. Only used for single-channel images
-  // that need [min, max] to [0, 255] rescaling for display. Multi-channel
-  // uint8 images map directly to RGB without rescaling.
-  // The file is read as double regardless of on-disk type, with no rescaling,
-  // so nodata comparisons (which use double) are exact.
-  inline vw::Vector2
-  approx_bounds_nocache(std::string const& file, bool has_nodata,
+  // Find approximate min/max for valid pixels of an image, ignoring
+  // outliers. Only the first channel is used.
+  template <class ImageT>
+  vw::Vector2
+  approx_bounds_nocache(ImageViewBase<ImageT> const& image, bool has_nodata,
                         double nodata_val,
                         float valid_min = std::numeric_limits<float>::quiet_NaN(),
                         float valid_max = std::numeric_limits<float>::quiet_NaN()) {
 
+    typedef typename CompoundChannelType<typename ImageT::pixel_type>::type channel_type;
     double big = std::numeric_limits<double>::max();
     bool has_valid_range = !std::isnan(valid_min) && !std::isnan(valid_max);
-
-    boost::shared_ptr<vw::DiskImageResource> rsrc(vw::DiskImageResourcePtr(file));
-    rsrc->set_rescale(false);
-    DiskImageView<double> img(rsrc);
+    ImageT const& img = image.impl();
 
     double num_samples = 250.0; // too many samples makes this slow
     int delta_col = (int)std::max(ceil(img.cols() / num_samples), 1.0);
@@ -205,7 +202,7 @@ namespace vw { namespace mosaic {
     vals.reserve(num_samples * num_samples);
     for (int col = 0; col < img.cols(); col += delta_col) {
       for (int row = 0; row < img.rows(); row += delta_row) {
-        double v = img(col, row);
+        double v = compound_select_channel<channel_type>(img(col, row), 0);
         if (std::isnan(v)) continue;
         if (has_nodata && v == nodata_val) continue;
         if (has_valid_range && (v < valid_min || v > valid_max)) continue;
@@ -235,12 +232,31 @@ namespace vw { namespace mosaic {
 
     return vw::Vector2(b, e);
   }
+
+  // Find approximate min/max for valid pixels, ignoring outliers.
+  // Uses the lowest pyramid level. Only used for single-channel images
+  // that need [min, max] to [0, 255] rescaling for display. Multi-channel
+  // uint8 images map directly to RGB without rescaling.
+  // The file is read as double regardless of on-disk type, with no rescaling,
+  // so nodata comparisons (which use double) are exact.
+  inline vw::Vector2
+  approx_bounds_nocache(std::string const& file, bool has_nodata,
+                        double nodata_val,
+                        float valid_min = std::numeric_limits<float>::quiet_NaN(),
+                        float valid_max = std::numeric_limits<float>::quiet_NaN()) {
+    boost::shared_ptr<vw::DiskImageResource> rsrc(vw::DiskImageResourcePtr(file));
+    rsrc->set_rescale(false);
+    return approx_bounds_nocache(DiskImageView<double>(rsrc), has_nodata, nodata_val,
+                                 valid_min, valid_max);
+  }
   
   /// A class to manage very large images and their subsampled
   /// versions in a pyramid. The most recently accessed tiles are
   /// cached in memory. Caching is handled by use of the
   /// DiskImageView class. Constructing this class creates a temporary
-  /// file on disk for each level of the pyramid.
+  /// file on disk for each large level of the pyramid, while the small
+  /// levels are kept in memory. The levels are made together from
+  /// tiles of the full resolution image, in a single pass over it.
   template <class PixelT>
   class DiskImagePyramid {
 
@@ -320,6 +336,28 @@ namespace vw { namespace mosaic {
     std::set<std::string> m_temporary_files;
 
     vw::Vector2 m_approx_bounds;
+
+    // The levels of at most this many bytes are kept in memory
+    static const int64 max_memory_level_bytes = int64(256)*1024*1024;
+
+    // The levels are made from tiles of about the min size, with as
+    // many levels per pass as fit in tiles of up to the max size
+    static const int32 min_tile_size = 1024;
+    static const int32 max_tile_size = 4096;
+
+    // Create the file for a level that is written
+    boost::shared_ptr<DiskImageResourceGDAL>
+    create_level_file(std::string const& file, Vector2i const& size,
+                      bool has_georef, cartography::GeoReference const& georef,
+                      bool has_nodata) const;
+
+    // Make the levels base+1, ..., last from tiles of the base level in
+    // one pass, writing each tile of a level to its file, if any, or to
+    // its image in memory. The levels that are neither are skipped.
+    void make_levels(int base, int last, std::vector<Vector2i> const& sizes,
+                     std::vector<ImageView<PixelT>> & images,
+                     std::vector<boost::shared_ptr<DiskImageResourceGDAL>> const& rsrcs,
+                     ProgressCallback const& progress_callback) const;
   };
 
   //#################################################################################
@@ -359,98 +397,212 @@ namespace vw { namespace mosaic {
     cartography::GeoReference georef;
     bool has_georef = cartography::read_georeference(georef, base_file);
 
-    // Keep making more pyramid levels until they are small enough
-    int level = 0;
-    int scale = 1;
-    while (double(m_pyramid[level].cols()) * double(m_pyramid[level].rows())
-           > m_lowest_resolution_subimage_num_pixels) {
+    // The sizes of the levels, each subsampled from the one before,
+    // until they are small enough
+    double sub_scale = 1.0/subsample;
+    std::vector<Vector2i> sizes(1, Vector2i(m_pyramid[0].cols(), m_pyramid[0].rows()));
+    while (double(sizes.back().x()) * double(sizes.back().y())
+           > m_lowest_resolution_subimage_num_pixels)
+      sizes.push_back(Vector2i(int32(.5 + sizes.back().x() * sub_scale),
+                               int32(.5 + sizes.back().y() * sub_scale)));
+    int num_levels = sizes.size();
+
+    // The large levels are written to files, or reused if files from
+    // an earlier run are up to date. The small ones are kept in memory.
+    std::vector<std::string> files(num_levels);
+    std::vector<boost::shared_ptr<DiskImageResourceGDAL>> rsrcs(num_levels);
+    std::vector<ImageView<PixelT>> images(num_levels);
+    int reused = 0; // The levels up to this one are reused files
+    int scale  = 1;
+    for (int level = 1; level < num_levels; level++) {
+      scale *= subsample;
+      m_scales.push_back(scale);
+      if (has_georef)
+        georef = resample(georef, sub_scale);
+
+      if (double(sizes[level].x()) * double(sizes[level].y()) * sizeof(PixelT)
+          <= max_memory_level_bytes) {
+        images[level].set_size(sizes[level].x(), sizes[level].y());
+        continue;
+      }
 
       // The name of the file at the current scale
       std::ostringstream os;
-      scale *= subsample;
       os <<  "_sub" << scale << ".tif";
       std::string suffix = os.str();
 
-      // If a valid pixel range was provided and the pixel type is scalar,
-      // use range masking. Otherwise fall back to exact nodata comparison.
-      ImageViewRef<PixelMask<PixelT>> masked
-        = maskForPyramid(m_pyramid[level], m_nodata_val,
-                         m_valid_min, m_valid_max);
-      double sub_scale   = 1.0/subsample;
-      int    tile_size   = 256;
-      int    sub_threads = 1;
-
-      // Resample the image at the current pyramid level.
-      // TODO: resample_aa is a hacky thingy. Need to understand
-      // what is a good way of resampling.
-      // Note that below we cast the channels to double for resampling,
-      // then cast back to current pixel type for saving.
-      PixelT nodata_pixel;
-      set_all(nodata_pixel, m_nodata_val);
-      ImageViewRef<PixelT> unmasked
-        = block_rasterize(cache_tile_aware_render
-                          (pixel_cast<PixelT>
-                           (apply_mask
-                            (resample_aa
-                             (channel_cast<double>(masked), sub_scale),
-                             nodata_pixel
-                             )),
-                           Vector2i(tile_size,tile_size) * sub_scale
-                           ), Vector2i(tile_size,tile_size), sub_threads);
-      
-      // Write the current image.
-      if (has_georef)
-        georef = resample(georef, sub_scale);
-
       // If the file exists, and has the right size, and is not too old,
       // don't write it again
       std::string curr_file = filename_from_suffix1(base_file, suffix);
       bool will_write = overwrite_if_no_good(base_file, curr_file,
-                                             unmasked.cols(), unmasked.rows());
-
+                                             sizes[level].x(), sizes[level].y());
       if (will_write) {
-
-        if (level == 0)
-          vw_out() << "Construct an image pyramid for: " << base_file << "\n";
-
-        TerminalProgressCallback tpc("vw", ": ");
-        vw_out() << "Writing: " << curr_file << "\n";
         try{
-          cartography::block_write_gdal_image(curr_file, unmasked, has_georef, georef,
-                      has_nodata, m_nodata_val, opt, tpc);
+          rsrcs[level] = create_level_file(curr_file, sizes[level], has_georef, georef,
+                                           has_nodata);
         } catch(...) {
           vw_out() << "Failed to write: " << curr_file << "\n";
           curr_file = filename_from_suffix2(base_file, suffix);
           will_write = overwrite_if_no_good(base_file, curr_file,
-                    unmasked.cols(), unmasked.rows());
-          if (will_write) {
-            vw_out() << "Writing: " << curr_file << "\n";
-            cartography::block_write_gdal_image(curr_file, unmasked, has_georef, georef,
-                  has_nodata, m_nodata_val, opt, tpc);
-          }
+                                            sizes[level].x(), sizes[level].y());
+          if (will_write)
+            rsrcs[level] = create_level_file(curr_file, sizes[level], has_georef, georef,
+                                             has_nodata);
         }
       }
 
-      if (!will_write)
+      if (will_write)
+        vw_out() << "Writing: " << curr_file << "\n";
+      else
         vw_out() << "Using existing subsampled image: " << curr_file << "\n";
 
-      // Note that m_pyramid contains a handle to DiskImageView.
-      // DiskImageView's implementation will make it possible to
-      // cache in memory the most recently used tiles of all
-      // the images in the pyramid.
-      m_pyramid_files.push_back(curr_file);
-    
-      m_temporary_files.insert(curr_file);
-      m_pyramid.push_back(DiskImageView<PixelT>(curr_file));
-      m_scales.push_back(scale);
+      files[level] = curr_file;
+      if (reused == level - 1 && !will_write)
+        reused = level;
+    }
 
-      level++;
-    } // End level creation loop
+    // Note that m_pyramid contains a handle to DiskImageView for the
+    // levels in files. DiskImageView's implementation will make it
+    // possible to cache in memory the most recently used tiles of all
+    // the images in the pyramid.
+    for (int level = 1; level <= reused; level++) {
+      m_pyramid_files.push_back(files[level]);
+      m_temporary_files.insert(files[level]);
+      m_pyramid.push_back(DiskImageView<PixelT>(files[level]));
+    }
+
+    // Make the other levels from the last reused one, or from the full
+    // resolution image, in as few passes over it as the tile size allows
+    int base = reused;
+    while (base + 1 < num_levels) {
+      int last  = base + 1;
+      int block = subsample;
+      while (last + 1 < num_levels && block * subsample <= max_tile_size) {
+        block *= subsample;
+        last++;
+      }
+
+      bool writing = false;
+      for (int level = base + 1; level <= last; level++)
+        writing = writing || bool(rsrcs[level]);
+      if (writing && base == 0)
+        vw_out() << "Construct an image pyramid for: " << base_file << "\n";
+      TerminalProgressCallback tpc("vw", ": ");
+      make_levels(base, last, sizes, images, rsrcs,
+                  writing ? (ProgressCallback const&)tpc : ProgressCallback::dummy_instance());
+
+      for (int level = base + 1; level <= last; level++) {
+        if (files[level].empty()) {
+          m_pyramid.push_back(images[level]);
+          continue;
+        }
+        if (rsrcs[level]) {
+          rsrcs[level].reset(); // Close the file
+          if (opt.cog)
+            cartography::convert_to_cog(files[level], opt);
+        }
+        m_pyramid_files.push_back(files[level]);
+        m_temporary_files.insert(files[level]);
+        m_pyramid.push_back(DiskImageView<PixelT>(files[level]));
+      }
+      base = last;
+    }
 
     // This is expensive, so cache it going forward
-    m_approx_bounds = approx_bounds_nocache(m_pyramid_files.back(),
-                                            has_nodata, m_nodata_val,
-                                            m_valid_min, m_valid_max);
+    if (num_levels > 1 && files.back().empty())
+      m_approx_bounds = approx_bounds_nocache(images.back(), has_nodata, m_nodata_val,
+                                              m_valid_min, m_valid_max);
+    else
+      m_approx_bounds = approx_bounds_nocache(m_pyramid_files.back(),
+                                              has_nodata, m_nodata_val,
+                                              m_valid_min, m_valid_max);
+  }
+
+  template <class PixelT>
+  boost::shared_ptr<DiskImageResourceGDAL>
+  DiskImagePyramid<PixelT>::create_level_file(std::string const& file, Vector2i const& size,
+                                              bool has_georef,
+                                              cartography::GeoReference const& georef,
+                                              bool has_nodata) const {
+    ImageFormat format = ImageView<PixelT>().format();
+    format.cols   = size.x();
+    format.rows   = size.y();
+    format.planes = 1;
+    boost::shared_ptr<DiskImageResourceGDAL> rsrc
+      (new DiskImageResourceGDAL(file, format, m_opt.raster_tile_size, m_opt.gdal_options));
+    if (has_nodata)
+      rsrc->set_nodata_write(m_nodata_val);
+    if (has_georef)
+      cartography::write_georeference(*rsrc, georef);
+    return rsrc;
+  }
+
+  template <class PixelT>
+  void DiskImagePyramid<PixelT>::make_levels
+  (int base, int last, std::vector<Vector2i> const& sizes,
+   std::vector<ImageView<PixelT>> & images,
+   std::vector<boost::shared_ptr<DiskImageResourceGDAL>> const& rsrcs,
+   ProgressCallback const& progress_callback) const {
+
+    // The tiles are aligned with the blocks of the base level that make
+    // one pixel of the last level, so that each pixel of the levels in
+    // between is made from one tile
+    int32 block = 1;
+    for (int level = base; level < last; level++)
+      block *= m_subsample;
+    int32 tile_size = block * std::max(1, min_tile_size / block);
+    int32 tiles_x   = (sizes[base].x() + tile_size - 1) / tile_size;
+    int32 tiles_y   = (sizes[base].y() + tile_size - 1) / tile_size;
+    size_t num_tiles = size_t(tiles_x) * size_t(tiles_y);
+
+    int num_threads = m_opt.num_threads;
+    if (num_threads <= 0)
+      num_threads = vw_settings().default_num_threads();
+
+    PixelT nodata_pixel;
+    set_all(nodata_pixel, m_nodata_val);
+    ImageViewRef<PixelT> source = m_pyramid[base];
+    Mutex mutex;
+    size_t num_done = 0;
+    progress_callback.report_progress(0);
+    process_in_parallel(num_tiles, num_threads, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        BBox2i bbox(int32(i % tiles_x) * tile_size, int32(i / tiles_x) * tile_size,
+                    tile_size, tile_size);
+        bbox.crop(BBox2i(Vector2i(), sizes[base]));
+        ImageView<PixelT> tile = crop(source, bbox);
+
+        // Subsample the tile while it is in memory, as resample_aa()
+        // would. A partial block at the right or bottom edge of a level
+        // makes a pixel if it is at least half a block.
+        for (int level = base + 1; level <= last; level++) {
+          Vector2i min = bbox.min() / m_subsample;
+          Vector2i max(std::min((bbox.max().x() + m_subsample - 1) / m_subsample, sizes[level].x()),
+                       std::min((bbox.max().y() + m_subsample - 1) / m_subsample, sizes[level].y()));
+          if (max.x() <= min.x() || max.y() <= min.y())
+            break; // Only a partial block that is dropped
+          bbox = BBox2i(min, max);
+
+          // If a valid pixel range was provided and the pixel type is scalar,
+          // use range masking. Otherwise fall back to exact nodata comparison.
+          ImageViewRef<PixelT> tile_ref = tile;
+          ImageView<PixelMask<PixelT>> masked
+            = maskForPyramid(tile_ref, m_nodata_val, m_valid_min, m_valid_max);
+          tile = pixel_cast<PixelT>(apply_mask(subsample_aa(masked, m_subsample,
+                                                            bbox.width(), bbox.height()),
+                                               nodata_pixel));
+          if (rsrcs[level])
+            write_image(*rsrcs[level], tile, bbox);
+          else if (images[level].cols() > 0)
+            crop(images[level], bbox) = tile;
+        }
+
+        Mutex::WriteLock lock(mutex);
+        num_done++;
+        progress_callback.report_progress(double(num_done) / num_tiles);
+      }
+    });
+    progress_callback.report_finished();
   }
 
   // Find the right pyramid level to use for the given sub scale
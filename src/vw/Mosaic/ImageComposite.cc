@@ -0,0 +1,128 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2013, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+
+#include <vw/Mosaic/ImageComposite.h>
+
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  #include <emmintrin.h>
+#endif
+
+namespace {
+
+  // One minus each 8-bit alpha over 255, computed as the generic
+  // draft_overlay_row() does, so that the results match it exactly.
+  struct Uint8AlphaFactors {
+    double factor[256];
+    Uint8AlphaFactors() {
+      for( int a=0; a<256; ++a )
+        factor[a] = 1.0 - a / 255.0;
+    }
+  };
+  const Uint8AlphaFactors uint8_alpha_factors;
+
+}
+
+void vw::mosaic::draft_overlay_row( PixelRGBA<uint8>* dst, PixelRGBA<uint8> const* src, int32 num ) {
+  int32 i = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  // Four pixels at a time. Opaque sources replace the destination and
+  // transparent ones add to it, which skips the multiplication for
+  // most of a mosaic. Otherwise the channels are scaled in double
+  // precision and truncated, as in the generic version. The sum wraps
+  // around like the uint8 addition does.
+  const __m128i zero       = _mm_setzero_si128();
+  const __m128i alpha_mask = _mm_set1_epi32( int(0xFF000000) );
+  for( ; i+4 <= num; i+=4 ) {
+    __m128i s     = _mm_loadu_si128( reinterpret_cast<__m128i const*>( src+i ) );
+    __m128i alpha = _mm_and_si128( s, alpha_mask );
+    if( _mm_movemask_epi8( _mm_cmpeq_epi32( alpha, alpha_mask ) ) == 0xFFFF ) {
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( dst+i ), s );
+      continue;
+    }
+    __m128i d = _mm_loadu_si128( reinterpret_cast<__m128i const*>( dst+i ) );
+    if( _mm_movemask_epi8( _mm_cmpeq_epi32( alpha, zero ) ) != 0xFFFF ) {
+      __m128i d16[2] = { _mm_unpacklo_epi8( d, zero ), _mm_unpackhi_epi8( d, zero ) };
+      __m128i scaled[4];
+      for( int k=0; k<4; ++k ) {
+        __m128i d32 = (k % 2 == 0) ? _mm_unpacklo_epi16( d16[k/2], zero )
+                                   : _mm_unpackhi_epi16( d16[k/2], zero );
+        __m128d factor = _mm_set1_pd( uint8_alpha_factors.factor[src[i+k].a()] );
+        __m128i lo = _mm_cvttpd_epi32( _mm_mul_pd( _mm_cvtepi32_pd( d32 ), factor ) );
+        __m128i hi = _mm_cvttpd_epi32( _mm_mul_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( d32, _MM_SHUFFLE(1,0,3,2) ) ), factor ) );
+        scaled[k] = _mm_unpacklo_epi64( lo, hi );
+      }
+      d = _mm_packus_epi16( _mm_packs_epi32( scaled[0], scaled[1] ),
+                            _mm_packs_epi32( scaled[2], scaled[3] ) );
+    }
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( dst+i ), _mm_add_epi8( d, s ) );
+  }
+#endif
+  for( ; i<num; ++i ) {
+    double factor = uint8_alpha_factors.factor[src[i].a()];
+    for( int c=0; c<4; ++c )
+      dst[i][c] = uint8( uint8( dst[i][c] * factor ) + src[i][c] );
+  }
+}
+
+void vw::mosaic::draft_overlay_row( PixelRGBA<float32>* dst, PixelRGBA<float32> const* src, int32 num ) {
+  int32 i = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  // One pixel at a time, scaling in double precision like the generic
+  // version and rounding back to float before the sum.
+  for( ; i<num; ++i ) {
+    float32 const* s_ptr = reinterpret_cast<float32 const*>( src+i );
+    float32      * d_ptr = reinterpret_cast<float32      *>( dst+i );
+    __m128  s      = _mm_loadu_ps( s_ptr );
+    __m128  d      = _mm_loadu_ps( d_ptr );
+    __m128d factor = _mm_set1_pd( 1.0 - src[i].a() / 1.0 );
+    __m128  lo     = _mm_cvtpd_ps( _mm_mul_pd( _mm_cvtps_pd( d ), factor ) );
+    __m128  hi     = _mm_cvtpd_ps( _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( d, d ) ), factor ) );
+    _mm_storeu_ps( d_ptr, _mm_add_ps( _mm_movelh_ps( lo, hi ), s ) );
+  }
+#endif
+  for( ; i<num; ++i ) {
+    double factor = 1.0 - src[i].a() / 1.0;
+    for( int c=0; c<4; ++c )
+      dst[i][c] = float32( float32( dst[i][c] * factor ) + src[i][c] );
+  }
+}
+
+void vw::mosaic::reduce_row( PixelRGBA<float32>* dst, PixelRGBA<float32> const* row0,
+                             PixelRGBA<float32> const* row1, PixelRGBA<float32> const* row2, int32 num ) {
+  int32 i = 0;
+#if defined(VW_ENABLE_SSE) && (VW_ENABLE_SSE==1)
+  // One pixel at a time, all four channels in a register, with the
+  // products summed in float in the same order as the generic version.
+  const float kernel[3] = { 0.25, 0.5, 0.25 };
+  __m128 weights[3][3];
+  for( int r=0; r<3; ++r )
+    for( int c=0; c<3; ++c )
+      weights[r][c] = _mm_set1_ps( kernel[c] * kernel[r] );
+  float32 const* rows[3] = { reinterpret_cast<float32 const*>( row0 ),
+                             reinterpret_cast<float32 const*>( row1 ),
+                             reinterpret_cast<float32 const*>( row2 ) };
+  for( ; i<num; ++i ) {
+    __m128 sum = _mm_setzero_ps();
+    for( int r=0; r<3; ++r )
+      for( int c=0; c<3; ++c )
+        sum = _mm_add_ps( sum, _mm_mul_ps( weights[r][c], _mm_loadu_ps( rows[r] + 4*(2*i+c) ) ) );
+    _mm_storeu_ps( reinterpret_cast<float32*>( dst+i ), sum );
+  }
+#endif
+  reduce_row<PixelRGBA<float32> >( dst+i, row0+2*i, row1+2*i, row2+2*i, num-i );
+}
@@ -26,6 +26,10 @@
 #include <iostream>
 #include <vector>
 #include <list>
+#include <algorithm>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility/enable_if.hpp>
 
 #include <vw/Core/Cache.h>
 #include <vw/Core/ProgressCallback.h>
@@ -34,6 +38,7 @@
 #include <vw/Image/ImageMath.h>
 #include <vw/Image/EdgeExtension.h>
 #include <vw/Image/Algorithms.h>
+#include <vw/Image/BlockRasterize.h>
 #include <vw/Image/Grassfire.h>
 #include <vw/Image/Transform.h>
 #include <vw/Image/Filter.h>
@@ -41,6 +46,7 @@
 #include <vw/FileIO/DiskImageIO.h>
 #include <vw/Image/Manipulation.h>
 #include <vw/Image/ImageChannels.h>
+#include <vw/Geometry/SpatialTree.h>
 
 namespace vw {
 namespace mosaic {
@@ -49,6 +55,31 @@ namespace mosaic {
   // PositionedImage
   // *******************************************************************
 
+  /// Blur three rows with the 1-2-1 kernel of PositionedImage::reduce()
+  /// at every other pixel, so that dst[i] is the blur at row1[2*i+1].
+  /// The weighted pixels are summed in float as a separable convolution
+  /// filter evaluated pixel by pixel does, a row at a time.
+  template <class PixelT>
+  void reduce_row( PixelT* dst, PixelT const* row0, PixelT const* row1, PixelT const* row2, int32 num ) {
+    typedef typename CompoundChannelType<PixelT>::type channel_type;
+    typedef typename ProductType<PixelT, float>::type  sum_type;
+    const float kernel[3] = { 0.25, 0.5, 0.25 };
+    PixelT const* rows[3] = { row0, row1, row2 };
+    for( int32 i=0; i<num; ++i ) {
+      sum_type sum = sum_type();
+      validate( sum );
+      for( int32 r=0; r<3; ++r )
+        for( int32 c=0; c<3; ++c )
+          sum += ( kernel[c] * kernel[r] ) * rows[r][2*i+c];
+      dst[i] = channel_cast_clamp_if_int<channel_type>( sum );
+    }
+  }
+
+  /// A vectorized version of reduce_row() for the usual blending pixel
+  /// type. The results are the same as the generic version's.
+  void reduce_row( PixelRGBA<float32>* dst, PixelRGBA<float32> const* row0,
+                   PixelRGBA<float32> const* row1, PixelRGBA<float32> const* row2, int32 num );
+
   /// ?
   template <class PixelT>
   class PositionedImage : public ImageViewBase<PositionedImage<PixelT> > {
@@ -73,19 +104,33 @@ namespace mosaic {
       int right  = std::min( border + (bbox.width()+left+border)%2, m_cols-bbox.min().x()-bbox.width()  );
       int bottom = std::min( border + (bbox.height()+top+border)%2, m_rows-bbox.min().y()-bbox.height() );
 
-      std::vector<float> kernel(3); kernel[0]=0.25; kernel[1]=0.5; kernel[2]=0.25;
       // I don't quite yet understand why (if?) this is the correct bounding box,
       // but bad things happen without the final "+1"s:
       BBox2i new_bbox( Vector2i( (bbox.min().x()-left)/2, 
                                  (bbox.min().y()-top )/2 ),
                        Vector2i( (bbox.min().x()-left)/2 + (bbox.width()+left+right +1)/2+1,
                                  (bbox.min().y()-top )/2 + (bbox.height()+top+bottom+1)/2+1 ) );
-      // We use vw::rasterize() here rather than ordinary assignment because it is
-      // faster for this particular combination of filtering and subsampling.
+
+      // The image is blurred with the kernel at every other pixel of its
+      // extent by left, top, right and bottom, with zeros around it, and
+      // the last blurred column and row are repeated to fill new_bbox.
+      // This is done row by row on a copy with a pixel of zeros around
+      // the extent, rather than with views, with the same results.
+      int32 cols = image.cols()+left+right, rows = image.rows()+top+bottom;
+      ImageView<PixelT> padded( cols+2, rows+2 );
+      crop( padded, left+1, top+1, image.cols(), image.rows() ) = image;
+      int32 blurred_cols = 1 + (cols-1)/2, blurred_rows = 1 + (rows-1)/2;
       ImageView<PixelT> new_image( new_bbox.width(), new_bbox.height() );
-      vw::rasterize( edge_extend( subsample( separable_convolution_filter( edge_extend( image, -left, -top, image.cols()+left+right, image.rows()+top+bottom, ZeroEdgeExtension() ),
-                                                                           kernel, kernel, ZeroEdgeExtension() ), 2 ), 0, 0, new_bbox.width(), new_bbox.height(), vw::ConstantEdgeExtension() ),
-                     new_image );
+      for( int32 j=0; j<new_image.rows(); ++j ) {
+        if( j >= blurred_rows ) {
+          std::copy( &new_image(0,j-1), &new_image(0,j-1)+new_image.cols(), &new_image(0,j) );
+          continue;
+        }
+        reduce_row( &new_image(0,j), &padded(0,2*j), &padded(0,2*j+1), &padded(0,2*j+2),
+                    std::min( blurred_cols, new_image.cols() ) );
+        for( int32 i=blurred_cols; i<new_image.cols(); ++i )
+          new_image(i,j) = new_image(blurred_cols-1,j);
+      }
       return PositionedImage( (m_cols+1)/2, (m_rows+1)/2, new_image, new_bbox );
     }
 
@@ -140,6 +185,144 @@ namespace mosaic {
   };
 
 
+  // *******************************************************************
+  // DraftCompositeView
+  // *******************************************************************
+
+  /// Lay a row of source pixels over a row of destination pixels, as
+  /// draft mode does. Each destination channel is scaled by one minus
+  /// the source alpha and the source is added to it.
+  template <class PixelT>
+  typename boost::enable_if<PixelHasAlpha<PixelT> >::type
+  draft_overlay_row( PixelT* dst, PixelT const* src, int32 num ) {
+    typedef typename PixelChannelType<PixelT>::type channel_type;
+    for( int32 i=0; i<num; ++i ) {
+      double factor = 1.0 - alpha_channel( src[i] ) / (double)ChannelRange<PixelT>::max();
+      for( int32 c=0; c<PixelNumChannels<PixelT>::value; ++c ) {
+        channel_type& d = compound_select_channel<channel_type&>( dst[i], c );
+        d = channel_type( d * factor );
+        d = channel_type( d + compound_select_channel<channel_type const&>( src[i], c ) );
+      }
+    }
+  }
+
+  /// Without an alpha channel the source replaces the destination.
+  template <class PixelT>
+  typename boost::disable_if<PixelHasAlpha<PixelT> >::type
+  draft_overlay_row( PixelT* dst, PixelT const* src, int32 num ) {
+    std::copy( src, src+num, dst );
+  }
+
+  /// Vectorized versions of draft_overlay_row() for the usual mosaic
+  /// pixel types. The results are the same as the generic version's.
+  void draft_overlay_row( PixelRGBA<uint8  >* dst, PixelRGBA<uint8  > const* src, int32 num );
+  void draft_overlay_row( PixelRGBA<float32>* dst, PixelRGBA<float32> const* src, int32 num );
+
+  /// The draft mode composite of a set of images, each laid over the
+  /// ones before it. The sources over each block of block_size pixels
+  /// are listed when the view is made, so that a patch only visits the
+  /// sources of the blocks it covers. Rasterizing into an ImageView
+  /// composites each source row straight into the destination.
+  template <class PixelT>
+  class DraftCompositeView : public ImageViewBase<DraftCompositeView<PixelT> > {
+    std::vector<ImageViewRef<PixelT> > m_sources;
+    std::vector<BBox2i> m_bboxes;
+    int32 m_cols, m_rows, m_block_size, m_blocks_x;
+    boost::shared_ptr<std::vector<std::vector<unsigned> > > m_block_sources;
+
+    /// The sources listed for the blocks under a box, in order.
+    void block_sources( BBox2i const& bbox, std::vector<unsigned> & result ) const {
+      int32 bx0 = bbox.min().x() / m_block_size, bx1 = (bbox.max().x()-1) / m_block_size;
+      int32 by0 = bbox.min().y() / m_block_size, by1 = (bbox.max().y()-1) / m_block_size;
+      if( bx0 == bx1 && by0 == by1 ) {
+        result = (*m_block_sources)[bx0 + by0*m_blocks_x];
+        return;
+      }
+      result.clear();
+      for( int32 by=by0; by<=by1; ++by ) {
+        for( int32 bx=bx0; bx<=bx1; ++bx ) {
+          std::vector<unsigned> const& block = (*m_block_sources)[bx + by*m_blocks_x];
+          result.insert( result.end(), block.begin(), block.end() );
+        }
+      }
+      std::sort( result.begin(), result.end() );
+      result.erase( std::unique( result.begin(), result.end() ), result.end() );
+    }
+
+  public:
+    typedef PixelT pixel_type;
+    typedef PixelT result_type;
+    typedef ProceduralPixelAccessor<DraftCompositeView> pixel_accessor;
+
+    /// The sources are placed at the given boxes of a cols x rows image.
+    DraftCompositeView( std::vector<ImageViewRef<PixelT> > const& sources,
+                        std::vector<BBox2i> const& bboxes,
+                        int32 cols, int32 rows, int32 block_size )
+      : m_sources(sources), m_bboxes(bboxes), m_cols(cols), m_rows(rows),
+        m_block_size(block_size) {
+      VW_ASSERT( sources.size() == bboxes.size(),
+                 ArgumentErr() << "DraftCompositeView: Every source needs a bounding box." );
+      VW_ASSERT( block_size > 0,
+                 ArgumentErr() << "DraftCompositeView: Illegal block size: " << block_size );
+      m_blocks_x = (cols + block_size - 1) / block_size;
+      int32 blocks_y = (rows + block_size - 1) / block_size;
+      m_block_sources.reset( new std::vector<std::vector<unsigned> >( size_t(m_blocks_x) * size_t(blocks_y) ) );
+      for( unsigned p=0; p<bboxes.size(); ++p ) {
+        BBox2i bbox = bboxes[p];
+        bbox.crop( BBox2i(0,0,cols,rows) );
+        if( bbox.empty() ) continue;
+        for( int32 by=bbox.min().y()/block_size; by<=(bbox.max().y()-1)/block_size; ++by )
+          for( int32 bx=bbox.min().x()/block_size; bx<=(bbox.max().x()-1)/block_size; ++bx )
+            (*m_block_sources)[bx + by*m_blocks_x].push_back( p );
+      }
+    }
+
+    int32 cols  () const { return m_cols; }
+    int32 rows  () const { return m_rows; }
+    int32 planes() const { return 1;      }
+    pixel_accessor origin() const { return pixel_accessor( *this, 0, 0 ); }
+
+    /// Composites a whole pixel, so it is slow. Wrap the view in a
+    /// BlockRasterizeView with a cache for pixel access.
+    result_type operator()( int32 x, int32 y, int32 p=0 ) const {
+      ImageView<PixelT> pixel( 1, 1 );
+      rasterize( pixel, BBox2i(x,y,1,1) );
+      return pixel(0,0,p);
+    }
+
+    typedef CropView<ImageView<PixelT> > prerasterize_type;
+    prerasterize_type prerasterize( BBox2i const& bbox ) const {
+      ImageView<PixelT> buf( bbox.width(), bbox.height() );
+      rasterize( buf, bbox );
+      return CropView<ImageView<PixelT> >( buf, BBox2i(-bbox.min().x(),-bbox.min().y(),cols(),rows()) );
+    }
+
+    template <class DestT> void rasterize( DestT const& dest, BBox2i const& bbox ) const {
+      vw::rasterize( prerasterize(bbox), dest, bbox );
+    }
+
+    /// Composite the box straight into an image of its size.
+    void rasterize( ImageView<PixelT> const& dest, BBox2i const& bbox ) const {
+      fill( dest, PixelT() );
+      if( bbox.empty() ) return;
+      std::vector<unsigned> overlapping;
+      block_sources( bbox, overlapping );
+      ImageView<PixelT> patch;
+      for( unsigned k=0; k<overlapping.size(); ++k ) {
+        unsigned p = overlapping[k];
+        BBox2i overlap = bbox;
+        overlap.crop( m_bboxes[p] );
+        if( overlap.empty() ) continue;
+        patch.set_size( overlap.width(), overlap.height() );
+        m_sources[p].rasterize( patch, overlap - m_bboxes[p].min() );
+        Vector2i offset = overlap.min() - bbox.min();
+        for( int32 j=0; j<overlap.height(); ++j )
+          draft_overlay_row( &dest(offset.x(),offset.y()+j), &patch(0,j), overlap.width() );
+      }
+    }
+  };
+
+
   // *******************************************************************
   // ImageComposite
   // *******************************************************************
@@ -157,85 +340,81 @@ namespace mosaic {
       std::vector<PositionedImage<channel_type> > masks;
     };
 
-    /// ?
-    class SourceGenerator {
-      ImageViewRef<pixel_type> m_source;
-    public:
-      typedef ImageView<pixel_type> value_type;
-      SourceGenerator( ImageViewRef<pixel_type> const& source ) : m_source(source) {}
-      size_t size() const {
-        return m_source.cols() * m_source.rows() * sizeof(pixel_type);
-      }
-      boost::shared_ptr<value_type> generate() const {
-        return boost::shared_ptr<value_type>( new value_type(m_source) );
-      }
-    };
-
-    class GrassfireGenerator {
-      ImageViewRef<pixel_type> m_source;
-    public:
-      typedef ImageView<float32> value_type;
-      GrassfireGenerator( ImageViewRef<pixel_type> const& source ) : m_source(source) {}
-      size_t size() const {
-        return m_source.cols() * m_source.rows() * sizeof(float32);
-      }
-      boost::shared_ptr<value_type> generate() const {
-        ImageView<float32> alpha = channel_cast<float32>( select_alpha_channel( copy( m_source ) ) );
-        return boost::shared_ptr<value_type>( new value_type( grassfire( alpha ) ) );
-      }
-    };
-
-    class AlphaGenerator {
-    public:
-      ImageComposite& m_composite;
-      size_t m_index;
-    public:
-      typedef ImageView<channel_type> value_type;
-      AlphaGenerator( ImageComposite& composite, size_t index ) : m_composite(composite), m_index(index) {}
-      size_t size() const {
-        return m_composite.sources[m_index].size() / PixelNumChannels<pixel_type>::value;
-      }
-      boost::shared_ptr<value_type> generate() const {
-        ImageView<pixel_type> source = *m_composite.sources[m_index];
-        m_composite.sources[m_index].release();
-        m_composite.sources[m_index].deprioritize();
-        return boost::shared_ptr<value_type>( new value_type( select_alpha_channel( source ) ) );
-      }
-    };
-
+    /// Builds the pyramid of a source over a window, which is the
+    /// part of the source that a block of the mosaic depends on.
     class PyramidGenerator {
     public:
-      ImageComposite& m_composite;
+      ImageComposite const& m_composite;
       size_t m_index;
+      BBox2i m_window; ///< In mosaic coordinates, within the source
     public:
       typedef Pyramid value_type;
-      PyramidGenerator( ImageComposite& composite, size_t index ) : m_composite(composite), m_index(index) {}
+      PyramidGenerator( ImageComposite const& composite, size_t index, BBox2i const& window )
+        : m_composite(composite), m_index(index), m_window(window) {}
       size_t size() const {
-        return size_t( double(m_composite.sources[m_index].size()) * 1.66 ); // 1.66 = (5/4)*(4/3)
+        return size_t( double(m_window.width()) * double(m_window.height()) * sizeof(pixel_type) * 1.66 ); // 1.66 = (5/4)*(4/3)
       }
       boost::shared_ptr<value_type> generate() const;
     };
 
     friend class PyramidGenerator;
 
+    /// The bounding box of a source, for the spatial index
+    struct SourceBox : public geometry::GeomPrimitive {
+      BBoxN    box;
+      unsigned index;
+      virtual const BBoxN &bounding_box() const { return box; }
+    };
+
     std::vector<BBox2i > bboxes;
     BBox2i view_bbox, data_bbox;
     int    mindim, levels;
     bool   m_draft_mode;
     bool   m_fill_holes;
-    bool   m_reuse_masks;
     Cache& m_cache;
     std::vector<ImageViewRef<pixel_type> >        sourcerefs;
-    std::vector<Cache::Handle<SourceGenerator > > sources;
-    std::vector<Cache::Handle<AlphaGenerator  > > alphas;
-    std::vector<Cache::Handle<PyramidGenerator> > pyramids;
-
-    void generate_masks( ProgressCallback const& progress_callback ) const;
+    int32  m_blocks_x;
+    std::vector<std::vector<Cache::Handle<PyramidGenerator> > > pyramids; ///< The source pyramids of each block, built by prepare()
+    boost::shared_ptr<std::vector<SourceBox> >    m_source_boxes;
+    boost::shared_ptr<geometry::SpatialTree>      m_source_tree;  ///< Index of m_source_boxes, built by prepare()
+    boost::shared_ptr<BlockRasterizeView<DraftCompositeView<pixel_type> > > m_draft_view; ///< Built by prepare() in draft mode
+
+    /// Draft mode patches come from the block cached m_draft_view once
+    /// prepare() has built it.
+    bool use_draft_view() const { return m_draft_mode && m_draft_view; }
+
+    /// Multi-band blending works on blocks of this size, each from
+    /// the pyramids of the sources over its footprint. Fewer levels
+    /// keep the footprints small.
+    static const int32 blend_block_size = 512;
+    static const int   max_blend_levels = 6;
+
+    /// The box of source pixels that can affect a patch of the blend.
+    BBox2i blend_footprint( BBox2i const& patch_bbox ) const;
+
+    /// The grassfire distance of a source over a box, clamped at
+    /// blend_radius(). It is found over a box that much bigger, so
+    /// it does not depend on the size of the source.
+    ImageView<int32> clamped_grassfire( size_t index, BBox2i const& bbox ) const;
+    int32 blend_radius() const { return 2 << levels; }
+
+    /// The blend mask of a source over a window: the pixels where no
+    /// other source has a greater clamped grassfire distance, with
+    /// ties going to the source inserted last.
+    ImageView<channel_type> blend_mask( size_t index, BBox2i const& window ) const;
+
+    /// The indices of the sources whose bounding boxes intersect the
+    /// given one, in the order they were inserted. Uses the spatial
+    /// index if prepare() has built it.
+    std::vector<unsigned> intersecting_sources( BBox2i const& bbox ) const;
 
     /// Generates a full-resolution patch of the mosaic corresponding
     /// to the given bounding box.
     ImageView<pixel_type> blend_patch( BBox2i const& patch_bbox ) const;
 
+    /// Blends a patch within one block from the pyramids of that block.
+    ImageView<pixel_type> blend_block( size_t block, BBox2i const& patch_bbox ) const;
+
     // Generates a full-resolution patch of the mosaic corresponding
     // to the given bounding box WITHOUT blending.
     ImageView<pixel_type> draft_patch( BBox2i const& patch_bbox ) const;
@@ -244,7 +423,7 @@ namespace mosaic {
     typedef pixel_type result_type;
 
     ImageComposite() : m_draft_mode (false), m_fill_holes(false),
-                       m_reuse_masks(false), m_cache(vw_system_cache()) {}
+                       m_cache(vw_system_cache()), m_blocks_x(0) {}
 
     void insert( ImageViewRef<pixel_type> const& image, int x, int y );
 
@@ -262,7 +441,9 @@ namespace mosaic {
 
     void set_fill_holes (bool fill_holes ) { m_fill_holes = fill_holes; }
 
-    void set_reuse_masks(bool reuse_masks) { m_reuse_masks = reuse_masks; }
+    /// Blend masks are now found as they are needed, rather than
+    /// written to disk by prepare(), so this has no effect.
+    void set_reuse_masks(bool /*reuse_masks*/) {}
 
     int32 cols  () const { return view_bbox.width();  }
     int32 rows  () const { return view_bbox.height(); }
@@ -272,9 +453,10 @@ namespace mosaic {
     BBox2i const& source_data_bbox() const { return view_bbox; }
 
     pixel_type operator()( int x, int y, int p=0 ) const {
+      if( use_draft_view() ) return (*m_draft_view)(x,y,p);
       // FIXME: This is horribly slow, and totally untested for
-      // multi-band blending.  We should do something faster for draft
-      // mode, and possibly cache output blocks in multi-band mode?
+      // multi-band blending.  We should possibly cache output blocks
+      // in multi-band mode?
       return generate_patch(BBox2i(x,y,1,1))(0,0,p);
     }
 
@@ -284,16 +466,20 @@ namespace mosaic {
     typedef CropView<ImageView<PixelT> > prerasterize_type;
 
     inline prerasterize_type prerasterize( BBox2i const& bbox ) const {
+      if( use_draft_view() ) return m_draft_view->prerasterize(bbox);
       ImageView<PixelT> buf = generate_patch(bbox);
       return CropView<ImageView<PixelT> >( buf, BBox2i(-bbox.min().x(),-bbox.min().y(),cols(),rows()) );
     }
 
     template <class DestT> inline void rasterize( DestT const& dest, BBox2i const& bbox ) const {
-      vw::rasterize( prerasterize(bbox), dest, bbox );
+      if( use_draft_view() ) m_draft_view->rasterize( dest, bbox );
+      else vw::rasterize( prerasterize(bbox), dest, bbox );
     }
 
     bool sparse_check( BBox2i const& bbox ) const {
-      for (unsigned int i = 0; i < bboxes.size(); ++i) {
+      std::vector<unsigned> overlapping = intersecting_sources( bbox );
+      for (unsigned int k = 0; k < overlapping.size(); ++k) {
+        unsigned i = overlapping[k];
         BBox2i src_bbox = bboxes[i];
         src_bbox.crop(bbox);
         if( ! src_bbox.empty() ) {
@@ -328,67 +514,66 @@ namespace mosaic {
 
 
 template <class PixelT>
-void vw::mosaic::ImageComposite<PixelT>::generate_masks( vw::ProgressCallback const& progress_callback ) const {
-  vw_out(DebugMessage, "mosaic") << "Generating masks..." << std::endl;
-  std::vector<Cache::Handle<GrassfireGenerator> > grassfires;
-  for( unsigned i=0; i<sources.size(); ++i )
-    grassfires.push_back( m_cache.insert( GrassfireGenerator( sourcerefs[i] ) ) );
-  for( unsigned p1=0; p1<sources.size(); ++p1 ) {
-    ImageView<float> mask = copy( *(grassfires[p1]) );
-    for( unsigned p2=0; p2<sources.size(); ++p2 ) {
-      if( p1 == p2 ) continue;
-      int ox = bboxes[p2].min().x() - bboxes[p1].min().x();
-      int oy = bboxes[p2].min().y() - bboxes[p1].min().y();
-      if( ! ( ox >= bboxes[p1].width() ||
-              oy >= bboxes[p1].height() ||
-              -ox >= bboxes[p2].width() ||
-              -oy >= bboxes[p2].height() ) )
-      {
-        ImageView<float> other = *grassfires[p2];
-        int left = std::max( ox, 0 );
-        int top = std::max( oy, 0 );
-        int right = std::min( bboxes[p2].width()+ox, bboxes[p1].width() );
-        int bottom = std::min( bboxes[p2].height()+oy, bboxes[p1].height() );
-        for( int j=top; j<bottom; ++j ) {
-          for( int i=left; i<right; ++i ) {
-            if( ( other(i-ox,j-oy) > mask(i,j) ) ||
-                ( other(i-ox,j-oy) == mask(i,j) && p2 > p1 ) )
-              mask(i,j) = 0;
-          }
-        }
+vw::ImageView<vw::int32> vw::mosaic::ImageComposite<PixelT>::clamped_grassfire( size_t index, BBox2i const& bbox ) const {
+  BBox2i region = bbox;
+  region.expand( blend_radius() );
+  region.crop( bboxes[index] );
+  ImageView<pixel_type> source = crop( sourcerefs[index], region - bboxes[index].min() );
+  ImageView<int32> distance = grassfire( select_alpha_channel( source ) );
+
+  // Within the box, a pixel is at least the radius away from any edge
+  // of the region that is not an edge of the source.
+  ImageView<int32> result( bbox.width(), bbox.height() );
+  for( int32 j=0; j<bbox.height(); ++j )
+    for( int32 i=0; i<bbox.width(); ++i )
+      result(i,j) = std::min( distance( bbox.min().x()-region.min().x()+i, bbox.min().y()-region.min().y()+j ), blend_radius() );
+  return result;
+}
+
+
+template <class PixelT>
+vw::ImageView<typename vw::mosaic::ImageComposite<PixelT>::channel_type>
+vw::mosaic::ImageComposite<PixelT>::blend_mask( size_t index, BBox2i const& window ) const {
+  ImageView<int32> mask = clamped_grassfire( index, window );
+  std::vector<unsigned> overlapping = intersecting_sources( window );
+  for( unsigned k=0; k<overlapping.size(); ++k ) {
+    unsigned p = overlapping[k];
+    if( p == index ) continue;
+    BBox2i overlap = window;
+    overlap.crop( bboxes[p] );
+    ImageView<int32> other = clamped_grassfire( p, overlap );
+    int ox = overlap.min().x() - window.min().x();
+    int oy = overlap.min().y() - window.min().y();
+    for( int j=0; j<overlap.height(); ++j ) {
+      for( int i=0; i<overlap.width(); ++i ) {
+        if( ( other(i,j) > mask(i+ox,j+oy) ) ||
+            ( other(i,j) == mask(i+ox,j+oy) && p > index ) )
+          mask(i+ox,j+oy) = 0;
       }
-      progress_callback.report_fractional_progress( double(p1*(sources.size()+1)+p2+1), double((sources.size()+1)*sources.size()) );
     }
-    mask = threshold( mask );
-    std::ostringstream filename;
-    filename << "mask." << p1 << ".png";
-    write_image( filename.str(), mask );
-    progress_callback.report_fractional_progress( double((p1+1)*(sources.size()+1)), double((sources.size()+1)*sources.size()) );
   }
-  // report_finished() called by prepare(), so don't call it here
+  ImageView<channel_type> result( window.width(), window.height() );
+  for( int j=0; j<window.height(); ++j )
+    for( int i=0; i<window.width(); ++i )
+      result(i,j) = ( mask(i,j) > 0 ) ? ChannelRange<channel_type>::max() : channel_type();
+  return result;
 }
 
 
 template <class PixelT>
 boost::shared_ptr<typename vw::mosaic::ImageComposite<PixelT>::Pyramid> vw::mosaic::ImageComposite<PixelT>::PyramidGenerator::generate() const {
-  vw_out(DebugMessage, "mosaic") << "ImageComposite generating pyramid " << m_index << std::endl;
+  vw_out(DebugMessage, "mosaic") << "ImageComposite generating pyramid " << m_index << " over " << m_window << std::endl;
   boost::shared_ptr<Pyramid> ptr( new Pyramid );
-  ImageView<pixel_type> source = copy(*m_composite.sources[m_index]);
-  m_composite.sources[m_index].release();
-  m_composite.sources[m_index].deprioritize();
+  ImageView<pixel_type> source = crop( m_composite.sourcerefs[m_index], m_window - m_composite.bboxes[m_index].min() );
 
   // This is sort of a kluge: the hole-filling algorithm currently
   // doesn't cope well with partially-transparent source pixels.
   if( m_composite.m_fill_holes ) source /= select_alpha_channel(source);
 
-  PositionedImage<pixel_type> image_high( m_composite.view_bbox.width(), m_composite.view_bbox.height(), source, m_composite.bboxes[m_index] );
+  PositionedImage<pixel_type> image_high( m_composite.view_bbox.width(), m_composite.view_bbox.height(), source, m_window );
   PositionedImage<pixel_type> image_low = image_high.reduce();
-  ImageView<channel_type> mask_image;
-
-  std::ostringstream mask_filename;
-  mask_filename << "mask." << m_index << ".png";
-  read_image( mask_image, mask_filename.str() );
-  PositionedImage<channel_type> mask( m_composite.view_bbox.width(), m_composite.view_bbox.height(), mask_image, m_composite.bboxes[m_index] );
+  PositionedImage<channel_type> mask( m_composite.view_bbox.width(), m_composite.view_bbox.height(),
+                                      m_composite.blend_mask( m_index, m_window ), m_window );
 
   for( int l=0; l<m_composite.levels; ++l ) {
     PositionedImage<pixel_type> diff = image_high;
@@ -410,10 +595,9 @@ boost::shared_ptr<typename vw::mosaic::ImageComposite<PixelT>::Pyramid> vw::mosa
 
 template <class PixelT>
 void vw::mosaic::ImageComposite<PixelT>::insert( ImageViewRef<pixel_type> const& image, int x, int y ) {
+  m_draft_view.reset();
+  pyramids.clear();
   sourcerefs.push_back( image );
-  sources.push_back( m_cache.insert( SourceGenerator( image ) ) );
-  alphas.push_back( m_cache.insert( AlphaGenerator( *this, pyramids.size() ) ) );
-  pyramids.push_back( m_cache.insert( PyramidGenerator( *this, pyramids.size() ) ) );
 
   int cols = image.cols(), rows = image.rows();
   BBox2i image_bbox( Vector2i(x, y), Vector2i(x+cols, y+rows) );
@@ -434,15 +618,59 @@ void vw::mosaic::ImageComposite<PixelT>::insert( ImageViewRef<pixel_type> const&
 template <class PixelT>
 void vw::mosaic::ImageComposite<PixelT>::prepare( vw::ProgressCallback const& progress_callback ) {
   // Translate bboxes to origin
-  for( unsigned i=0; i<sources.size(); ++i )
+  for( unsigned i=0; i<bboxes.size(); ++i )
     bboxes[i] -= view_bbox.min();
   data_bbox -= view_bbox.min();
 
   levels = (int) floorf( logf( float(mindim)/2.0f ) / logf(2.0f) ) - 1;
   if( levels < 1 ) levels = 1;
+  if( levels > max_blend_levels ) levels = max_blend_levels;
+
+  // Index the sources, so that a patch only visits the ones over it
+  m_source_tree.reset();
+  m_source_boxes.reset( new std::vector<SourceBox>( bboxes.size() ) );
+  std::vector<geometry::GeomPrimitive*> prims( bboxes.size() );
+  for( unsigned i=0; i<bboxes.size(); ++i ) {
+    SourceBox & source_box = (*m_source_boxes)[i];
+    source_box.box   = BBoxN( Vector2( bboxes[i].min() ), Vector2( bboxes[i].max() ) );
+    source_box.index = i;
+    prims[i] = &source_box;
+  }
+  if( ! prims.empty() )
+    m_source_tree.reset( new geometry::SpatialTree( int(prims.size()), &prims[0] ) );
+
+  // In draft mode, output blocks are composited once and cached
+  m_draft_view.reset();
+  if( m_draft_mode && cols() > 0 && rows() > 0 ) {
+    const int32 block_size = 256;
+    m_draft_view.reset( new BlockRasterizeView<DraftCompositeView<pixel_type> >
+                        ( DraftCompositeView<pixel_type>( sourcerefs, bboxes, cols(), rows(), block_size ),
+                          Vector2i(block_size,block_size), 1, &m_cache ) );
+  }
 
-  if( !m_draft_mode && !m_reuse_masks ) {
-    generate_masks( progress_callback );
+  // Otherwise each block is blended from pyramids of the sources over
+  // its footprint, which match the pyramids of the whole sources over
+  // the block. They are built as they are needed, and the cache keeps
+  // them for the other patches in the block.
+  pyramids.clear();
+  m_blocks_x = 0;
+  if( !m_draft_mode && cols() > 0 && rows() > 0 ) {
+    m_blocks_x = (cols()-1) / blend_block_size + 1;
+    int32 blocks_y = (rows()-1) / blend_block_size + 1;
+    pyramids.resize( size_t(m_blocks_x) * size_t(blocks_y) );
+    for( int32 by=0; by<blocks_y; ++by ) {
+      for( int32 bx=0; bx<m_blocks_x; ++bx ) {
+        BBox2i footprint = blend_footprint( BBox2i( bx*blend_block_size, by*blend_block_size,
+                                                    blend_block_size, blend_block_size ) );
+        std::vector<unsigned> overlapping = intersecting_sources( footprint );
+        for( unsigned k=0; k<overlapping.size(); ++k ) {
+          BBox2i window = footprint;
+          window.crop( bboxes[overlapping[k]] );
+          pyramids[bx + by*m_blocks_x].push_back( m_cache.insert( PyramidGenerator( *this, overlapping[k], window ) ) );
+        }
+      }
+      progress_callback.report_fractional_progress( by+1, blocks_y );
+    }
   }
   progress_callback.report_finished();
 }
@@ -454,6 +682,29 @@ void vw::mosaic::ImageComposite<PixelT>::prepare( BBox2i const& total_bbox,
   prepare( progress_callback );
 }
 
+template <class PixelT>
+std::vector<unsigned> vw::mosaic::ImageComposite<PixelT>::intersecting_sources( BBox2i const& bbox ) const {
+  std::vector<unsigned> result;
+  if( ! m_source_tree ) {
+    for( unsigned p=0; p<bboxes.size(); ++p )
+      if( bbox.intersects( bboxes[p] ) )
+        result.push_back( p );
+    return result;
+  }
+
+  // The tree treats boxes as closed, so it may return sources that
+  // only touch the box. Those are dropped here.
+  std::list<geometry::GeomPrimitive*> prims;
+  m_source_tree->intersects( BBoxN( Vector2( bbox.min() ), Vector2( bbox.max() ) ), prims );
+  for( std::list<geometry::GeomPrimitive*>::const_iterator it = prims.begin(); it != prims.end(); ++it ) {
+    unsigned p = static_cast<SourceBox const*>( *it )->index;
+    if( bbox.intersects( bboxes[p] ) )
+      result.push_back( p );
+  }
+  std::sort( result.begin(), result.end() );
+  return result;
+}
+
 // Suppose a destination image patch at a given level of the pyramid
 // has a bounding box that begins at offset x and has width w.  It
 // is affected by a range of pixels at the next level of the pyramid
@@ -462,10 +713,48 @@ void vw::mosaic::ImageComposite<PixelT>::prepare( BBox2i const& total_bbox,
 // the range starting at 2*(x/2)-1 = x-x%2-1 with width
 // (2*(x+w)/2+1)-(2*(x/2)-1)+1 = w-(x+w)%2+x%2+3.
 
+template <class PixelT>
+vw::BBox2i vw::mosaic::ImageComposite<PixelT>::blend_footprint( BBox2i const& patch_bbox ) const {
+  BBox2i padded_bbox = patch_bbox;
+  for( int l=0; l<levels-1; ++l ) {
+    padded_bbox.min().x() = padded_bbox.min().x()/2;
+    padded_bbox.min().y() = padded_bbox.min().y()/2;
+    padded_bbox.max().x() = padded_bbox.max().x()/2+1;
+    padded_bbox.max().y() = padded_bbox.max().y()/2+1;
+  }
+  for( int l=0; l<levels-1; ++l ) {
+    padded_bbox.min().x() = 2*padded_bbox.min().x()-1;
+    padded_bbox.min().y() = 2*padded_bbox.min().y()-1;
+    padded_bbox.max().x() = 2*padded_bbox.max().x();
+    padded_bbox.max().y() = 2*padded_bbox.max().y();
+  }
+  return padded_bbox;
+}
+
 // Generates a full-resolution patch of the mosaic corresponding
 // to the given bounding box.
 template <class PixelT>
 vw::ImageView<PixelT> vw::mosaic::ImageComposite<PixelT>::blend_patch( BBox2i const& patch_bbox ) const {
+  VW_ASSERT( m_blocks_x > 0, LogicErr() << "ImageComposite: prepare() must be called before blending." );
+  if( patch_bbox.min().x() / blend_block_size == (patch_bbox.max().x()-1) / blend_block_size &&
+      patch_bbox.min().y() / blend_block_size == (patch_bbox.max().y()-1) / blend_block_size )
+    return blend_block( patch_bbox.min().x() / blend_block_size + patch_bbox.min().y() / blend_block_size * m_blocks_x,
+                        patch_bbox );
+
+  // Blend the part of the patch in each block separately
+  ImageView<pixel_type> composite( patch_bbox.width(), patch_bbox.height() );
+  for( int32 by=patch_bbox.min().y()/blend_block_size; by<=(patch_bbox.max().y()-1)/blend_block_size; ++by ) {
+    for( int32 bx=patch_bbox.min().x()/blend_block_size; bx<=(patch_bbox.max().x()-1)/blend_block_size; ++bx ) {
+      BBox2i bbox( bx*blend_block_size, by*blend_block_size, blend_block_size, blend_block_size );
+      bbox.crop( patch_bbox );
+      crop( composite, bbox - patch_bbox.min() ) = blend_block( bx + by*m_blocks_x, bbox );
+    }
+  }
+  return composite;
+}
+
+template <class PixelT>
+vw::ImageView<PixelT> vw::mosaic::ImageComposite<PixelT>::blend_block( size_t block, BBox2i const& patch_bbox ) const {
 #if VW_DEBUG_LEVEL > 1
   vw_out(DebugMessage, "mosaic") << "ImageComposite compositing patch " << patch_bbox << "..." << std::endl;
 #endif
@@ -483,41 +772,25 @@ vw::ImageView<PixelT> vw::mosaic::ImageComposite<PixelT>::blend_patch( BBox2i co
     msum_pyr[l] = ImageView<channel_type>( bbox_pyr[l].width(), bbox_pyr[l].height() );
   }
 
-  // Compute the bounding box for source pixels that could
-  // impact the patch.
-  BBox2i padded_bbox = patch_bbox;
-  for( int l=0; l<levels-1; ++l ) {
-    padded_bbox.min().x() = padded_bbox.min().x()/2;
-    padded_bbox.min().y() = padded_bbox.min().y()/2;
-    padded_bbox.max().x() = padded_bbox.max().x()/2+1;
-    padded_bbox.max().y() = padded_bbox.max().y()/2+1;
-  }
-  for( int l=0; l<levels-1; ++l ) {
-    padded_bbox.min().x() = 2*padded_bbox.min().x()-1;
-    padded_bbox.min().y() = 2*padded_bbox.min().y()-1;
-    padded_bbox.max().x() = 2*padded_bbox.max().x();
-    padded_bbox.max().y() = 2*padded_bbox.max().y();
-  }
-
-  // Make a list of the images whose bounding boxes permit them to
-  // impact the patch, prioritizing ones that are already in memory.
+  // The pyramids of the block cover the sources that could impact
+  // the patch. Use the ones that are already in memory first.
+  std::vector<Cache::Handle<PyramidGenerator> > const& block_pyramids = pyramids[block];
   std::list<unsigned> image_list;
-  for( unsigned p=0; p<sources.size(); ++p ) {
-    if( ! padded_bbox.intersects( bboxes[p] ) ) continue;
-    if( ! pyramids[p].valid() ) image_list.push_back( p );
-    else image_list.push_front( p );
+  for( unsigned k=0; k<block_pyramids.size(); ++k ) {
+    if( ! block_pyramids[k].valid() ) image_list.push_back( k );
+    else image_list.push_front( k );
   }
 
   // Add each source image pyramid to the blend pyramid.
   std::list<unsigned>::iterator ili=image_list.begin(), ilend=image_list.end();
   for( ; ili!=ilend; ++ili ) {
-    unsigned p = *ili;
-    boost::shared_ptr<Pyramid> pyr = pyramids[p];
+    Cache::Handle<PyramidGenerator> const& handle = block_pyramids[*ili];
+    boost::shared_ptr<Pyramid> pyr = handle;
     for( int l=0; l<levels; ++l ) {
       pyr->images[l].addto( sum_pyr [l], bbox_pyr[l].min().x(), bbox_pyr[l].min().y() );
       pyr->masks [l].addto( msum_pyr[l], bbox_pyr[l].min().x(), bbox_pyr[l].min().y() );
     }
-    pyramids[p].release();
+    handle.release();
   }
 
   // Collapse the pyramid
@@ -539,22 +812,22 @@ vw::ImageView<PixelT> vw::mosaic::ImageComposite<PixelT>::blend_patch( BBox2i co
   }
   else {
 
-    // Trim to the maximal source alpha, reloading images if needed
+    // Trim to the maximal source alpha over the patch
     ImageView<channel_type> alpha( patch_bbox.width(), patch_bbox.height() );
-    for( unsigned p=0; p<sources.size(); ++p ) {
-      if( ! patch_bbox.intersects( bboxes[p] ) ) continue;
-
-      ImageView<channel_type> source_alpha = *alphas[p];
-      alphas[p].release();
+    std::vector<unsigned> patch_sources = intersecting_sources( patch_bbox );
+    for( unsigned k=0; k<patch_sources.size(); ++k ) {
+      unsigned p = patch_sources[k];
 
       BBox2i overlap = patch_bbox;
       overlap.crop( bboxes[p] );
+      ImageView<pixel_type> source = crop( sourcerefs[p], overlap - bboxes[p].min() );
+      ImageView<channel_type> source_alpha = select_alpha_channel( source );
       for( int j=0; j<overlap.height(); ++j ) {
         for( int i=0; i<overlap.width(); ++i ) {
-          if( source_alpha( overlap.min().x()+i-bboxes[p].min().x(), overlap.min().y()+j-bboxes[p].min().y() ) >
+          if( source_alpha( i, j ) >
               alpha( overlap.min().x()+i-patch_bbox.min().x(), overlap.min().y()+j-patch_bbox.min().y() ) ) {
             alpha( overlap.min().x()+i-patch_bbox.min().x(), overlap.min().y()+j-patch_bbox.min().y() ) =
-              source_alpha( overlap.min().x()+i-bboxes[p].min().x(), overlap.min().y()+j-bboxes[p].min().y() );
+              source_alpha( i, j );
           }
         }
       }
@@ -575,15 +848,21 @@ vw::ImageView<PixelT> vw::mosaic::ImageComposite<PixelT>::draft_patch( BBox2i co
   vw_out(DebugMessage, "mosaic") << "ImageComposite compositing patch " << patch_bbox << "..." << std::endl;
 #endif
   ImageView<pixel_type> composite(patch_bbox.width(),patch_bbox.height());
+  if( m_draft_view ) {
+    m_draft_view->rasterize( composite, patch_bbox );
+    return composite;
+  }
 
-  // Add each image to the composite.
-  for( unsigned p=0; p<sources.size(); ++p ) {
-    if( ! patch_bbox.intersects( bboxes[p] ) ) continue;
+  // Lay each image over the composite.
+  std::vector<unsigned> overlapping = intersecting_sources( patch_bbox );
+  for( unsigned k=0; k<overlapping.size(); ++k ) {
+    unsigned p = overlapping[k];
     BBox2i bbox = patch_bbox;
     bbox.crop( bboxes[p] );
-    PositionedImage<pixel_type> image( view_bbox.width(), view_bbox.height(),
-                                       crop(sourcerefs[p],bbox-bboxes[p].min()), bbox );
-    image.addto( composite, patch_bbox.min().x(), patch_bbox.min().y(), true );
+    ImageView<pixel_type> image = crop( sourcerefs[p], bbox-bboxes[p].min() );
+    Vector2i offset = bbox.min() - patch_bbox.min();
+    for( int32 j=0; j<bbox.height(); ++j )
+      draft_overlay_row( &composite(offset.x(),offset.y()+j), &image(0,j), bbox.width() );
   }
 
   return composite;
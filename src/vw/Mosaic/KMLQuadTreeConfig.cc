@@ -304,11 +304,15 @@ namespace mosaic {
 
     kml << "</Folder>\n</kml>\n";
 
-    // Skip this file if there aren't any real contents
+    // Skip this file if there aren't any real contents, removing the
+    // one left by an earlier run when the tree is being updated
     if( num_children != 0 ) {
       fs::ofstream kmlfs( kml_path );
       kmlfs << kml.str();
     }
+    else if( ! qtree.get_dirty_bboxes().empty() ) {
+      fs::remove( kml_path );
+    }
   }
 
   std::vector<std::pair<std::string,vw::BBox2i> > KMLQuadTreeConfigData::branch_func( QuadTreeGenerator const& qtree, std::string const& name, BBox2i const& region ) const {
@@ -83,13 +83,56 @@ namespace mosaic {
     return boost::shared_ptr<DstImageResource>( DiskImageResource::create( info.filepath+info.filetype, format ) );
   }
 
+  bool QuadTreeGenerator::is_dirty( BBox2i const& region ) const {
+    if( m_dirty_bboxes.empty() )
+      return true;
+    for( unsigned i=0; i<m_dirty_bboxes.size(); ++i )
+      if( region.intersects( m_dirty_bboxes[i] ) )
+        return true;
+    return false;
+  }
+
+  std::vector<std::string> QuadTreeGenerator::tile_file_types() const {
+    std::vector<std::string> types;
+    if( m_file_type == "auto" ) {
+      types.push_back( ".jpg" );
+      types.push_back( ".png" );
+    }
+    else {
+      types.push_back( "." + m_file_type );
+    }
+    return types;
+  }
+
+  boost::shared_ptr<SrcImageResource> QuadTreeGenerator::open_tile( std::string const& name ) const {
+    std::string path = image_path( name );
+    std::vector<std::string> types = tile_file_types();
+    for( unsigned i=0; i<types.size(); ++i ) {
+      if( fs::exists( path + types[i] ) )
+        return boost::shared_ptr<SrcImageResource>( DiskImageResource::open( path + types[i] ) );
+    }
+    return boost::shared_ptr<SrcImageResource>();
+  }
+
+  void QuadTreeGenerator::remove_tile( std::string const& name ) const {
+    std::string path = image_path( name );
+    std::vector<std::string> types = tile_file_types();
+    for( unsigned i=0; i<types.size(); ++i )
+      fs::remove( path + types[i] );
+  }
+
   void QuadTreeGenerator::generate( const ProgressCallback &progress_callback ) {
     ScopedWatch sw("QuadTreeGenerator::generate");
     int32 tree_levels = get_tree_levels();
 
+    if( ! m_dirty_bboxes.empty() && m_crop_images )
+      vw_throw( NoImplErr() << "QuadTreeGenerator: Trees with cropped tiles can not be updated in place." );
+
     vw_out(DebugMessage, "mosaic") << "Using tile size: "               << m_tile_size << " pixels" << std::endl;
     vw_out(DebugMessage, "mosaic") << "Generating tile files of type: " << m_file_type << std::endl;
     vw_out(DebugMessage, "mosaic") << "Generating quadtree with "       << tree_levels << " levels." << std::endl;
+    if( ! m_dirty_bboxes.empty() )
+      vw_out(DebugMessage, "mosaic") << "Updating the tiles over "      << m_dirty_bboxes.size() << " changed regions." << std::endl;
 
     BBox2i region_bbox = BBox2i(0,0,m_tile_size,m_tile_size) * (1<<(tree_levels-1));
     m_processor->generate( region_bbox, progress_callback );
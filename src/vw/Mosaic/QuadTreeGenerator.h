@@ -38,12 +38,17 @@
 #pragma GCC diagnostic pop
 
 #include <vw/Core/ProgressCallback.h>
+#include <vw/Core/Settings.h>
 #include <vw/Core/Stopwatch.h>
+#include <vw/Core/ThreadPool.h>
 #include <vw/Image/EdgeExtension.h>
 #include <vw/Image/SparseImageCheck.h>
+#include <vw/Image/OccupancyMap.h>
 #include <vw/Image/ImageView.h>
 #include <vw/Image/ImageViewRef.h>
+#include <vw/Image/ImageIO.h>
 #include <vw/Image/Algorithms.h>
+#include <vw/Image/AntiAliasing.h>
 #include <vw/Image/ImageOpacity.h>
 #include <vw/Image/Filter.h>
 #include <vw/Image/Manipulation.h>
@@ -52,22 +57,9 @@
 namespace vw {
 namespace mosaic {
 
-  // This feature, or something like it, should be implemented better and
-  // moved somewhere into the Image module.
-  /// ???
-  template <class PixelT>
-  ImageView<PixelT> box_subsample( ImageView<PixelT> const& image, Vector2i const& scale ) {
-    std::vector<double> xkernel(scale.x()), ykernel(scale.y());
-    for( int x=0; x<scale.x(); ++x ) 
-      xkernel[x] = 1.0 / scale.x();
-    for( int y=0; y<scale.y(); ++y ) 
-      ykernel[y] = 1.0 / scale.y();
-    
-    ImageView<PixelT> result( image.cols()/scale.x(), image.rows()/scale.y() );
-    rasterize( subsample( separable_convolution_filter( image, xkernel, ykernel, scale.x()-1, scale.y()-1 ), scale.x(), scale.y() ), result );
-    return result;
-  }
-  
+  // Now in the Image module, and still found here for existing callers
+  using vw::box_subsample;
+
   /// A class that generates filesystem-based quadtrees of large images.
   class QuadTreeGenerator {
   public:
@@ -104,6 +96,8 @@ namespace mosaic {
         m_crop_bbox(),
         m_crop_images( false ),
         m_cull_images( false ),
+        m_use_occupancy_map( false ),
+        m_num_threads( 1 ),
         m_dimensions( image.impl().cols(), image.impl().rows() ),
         m_processor( new Processor<typename ImageT::pixel_type>( this, image.impl() ) ),
         m_image_path_func( simple_image_path() ),
@@ -119,6 +113,22 @@ namespace mosaic {
       m_processor = processor;
     }
 
+    /// Generate the tree. With more than one thread (see
+    /// set_num_threads(), where 0 means the default number), subtrees
+    /// are generated and written in parallel, so the path, branch,
+    /// resource and metadata functions must be thread-safe. The tiles
+    /// are the same as with one thread, which is the default.
+    ///
+    /// If dirty boxes are set (see set_dirty_bboxes()), the tree on
+    /// disk is updated instead: only the tiles over those boxes of the
+    /// source image, and the tiles above them up to the root, are made
+    /// again. The tiles of the other branches are read back from disk
+    /// where a parent needs them, so the source is only read in the
+    /// dirty boxes. As JPEG tiles are lossy, and PNG tiles store the
+    /// pixels unpremultiplied, the parents may differ a little from
+    /// those of a full regeneration. The tree must have been generated
+    /// before with the same settings, and without cropped tiles, which
+    /// can not be placed back in their region.
     void generate( const ProgressCallback &progress_callback = ProgressCallback::dummy_instance() );
 
     void set_crop_bbox( BBox2i const& bbox ) {
@@ -144,6 +154,9 @@ namespace mosaic {
     Vector2i    const& get_dimensions()  const { return m_dimensions;  }
     bool               get_crop_images() const { return m_crop_images; }
     bool               get_cull_images() const { return m_cull_images; }
+    bool               get_use_occupancy_map() const { return m_use_occupancy_map; }
+    int32              get_num_threads() const { return m_num_threads; }
+    std::vector<BBox2i> const& get_dirty_bboxes() const { return m_dirty_bboxes; }
     sparse_image_check_type const& sparse_image_check() const { return m_sparse_image_check; }
 
 
@@ -153,6 +166,9 @@ namespace mosaic {
     void set_tile_size         (int32                          size              ) {m_tile_size          = size;              }
     void set_crop_images       (bool                           crop              ) {m_crop_images        = crop;              }
     void set_cull_images       (bool                           cull              ) {m_cull_images        = cull;              }
+    void set_use_occupancy_map (bool                           use               ) {m_use_occupancy_map  = use;               }
+    void set_num_threads       (int32                          num_threads       ) {m_num_threads        = num_threads;       }
+    void set_dirty_bboxes      (std::vector<BBox2i>     const& bboxes            ) {m_dirty_bboxes       = bboxes;            }
     void set_image_path_func   (image_path_func_type           image_path_func   ) {m_image_path_func    = image_path_func;   }
     void set_branch_func       (branch_func_type        const& branch_func       ) {m_branch_func        = branch_func;       }
     void set_tile_resource_func(tile_resource_func_type const& tile_resource_func) {m_tile_resource_func = tile_resource_func;}
@@ -178,6 +194,21 @@ namespace mosaic {
       }
     }
 
+    /// Whether a region of the source image must be made again, which
+    /// is always the case unless dirty boxes are set.
+    bool is_dirty( BBox2i const& region ) const;
+
+    /// The file extensions that the tiles may have, such as ".png".
+    std::vector<std::string> tile_file_types() const;
+
+    /// Open the tile of a branch from the tree on disk. Returns a null
+    /// pointer if it has no tile, such as when it was culled.
+    boost::shared_ptr<SrcImageResource> open_tile( std::string const& name ) const;
+
+    /// Remove the tile of a branch from the tree on disk, in each of
+    /// the file types it may have.
+    void remove_tile( std::string const& name ) const;
+
     // Here we have a set of functor classes which contain different implementations of a path generation function
 
     /// Makes paths of the form "path/name/r0132.jpg".  More accurately: [qtree.get_name()]/r[name]
@@ -214,6 +245,8 @@ namespace mosaic {
     template <class PixelT>
     class Processor : public ProcessorBase {
       ImageViewRef<PixelT> m_source;
+      std::map<std::string, ImageView<PixelT> > m_subtrees; ///< Top tiles of the subtrees made in parallel
+      OccupancyMap m_occupancy; ///< Which tile-sized cells of the source have data, if wanted
 
     public:
       /// Construct the image with the qtree object and the full resolution source image
@@ -224,13 +257,125 @@ namespace mosaic {
 
       /// Top level call to generate a qtree from a specified region of the input image.
       void generate( BBox2i const& region_bbox, const ProgressCallback &progress_callback ) {
+        int32 num_threads = qtree->get_num_threads();
+        if( num_threads <= 0 )
+          num_threads = vw_settings().default_num_threads();
+
+        // Only tiles with transparency are culled or cropped, so only
+        // those can skip the regions without data
+        m_occupancy = OccupancyMap();
+        if( qtree->m_use_occupancy_map && PixelHasAlpha<PixelT>::value &&
+            ( qtree->m_crop_images || qtree->m_cull_images ) ) {
+          ScopedWatch sw("QuadTreeGenerator::occupancy_map");
+          m_occupancy = OccupancyMap( m_source, qtree->m_tile_size, num_threads );
+        }
+
+        m_subtrees.clear();
+        if( num_threads > 1 && qtree->get_tree_levels() > 1 ) {
+          // Make the subtrees in parallel, then the levels above them from their top tiles
+          generate_subtrees( region_bbox, num_threads, progress_callback );
+          generate_branch( "", region_bbox, ProgressCallback::dummy_instance() );
+          m_subtrees.clear();
+          return;
+        }
+
         // Just redirect to the branch function leaving the name blank.
         generate_branch( "", region_bbox, progress_callback );
       }
 
+      /// The part of a region that is in the source image and the crop box.
+      BBox2i image_bbox( BBox2i const& region_bbox ) const {
+        BBox2i crop_bbox(Vector2i(), qtree->get_dimensions());
+        if( ! qtree->get_crop_bbox().empty() ) 
+          crop_bbox.crop( qtree->get_crop_bbox() );
+        BBox2i bbox = region_bbox;
+        bbox.crop( crop_bbox );
+        return bbox;
+      }
+
+      /// Whether a region may have data, by the sparse image check and
+      /// the occupancy map. A region with none makes no tiles.
+      bool has_data( BBox2i const& region_bbox ) const {
+        if( qtree->m_sparse_image_check && ! qtree->m_sparse_image_check(region_bbox) )
+          return false;
+        return m_occupancy.cell_size() == 0 || ! m_occupancy.is_empty( region_bbox );
+      }
+
+      /// Find the branches a number of levels below a region that
+      /// generate_branch() would visit, in the order it would visit them.
+      void find_subtrees( std::string const& name, BBox2i const& region_bbox, int32 levels,
+                          std::vector<std::pair<std::string, BBox2i> > & subtrees ) const {
+        BBox2i bbox = image_bbox( region_bbox );
+        if( bbox.empty() )
+          return;
+        if( ! has_data( region_bbox ) )
+          return;
+        if( levels == 0 ) {
+          subtrees.push_back( std::make_pair(name, region_bbox) );
+          return;
+        }
+        std::vector<std::pair<std::string, BBox2i> > children = qtree->m_branch_func(*qtree, name, region_bbox);
+        for( unsigned i=0; i<children.size(); ++i ) {
+          BBox2i child_bbox = children[i].second;
+          child_bbox.crop( bbox );
+          if( ! child_bbox.empty() )
+            find_subtrees( children[i].first, children[i].second, levels-1, subtrees );
+        }
+      }
+
+      /// Generate the subtrees a few levels below the top of the tree
+      /// with a pool of threads, keeping their top tiles for
+      /// generate_branch(). Each thread makes a subtree depth-first, so
+      /// it holds only a few tiles per level, and writes its tiles as it
+      /// goes. The tiles are the same as those made by a single thread.
+      void generate_subtrees( BBox2i const& region_bbox, int32 num_threads,
+                              const ProgressCallback &progress_callback ) {
+        // Have several subtrees per thread, as sparse ones finish quickly
+        int32 levels = 0;
+        for( int64 count = 1; count < 4*num_threads && levels < qtree->get_tree_levels()-1; count *= 4 )
+          levels++;
+        std::vector<std::pair<std::string, BBox2i> > subtrees;
+        find_subtrees( "", region_bbox, levels, subtrees );
+
+        double total_area = 0, done_area = 0;
+        for( unsigned i=0; i<subtrees.size(); ++i )
+          total_area += (double) image_bbox(subtrees[i].second).width() * image_bbox(subtrees[i].second).height();
+
+        std::vector<ImageView<PixelT> > images( subtrees.size() );
+        Mutex mutex;
+        auto generate_subtree = [&]( size_t begin, size_t end ) {
+          for( size_t i = begin; i < end; i++ ) {
+            if( progress_callback.abort_requested() )
+              return;
+            images[i] = generate_branch( subtrees[i].first, subtrees[i].second,
+                                         ProgressCallback::dummy_instance() );
+            BBox2i bbox = image_bbox( subtrees[i].second );
+            Mutex::WriteLock lock( mutex );
+            done_area += (double) bbox.width() * bbox.height();
+            progress_callback.report_progress( done_area / total_area );
+          }
+        };
+
+        // One task per subtree, started in the order of a serial run
+        FifoWorkQueue queue( num_threads );
+        for( size_t i = 0; i < subtrees.size(); i++ )
+          queue.add_task( boost::shared_ptr<Task>( new RangeTask<decltype(generate_subtree)>( generate_subtree, i, i+1 ) ) );
+        queue.join_all();
+        progress_callback.abort_if_requested();
+
+        for( size_t i = 0; i < subtrees.size(); i++ )
+          m_subtrees[subtrees[i].first] = images[i];
+      }
+
       /// Generate all images and metadata files (all the way down the tree) for a named region of the input image.
       /// - Note that region_bbox is always in the original source image, not the parent of this particular branch.
       ImageView<PixelT> generate_branch( std::string const& name, BBox2i const& region_bbox, const ProgressCallback &progress_callback ) {
+        if( ! m_subtrees.empty() ) { // Already made by generate_subtrees()
+          typename std::map<std::string, ImageView<PixelT> >::const_iterator it = m_subtrees.find( name );
+          if( it != m_subtrees.end() )
+            return it->second;
+        }
+
         progress_callback.report_progress(0);
         progress_callback.abort_if_requested();
 
@@ -238,12 +383,7 @@ namespace mosaic {
         TileInfo info;
         info.name = name;
         info.region_bbox = region_bbox;
-
-        BBox2i crop_bbox(Vector2i(), qtree->get_dimensions());
-        if( ! qtree->get_crop_bbox().empty() ) 
-          crop_bbox.crop( qtree->get_crop_bbox() );
-        info.image_bbox = info.region_bbox;
-        info.image_bbox.crop( crop_bbox );
+        info.image_bbox  = image_bbox( region_bbox );
 
         if( info.image_bbox.empty() ) {
           if( ! (qtree->get_crop_images() || qtree->get_cull_images()) )
@@ -251,8 +391,17 @@ namespace mosaic {
           return image;
         }
 
-        if( qtree->m_sparse_image_check && ! qtree->m_sparse_image_check(info.region_bbox) ) 
-            return image;
+        if( ! has_data( info.region_bbox ) ) {
+          if( ! qtree->m_dirty_bboxes.empty() && qtree->is_dirty( info.region_bbox ) )
+            remove_branch( info.name, info.region_bbox ); // Its data is gone
+          return image;
+        }
+
+        // Unchanged, so the tile on disk is up to date, and a parent
+        // that is made again uses it as it comes back from the file.
+        // Its branch is not visited.
+        if( ! qtree->is_dirty( info.region_bbox ) )
+          return read_tile( info.name );
 
         Vector2i scale = info.region_bbox.size() / qtree->m_tile_size;
 
@@ -298,8 +447,18 @@ namespace mosaic {
         if( qtree->m_crop_images || qtree->m_cull_images ) {
         
           BBox2i data_bbox = elem_quot( info.image_bbox-info.region_bbox.min(), scale );
-          if( PixelHasAlpha<PixelT>::value )
-            data_bbox.crop( nonzero_data_bounding_box( image ) );
+          if( PixelHasAlpha<PixelT>::value ) {
+            // The occupancy map has the data of full resolution leaves
+            // that the crop box does not cut
+            BBox2i nonzero_bbox;
+            if( children.empty() && scale == Vector2i(1,1) &&
+                info.image_bbox == info.region_bbox &&
+                m_occupancy.data_bbox( info.region_bbox, nonzero_bbox ) )
+              nonzero_bbox = nonzero_bbox.empty() ? BBox2i(0,0,0,0) : nonzero_bbox - info.region_bbox.min();
+            else
+              nonzero_bbox = nonzero_data_bounding_box( image );
+            data_bbox.crop( nonzero_bbox );
+          }
             
           if( data_bbox.width() != qtree->m_tile_size || data_bbox.height() != qtree->m_tile_size ) {
             if( data_bbox.empty() ) { 
@@ -315,7 +474,9 @@ namespace mosaic {
         } // End crop or cull images case
 
         if( qtree->m_file_type == "auto" ) {
-          if( is_opaque( cropped_image ) ) 
+          bool opaque_leaf = children.empty() && scale == Vector2i(1,1) &&
+                             info.image_bbox == info.region_bbox && m_occupancy.is_opaque( info.region_bbox );
+          if( opaque_leaf || is_opaque( cropped_image ) ) 
             info.filetype += ".jpg";  // Use jpg for images with no alpha channel
           else 
             info.filetype += ".png"; // Use png for images with transparency
@@ -326,6 +487,8 @@ namespace mosaic {
 
         // Retrieve the output path for this tile and write it to disk
         info.filepath = qtree->m_image_path_func( *qtree, info.name );
+        if( ! qtree->m_dirty_bboxes.empty() ) // The old tile may be culled now, or of another type
+          qtree->remove_tile( info.name );
         if( cropped_image.is_valid_image() ) {
           ScopedWatch sw("QuadTreeGenerator::write_tile");
           boost::shared_ptr<DstImageResource> r = qtree->m_tile_resource_func( *qtree, info, cropped_image.format() );
@@ -338,6 +501,46 @@ namespace mosaic {
         progress_callback.report_progress(1);
         return image;
       }
+
+      /// Remove the tiles of a branch from the tree on disk, when it has
+      /// no data any more. The metadata function is called for each
+      /// tile, as for culled tiles, so that it can remove its files.
+      void remove_branch( std::string const& name, BBox2i const& region_bbox ) const {
+        BBox2i bbox = image_bbox( region_bbox );
+        std::vector<std::pair<std::string, BBox2i> > children = qtree->m_branch_func(*qtree, name, region_bbox);
+        for( unsigned i=0; i<children.size(); ++i ) {
+          BBox2i child_bbox = children[i].second;
+          child_bbox.crop( bbox );
+          if( ! child_bbox.empty() )
+            remove_branch( children[i].first, children[i].second );
+        }
+        qtree->remove_tile( name );
+        if( qtree->m_metadata_func ) {
+          TileInfo info;
+          info.name        = name;
+          info.region_bbox = region_bbox;
+          info.image_bbox  = bbox;
+          info.filepath    = qtree->m_image_path_func( *qtree, name );
+          info.filetype    = qtree->tile_file_types().front();
+          qtree->m_metadata_func( *qtree, info );
+        }
+      }
+
+      /// Read back the tile of a branch from the tree on disk, or an
+      /// empty image if it has none. JPEG tiles are lossy, and others
+      /// such as PNG store the pixels unpremultiplied, so the pixels may
+      /// differ a little from the ones that were written.
+      ImageView<PixelT> read_tile( std::string const& name ) const {
+        ImageView<PixelT> image;
+        boost::shared_ptr<SrcImageResource> r = qtree->open_tile( name );
+        if( ! r )
+          return image;
+        VW_ASSERT( r->cols() == qtree->m_tile_size && r->rows() == qtree->m_tile_size,
+                   IOErr() << "QuadTreeGenerator: Tile \"" << name << "\" on disk is not "
+                           << qtree->m_tile_size << " pixels square." );
+        read_image( image, *r );
+        return image;
+      }
     }; // End class Processor
 
     template<class> friend class Processor;
@@ -349,7 +552,10 @@ namespace mosaic {
     BBox2i      m_crop_bbox;
     bool        m_crop_images;
     bool        m_cull_images;
+    bool        m_use_occupancy_map;
+    int32       m_num_threads;
     Vector2i    m_dimensions;
+    std::vector<BBox2i> m_dirty_bboxes;
     boost::shared_ptr<ProcessorBase> m_processor;
 
     // A bunch of function types
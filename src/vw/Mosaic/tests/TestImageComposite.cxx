@@ -18,6 +18,10 @@
 
 #include <gtest/gtest_VW.h>
 #include <vw/Mosaic/ImageComposite.h>
+#include <vw/Core/Stopwatch.h>
+#include <vw/Image/Filter.h>
+
+#include <cstdlib>
 
 using namespace std;
 using namespace vw;
@@ -50,3 +54,225 @@ TEST(TestImageComposite, Basic) {
       EXPECT_EQ(2, c(col, row)) << "at (" << col << "," << row << ")";
   }
 }
+
+TEST(TestImageComposite, ManySources) {
+  // Many small images scattered over a large area, overlapping here
+  // and there. Later images are drawn over earlier ones.
+  const int num_images = 10000, size = 2000;
+  ImageView<uint32> expected(size, size);
+  ImageComposite<uint32> c;
+  c.set_draft_mode(true);
+  std::srand(5);
+  for (int i = 0; i < num_images; i++) {
+    int x = std::rand() % (size - 24), y = std::rand() % (size - 24);
+    ImageView<uint32> img(8 + std::rand() % 16, 8 + std::rand() % 16);
+    fill(img, uint32(i + 1));
+    c.insert(img, x, y);
+    crop(expected, x, y, img.cols(), img.rows()) = img;
+  }
+  c.prepare(BBox2i(0, 0, size, size));
+  ASSERT_EQ(size, c.cols());
+  ASSERT_EQ(size, c.rows());
+
+  // Time the tiles, which is mostly the overhead of finding the
+  // sources over each one
+  const int tile = 64;
+  ImageView<uint32> result(size, size);
+  int num_tiles = 0;
+  uint64 start = Stopwatch::microtime();
+  for (int row = 0; row < size; row += tile) {
+    for (int col = 0; col < size; col += tile) {
+      BBox2i bbox(col, row, std::min(tile, size - col), std::min(tile, size - row));
+      c.rasterize(crop(result, bbox), bbox);
+      num_tiles++;
+    }
+  }
+  uint64 stop = Stopwatch::microtime();
+  vw_out() << "ImageComposite with " << num_images << " sources: "
+           << double(stop - start) / num_tiles << " us per " << tile << "x"
+           << tile << " tile\n";
+
+  for (int row = 0; row < size; row++)
+    for (int col = 0; col < size; col++)
+      ASSERT_EQ(expected(col, row), result(col, row)) << "at (" << col << "," << row << ")";
+
+  // A box touches a source only if it overlaps it
+  EXPECT_TRUE (c.sparse_check(BBox2i(0, 0, size, size)));
+  ImageComposite<uint32> c2;
+  c2.set_draft_mode(true);
+  c2.insert(make(1), 10, 10);
+  c2.insert(make(2), 30, 10);
+  c2.prepare(BBox2i(0, 0, 40, 20));
+  EXPECT_TRUE (c2.sparse_check(BBox2i(17, 17, 1, 1)));
+  EXPECT_FALSE(c2.sparse_check(BBox2i(18, 10, 12, 8)));
+  EXPECT_FALSE(c2.sparse_check(BBox2i(0, 0, 10, 10)));
+  EXPECT_TRUE (c2.sparse_check(BBox2i(29, 0, 2, 11)));
+}
+
+namespace {
+  // Random pixels, with runs of opaque and transparent ones
+  template <class PixelT>
+  ImageView<PixelT> random_rgba(int cols, int rows, double max) {
+    ImageView<PixelT> img(cols, rows);
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < cols; col++) {
+        double alpha = (std::rand() % 100) / 99.0;
+        if ((col / 8) % 3 == 1) alpha = 1.0;
+        if ((col / 8) % 3 == 2 && row % 2) alpha = 0.0;
+        for (int c = 0; c < 3; c++)
+          img(col, row)[c] = typename PixelChannelType<PixelT>::type(alpha * max * (std::rand() % 100) / 99.0);
+        img(col, row).a() = typename PixelChannelType<PixelT>::type(alpha * max);
+      }
+    }
+    return img;
+  }
+
+  // Lay src over dst row by row, and compare with the overlay of
+  // PositionedImage.
+  template <class PixelT>
+  void check_overlay(ImageView<PixelT> const& dst, ImageView<PixelT> const& src) {
+    ImageView<PixelT> expected = copy(dst), result = copy(dst);
+    PositionedImage<PixelT> image(dst.cols(), dst.rows(), src, bounding_box(src));
+    image.addto(expected, 0, 0, true);
+    for (int row = 0; row < dst.rows(); row++)
+      draft_overlay_row(&result(0, row), &src(0, row), src.cols());
+    for (int row = 0; row < dst.rows(); row++)
+      for (int col = 0; col < dst.cols(); col++)
+        for (int c = 0; c < 4; c++)
+          ASSERT_EQ(expected(col, row)[c], result(col, row)[c])
+            << "at (" << col << "," << row << ") channel " << c;
+  }
+}
+
+namespace {
+  // What PositionedImage::reduce() computed with views
+  template <class PixelT>
+  ImageView<PixelT> filter_reduce(PositionedImage<PixelT> const& image) {
+    BBox2i const& bbox = image.bbox;
+    const int border = 1;
+    int left   = std::min(border + (bbox.min().x()            + border) % 2, bbox.min().x());
+    int top    = std::min(border + (bbox.min().y()            + border) % 2, bbox.min().y());
+    int right  = std::min(border + (bbox.width()  + left + border) % 2, image.m_cols - bbox.min().x() - bbox.width());
+    int bottom = std::min(border + (bbox.height() + top  + border) % 2, image.m_rows - bbox.min().y() - bbox.height());
+    std::vector<float> kernel(3); kernel[0] = 0.25; kernel[1] = 0.5; kernel[2] = 0.25;
+    ImageView<PixelT> result((bbox.width() + left + right + 1) / 2 + 1, (bbox.height() + top + bottom + 1) / 2 + 1);
+    vw::rasterize(edge_extend(subsample(separable_convolution_filter(edge_extend(image.image, -left, -top, image.image.cols() + left + right, image.image.rows() + top + bottom, ZeroEdgeExtension()),
+                                                                     kernel, kernel, ZeroEdgeExtension()), 2), 0, 0, result.cols(), result.rows(), ConstantEdgeExtension()),
+                  result);
+    return result;
+  }
+
+  template <class PixelT>
+  void check_reduce(double max) {
+    BBox2i bboxes[] = { BBox2i(0, 0, 300, 200), BBox2i(13, 20, 301, 199), BBox2i(400, 401, 300, 199), BBox2i(1, 1, 5, 3) };
+    for (int i = 0; i < 4; i++) {
+      PositionedImage<PixelT> image(700, 600, random_rgba<PixelT>(bboxes[i].width(), bboxes[i].height(), max), bboxes[i]);
+      ImageView<PixelT> expected = filter_reduce(image);
+      PositionedImage<PixelT> result = image.reduce();
+      ASSERT_EQ(expected.cols(), result.image.cols());
+      ASSERT_EQ(expected.rows(), result.image.rows());
+      for (int row = 0; row < expected.rows(); row++)
+        for (int col = 0; col < expected.cols(); col++)
+          for (int c = 0; c < PixelNumChannels<PixelT>::value; c++)
+            EXPECT_EQ(expected(col, row)[c], result.image(col, row)[c]) << bboxes[i] << ": " << col << "," << row;
+    }
+  }
+}
+
+TEST(TestImageComposite, Reduce) {
+  check_reduce<PixelRGBA<float32> >(1.0);
+  check_reduce<PixelRGBA<uint8  > >(255.0);
+}
+
+TEST(TestImageComposite, DraftOverlay) {
+  std::srand(7);
+  check_overlay(random_rgba<PixelRGBA<uint8  > >(37, 9, 255), random_rgba<PixelRGBA<uint8  > >(37, 9, 255));
+  check_overlay(random_rgba<PixelRGBA<float32> >(37, 9, 1.0), random_rgba<PixelRGBA<float32> >(37, 9, 1.0));
+  check_overlay(random_rgba<PixelRGBA<uint16 > >(37, 9, 65535), random_rgba<PixelRGBA<uint16 > >(37, 9, 65535));
+}
+
+TEST(TestImageComposite, DraftBlocks) {
+  // Overlapping translucent images across several cache blocks
+  typedef PixelRGBA<uint8> PixelT;
+  ImageComposite<PixelT> c;
+  c.set_draft_mode(true);
+  std::srand(9);
+  ImageView<PixelT> expected(700, 600);
+  for (int i = 0; i < 40; i++) {
+    int x = std::rand() % 600, y = std::rand() % 500;
+    ImageView<PixelT> img = random_rgba<PixelT>(1 + std::rand() % 100, 1 + std::rand() % 100, 255);
+    c.insert(img, x, y);
+    PositionedImage<PixelT>(700, 600, img, BBox2i(x, y, img.cols(), img.rows()))
+      .addto(expected, 0, 0, true);
+  }
+  c.prepare(BBox2i(0, 0, 700, 600));
+
+  // Boxes inside one block and across several, and single pixels
+  BBox2i boxes[3] = { BBox2i(0, 0, 700, 600), BBox2i(250, 250, 10, 10), BBox2i(100, 200, 333, 101) };
+  for (int b = 0; b < 3; b++) {
+    ImageView<PixelT> result = crop(c, boxes[b]);
+    for (int row = 0; row < result.rows(); row++)
+      for (int col = 0; col < result.cols(); col++)
+        ASSERT_EQ(expected(boxes[b].min().x() + col, boxes[b].min().y() + row), result(col, row))
+          << "in " << boxes[b] << " at (" << col << "," << row << ")";
+  }
+  for (int i = 0; i < 100; i++) {
+    int x = std::rand() % 700, y = std::rand() % 600;
+    EXPECT_EQ(expected(x, y), c(x, y));
+  }
+}
+
+TEST(TestImageComposite, Blend) {
+  typedef PixelRGBA<float32> PixelT;
+  const int size = 1200, offset = 500;
+
+  // A single source comes back unchanged, across several blocks
+  ImageView<PixelT> img(size, size);
+  for (int row = 0; row < size; row++)
+    for (int col = 0; col < size; col++)
+      img(col, row) = PixelT(col / float(size), row / float(size), 0.5, 1.0);
+  ImageComposite<PixelT> c1;
+  c1.insert(img, 0, 0);
+  c1.prepare();
+  ImageView<PixelT> result = c1;
+  for (int row = 0; row < size; row++)
+    for (int col = 0; col < size; col++)
+      for (int ch = 0; ch < 4; ch++)
+        ASSERT_NEAR(img(col, row)[ch], result(col, row)[ch], 1e-4) << "at (" << col << "," << row << ")";
+
+  // Two overlapping sources of different colors blend smoothly, with
+  // no seams at the block edges
+  ImageView<PixelT> img1(size, size), img2(size, size);
+  fill(img1, PixelT(1, 0, 0, 1));
+  fill(img2, PixelT(0, 0, 1, 1));
+  ImageComposite<PixelT> c2;
+  c2.insert(img1, 0, 0);
+  c2.insert(img2, offset, offset);
+  c2.prepare();
+  ASSERT_EQ(size + offset, c2.cols());
+  result = ImageView<PixelT>(c2.cols(), c2.rows());
+  for (int row = 0; row < c2.rows(); row += 100)
+    for (int col = 0; col < c2.cols(); col += 100) {
+      BBox2i bbox(col, row, std::min(100, c2.cols() - col), std::min(100, c2.rows() - row));
+      c2.rasterize(crop(result, bbox), bbox);
+    }
+  EXPECT_NEAR(1.0, result(100, 100).r(), 1e-4);
+  EXPECT_NEAR(1.0, result(size + offset - 100, size + offset - 100).b(), 1e-4);
+  for (int row = offset; row < size; row++) {
+    for (int col = offset; col < size; col++) {
+      ASSERT_GE(result(col, row).r(), -1e-4);
+      ASSERT_LE(result(col, row).r(),  1 + 1e-4);
+      ASSERT_NEAR(1.0, result(col, row).r() + result(col, row).b(), 1e-4);
+      ASSERT_LT(std::abs(result(col + 1, row).r() - result(col, row).r()), 0.05)
+        << "at (" << col << "," << row << ")";
+      ASSERT_LT(std::abs(result(col, row + 1).r() - result(col, row).r()), 0.05)
+        << "at (" << col << "," << row << ")";
+    }
+  }
+
+  // Pixel access agrees with rasterization
+  for (int i = 0; i < 20; i++) {
+    int x = offset + std::rand() % (size - offset), y = offset + std::rand() % (size - offset);
+    EXPECT_NEAR(result(x, y).r(), c2(x, y).r(), 1e-6);
+  }
+}
@@ -0,0 +1,306 @@
+// __BEGIN_LICENSE__
+//  Copyright (c) 2006-2025, United States Government as represented by the
+//  Administrator of the National Aeronautics and Space Administration. All
+//  rights reserved.
+//
+//  The NASA Vision Workbench is licensed under the Apache License,
+//  Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+// __END_LICENSE__
+
+#include <test/Helpers.h>
+
+#include <vw/Mosaic/QuadTreeGenerator.h>
+#include <vw/Image/PixelTypes.h>
+#include <vw/Image/PerPixelViews.h>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <map>
+
+namespace fs = boost::filesystem;
+
+using namespace vw;
+using namespace vw::mosaic;
+using namespace vw::test;
+
+namespace {
+  // The contents of the files in a directory tree, by relative path
+  std::map<std::string, std::string> read_tree(std::string const& dir) {
+    std::map<std::string, std::string> files;
+    for (fs::recursive_directory_iterator it(dir), end; it != end; ++it) {
+      if (!fs::is_regular_file(it->path()))
+        continue;
+      std::ifstream in(it->path().string().c_str(), std::ios::binary);
+      files[it->path().string().substr(dir.size())]
+        = std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    return files;
+  }
+
+  // The pixels of an image, recording the box of those that are read
+  template <class PixelT>
+  struct RecordReads {
+    typedef PixelT result_type;
+    ImageView<PixelT> const* image;
+    BBox2i* read_bbox;
+    PixelT operator()(double i, double j, int32 /*p*/) const {
+      read_bbox->grow(Vector2i(int32(i), int32(j)));
+      return (*image)(int32(i), int32(j));
+    }
+  };
+
+  // Update a tree after changing a box of the image, and check that
+  // only the source pixels of the tiles over that box are read, and
+  // that the tiles of the other branches are left as they were
+  template <class PixelT>
+  void check_update_reads(ImageView<PixelT> & image, std::string const& file_type,
+                          std::string const& tree) {
+    {
+      QuadTreeGenerator qtree(image, tree);
+      qtree.set_tile_size(64);
+      qtree.set_file_type(file_type);
+      qtree.set_cull_images(true);
+      qtree.generate();
+    }
+    std::map<std::string, std::string> before = read_tree(tree);
+
+    std::vector<BBox2i> dirty(1, BBox2i(300, 100, 90, 70));
+    fill(crop(image, dirty[0]), PixelT(PixelRGB<uint8>(9, 99, 199)));
+    BBox2i read_bbox;
+    RecordReads<PixelT> func = { &image, &read_bbox };
+    QuadTreeGenerator qtree(PerPixelIndexView<RecordReads<PixelT> >(func, image.cols(), image.rows()),
+                            tree);
+    qtree.set_tile_size(64);
+    qtree.set_file_type(file_type);
+    qtree.set_cull_images(true);
+    qtree.set_dirty_bboxes(dirty);
+    qtree.generate();
+
+    // The leaf tiles over the dirty box
+    EXPECT_FALSE(read_bbox.empty());
+    EXPECT_TRUE(BBox2i(256, 64, 192, 128).contains(read_bbox)) << read_bbox;
+
+    // Only the tiles from the root down to those leaves are new: the
+    // 6 leaves, 4, 1 and 1 tiles on the levels above, and the root
+    std::map<std::string, std::string> after = read_tree(tree);
+    EXPECT_EQ(before.size(), after.size());
+    int num_changed = 0;
+    for (std::map<std::string, std::string>::const_iterator it = after.begin(); it != after.end(); ++it)
+      if (before[it->first] != it->second)
+        num_changed++;
+    EXPECT_LT(0, num_changed);
+    EXPECT_GE(13, num_changed);
+  }
+}
+
+TEST(QuadTreeGenerator, ParallelMatchesSerial) {
+  // An image with a transparent part, so some tiles are cropped or culled
+  ImageView<PixelRGBA<uint8> > image(700, 500);
+  for (int32 row = 0; row < image.rows(); row++)
+    for (int32 col = 0; col < image.cols(); col++)
+      image(col, row) = PixelRGBA<uint8>(col % 256, row % 256, (col * row) % 251,
+                                         (col < 200 && row > 300) ? 0 : 255);
+
+  UnlinkName serial("qtree_serial"), parallel("qtree_parallel");
+  std::string const* names[2] = { &serial, &parallel };
+  for (int i = 0; i < 2; i++) {
+    QuadTreeGenerator qtree(image, *names[i]);
+    qtree.set_tile_size(64);
+    qtree.set_file_type("png");
+    qtree.set_crop_images(true);
+    qtree.set_crop_bbox(BBox2i(10, 20, 650, 470));
+    qtree.set_num_threads(i == 0 ? 1 : 4);
+    qtree.generate();
+  }
+
+  std::map<std::string, std::string> serial_files   = read_tree(serial);
+  std::map<std::string, std::string> parallel_files = read_tree(parallel);
+  EXPECT_LT(60u, serial_files.size());
+  EXPECT_EQ(serial_files.size(), parallel_files.size());
+  EXPECT_TRUE(serial_files == parallel_files);
+}
+
+TEST(QuadTreeGenerator, UpdateMatchesRegenerate) {
+  // The transparent part has no color, as a premultiplied image must,
+  // so the tiles read back from disk are as they were made
+  ImageView<PixelRGBA<uint8> > image(700, 500);
+  for (int32 row = 0; row < image.rows(); row++)
+    for (int32 col = 0; col < image.cols(); col++)
+      if (col >= 200 || row <= 300)
+        image(col, row) = PixelRGBA<uint8>(col % 256, row % 256, (col * row) % 251, 255);
+
+  UnlinkName updated("qtree_updated"), regenerated("qtree_regenerated");
+  {
+    QuadTreeGenerator qtree(image, updated);
+    qtree.set_tile_size(64);
+    qtree.set_file_type("png");
+    qtree.set_cull_images(true);
+    qtree.generate();
+  }
+
+  // Change one region and make another one transparent, so that its
+  // tiles must be removed
+  std::vector<BBox2i> dirty;
+  dirty.push_back(BBox2i(300, 100, 90, 70));
+  dirty.push_back(BBox2i(576, 0, 124, 128));
+  for (int32 row = 100; row < 170; row++)
+    for (int32 col = 300; col < 390; col++)
+      image(col, row) = PixelRGBA<uint8>(255 - col % 256, 7, 9, 255);
+  for (int32 row = 0; row < 128; row++)
+    for (int32 col = 576; col < 700; col++)
+      image(col, row) = PixelRGBA<uint8>();
+
+  for (int i = 0; i < 2; i++) {
+    QuadTreeGenerator qtree(image, i == 0 ? updated : regenerated);
+    qtree.set_tile_size(64);
+    qtree.set_file_type("png");
+    qtree.set_cull_images(true);
+    if (i == 0) {
+      qtree.set_dirty_bboxes(dirty);
+      qtree.set_num_threads(4);
+    }
+    qtree.generate();
+  }
+
+  std::map<std::string, std::string> updated_files     = read_tree(updated);
+  std::map<std::string, std::string> regenerated_files = read_tree(regenerated);
+  EXPECT_LT(60u, regenerated_files.size());
+  EXPECT_EQ(regenerated_files.size(), updated_files.size());
+  EXPECT_TRUE(regenerated_files == updated_files);
+
+  // Cropped tiles can not be put back in place
+  QuadTreeGenerator qtree(image, updated);
+  qtree.set_crop_images(true);
+  qtree.set_dirty_bboxes(dirty);
+  EXPECT_THROW(qtree.generate(), NoImplErr);
+}
+
+TEST(QuadTreeGenerator, UpdateReadsOnlyDirtyBranches) {
+  // Lossy JPEG tiles are read back as they are
+  ImageView<PixelRGB<uint8> > rgb(700, 500);
+  for (int32 row = 0; row < rgb.rows(); row++)
+    for (int32 col = 0; col < rgb.cols(); col++)
+      rgb(col, row) = PixelRGB<uint8>(col % 256, row % 256, (col * row) % 251);
+  UnlinkName jpg_tree("qtree_jpg");
+  check_update_reads(rgb, "jpg", jpg_tree);
+
+  // As are PNG tiles with transparent edges, in a tree of both types
+  ImageView<PixelRGBA<uint8> > rgba(700, 500);
+  for (int32 row = 0; row < rgba.rows(); row++)
+    for (int32 col = 0; col < rgba.cols(); col++)
+      if (col >= 200 || row <= 300)
+        rgba(col, row) = PixelRGBA<uint8>(col % 256, row % 256, (col * row) % 251, 255);
+  UnlinkName auto_tree("qtree_auto");
+  check_update_reads(rgba, "auto", auto_tree);
+}
+
+TEST(QuadTreeGenerator, UpdateRemovesEmptyBranches) {
+  ImageView<PixelRGBA<uint8> > image(300, 200);
+  fill(image, PixelRGBA<uint8>(10, 20, 30, 255));
+
+  UnlinkName updated("qtree_updated"), regenerated("qtree_regenerated");
+  {
+    QuadTreeGenerator qtree(image, updated);
+    qtree.set_tile_size(64);
+    qtree.set_file_type("png");
+    qtree.set_cull_images(true);
+    qtree.generate();
+  }
+
+  // Empty a region that the sparse image check then skips, so that
+  // the tiles of its branches are removed without being made again
+  std::vector<BBox2i> dirty(1, BBox2i(128, 0, 172, 128));
+  fill(crop(image, dirty[0]), PixelRGBA<uint8>());
+  BBox2i emptied = dirty[0];
+  for (int i = 0; i < 2; i++) {
+    QuadTreeGenerator qtree(image, i == 0 ? updated : regenerated);
+    qtree.set_tile_size(64);
+    qtree.set_file_type("png");
+    qtree.set_cull_images(true);
+    qtree.set_sparse_image_check([emptied](BBox2i const& bbox) {
+        BBox2i image_bbox = bbox;
+        image_bbox.crop(BBox2i(0, 0, 300, 200));
+        return !emptied.contains(image_bbox);
+      });
+    if (i == 0)
+      qtree.set_dirty_bboxes(dirty);
+    qtree.generate();
+  }
+
+  std::map<std::string, std::string> updated_files     = read_tree(updated);
+  std::map<std::string, std::string> regenerated_files = read_tree(regenerated);
+  EXPECT_LT(5u, regenerated_files.size());
+  EXPECT_EQ(regenerated_files.size(), updated_files.size());
+  EXPECT_TRUE(regenerated_files == updated_files);
+}
+
+TEST(QuadTreeGenerator, OccupancyMap) {
+  // Mostly empty, as a polar mosaic is, with some partly opaque tiles
+  ImageView<PixelRGBA<uint8> > image(900, 700);
+  for (int32 row = 0; row < image.rows(); row++)
+    for (int32 col = 0; col < image.cols(); col++)
+      if ((col - 300) * (col - 300) + (row - 250) * (row - 250) < 150 * 150 || (col > 700 && row > 600))
+        image(col, row) = PixelRGBA<uint8>(col % 256, row % 256, 50, 255);
+  image(150, 580) = PixelRGBA<uint8>(1, 2, 3, 255);
+  image(180, 620) = PixelRGBA<uint8>(4, 5, 6, 255);
+
+  // Also with a crop box that cuts through the leaf of the last two
+  // pixels, leaving one of them out
+  for (int crop = 0; crop < 3; crop++) {
+    UnlinkName plain("qtree_plain"), mapped("qtree_mapped");
+    std::string const* names[2] = { &plain, &mapped };
+    for (int i = 0; i < 2; i++) {
+      QuadTreeGenerator qtree(image, *names[i]);
+      qtree.set_tile_size(64);
+      qtree.set_file_type("auto");
+      qtree.set_crop_images(crop >= 1);
+      if (crop == 2)
+        qtree.set_crop_bbox(BBox2i(170, 100, 570, 530));
+      qtree.set_cull_images(true);
+      qtree.set_use_occupancy_map(i == 1);
+      qtree.generate();
+    }
+    std::map<std::string, std::string> plain_files  = read_tree(plain);
+    std::map<std::string, std::string> mapped_files = read_tree(mapped);
+    EXPECT_LT(20u, plain_files.size());
+    EXPECT_EQ(plain_files.size(), mapped_files.size());
+    EXPECT_TRUE(plain_files == mapped_files);
+  }
+
+  // Emptying a region in an update removes its tiles, as the map skips it
+  UnlinkName updated("qtree_updated"), regenerated("qtree_regenerated");
+  {
+    QuadTreeGenerator qtree(image, updated);
+    qtree.set_tile_size(64);
+    qtree.set_file_type("auto");
+    qtree.set_cull_images(true);
+    qtree.set_use_occupancy_map(true);
+    qtree.generate();
+  }
+  std::vector<BBox2i> dirty(1, BBox2i(640, 576, 260, 124));
+  fill(crop(image, dirty[0]), PixelRGBA<uint8>());
+  for (int i = 0; i < 2; i++) {
+    QuadTreeGenerator qtree(image, i == 0 ? updated : regenerated);
+    qtree.set_tile_size(64);
+    qtree.set_file_type("auto");
+    qtree.set_cull_images(true);
+    qtree.set_use_occupancy_map(true);
+    if (i == 0)
+      qtree.set_dirty_bboxes(dirty);
+    qtree.generate();
+  }
+  std::map<std::string, std::string> updated_files     = read_tree(updated);
+  std::map<std::string, std::string> regenerated_files = read_tree(regenerated);
+  EXPECT_EQ(regenerated_files.size(), updated_files.size());
+  EXPECT_TRUE(regenerated_files == updated_files);
+}
@@ -25,6 +25,8 @@
 #include <vw/Camera/CameraModel.h>
 #include <vw/Stereo/StereoModel.h>
 #include <vw/Core/Exception.h>
+
+#include <typeinfo>
 using namespace std;
 
 namespace vw { namespace stereo {
@@ -122,30 +124,82 @@ Vector3 StereoModel::operator()(vector<Vector2> const& pixVec,
       camCtrs.push_back(m_cameras[p]->camera_center(pix));
     }
 
-    // Not enough valid rays
-    if (camDirs.size() < 2) 
-      return Vector3();
-
-    if (are_nearly_parallel(m_angle_tol, camDirs)) 
-      return Vector3();
-
-    // Determine range by triangulation
-    Vector3 result = triangulate_point(camDirs, camCtrs, errorVec);
-    
-    // Reflect points that fall behind one of the two cameras.
-    bool reflect = false;
-    for (int p = 0; p < (int)camCtrs.size(); p++)
-      if (dot_prod(result - camCtrs[p], camDirs[p]) < 0 ) reflect = true;
-    if (reflect)
-      result = -result + 2*camCtrs[0];
-
-    return result;
+    return intersect_rays(camDirs, camCtrs, errorVec);
     
   } catch (const camera::PixelToRayErr& /*e*/) {
   }
   return Vector3();
 }
 
+Vector3 StereoModel::intersect_rays(vector<Vector3> const& camDirs,
+                                    vector<Vector3> const& camCtrs,
+                                    Vector3& errorVec) const {
+  // Not enough valid rays
+  if (camDirs.size() < 2) 
+    return Vector3();
+
+  if (are_nearly_parallel(m_angle_tol, camDirs)) 
+    return Vector3();
+
+  // Determine range by triangulation
+  Vector3 result = triangulate_point(camDirs, camCtrs, errorVec);
+  
+  // Reflect points that fall behind one of the two cameras.
+  bool reflect = false;
+  for (int p = 0; p < (int)camCtrs.size(); p++)
+    if (dot_prod(result - camCtrs[p], camDirs[p]) < 0 ) reflect = true;
+  if (reflect)
+    result = -result + 2*camCtrs[0];
+
+  return result;
+}
+
+void StereoModel::triangulate_pairs(Vector2 const* pix1, Vector2 const* pix2, size_t num,
+                                    Vector3* points, Vector3* errorVecs) const {
+
+  // Classes derived from this one find the rays their own way
+  if (typeid(*this) != typeid(StereoModel) || m_cameras.size() != 2) {
+    for (size_t i = 0; i < num; i++)
+      points[i] = operator()(pix1[i], pix2[i], errorVecs[i]);
+    return;
+  }
+
+  // Only the pairs of valid pixels are passed to the cameras
+  vector<size_t>  index;
+  vector<Vector2> valid1, valid2;
+  index.reserve(num); valid1.reserve(num); valid2.reserve(num);
+  for (size_t i = 0; i < num; i++) {
+    points[i]    = Vector3();
+    errorVecs[i] = Vector3();
+    if (pix1[i] != pix1[i] || pix1[i] == camera::CameraModel::invalid_pixel() ||
+        pix2[i] != pix2[i] || pix2[i] == camera::CameraModel::invalid_pixel())
+      continue;
+    index.push_back(i);
+    valid1.push_back(pix1[i]);
+    valid2.push_back(pix2[i]);
+  }
+  size_t num_valid = index.size();
+  if (num_valid == 0)
+    return;
+
+  vector<Vector3> dirs1(num_valid), ctrs1(num_valid), dirs2(num_valid), ctrs2(num_valid);
+  m_cameras[0]->pixels_to_vectors(&valid1[0], &dirs1[0], num_valid);
+  m_cameras[0]->camera_centers   (&valid1[0], &ctrs1[0], num_valid);
+  m_cameras[1]->pixels_to_vectors(&valid2[0], &dirs2[0], num_valid);
+  m_cameras[1]->camera_centers   (&valid2[0], &ctrs2[0], num_valid);
+
+  // A failed ray comes back as a zero vector. Then there are fewer
+  // than two rays, as when operator() catches PixelToRayErr.
+  vector<Vector3> camDirs(2), camCtrs(2);
+  for (size_t k = 0; k < num_valid; k++) {
+    if (dirs1[k] == Vector3() || dirs2[k] == Vector3())
+      continue;
+    camDirs[0] = dirs1[k]; camCtrs[0] = ctrs1[k];
+    camDirs[1] = dirs2[k]; camCtrs[1] = ctrs2[k];
+    points[index[k]] = intersect_rays(camDirs, camCtrs, errorVecs[index[k]]);
+  }
+}
+
 Vector3 StereoModel::operator()(vector<Vector2> const& pixVec,
                                 double& error) const {
   Vector3 errorVec;
@@ -265,37 +319,50 @@ StereoModel::operator()(ImageView<PixelMask<Vector2f> > const& disparity_map,
   ImageView<Vector3> xyz(disparity_map.cols(), disparity_map.rows());
   error.set_size(disparity_map.cols(), disparity_map.rows());
 
-  // Compute 3D position for each pixel in the disparity map
+  // Compute 3D position for each pixel in the disparity map, a row at a time
   vw_out() << "StereoModel: Applying camera models\n";
+  vector<Vector2> pix1, pix2;
+  vector<Vector3> points, errorVecs;
+  vector<int32>   cols;
   for (int32 y = 0; y < disparity_map.rows(); y++) {
     if (y % 100 == 0) {
       printf("\tStereoModel computing points: %0.2f%% complete.\r",
              100.0f * float(y)/disparity_map.rows());
       fflush(stdout);
     }
+    pix1.clear(); pix2.clear(); cols.clear();
     for (int32 x = 0; x < disparity_map.cols(); x++) {
       if ( is_valid(disparity_map(x,y)) ) {
-        xyz(x,y) = (*this)(Vector2( x, y),
-                           Vector2( x+disparity_map(x,y)[0],
-                                    y+disparity_map(x,y)[1]),
-                           error(x,y) );
-
-        if (error(x,y) >= 0) {
-          // Keep track of error statistics
-          if (error(x,y) > max_error)
-            max_error = error(x,y);
-          mean_error += error(x,y);
-            ++point_count;
-        } else {
-          // rays diverge or are parallel
-          xyz(x,y) = Vector3();
-          divergent++;
-        }
+        pix1.push_back(Vector2(x, y));
+        pix2.push_back(Vector2(x+disparity_map(x,y)[0], y+disparity_map(x,y)[1]));
+        cols.push_back(x);
       } else {
         xyz(x,y) = Vector3();
         error(x,y) = 0;
       }
+    }
+    if (cols.empty())
+      continue;
+
+    points.resize(cols.size());
+    errorVecs.resize(cols.size());
+    triangulate_pairs(&pix1[0], &pix2[0], cols.size(), &points[0], &errorVecs[0]);
+    for (size_t k = 0; k < cols.size(); k++) {
+      int32 x = cols[k];
+      xyz(x,y)   = points[k];
+      error(x,y) = norm_2(errorVecs[k]);
+      if (error(x,y) >= 0) {
+        // Keep track of error statistics
+        if (error(x,y) > max_error)
+          max_error = error(x,y);
+        mean_error += error(x,y);
+        ++point_count;
+      } else {
+        // rays diverge or are parallel
+        xyz(x,y) = Vector3();
+        divergent++;
       }
+    }
   }
 
   if (divergent != 0)
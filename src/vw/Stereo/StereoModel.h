@@ -84,6 +84,12 @@ namespace stereo {
     virtual Vector3 operator()(Vector2 const& pix1, Vector2 const& pix2,
                                double & error) const;
 
+    /// Triangulate num pairs of pixels, as operator() does for each pair.
+    /// This makes one batch call per camera for all the rays, rather
+    /// than several virtual calls per pair.
+    void triangulate_pairs(Vector2 const* pix1, Vector2 const* pix2, size_t num,
+                           Vector3* points, Vector3* errorVecs) const;
+
     /// Returns the dot product of the two rays emanating from camera
     /// 1 and camera 2 through pix1 and pix2 respectively.  This can
     /// effectively be interpreted as the angle (in radians) between
@@ -113,6 +119,12 @@ namespace stereo {
     
     static bool are_nearly_parallel(double angle_tol,
                                     std::vector<Vector3> const& camDirs);
+
+    /// Intersect the valid rays found by operator(). Returns a zero
+    /// vector if there are fewer than two or they are nearly parallel.
+    Vector3 intersect_rays(std::vector<Vector3> const& camDirs,
+                           std::vector<Vector3> const& camCtrs,
+                           Vector3& errorVec) const;
   };
 
 }}      // namespace vw::stereo
@@ -20,11 +20,14 @@
 #define __VW_STEREO_STEREOVIEW_H__
 
 #include <vw/Image/ImageViewBase.h>
+#include <vw/Image/ImageView.h>
+#include <vw/Image/Manipulation.h>
 #include <vw/Image/PixelMask.h>
 #include <vw/Image/PixelTypes.h>
 #include <vw/Image/PixelAccessors.h>
 #include <vw/Stereo/StereoModel.h>
 #include <limits>
+#include <vector>
 
 namespace vw {
 
@@ -118,8 +121,39 @@ namespace stereo {
     /// \cond INTERNAL
     typedef StereoView<typename DisparityImageT::prerasterize_type> prerasterize_type;
     inline prerasterize_type prerasterize( BBox2i const& bbox ) const { return prerasterize_type( m_disparity_map.prerasterize(bbox), m_stereo_model ); }
-    template <class DestT> inline void rasterize( DestT const& dest, BBox2i const& bbox ) const { vw::rasterize( prerasterize(bbox), dest, bbox ); }
     /// \endcond
+
+    /// Triangulate the valid pixels of the box together, so that each
+    /// camera is called once for all of their rays.
+    template <class DestT> inline void rasterize( DestT const& dest, BBox2i const& bbox ) const {
+      ImageView<dpixel_type> disp = crop(m_disparity_map, bbox);
+      std::vector<Vector2> pix1, pix2;
+      pix1.reserve(disp.cols() * disp.rows());
+      pix2.reserve(disp.cols() * disp.rows());
+      for (int32 row = 0; row < disp.rows(); row++) {
+        for (int32 col = 0; col < disp.cols(); col++) {
+          if (!is_valid(disp(col, row)))
+            continue;
+          Vector2 pix(bbox.min().x() + col, bbox.min().y() + row);
+          pix1.push_back(pix);
+          pix2.push_back(pix + DispHelper(disp(col, row)));
+        }
+      }
+
+      // For missing pixels in the disparity map, we return a null 3D position.
+      ImageView<Vector3> points(disp.cols(), disp.rows());
+      if (!pix1.empty()) {
+        std::vector<Vector3> xyz(pix1.size()), errorVecs(pix1.size());
+        m_stereo_model.triangulate_pairs(&pix1[0], &pix2[0], pix1.size(),
+                                         &xyz[0], &errorVecs[0]);
+        size_t k = 0;
+        for (int32 row = 0; row < disp.rows(); row++)
+          for (int32 col = 0; col < disp.cols(); col++)
+            if (is_valid(disp(col, row)))
+              points(col, row) = xyz[k++];
+      }
+      vw::rasterize( points, dest, BBox2i(0, 0, disp.cols(), disp.rows()) );
+    }
   };
 
   template <class ImageT>
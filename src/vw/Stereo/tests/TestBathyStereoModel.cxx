@@ -19,6 +19,8 @@
 #include <test/Helpers.h>
 #include <vw/Cartography/SnellLaw.h>
 
+#include <boost/scoped_array.hpp>
+
 using namespace vw;
 
 // Test using Snell's law to see how a ray bends after hitting water
@@ -55,3 +57,41 @@ TEST(BathyStereoModel, SnellLaw) {
 
   EXPECT_NEAR(sin(theta1), water_refraction_index * sin(theta2), 1e-12);
 }
+
+// The batch version bends the same as one ray at a time
+TEST(BathyStereoModel, BatchSnellLaw) {
+
+  std::vector<double> bathy_plane;
+  bathy_plane.push_back(0.129446509386046349);
+  bathy_plane.push_back(-0.899798011977084089);
+  bathy_plane.push_back(0.416661899925893919);
+  bathy_plane.push_back(-6374384.66267670784);
+
+  // Rays around the one above. Some go up, so they are not bent.
+  Vector3 camCtr(1220937.38505603513,-6327090.5660436973,3081502.09552069381);
+  std::vector<Vector3> ctrs, dirs;
+  for (int i = 0; i < 101; i++) {
+    Vector3 dir(-0.458009742779199258 + 0.01 * sin(i), 0.708215158481702134 + 0.01 * cos(i),
+                -0.537269359647531974);
+    if (i % 10 == 3)
+      dir = -dir;
+    ctrs.push_back(camCtr + 100.0 * i * Vector3(1, 0, 0));
+    dirs.push_back(normalize(dir));
+  }
+
+  std::vector<Vector3> waterCtrs(ctrs.size()), waterDirs(ctrs.size());
+  boost::scoped_array<bool> success(new bool[ctrs.size()]);
+  vw::snellLaw(&ctrs[0], &dirs[0], ctrs.size(), bathy_plane, 1.333,
+               &waterCtrs[0], &waterDirs[0], success.get());
+
+  for (size_t i = 0; i < ctrs.size(); i++) {
+    Vector3 waterCtr, waterDir;
+    bool ans = vw::snellLaw(ctrs[i], dirs[i], bathy_plane, 1.333, waterCtr, waterDir);
+    EXPECT_EQ(ans, i % 10 != 3);
+    ASSERT_EQ(ans, success[i]);
+    if (!ans)
+      continue;
+    EXPECT_VECTOR_NEAR(waterCtrs[i], waterCtr, 1e-6);
+    EXPECT_VECTOR_NEAR(waterDirs[i], waterDir, 1e-12);
+  }
+}
@@ -96,6 +96,36 @@ TEST( StereoModel, AdjustedStereo ) {
   }
 }
 
+TEST( StereoModel, TriangulatePairs ) {
+
+  boost::shared_ptr<CameraModel> pin1(new camera::PinholeModel(Vector3(), identity_matrix<3>(),
+                                                               100, 100, 50, 50));
+  boost::shared_ptr<CameraModel> pin2(new camera::PinholeModel(Vector3(1,0,0), identity_matrix<3>(),
+                                                               100, 100, 50, 50));
+  camera::AdjustedCameraModel adj2(pin2, Vector3(0.1, 0.04, 0.123),
+                                   euler_to_quaternion(0.01, 0.02, -0.01, "xyz"));
+  StereoModel st(pin1.get(), &adj2);
+
+  std::vector<Vector2> pix1, pix2;
+  for (int i = 0; i < 30; i++) {
+    Vector3 point(-1 + 0.1*i, 0.5 - 0.05*i, 4 + 0.2*i);
+    pix1.push_back(pin1->point_to_pixel(point) + Vector2(0, 0.01*i));
+    pix2.push_back(adj2.point_to_pixel(point));
+  }
+  pix1[3] = CameraModel::invalid_pixel();
+  pix2[7] = CameraModel::invalid_pixel();
+
+  std::vector<Vector3> points(pix1.size()), errors(pix1.size());
+  st.triangulate_pairs(&pix1[0], &pix2[0], pix1.size(), &points[0], &errors[0]);
+  for (size_t i = 0; i < pix1.size(); i++) {
+    Vector3 error;
+    EXPECT_VECTOR_NEAR( st(pix1[i], pix2[i], error), points[i], 1e-8 );
+    EXPECT_VECTOR_NEAR( error, errors[i], 1e-8 );
+  }
+  EXPECT_VECTOR_EQ( Vector3(), points[3] );
+  EXPECT_VECTOR_EQ( Vector3(), points[7] );
+}
+
 TEST(StereoView, PixelMaskVec2) {
   Vector3 pos1, pos2;
   pos2 = Vector3(1,0,0);
@@ -92,6 +92,7 @@ struct Options: GdalWriteOptions {
     north(0), south(0),
     east(0), west(0),
     multiband(false),
+    occupancy_map(false),
     help(false),
     normalize(false),
     manual(false),
@@ -117,6 +118,7 @@ struct Options: GdalWriteOptions {
   std::string mode; // Quadtree type
 
   bool multiband;
+  bool occupancy_map;
   bool help;
   bool normalize;
   bool manual;
@@ -367,6 +369,8 @@ void do_normal_mosaic(const Options& opt,
   QuadTreeGenerator quadtree(img, opt.output_file_name);
   quadtree.set_tile_size(256);
   quadtree.set_file_type("png");
+  quadtree.set_num_threads(opt.num_threads);
+  quadtree.set_use_occupancy_map(opt.occupancy_map);
 
   if (opt.mode != "NONE") {
     boost::shared_ptr<QuadTreeConfig> config =
@@ -555,6 +559,8 @@ void do_mosaic(const Options& opt, const ProgressCallback *progress) {
   BBox2i data_bbox = composite.bbox();
   data_bbox.crop(BBox2i(0, 0, total_bbox.width(), total_bbox.height()));
   quadtree.set_crop_bbox(data_bbox);
+  quadtree.set_num_threads(opt.num_threads);
+  quadtree.set_use_occupancy_map(opt.occupancy_map);
 
   vw_out() << "Generating overlay...\n";
   vw_out() << "Writing: " << opt.output_file_name << "\n";
@@ -625,6 +631,11 @@ int handle_options(int argc, char *argv[], Options& opt) {
      "Composite images using multi-band blending")
     ("aspect-ratio", po::value(&opt.aspect_ratio),
      "Pixel aspect ratio (for polar overlays; should be a power of two)")
+    ("occupancy-map", po::bool_switch(&opt.occupancy_map),
+     "Find which tiles have data in one extra pass over the input before "
+     "making them, and skip the empty ones, as in polar or coastal "
+     "mosaics. Helps only when tiles are cropped or culled, as in KML "
+     "mode.")
     ("global-resolution", po::value(&opt.global_resolution),
      "Override the global pixel resolution; should be a power of two");
 
@@ -178,6 +178,71 @@ void mergeMatchFiles(std::vector<std::string> const& files,
   write_match_file(files.back(), left_ip, right_ip, matches_as_txt);
 }
 
+// Fit a transform to the matches with RANSAC and return the indices of
+// the inliers. The preemptive variant samples the matches with the best
+// quality first and scores hypotheses on growing subsets of the data.
+template <class FittingFuncT, class ErrorFuncT>
+vw::Matrix<double> fit_with_ransac(FittingFuncT const& fitting_func,
+                                   ErrorFuncT const& error_func,
+                                   std::vector<vw::Vector3> const& ransac_ip1,
+                                   std::vector<vw::Vector3> const& ransac_ip2,
+                                   std::vector<double> const& quality,
+                                   int ransac_iterations, double inlier_threshold,
+                                   bool preemptive_ransac,
+                                   std::vector<size_t> & indices) {
+  vw::Matrix<double> H;
+  if (preemptive_ransac) {
+    vw::math::PreemptiveSampleConsensus<FittingFuncT, ErrorFuncT>
+      ransac(fitting_func, error_func, ransac_iterations, inlier_threshold,
+             ransac_ip1.size()/2, true);
+    H = ransac(ransac_ip1, ransac_ip2, quality);
+    indices = ransac.inlier_indices(H, ransac_ip1, ransac_ip2);
+  } else {
+    vw::math::RandomSampleConsensus<FittingFuncT, ErrorFuncT>
+      ransac(fitting_func, error_func, ransac_iterations, inlier_threshold,
+             ransac_ip1.size()/2, true);
+    H = ransac(ransac_ip1, ransac_ip2);
+    indices = ransac.inlier_indices(H, ransac_ip1, ransac_ip2);
+  }
+  return H;
+}
+
+// Match ip1 to ip2 using a FLANN index over ip2 that is cached on disk next
+// to the ip2 file, so that it is built only once when ip2 is matched against
+// several images, or again later.
+template <class MetricT>
+void match_with_cached_index(std::vector<InterestPoint> const& ip1,
+                             std::vector<InterestPoint> const& ip2,
+                             std::string const& ip2_file,
+                             std::string const& flann_method,
+                             double matcher_threshold,
+                             std::vector<InterestPoint> & matched_ip1,
+                             std::vector<InterestPoint> & matched_ip2) {
+  matched_ip1.clear();
+  matched_ip2.clear();
+  if (ip1.empty() || ip2.empty())
+    return;
+
+  std::string index_file = flann_index_filename(ip2_file, ip2, flann_method,
+                                                MetricT::flann_type);
+  std::vector<boost::shared_ptr<InterestPointIndex>> indices(1);
+  indices[0].reset(new InterestPointIndex(ip2, MetricT::flann_type, flann_method,
+                                          index_file));
+  vw_out() << (indices[0]->loaded_from_cache() ? "Read" : "Wrote")
+           << " FLANN index: " << index_file << "\n";
+
+  InterestPointMatcher<MetricT, NullConstraint> matcher(flann_method, matcher_threshold);
+  std::vector<std::vector<size_t>> index_lists;
+  matcher.match_indexed(ip1, indices, index_lists,
+                        TerminalProgressCallback("tools.ipmatch", "Matching:"));
+  for (size_t k = 0; k < ip1.size(); k++) {
+    if (index_lists[0][k] < ip2.size()) {
+      matched_ip1.push_back(ip1[k]);
+      matched_ip2.push_back(ip2[index_lists[0][k]]);
+    }
+  }
+}
+
 // TODO(oalexan1): Make all options below use the Options structure
 struct Options: public vw::GdalWriteOptions {};
 
@@ -190,6 +255,7 @@ int main(int argc, char** argv) {
   float       inlier_threshold;
   int         ransac_iterations;
   bool        merge_match_files, matches_as_txt, binary_to_txt, txt_to_binary;
+  bool        preemptive_ransac, cache_flann_index;
 
   po::options_description general_options("Options");
   general_options.add_options()
@@ -200,6 +266,10 @@ int main(int argc, char** argv) {
     ("flann-method", po::value(&flann_method)->default_value("kmeans"),
      "Choose the FLANN method for matching interest points. The default 'kmeans' is "
      "slower but deterministic, while 'kdtree' is faster but not deterministic.")
+    ("cache-flann-index",
+     po::bool_switch(&cache_flann_index)->default_value(false)->implicit_value(true),
+     "Save the FLANN index built for each .vwip file next to it, and reuse it when "
+     "matching that file again. This saves rebuilding the index for each image pair.")
     ("non-flann",
      "Use an implementation of the interest matcher that is not reliant on FLANN.")
     ("distance-metric,m", po::value(&distance_metric_in)->default_value("L2"),
@@ -212,6 +282,11 @@ int main(int argc, char** argv) {
      "RANSAC inlier threshold (in pixels).")
     ("ransac-iterations", po::value(&ransac_iterations)->default_value(1000),
      "Number of RANSAC iterations.")
+    ("preemptive-ransac",
+     po::bool_switch(&preemptive_ransac)->default_value(false)->implicit_value(true),
+     "Use preemptive RANSAC, which tries the matches between the most salient interest "
+     "points first, scores hypotheses on subsets of the matches, and stops once the fit "
+     "is good enough. Faster with many matches.")
     ("debug-image,d", "Write out debug images.")
     ("merge-match-files",
      po::bool_switch(&merge_match_files)->default_value(false)->implicit_value(true),
@@ -352,12 +427,18 @@ int main(int argc, char** argv) {
       if (!vm.count("non-flann")) {
         vw_out() << "Using FLANN method: " << flann_method << std::endl;
         // Run interest point matcher that uses KDTree algorithm.
-        if (distance_metric == "l2") {
+        if (cache_flann_index) {
+          if (distance_metric == "l2")
+            match_with_cached_index<L2NormMetric>(ip1, ip2, vwip_paths[j], flann_method,
+                                                  matcher_threshold, matched_ip1, matched_ip2);
+          if (distance_metric == "hamming")
+            match_with_cached_index<HammingMetric>(ip1, ip2, vwip_paths[j], flann_method,
+                                                   matcher_threshold, matched_ip1, matched_ip2);
+        } else if (distance_metric == "l2") {
           InterestPointMatcher<L2NormMetric, NullConstraint> 
             matcher(flann_method, matcher_threshold);
           matcher(ip1, ip2, matched_ip1, matched_ip2, TerminalProgressCallback( "tools.ipmatch","Matching:"));
-        } 
-        if (distance_metric == "hamming") {
+        } else if (distance_metric == "hamming") {
           InterestPointMatcher<HammingMetric, NullConstraint> 
             matcher(flann_method, matcher_threshold);
           matcher(ip1, ip2, matched_ip1, matched_ip2, TerminalProgressCallback( "tools.ipmatch","Matching:"));
@@ -382,44 +463,37 @@ int main(int argc, char** argv) {
 
       std::vector<Vector3> ransac_ip1 = iplist_to_vectorlist(matched_ip1),
                            ransac_ip2 = iplist_to_vectorlist(matched_ip2);
+      // A match is only as reliable as the weaker of its two interest points
+      std::vector<double> quality(matched_ip1.size());
+      for (size_t i = 0; i < matched_ip1.size(); i++)
+        quality[i] = std::min(std::abs(matched_ip1[i].interest),
+                              std::abs(matched_ip2[i].interest));
       std::vector<size_t> indices;
       try {
         // RANSAC is used to fit a transform between the matched sets
         // of points.  Points that don't meet this geometric
         // constraint are rejected as outliers.
         if (ransac_constraint == "similarity") {
-          math::RandomSampleConsensus<math::SimilarityFittingFunctor, 
-                                      math::InterestPointErrorMetric> 
-              ransac( math::SimilarityFittingFunctor(),
-                      math::InterestPointErrorMetric(),
-                      ransac_iterations,
-                      inlier_threshold,
-                      ransac_ip1.size()/2, true);
-          Matrix<double> H(ransac(ransac_ip1,ransac_ip2));
+          Matrix<double> H = fit_with_ransac(math::SimilarityFittingFunctor(),
+                                             math::InterestPointErrorMetric(),
+                                             ransac_ip1, ransac_ip2, quality,
+                                             ransac_iterations, inlier_threshold,
+                                             preemptive_ransac, indices);
           std::cout << "\t--> Similarity: " << H << "\n";
-          indices = ransac.inlier_indices(H,ransac_ip1,ransac_ip2);
         } else if (ransac_constraint == "homography") {
-          math::RandomSampleConsensus<math::HomographyFittingFunctor, 
-                                      math::InterestPointErrorMetric> 
-              ransac( math::HomographyFittingFunctor(),
-                      math::InterestPointErrorMetric(),
-                      ransac_iterations,
-                      inlier_threshold,
-                      ransac_ip1.size()/2, true);
-          Matrix<double> H(ransac(ransac_ip1,ransac_ip2));
+          Matrix<double> H = fit_with_ransac(math::HomographyFittingFunctor(),
+                                             math::InterestPointErrorMetric(),
+                                             ransac_ip1, ransac_ip2, quality,
+                                             ransac_iterations, inlier_threshold,
+                                             preemptive_ransac, indices);
           std::cout << "\t--> Homography: " << H << "\n";
-          indices = ransac.inlier_indices(H,ransac_ip1,ransac_ip2);
         } else if (ransac_constraint == "fundamental") {
-          math::RandomSampleConsensus<camera::FundamentalMatrix8PFittingFunctor, 
-                                      camera::FundamentalMatrixDistanceErrorMetric> 
-              ransac( camera::FundamentalMatrix8PFittingFunctor(),
-                      camera::FundamentalMatrixDistanceErrorMetric(), 
-                      ransac_iterations, 
-                      inlier_threshold, 
-                      ransac_ip1.size()/2, true );
-          Matrix<double> F(ransac(ransac_ip1,ransac_ip2));
+          Matrix<double> F = fit_with_ransac(camera::FundamentalMatrix8PFittingFunctor(),
+                                             camera::FundamentalMatrixDistanceErrorMetric(),
+                                             ransac_ip1, ransac_ip2, quality,
+                                             ransac_iterations, inlier_threshold,
+                                             preemptive_ransac, indices);
           std::cout << "\t--> Fundamental: " << F << "\n";
-          indices = ransac.inlier_indices(F,ransac_ip1,ransac_ip2);
         } else if (ransac_constraint == "none") {
           indices.reserve( matched_ip1.size() );
           for ( size_t i = 0; i < matched_ip1.size(); ++i )
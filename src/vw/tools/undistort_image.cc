@@ -66,6 +66,7 @@ std::string input_file_name, output_file_name, camera_file_name;
 double output_nodata_value = -std::numeric_limits<float>::max();
 bool output_nodata_value_was_set = false;
 std::string interpolation_method;
+double distortion_table_spacing = 8.0;
 
 template <class ImageT>
 class UndistortView: public ImageViewBase< UndistortView<ImageT> >{
@@ -118,7 +119,6 @@ public:
     else
       vw_throw(NoImplErr() << "Unknown interpolation method: " << interpolation_method << "\n");
     
-    const LensDistortion* lens_ptr = m_camera_model.lens_distortion();
     const double pitch = m_camera_model.pixel_pitch();
 
     ImageView<result_type> tile(bbox.width(), bbox.height());
@@ -127,7 +127,7 @@ public:
       for (int row = bbox.min().y(); row < bbox.max().y(); row++){
 
         Vector2 lens_loc = elem_prod(Vector2(col, row) + m_offset, pitch);
-        Vector2 out_loc  = lens_ptr->distorted_coordinates(m_camera_model, lens_loc);
+        Vector2 out_loc  = m_camera_model.distorted_coordinates(lens_loc);
         Vector2 in_loc = elem_quot(out_loc, pitch);
 
         tile(col - bbox.min().x(), row - bbox.min().y())
@@ -172,7 +172,13 @@ void do_work() {
   
   const int width_in  = dist_img.cols();
   const int height_in = dist_img.rows();
-  const LensDistortion* lens_ptr = camera_model.lens_distortion();
+
+  // Tabulate the lens distortion over the input image, so that the
+  // solver it may need is not run for every output pixel
+  if (distortion_table_spacing > 0)
+    camera_model.enable_distortion_table(Vector2i(width_in, height_in),
+                                         distortion_table_spacing);
+
   const double pitch = camera_model.pixel_pitch();
 
   // Figure out the size of the undistorted image
@@ -181,20 +187,20 @@ void do_work() {
   BBox2   output_area;
   for (int r=0; r<height_in; ++r) {
     lens_loc = elem_prod(Vector2(0, r), pitch);
-    out_loc  = lens_ptr->undistorted_coordinates(camera_model, lens_loc);
+    out_loc  = camera_model.undistorted_coordinates(lens_loc);
     output_area.grow(elem_quot(out_loc, pitch));
     
     lens_loc = elem_prod(Vector2(width_in-1, r), pitch);
-    out_loc  = lens_ptr->undistorted_coordinates(camera_model, lens_loc);
+    out_loc  = camera_model.undistorted_coordinates(lens_loc);
     output_area.grow(elem_quot(out_loc, pitch));
   }
   for (int c=0; c<width_in; ++c) {
     lens_loc = elem_prod(Vector2(c, 0), pitch);
-    out_loc  = lens_ptr->undistorted_coordinates(camera_model, lens_loc);
+    out_loc  = camera_model.undistorted_coordinates(lens_loc);
     output_area.grow(elem_quot(out_loc, pitch));
     
     lens_loc = elem_prod(Vector2(c, height_in-1), pitch);
-    out_loc  = lens_ptr->undistorted_coordinates(camera_model, lens_loc);
+    out_loc  = camera_model.undistorted_coordinates(lens_loc);
     output_area.grow(elem_quot(out_loc, pitch));
   }
 
@@ -353,7 +359,9 @@ int main(int argc, char *argv[]) {
      "Specify the output file")
     ("output-nodata-value", po::value(&output_nodata_value)->default_value(-std::numeric_limits<float>::max()),
      "Set the output nodata value. Only applicable if the output is a single-channel image with pixels that are float or double.")
-    ("interpolation-method",  po::value<std::string>(&interpolation_method)->default_value("bilinear"), "Interpolation method. Options: bilinear, bicubic. Default: bilinear.");
+    ("interpolation-method",  po::value<std::string>(&interpolation_method)->default_value("bilinear"), "Interpolation method. Options: bilinear, bicubic. Default: bilinear.")
+    ("distortion-table-spacing", po::value(&distortion_table_spacing)->default_value(8.0),
+     "Tabulate the lens distortion with a node every this many pixels, and look it up instead of using the distortion model. The table is checked against the model, and is not used if it differs from it by more than 0.001 pixels. Set to 0 to always use the model.");
 
   general_options.add(vw::GdalWriteOptionsDescription(opt));
   